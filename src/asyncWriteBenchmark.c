@@ -0,0 +1,401 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//This is the main file for the Async Write Benchmark helper program
+//It replays a recorded bitstream file (reserved NAL header + encoded frame
+//per access unit) through the asynchronous write functions the same way the
+//Lossless Screen Record program writes them out (two alternating output slots)
+//The replay happens once with the header and frame as separate writes, once with
+//both going out together as one vectored write, and last once more vectored with
+//the recorder's checkpoints (flush + journal record every few IDR segments)
+//Two vectored runs in between first reserve twice the input's size for the output file
+//(like the recorder's worst case estimate) and truncate it to the written end
+//when done: one keeping the file size at the written end and one extending the
+//file to the reserved size up front, so the write latency tails with and
+//without extents being allocated during the writes can be compared on each
+//file system (ext4, xfs, NTFS...)
+//A last run opens the output for direct writes and sends the chain out in whole
+//4096 byte blocks straight from the (page aligned) input copy so they bypass the
+//file cache, with the unaligned end going through the cache once every frame is out
+//Given a frame rate the writes go out at that pace like the recorder's instead
+//of as fast as the disk takes them
+//Usage: AsyncWriteBenchmark [input bitstream] [output file] [IDR segments per checkpoint] [pace fps]
+
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "bitstreamContainer.h" //Includes the checkpoint journal and the seek table trailer
+#include "latencyHistogram.h" //Includes the write latency histograms
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define REPLAY_READ_CHUNK_BYTES 1073741824
+#define REPLAY_MODE_SEPARATE 0
+#define REPLAY_MODE_VECTORED 1
+#define REPLAY_MODE_CHECKPOINT 2 //Vectored with checkpoints
+#define REPLAY_MODE_RESERVED 3 //Vectored into file space reserved up front (file size stays at the written end)
+#define REPLAY_MODE_EXTENDED 4 //Vectored into a file extended to the reserved size up front
+#define REPLAY_MODE_DIRECT 5 //Whole blocks of the chain as they fill up, bypassing the file cache
+#define REPLAY_DIRECT_ALIGNMENT 4096 //Same block size as IO_FILE_WRITE_ASYNC_DIRECT
+#define REPLAY_CHECKPOINT_OPERATION 4 //After the two slots (and their separate header writes)
+#define REPLAY_RESERVE_FACTOR 2 //Reserved output size as a multiple of the input's (leaves the truncate some work)
+
+static uint8_t* replayData = NULL;
+static uint64_t replayDataBytes = 0;
+static uint64_t* replayFrameOffsets = NULL; //Offset of each reserved NAL header in replayData
+static uint64_t replayFrameCount = 0;
+
+//Same layout as the recorder: one reserved NAL header per output slot
+static uint8_t replayReservedNAL0[10];
+static uint8_t replayReservedNAL1[10];
+static ioWriteVec replayWriteVectors0[2];
+static ioWriteVec replayWriteVectors1[2];
+static bitstreamCheckpoint replayCheckpoint;
+static uint64_t replayCheckpointSegments = 1;
+static uint64_t replayModeLines[6] = {57, 58, 153, 191, 192, 198};
+
+static uint64_t replayPaceFps = 0; //0 writes as fast as the disk takes them
+static void* replayWaitSet = NULL; //Paced runs sleep on it until the next frame time or a write completing
+static uint64_t replaySubmitTimes[2];
+static uint64_t replayPending[2]; //Slot holds a write that has not been seen completing yet
+static latencyHistogram replayLatency; //Submit to seen completing (a write finishing while the loop submits gets seen afterwards)
+
+static int replayReadInput(char* inputFileName) {
+	void* inputFile = NULL;
+	int error = ioOpenFile(&inputFile, inputFileName, -1, IO_FILE_READ_NORMAL);
+	RETURN_ON_ERROR(error);
+	error = ioGetFileSize(inputFile, &replayDataBytes);
+	RETURN_ON_ERROR(error);
+	
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, replayDataBytes + 8, 0);
+	RETURN_ON_ERROR(error);
+	replayData = (uint8_t*) memAlloc;
+	
+	uint64_t readBytes = 0;
+	while (readBytes < replayDataBytes) {
+		uint32_t bytesRead = REPLAY_READ_CHUNK_BYTES;
+		if ((replayDataBytes - readBytes) < REPLAY_READ_CHUNK_BYTES) {
+			bytesRead = (uint32_t) (replayDataBytes - readBytes);
+		}
+		error = ioReadFile(inputFile, &(replayData[readBytes]), &bytesRead);
+		RETURN_ON_ERROR(error);
+		if (bytesRead == 0) {
+			return ERROR_IO_WRONG_READ_SIZE;
+		}
+		readBytes += bytesRead;
+	}
+	
+	return ioCloseFile(&inputFile);
+}
+
+//Walks the reserved NAL headers once to count and locate every frame
+//The recorder's seek table trailer (reserved NAL + table + footer) ends the file and is not a frame
+static int replayFindFrames() {
+	uint64_t offset = 0;
+	while ((offset + 10) <= replayDataBytes) {
+		uint64_t* nalReservedHeader = (uint64_t*) (&(replayData[offset]));
+		if ((*nalReservedHeader & 0xFFFFFFFFFFFF) != 0x015401000000) {
+			return ERROR_PARSE_ISSUE;
+		}
+		uint32_t* nalReservedSize = (uint32_t*) (&(replayData[offset + 6]));
+		uint64_t nextOffset = offset + 10 + (*nalReservedSize);
+		if (((offset + 18) <= replayDataBytes) && (*((uint64_t*) (&(replayData[offset + 10]))) == BITSTREAM_SEEK_TABLE_MAGIC)) {
+			if (nextOffset != replayDataBytes) { //Footer is inside the trailer's size so it has to end right at the file end
+				return ERROR_PARSE_ISSUE;
+			}
+			break;
+		}
+		offset = nextOffset;
+		replayFrameCount++;
+	}
+	if (((offset != replayDataBytes) && ((offset + 10) > replayDataBytes)) || (replayFrameCount == 0)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, replayFrameCount * sizeof(uint64_t), 0);
+	RETURN_ON_ERROR(error);
+	replayFrameOffsets = (uint64_t*) memAlloc;
+	
+	offset = 0;
+	for (uint64_t f = 0; f < replayFrameCount; f++) {
+		replayFrameOffsets[f] = offset;
+		uint32_t* nalReservedSize = (uint32_t*) (&(replayData[offset + 6]));
+		offset += 10 + (*nalReservedSize);
+	}
+	return 0;
+}
+
+//Waits for the slot's write (both of them when separate) and records its latency
+static int replayComplete(uint64_t slot, uint64_t mode) {
+	if (replayPending[slot] == 0) {
+		return 0;
+	}
+	int error = ioAsyncSignalWait(slot);
+	RETURN_ON_ERROR(error);
+	if (mode == REPLAY_MODE_SEPARATE) {
+		error = ioAsyncSignalWait(slot + 2);
+		RETURN_ON_ERROR(error);
+	}
+	latencyHistogramRecord(&replayLatency, getDiffTimeNanoseconds(replaySubmitTimes[slot], getCurrentTime()));
+	replayPending[slot] = 0;
+	return 0;
+}
+
+//Sleeps until the frame time, recording the writes that complete in the meantime as they do
+static int replayPace(uint64_t frameTime, uint64_t oldestSlot, uint64_t mode) {
+	while (getCurrentTime() < frameTime) {
+		uint64_t slot = oldestSlot;
+		if (replayPending[slot] == 0) {
+			slot ^= 1;
+		}
+		uint64_t asyncOperation = (replayPending[slot] > 0) ? slot : SYNC_WAIT_NONE;
+		int error = syncWaitSetWait(replayWaitSet, asyncOperation, frameTime);
+		RETURN_ON_ERROR(error);
+		if (asyncOperation == SYNC_WAIT_NONE) {
+			continue;
+		}
+		uint64_t signaled = 0;
+		error = ioAsyncSignalCheck(slot, &signaled);
+		RETURN_ON_ERROR(error);
+		if (signaled > 0) {
+			if (mode == REPLAY_MODE_SEPARATE) { //The header went out first
+				error = ioAsyncSignalWait(slot + 2);
+				RETURN_ON_ERROR(error);
+			}
+			latencyHistogramRecord(&replayLatency, getDiffTimeNanoseconds(replaySubmitTimes[slot], getCurrentTime()));
+			replayPending[slot] = 0;
+		}
+	}
+	return 0;
+}
+
+static int replayWrite(char* outputFileName, uint64_t mode) {
+	void* outputFile = NULL;
+	int error = ioOpenFile(&outputFile, outputFileName, -1, (mode == REPLAY_MODE_DIRECT) ? IO_FILE_WRITE_ASYNC_DIRECT : IO_FILE_WRITE_ASYNC);
+	RETURN_ON_ERROR(error);
+	uint64_t checkpointSegments = (mode == REPLAY_MODE_CHECKPOINT) ? replayCheckpointSegments : 0;
+	error = bitstreamCheckpointSetup(&replayCheckpoint, outputFileName, checkpointSegments, REPLAY_CHECKPOINT_OPERATION);
+	RETURN_ON_ERROR(error);
+	
+	uint64_t reserveTime = 0;
+	if ((mode == REPLAY_MODE_RESERVED) || (mode == REPLAY_MODE_EXTENDED)) { //Before the clock starts like the recorder does it before recording
+		uint64_t reserveStartTime = getCurrentTime();
+		error = ioAllocateFileSpace(outputFile, replayDataBytes * REPLAY_RESERVE_FACTOR);
+		if (error != 0) {
+			consolePrintLine(replayModeLines[mode]);
+			consolePrintLine(194);
+			return ioCloseFile(&outputFile);
+		}
+		if (mode == REPLAY_MODE_EXTENDED) {
+			error = ioSetFileSize(outputFile, replayDataBytes * REPLAY_RESERVE_FACTOR);
+			RETURN_ON_ERROR(error);
+		}
+		reserveTime = getDiffTimeMicroseconds(reserveStartTime, getCurrentTime());
+	}
+	
+	latencyHistogramReset(&replayLatency);
+	replayPending[0] = 0;
+	replayPending[1] = 0;
+	uint64_t frameIntervalTime = (replayPaceFps > 0) ? getFrameIntervalTime(replayPaceFps) : 0;
+	uint64_t systemCallsStart = ioAsyncGetSystemCallCount();
+	uint64_t startTime = getCurrentTime();
+	
+	uint64_t writeOffset = 0;
+	uint64_t directOffset = 0; //Where the direct run's block writes end
+	for (uint64_t f = 0; f < replayFrameCount; f++) {
+		uint64_t slot = f & 1;
+		if (replayPaceFps > 0) {
+			error = replayPace(startTime + (f * frameIntervalTime), slot, mode); //Oldest write is in this slot
+			RETURN_ON_ERROR(error);
+		}
+		if (f >= 2) { //Slot still holds the write from two frames ago
+			error = replayComplete(slot, mode);
+			RETURN_ON_ERROR(error);
+			error = bitstreamCheckpointUpdate(&replayCheckpoint, outputFile, replayFrameOffsets[f - 1]); //Frame f - 2 is written
+			RETURN_ON_ERROR(error);
+		}
+		
+		uint8_t* reservedNAL = (slot == 0) ? replayReservedNAL0 : replayReservedNAL1;
+		ioWriteVec* writeVectors = (slot == 0) ? replayWriteVectors0 : replayWriteVectors1;
+		uint8_t* frameData = &(replayData[replayFrameOffsets[f]]);
+		uint32_t frameBytes = *((uint32_t*) (&(frameData[6])));
+		*((uint32_t*) (&(reservedNAL[6]))) = frameBytes;
+		
+		writeOffset += 10 + frameBytes;
+		if (mode == REPLAY_MODE_DIRECT) { //The blocks this frame filled (none when it did not reach the next block)
+			uint64_t blockEnd = writeOffset & ~((uint64_t) (REPLAY_DIRECT_ALIGNMENT - 1));
+			if (blockEnd > directOffset) {
+				replaySubmitTimes[slot] = getCurrentTime();
+				replayPending[slot] = 1;
+				error = ioAsyncWriteFile(outputFile, &(replayData[directOffset]), blockEnd - directOffset, slot, directOffset);
+				RETURN_ON_ERROR(error);
+				directOffset = blockEnd;
+			}
+			continue;
+		}
+		
+		replaySubmitTimes[slot] = getCurrentTime();
+		replayPending[slot] = 1;
+		if (mode == REPLAY_MODE_SEPARATE) {
+			error = ioAsyncWriteFile(outputFile, reservedNAL, 10, slot + 2, writeOffset - frameBytes - 10);
+			RETURN_ON_ERROR(error);
+			error = ioAsyncWriteFile(outputFile, &(frameData[10]), frameBytes, slot, writeOffset - frameBytes);
+			RETURN_ON_ERROR(error);
+		}
+		else {
+			writeVectors[1].dataPtr = &(frameData[10]);
+			writeVectors[1].numBytes = frameBytes;
+			error = ioAsyncWriteFileV(outputFile, writeVectors, 2, slot, writeOffset - frameBytes - 10);
+			RETURN_ON_ERROR(error);
+			bitstreamCheckpointAdd(&replayCheckpoint, reservedNAL, &(frameData[10]), frameBytes);
+		}
+	}
+	
+	error = replayComplete(replayFrameCount & 1, mode); //Oldest first
+	RETURN_ON_ERROR(error);
+	error = replayComplete((replayFrameCount & 1) ^ 1, mode);
+	RETURN_ON_ERROR(error);
+	if ((mode == REPLAY_MODE_DIRECT) && (directOffset < writeOffset)) { //Unaligned end through the cache
+		replaySubmitTimes[0] = getCurrentTime();
+		replayPending[0] = 1;
+		error = ioAsyncWriteFile(outputFile, &(replayData[directOffset]), writeOffset - directOffset, 0, directOffset);
+		RETURN_ON_ERROR(error);
+		error = replayComplete(0, mode);
+		RETURN_ON_ERROR(error);
+	}
+	error = bitstreamCheckpointFinish(&replayCheckpoint, outputFile, writeOffset);
+	RETURN_ON_ERROR(error);
+	
+	uint64_t stopTime = getCurrentTime();
+	uint64_t systemCalls = ioAsyncGetSystemCallCount() - systemCallsStart;
+	
+	if ((mode == REPLAY_MODE_RESERVED) || (mode == REPLAY_MODE_EXTENDED)) { //Releases the reserved space past the written end
+		error = ioSetFileSize(outputFile, writeOffset);
+		RETURN_ON_ERROR(error);
+	}
+	error = ioCloseFile(&outputFile);
+	RETURN_ON_ERROR(error);
+	
+	uint64_t runTime = getDiffTimeMicroseconds(startTime, stopTime);
+	if (runTime == 0) {
+		runTime = 1;
+	}
+	consolePrintLine(replayModeLines[mode]);
+	consolePrintLineWithNumber(59, writeOffset / runTime, NUM_FORMAT_UNSIGNED_INTEGER); //Bytes per us is MB/s
+	consolePrintLineWithNumber(60, (systemCalls * 1000) / replayFrameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrint(196, CON_NO_CTRL);
+	consolePrintWithNumber(148, latencyHistogramPercentile(&replayLatency, 5000) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, latencyHistogramPercentile(&replayLatency, 9000) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, latencyHistogramPercentile(&replayLatency, 9900) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, latencyHistogramPercentile(&replayLatency, 9990) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(164, replayLatency.max / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER_NEW_LINE);
+	if ((mode == REPLAY_MODE_RESERVED) || (mode == REPLAY_MODE_EXTENDED)) {
+		consolePrintLineWithNumber(193, reserveTime, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	if (mode == REPLAY_MODE_CHECKPOINT) {
+		consolePrintLineWithNumber(150, replayCheckpoint.recordCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(151, replayCheckpoint.skipped, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(152, replayCheckpoint.durationMax, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	
+	return 0;
+}
+
+int programMain() {
+	char* inputFileName = "bitstream.h265";
+	char* outputFileName = "replay.h265";
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		inputFileName = argument;
+	}
+	if (ioGetCommandArgument(2, &argument, &argumentBytes) == 0) {
+		outputFileName = argument;
+	}
+	if (ioGetCommandArgument(3, &argument, &argumentBytes) == 0) {
+		replayCheckpointSegments = 0;
+		for (uint64_t i = 0; i < argumentBytes; i++) {
+			if ((argument[i] < '0') || (argument[i] > '9')) {
+				return ERROR_INVALID_ARGUMENT;
+			}
+			replayCheckpointSegments = (replayCheckpointSegments * 10) + (argument[i] - '0');
+		}
+	}
+	if (ioGetCommandArgument(4, &argument, &argumentBytes) == 0) {
+		for (uint64_t i = 0; i < argumentBytes; i++) {
+			if ((argument[i] < '0') || (argument[i] > '9')) {
+				return ERROR_INVALID_ARGUMENT;
+			}
+			replayPaceFps = (replayPaceFps * 10) + (argument[i] - '0');
+		}
+	}
+	
+	consolePrintLine(55);
+	int error = replayReadInput(inputFileName);
+	RETURN_ON_ERROR(error);
+	error = replayFindFrames();
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(56, replayFrameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(195, replayPaceFps, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	for (uint64_t i = 0; i < 6; i++) {
+		replayReservedNAL0[i] = replayData[i];
+		replayReservedNAL1[i] = replayData[i];
+	}
+	replayWriteVectors0[0].dataPtr = replayReservedNAL0;
+	replayWriteVectors0[0].numBytes = 10;
+	replayWriteVectors1[0].dataPtr = replayReservedNAL1;
+	replayWriteVectors1[0].numBytes = 10;
+	
+	error = ioAsyncSetup(REPLAY_CHECKPOINT_OPERATION + 1);
+	RETURN_ON_ERROR(error);
+	error = ioAsyncRegisterBuffer(replayData, replayDataBytes);
+	RETURN_ON_ERROR(error);
+	error = syncCreateWaitSet(&replayWaitSet);
+	RETURN_ON_ERROR(error);
+	
+	error = replayWrite(outputFileName, REPLAY_MODE_SEPARATE);
+	RETURN_ON_ERROR(error);
+	error = replayWrite(outputFileName, REPLAY_MODE_VECTORED);
+	RETURN_ON_ERROR(error);
+	error = replayWrite(outputFileName, REPLAY_MODE_RESERVED);
+	RETURN_ON_ERROR(error);
+	error = replayWrite(outputFileName, REPLAY_MODE_EXTENDED);
+	RETURN_ON_ERROR(error);
+	error = replayWrite(outputFileName, REPLAY_MODE_DIRECT);
+	RETURN_ON_ERROR(error);
+	if (replayCheckpointSegments > 0) {
+		error = replayWrite(outputFileName, REPLAY_MODE_CHECKPOINT);
+		RETURN_ON_ERROR(error);
+	}
+	
+	syncCloseWaitSet(&replayWaitSet);
+	ioAsyncCleanup();
+	error = memoryDeallocate((void**) &replayFrameOffsets);
+	RETURN_ON_ERROR(error);
+	error = memoryDeallocate((void**) &replayData);
+	RETURN_ON_ERROR(error);
+	
+	consoleBufferFlush();
+	return 0;
+}
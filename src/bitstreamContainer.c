@@ -0,0 +1,1073 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+//Media Enhanced Bitstream Container Functions
+//Walks the recorder's reserved NAL chain into a frame index, keeps that index
+//in a sidecar file, and reads frames straight from their indexed offsets
+//(or views them in place through a mapped window of the file)
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "bitstreamContainer.h" //Include Bitstream Container Function Definitions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define BITSTREAM_IO_CHUNK_BYTES 1073741824
+#define BITSTREAM_INDEX_INITIAL_FRAMES 4096
+#define BITSTREAM_PAGE_BYTES 4096 //The last mapped page reads as zeros past the end of the file
+
+#define HEVC_NAL_BLA_W_LP 16
+#define HEVC_NAL_IDR_W_RADL 19
+#define HEVC_NAL_IDR_N_LP 20
+#define HEVC_NAL_RSV_IRAP_VCL23 23
+#define HEVC_NAL_VPS 32
+
+int bitstreamReaderOpen(bitstreamReader* reader, char* fileName) {
+	reader->file = NULL;
+	reader->fileName = fileName;
+	reader->fileBytes = 0;
+	reader->chainBytes = 0;
+	reader->truncatedBytes = 0;
+	reader->window = NULL;
+	reader->windowOffset = 0;
+	reader->windowBytes = 0;
+	reader->bounce = NULL;
+	reader->bounceBytes = 0;
+	reader->frames = NULL;
+	reader->frameCount = 0;
+	reader->maxFrameBytes = 0;
+	reader->unitsInTick = 0;
+	reader->timeScale = 0;
+	
+	int error = ioOpenFile(&(reader->file), fileName, -1, IO_FILE_READ_NORMAL);
+	RETURN_ON_ERROR(error);
+	return ioGetFileSize(reader->file, &(reader->fileBytes));
+}
+
+int bitstreamReaderRead(bitstreamReader* reader, uint64_t offset, void* buffer, uint64_t numBytes) {
+	uint8_t* readPtr = (uint8_t*) buffer;
+	uint64_t readBytes = 0;
+	while (readBytes < numBytes) {
+		uint32_t bytesRead = BITSTREAM_IO_CHUNK_BYTES;
+		if ((numBytes - readBytes) < BITSTREAM_IO_CHUNK_BYTES) {
+			bytesRead = (uint32_t) (numBytes - readBytes);
+		}
+		int error = ioReadFileOffset(reader->file, &(readPtr[readBytes]), &bytesRead, offset + readBytes);
+		RETURN_ON_ERROR(error);
+		if (bytesRead == 0) {
+			return ERROR_IO_WRONG_READ_SIZE;
+		}
+		readBytes += bytesRead;
+	}
+	return 0;
+}
+
+//Views that fit the window just move a pointer, otherwise the window gets remapped at the view
+//(windows only reach the end of the file, so the padding there comes from the rest of the last page)
+int bitstreamReaderView(bitstreamReader* reader, uint64_t offset, uint64_t numBytes, uint8_t** view) {
+	if ((offset > reader->fileBytes) || (numBytes > (reader->fileBytes - offset)) || (numBytes == 0)) {
+		return ERROR_IO_WRONG_READ_SIZE;
+	}
+	uint64_t viewEnd = offset + numBytes + BITSTREAM_VIEW_PADDING_BYTES;
+	uint64_t windowEnd = reader->windowOffset + reader->windowBytes;
+	if (windowEnd == reader->fileBytes) {
+		windowEnd = (windowEnd + BITSTREAM_PAGE_BYTES - 1) & (~((uint64_t) (BITSTREAM_PAGE_BYTES - 1)));
+	}
+	if ((reader->window == NULL) || (offset < reader->windowOffset) || (viewEnd > windowEnd)) {
+		int error = 0;
+		if (reader->window != NULL) {
+			error = ioUnmapFile((void**) &(reader->window), reader->windowBytes);
+			RETURN_ON_ERROR(error);
+		}
+		reader->windowOffset = offset - (offset % IO_MAP_ALIGNMENT);
+		reader->windowBytes = BITSTREAM_WINDOW_BYTES;
+		if ((viewEnd - reader->windowOffset) > reader->windowBytes) {
+			reader->windowBytes = viewEnd - reader->windowOffset;
+		}
+		if (reader->windowBytes > (reader->fileBytes - reader->windowOffset)) {
+			reader->windowBytes = reader->fileBytes - reader->windowOffset;
+		}
+		void* mapPtr = NULL;
+		error = ioMapFile(reader->file, reader->windowOffset, reader->windowBytes, &mapPtr);
+		if (error != 0) {
+			reader->windowBytes = 0;
+			return error;
+		}
+		reader->window = (uint8_t*) mapPtr;
+		
+		windowEnd = reader->windowOffset + reader->windowBytes;
+		if (windowEnd == reader->fileBytes) {
+			windowEnd = (windowEnd + BITSTREAM_PAGE_BYTES - 1) & (~((uint64_t) (BITSTREAM_PAGE_BYTES - 1)));
+		}
+	}
+	*view = &(reader->window[offset - reader->windowOffset]);
+	if (viewEnd <= windowEnd) {
+		return 0;
+	}
+	
+	//Ends within the padding of a page aligned file end (the only case that still copies)
+	if ((numBytes + BITSTREAM_VIEW_PADDING_BYTES) > reader->bounceBytes) {
+		int error = 0;
+		if (reader->bounce != NULL) {
+			error = memoryDeallocate((void**) &(reader->bounce));
+			RETURN_ON_ERROR(error);
+		}
+		reader->bounceBytes = 0;
+		void* memAlloc = NULL;
+		error = memoryAllocate(&memAlloc, numBytes + BITSTREAM_VIEW_PADDING_BYTES, 0);
+		RETURN_ON_ERROR(error);
+		reader->bounce = (uint8_t*) memAlloc;
+		reader->bounceBytes = numBytes + BITSTREAM_VIEW_PADDING_BYTES;
+	}
+	memcpyBasic(reader->bounce, *view, numBytes);
+	memzeroBasic(&(reader->bounce[numBytes]), BITSTREAM_VIEW_PADDING_BYTES);
+	*view = reader->bounce;
+	return 0;
+}
+
+int bitstreamReaderMapAll(bitstreamReader* reader, uint8_t** data) {
+	if (reader->fileBytes == 0) {
+		return ERROR_IO_WRONG_READ_SIZE;
+	}
+	if ((reader->window == NULL) || (reader->windowOffset != 0) || (reader->windowBytes != reader->fileBytes)) {
+		int error = 0;
+		if (reader->window != NULL) {
+			error = ioUnmapFile((void**) &(reader->window), reader->windowBytes);
+			RETURN_ON_ERROR(error);
+		}
+		reader->windowOffset = 0;
+		reader->windowBytes = 0;
+		void* mapPtr = NULL;
+		error = ioMapFile(reader->file, 0, reader->fileBytes, &mapPtr);
+		RETURN_ON_ERROR(error);
+		reader->window = (uint8_t*) mapPtr;
+		reader->windowBytes = reader->fileBytes;
+	}
+	*data = reader->window;
+	return 0;
+}
+
+//Looks through the NAL units at the start of an access unit until the first slice
+//(emulation prevention keeps 0x000001 out of the NAL payloads)
+uint32_t bitstreamClassifyAccessUnit(uint8_t* data, uint64_t dataBytes) {
+	uint32_t flags = 0;
+	uint64_t i = 0;
+	while ((i + 3) < dataBytes) {
+		if ((data[i] == 0) && (data[i + 1] == 0) && (data[i + 2] == 1)) {
+			uint64_t nalType = (data[i + 3] >> 1) & 0x3F;
+			if (nalType < HEVC_NAL_VPS) { //First slice decides the picture type
+				if ((nalType >= HEVC_NAL_BLA_W_LP) && (nalType <= HEVC_NAL_RSV_IRAP_VCL23)) {
+					flags |= BITSTREAM_FRAME_RANDOM_ACCESS;
+				}
+				if ((nalType == HEVC_NAL_IDR_W_RADL) || (nalType == HEVC_NAL_IDR_N_LP)) {
+					flags |= BITSTREAM_FRAME_IDR;
+				}
+				break;
+			}
+			if (nalType == HEVC_NAL_VPS) {
+				flags |= BITSTREAM_FRAME_PARAMETER_SETS;
+			}
+			i += 4;
+		}
+		else {
+			i++;
+		}
+	}
+	return flags;
+}
+
+//Every recorded frame interval has exactly one access unit (missed frames get repeated)
+//so the presentation time follows from the frame number
+static uint64_t bitstreamPresentationTime(uint64_t frame, uint32_t unitsInTick, uint32_t timeScale) {
+	if (timeScale == 0) {
+		return 0;
+	}
+	return (frame * unitsInTick * 1000000) / timeScale;
+}
+
+static int bitstreamIndexFree(bitstreamReader* reader) {
+	reader->frameCount = 0;
+	reader->maxFrameBytes = 0;
+	reader->truncatedBytes = 0;
+	if (reader->frames == NULL) {
+		return 0;
+	}
+	return memoryDeallocate((void**) &(reader->frames));
+}
+
+static int bitstreamIndexGrow(bitstreamReader* reader, uint64_t* capacity) {
+	uint64_t newCapacity = BITSTREAM_INDEX_INITIAL_FRAMES;
+	if (*capacity > 0) {
+		newCapacity = (*capacity) << 1;
+	}
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, newCapacity * sizeof(bitstreamFrameEntry), 0);
+	RETURN_ON_ERROR(error);
+	if (reader->frames != NULL) {
+		memcpyBasic(memAlloc, reader->frames, reader->frameCount * sizeof(bitstreamFrameEntry));
+		error = memoryDeallocate((void**) &(reader->frames));
+		RETURN_ON_ERROR(error);
+	}
+	reader->frames = (bitstreamFrameEntry*) memAlloc;
+	*capacity = newCapacity;
+	return 0;
+}
+
+int bitstreamIndexBuild(bitstreamReader* reader, uint32_t unitsInTick, uint32_t timeScale) {
+	int error = bitstreamIndexFree(reader);
+	RETURN_ON_ERROR(error);
+	reader->unitsInTick = unitsInTick;
+	reader->timeScale = timeScale;
+	
+	//Only the reserved NAL and the first few hundred bytes of each access unit get touched
+	uint64_t capacity = 0;
+	uint64_t offset = 0;
+	while (offset < reader->fileBytes) {
+		uint64_t peekBytes = BITSTREAM_RESERVED_NAL_BYTES + BITSTREAM_CLASSIFY_BYTES;
+		if ((reader->fileBytes - offset) < peekBytes) {
+			peekBytes = reader->fileBytes - offset;
+		}
+		if (peekBytes < BITSTREAM_RESERVED_NAL_BYTES) { //Cut off inside the reserved NAL
+			reader->truncatedBytes = reader->fileBytes - offset;
+			break;
+		}
+		uint8_t* peek = NULL;
+		error = bitstreamReaderView(reader, offset, peekBytes, &peek);
+		RETURN_ON_ERROR(error);
+		
+		uint64_t* nalReservedHeader = (uint64_t*) peek;
+		uint32_t* nalReservedSize = (uint32_t*) (&(peek[6]));
+		if ((*nalReservedHeader & BITSTREAM_RESERVED_NAL_MASK) != BITSTREAM_RESERVED_NAL_START) {
+			return ERROR_BITSTREAM_BROKEN_CHAIN;
+		}
+		uint64_t frameEnd = offset + BITSTREAM_RESERVED_NAL_BYTES + (*nalReservedSize);
+		if (frameEnd > reader->fileBytes) { //Cut off inside the access unit
+			reader->truncatedBytes = reader->fileBytes - offset;
+			break;
+		}
+		if ((peekBytes >= (BITSTREAM_RESERVED_NAL_BYTES + 8)) && (*((uint64_t*) (&(peek[BITSTREAM_RESERVED_NAL_BYTES]))) == BITSTREAM_SEEK_TABLE_MAGIC)) {
+			if (frameEnd != reader->fileBytes) { //The seek table trailer is always last
+				return ERROR_BITSTREAM_BROKEN_CHAIN;
+			}
+			break;
+		}
+		
+		if (reader->frameCount >= capacity) {
+			error = bitstreamIndexGrow(reader, &capacity);
+			RETURN_ON_ERROR(error);
+		}
+		bitstreamFrameEntry* entry = &(reader->frames[reader->frameCount]);
+		entry->offset = offset;
+		entry->bytes = *nalReservedSize;
+		entry->flags = bitstreamClassifyAccessUnit(&(peek[BITSTREAM_RESERVED_NAL_BYTES]), peekBytes - BITSTREAM_RESERVED_NAL_BYTES);
+		entry->presentationTime = bitstreamPresentationTime(reader->frameCount, unitsInTick, timeScale);
+		if (entry->bytes > reader->maxFrameBytes) {
+			reader->maxFrameBytes = entry->bytes;
+		}
+		reader->frameCount++;
+		offset = frameEnd;
+	}
+	reader->chainBytes = offset;
+	if ((reader->truncatedBytes > 0) && (reader->frameCount == 0)) { //Not even one whole frame
+		return ERROR_BITSTREAM_BROKEN_CHAIN;
+	}
+	
+	return 0;
+}
+
+//Sidecar names are the bitstream file name with an extension (".idx" or ".ckpt") added
+int bitstreamSideFileName(char* sideName, char* fileName, char* extension) {
+	uint64_t extensionBytes = 1;
+	while (extension[extensionBytes - 1] != 0) {
+		extensionBytes++;
+	}
+	uint64_t index = 0;
+	while (fileName[index] != 0) {
+		if (index >= (BITSTREAM_FILE_NAME_MAX - extensionBytes)) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		sideName[index] = fileName[index];
+		index++;
+	}
+	for (uint64_t i = 0; i < extensionBytes; i++) {
+		sideName[index + i] = extension[i];
+	}
+	return 0;
+}
+
+int bitstreamTextOpen(bitstreamTextWriter* writer, char* fileName, char* buffer, uint64_t flushBytes) {
+	writer->buffer = buffer;
+	writer->bytes = 0;
+	writer->flushBytes = flushBytes;
+	return ioOpenFile(&(writer->file), fileName, -1, IO_FILE_WRITE_NORMAL);
+}
+
+int bitstreamTextFlush(bitstreamTextWriter* writer) {
+	if (writer->bytes == 0) {
+		return 0;
+	}
+	int error = ioWriteFile(writer->file, writer->buffer, (uint32_t) writer->bytes);
+	writer->bytes = 0;
+	return error;
+}
+
+int bitstreamTextPut(bitstreamTextWriter* writer, char* text) {
+	for (uint64_t i = 0; text[i] != 0; i++) {
+		writer->buffer[writer->bytes] = text[i];
+		writer->bytes++;
+	}
+	if (writer->bytes >= writer->flushBytes) {
+		return bitstreamTextFlush(writer);
+	}
+	return 0;
+}
+
+int bitstreamTextPutNumber(bitstreamTextWriter* writer, uint64_t number) {
+	writer->bytes += numToUDecStr(&(writer->buffer[writer->bytes]), number);
+	if (writer->bytes >= writer->flushBytes) {
+		return bitstreamTextFlush(writer);
+	}
+	return 0;
+}
+
+int bitstreamTextClose(bitstreamTextWriter* writer, int error) {
+	if (error == 0) {
+		error = bitstreamTextFlush(writer);
+	}
+	int closeError = ioCloseFile(&(writer->file));
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+static int bitstreamIndexTransfer(void* indexFile, void* data, uint64_t numBytes, uint64_t write) {
+	uint8_t* dataPtr = (uint8_t*) data;
+	uint64_t doneBytes = 0;
+	while (doneBytes < numBytes) {
+		uint32_t chunkBytes = BITSTREAM_IO_CHUNK_BYTES;
+		if ((numBytes - doneBytes) < BITSTREAM_IO_CHUNK_BYTES) {
+			chunkBytes = (uint32_t) (numBytes - doneBytes);
+		}
+		int error = 0;
+		if (write > 0) {
+			error = ioWriteFile(indexFile, &(dataPtr[doneBytes]), chunkBytes);
+		}
+		else {
+			error = ioReadFile(indexFile, &(dataPtr[doneBytes]), &chunkBytes);
+			if ((error == 0) && (chunkBytes == 0)) {
+				error = ERROR_IO_WRONG_READ_SIZE;
+			}
+		}
+		RETURN_ON_ERROR(error);
+		doneBytes += chunkBytes;
+	}
+	return 0;
+}
+
+int bitstreamIndexLoad(bitstreamReader* reader, uint32_t unitsInTick, uint32_t timeScale) {
+	int error = bitstreamIndexFree(reader);
+	RETURN_ON_ERROR(error);
+	char indexName[BITSTREAM_FILE_NAME_MAX];
+	error = bitstreamSideFileName(indexName, reader->fileName, ".idx");
+	RETURN_ON_ERROR(error);
+	void* indexFile = NULL;
+	error = ioOpenFile(&indexFile, indexName, -1, IO_FILE_READ_NORMAL);
+	if (error != 0) {
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	
+	uint64_t indexBytes = 0;
+	bitstreamIndexHeader header;
+	error = ioGetFileSize(indexFile, &indexBytes);
+	if ((error == 0) && (indexBytes >= sizeof(bitstreamIndexHeader))) {
+		error = bitstreamIndexTransfer(indexFile, &header, sizeof(bitstreamIndexHeader), 0);
+	}
+	else {
+		error = ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	if ((error == 0) && (header.magic == BITSTREAM_INDEX_MAGIC) && (header.formatVersion == BITSTREAM_INDEX_FORMAT_VERSION) &&
+		(header.entryBytes == sizeof(bitstreamFrameEntry)) && (header.containerBytes == reader->fileBytes) && (header.frameCount > 0) &&
+		(header.unitsInTick == unitsInTick) && (header.timeScale == timeScale) &&
+		(indexBytes == (sizeof(bitstreamIndexHeader) + (header.frameCount * sizeof(bitstreamFrameEntry))))) {
+		void* memAlloc = NULL;
+		error = memoryAllocate(&memAlloc, header.frameCount * sizeof(bitstreamFrameEntry), 0);
+		if (error == 0) {
+			reader->frames = (bitstreamFrameEntry*) memAlloc;
+			reader->frameCount = header.frameCount;
+			reader->maxFrameBytes = header.maxFrameBytes;
+			reader->unitsInTick = unitsInTick;
+			reader->timeScale = timeScale;
+			error = bitstreamIndexTransfer(indexFile, reader->frames, header.frameCount * sizeof(bitstreamFrameEntry), 0);
+		}
+	}
+	else if (error == 0) {
+		error = ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	ioCloseFile(&indexFile);
+	
+	//Both ends of the chain have to line up with the bitstream file
+	if (error == 0) {
+		bitstreamFrameEntry* last = &(reader->frames[reader->frameCount - 1]);
+		reader->chainBytes = last->offset + BITSTREAM_RESERVED_NAL_BYTES + last->bytes;
+		if ((reader->frames[0].offset != 0) || (reader->chainBytes > reader->fileBytes)) {
+			error = ERROR_BITSTREAM_INDEX_INVALID;
+		}
+		else {
+			reader->truncatedBytes = reader->fileBytes - reader->chainBytes; //Sidecar of a cut off recording
+		}
+	}
+	if (error != 0) {
+		bitstreamIndexFree(reader);
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	return 0;
+}
+
+int bitstreamIndexSave(bitstreamReader* reader) {
+	bitstreamIndexHeader header;
+	memzeroBasic(&header, sizeof(bitstreamIndexHeader));
+	header.magic = BITSTREAM_INDEX_MAGIC;
+	header.formatVersion = BITSTREAM_INDEX_FORMAT_VERSION;
+	header.entryBytes = sizeof(bitstreamFrameEntry);
+	header.frameCount = reader->frameCount;
+	header.containerBytes = reader->fileBytes;
+	header.maxFrameBytes = reader->maxFrameBytes;
+	header.unitsInTick = reader->unitsInTick;
+	header.timeScale = reader->timeScale;
+	
+	char indexName[BITSTREAM_FILE_NAME_MAX];
+	int error = bitstreamSideFileName(indexName, reader->fileName, ".idx");
+	RETURN_ON_ERROR(error);
+	void* indexFile = NULL;
+	error = ioOpenFile(&indexFile, indexName, -1, IO_FILE_WRITE_NORMAL);
+	RETURN_ON_ERROR(error);
+	error = bitstreamIndexTransfer(indexFile, &header, sizeof(bitstreamIndexHeader), 1);
+	if (error == 0) {
+		error = bitstreamIndexTransfer(indexFile, reader->frames, reader->frameCount * sizeof(bitstreamFrameEntry), 1);
+	}
+	int closeError = ioCloseFile(&indexFile);
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+//Seek Table Trailer
+//Emulation prevention the same way slice data gets it: 0x03 goes in after two zero bytes when the next byte is 0x03 or less
+//zeroCount carries over so one payload can get escaped in pieces
+static uint64_t bitstreamEscape(uint8_t* escaped, uint8_t* data, uint64_t dataBytes, uint64_t* zeroCount) {
+	uint64_t escapedBytes = 0;
+	for (uint64_t i = 0; i < dataBytes; i++) {
+		if ((*zeroCount >= 2) && (data[i] <= 3)) {
+			escaped[escapedBytes] = 3;
+			escapedBytes++;
+			*zeroCount = 0;
+		}
+		escaped[escapedBytes] = data[i];
+		escapedBytes++;
+		if (data[i] == 0) {
+			(*zeroCount)++;
+		}
+		else {
+			*zeroCount = 0;
+		}
+	}
+	return escapedBytes;
+}
+
+//Removes the emulation prevention bytes in place and returns the remaining bytes
+static uint64_t bitstreamUnescape(uint8_t* data, uint64_t dataBytes) {
+	uint64_t dataIndex = 0;
+	uint64_t zeroCount = 0;
+	for (uint64_t i = 0; i < dataBytes; i++) {
+		if ((zeroCount >= 2) && (data[i] == 3)) {
+			zeroCount = 0;
+			continue;
+		}
+		data[dataIndex] = data[i];
+		dataIndex++;
+		if (data[i] == 0) {
+			zeroCount++;
+		}
+		else {
+			zeroCount = 0;
+		}
+	}
+	return dataIndex;
+}
+
+int bitstreamSeekTableSetup(bitstreamSeekTable* table, uint64_t frameCapacity, uint32_t unitsInTick, uint32_t timeScale) {
+	table->frames = NULL;
+	table->trailer = NULL;
+	table->frameCapacity = frameCapacity;
+	table->unitsInTick = unitsInTick;
+	table->timeScale = timeScale;
+	bitstreamSeekTableReset(table);
+	
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, frameCapacity * sizeof(bitstreamFrameEntry), 0);
+	RETURN_ON_ERROR(error);
+	table->frames = (bitstreamFrameEntry*) memAlloc;
+	memzeroBasic(memAlloc, frameCapacity * sizeof(bitstreamFrameEntry)); //First touches happen here instead of while recording
+	
+	//Escaping adds at most one byte for every two
+	uint64_t payloadBytes = sizeof(bitstreamIndexHeader) + (frameCapacity * sizeof(bitstreamFrameEntry));
+	table->trailerCapacity = BITSTREAM_RESERVED_NAL_BYTES + payloadBytes + (payloadBytes >> 1) + BITSTREAM_SEEK_FOOTER_BYTES;
+	error = memoryAllocate(&memAlloc, table->trailerCapacity, 0);
+	RETURN_ON_ERROR(error);
+	table->trailer = (uint8_t*) memAlloc;
+	return 0;
+}
+
+void bitstreamSeekTableReset(bitstreamSeekTable* table) {
+	table->frameCount = 0;
+	table->maxFrameBytes = 0;
+	table->overflow = 0;
+}
+
+void bitstreamSeekTableAdd(bitstreamSeekTable* table, uint64_t offset, uint8_t* accessUnit, uint64_t accessUnitBytes) {
+	if (table->frameCount >= table->frameCapacity) {
+		table->overflow = 1;
+		return;
+	}
+	uint64_t classifyBytes = accessUnitBytes;
+	if (classifyBytes > BITSTREAM_CLASSIFY_BYTES) {
+		classifyBytes = BITSTREAM_CLASSIFY_BYTES;
+	}
+	bitstreamFrameEntry* entry = &(table->frames[table->frameCount]);
+	entry->offset = offset;
+	entry->bytes = (uint32_t) accessUnitBytes;
+	entry->flags = bitstreamClassifyAccessUnit(accessUnit, classifyBytes);
+	entry->presentationTime = bitstreamPresentationTime(table->frameCount, table->unitsInTick, table->timeScale);
+	if (accessUnitBytes > table->maxFrameBytes) {
+		table->maxFrameBytes = accessUnitBytes;
+	}
+	table->frameCount++;
+}
+
+uint64_t bitstreamSeekTableFinish(bitstreamSeekTable* table, uint64_t chainBytes) {
+	if ((table->overflow > 0) || (table->frameCount == 0)) {
+		return 0;
+	}
+	
+	bitstreamIndexHeader header;
+	memzeroBasic(&header, sizeof(bitstreamIndexHeader));
+	header.magic = BITSTREAM_SEEK_TABLE_MAGIC;
+	header.formatVersion = BITSTREAM_INDEX_FORMAT_VERSION;
+	header.entryBytes = sizeof(bitstreamFrameEntry);
+	header.frameCount = table->frameCount;
+	header.containerBytes = chainBytes;
+	header.maxFrameBytes = table->maxFrameBytes;
+	header.unitsInTick = table->unitsInTick;
+	header.timeScale = table->timeScale;
+	
+	uint8_t* trailer = table->trailer;
+	uint64_t trailerBytes = BITSTREAM_RESERVED_NAL_BYTES;
+	uint64_t zeroCount = 0;
+	trailerBytes += bitstreamEscape(&(trailer[trailerBytes]), (uint8_t*) &header, sizeof(bitstreamIndexHeader), &zeroCount);
+	trailerBytes += bitstreamEscape(&(trailer[trailerBytes]), (uint8_t*) table->frames, table->frameCount * sizeof(bitstreamFrameEntry), &zeroCount);
+	
+	//Footer bytes never need escaping (all have the high bit set or are letters)
+	for (uint64_t i = 0; i < 8; i++) {
+		trailer[trailerBytes + i] = 0x80 | ((chainBytes >> (7 * i)) & 0x7F);
+	}
+	*((uint64_t*) (&(trailer[trailerBytes + 8]))) = BITSTREAM_SEEK_FOOTER_MAGIC;
+	trailerBytes += BITSTREAM_SEEK_FOOTER_BYTES;
+	
+	trailer[0] = 0;
+	trailer[1] = 0;
+	trailer[2] = 0;
+	trailer[3] = 1;
+	trailer[4] = 84;
+	trailer[5] = 1;
+	*((uint32_t*) (&(trailer[6]))) = (uint32_t) (trailerBytes - BITSTREAM_RESERVED_NAL_BYTES);
+	return trailerBytes;
+}
+
+void bitstreamSeekTableCleanup(bitstreamSeekTable* table) {
+	if (table->frames != NULL) {
+		memoryDeallocate((void**) &(table->frames));
+	}
+	if (table->trailer != NULL) {
+		memoryDeallocate((void**) &(table->trailer));
+	}
+}
+
+//Follows the footer back to the trailer (two reads no matter how big the file is)
+int bitstreamSeekTableLoad(bitstreamReader* reader) {
+	int error = bitstreamIndexFree(reader);
+	RETURN_ON_ERROR(error);
+	uint64_t minimumBytes = BITSTREAM_RESERVED_NAL_BYTES + sizeof(bitstreamIndexHeader) + BITSTREAM_SEEK_FOOTER_BYTES;
+	if (reader->fileBytes < minimumBytes) {
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	
+	uint8_t footer[BITSTREAM_SEEK_FOOTER_BYTES];
+	error = bitstreamReaderRead(reader, reader->fileBytes - BITSTREAM_SEEK_FOOTER_BYTES, footer, BITSTREAM_SEEK_FOOTER_BYTES);
+	RETURN_ON_ERROR(error);
+	if (*((uint64_t*) (&(footer[8]))) != BITSTREAM_SEEK_FOOTER_MAGIC) {
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	uint64_t trailerOffset = 0;
+	for (uint64_t i = 0; i < 8; i++) {
+		trailerOffset |= ((uint64_t) (footer[i] & 0x7F)) << (7 * i);
+	}
+	if ((trailerOffset + minimumBytes) > reader->fileBytes) {
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	
+	uint64_t trailerBytes = reader->fileBytes - trailerOffset;
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, trailerBytes, 0);
+	RETURN_ON_ERROR(error);
+	uint8_t* trailer = (uint8_t*) memAlloc;
+	error = bitstreamReaderRead(reader, trailerOffset, trailer, trailerBytes);
+	
+	uint64_t payloadBytes = 0;
+	bitstreamIndexHeader* header = (bitstreamIndexHeader*) (&(trailer[BITSTREAM_RESERVED_NAL_BYTES]));
+	if ((error == 0) && ((*((uint64_t*) trailer) & BITSTREAM_RESERVED_NAL_MASK) == BITSTREAM_RESERVED_NAL_START) &&
+		(*((uint32_t*) (&(trailer[6]))) == (trailerBytes - BITSTREAM_RESERVED_NAL_BYTES))) {
+		payloadBytes = bitstreamUnescape(&(trailer[BITSTREAM_RESERVED_NAL_BYTES]), trailerBytes - BITSTREAM_RESERVED_NAL_BYTES - BITSTREAM_SEEK_FOOTER_BYTES);
+	}
+	if ((payloadBytes >= sizeof(bitstreamIndexHeader)) && (header->magic == BITSTREAM_SEEK_TABLE_MAGIC) &&
+		(header->formatVersion == BITSTREAM_INDEX_FORMAT_VERSION) && (header->entryBytes == sizeof(bitstreamFrameEntry)) &&
+		(header->containerBytes == trailerOffset) && (header->frameCount > 0) &&
+		(payloadBytes == (sizeof(bitstreamIndexHeader) + (header->frameCount * sizeof(bitstreamFrameEntry))))) {
+		error = memoryAllocate(&memAlloc, header->frameCount * sizeof(bitstreamFrameEntry), 0);
+		if (error == 0) {
+			reader->frames = (bitstreamFrameEntry*) memAlloc;
+			memcpyBasic(reader->frames, &(trailer[BITSTREAM_RESERVED_NAL_BYTES + sizeof(bitstreamIndexHeader)]), header->frameCount * sizeof(bitstreamFrameEntry));
+			reader->frameCount = header->frameCount;
+			reader->maxFrameBytes = header->maxFrameBytes;
+			reader->unitsInTick = header->unitsInTick;
+			reader->timeScale = header->timeScale;
+			reader->chainBytes = trailerOffset;
+			
+			bitstreamFrameEntry* last = &(reader->frames[reader->frameCount - 1]);
+			if ((reader->frames[0].offset != 0) || ((last->offset + BITSTREAM_RESERVED_NAL_BYTES + last->bytes) != trailerOffset)) {
+				error = ERROR_BITSTREAM_INDEX_INVALID;
+			}
+		}
+	}
+	else {
+		error = ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	memAlloc = trailer;
+	memoryDeallocate(&memAlloc);
+	
+	if (error != 0) {
+		bitstreamIndexFree(reader);
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	return 0;
+}
+
+//Checksums and Checkpoint Journal
+#define BITSTREAM_CHECKSUM_PRIME 0x9E3779B97F4A7C15
+
+void bitstreamChecksumReset(bitstreamChecksum* checksum) {
+	checksum->lanes[0] = 0x243F6A8885A308D3;
+	checksum->lanes[1] = 0x13198A2E03707344;
+	checksum->lanes[2] = 0xA4093822299F31D0;
+	checksum->lanes[3] = 0x082EFA98EC4E6C89;
+	checksum->bytes = 0;
+	checksum->pendingBytes = 0;
+}
+
+//32 bytes per step (lanes kept in locals so they stay in registers)
+static void bitstreamChecksumSteps(uint64_t* lanes, uint8_t* data, uint64_t steps) {
+	uint64_t lane0 = lanes[0];
+	uint64_t lane1 = lanes[1];
+	uint64_t lane2 = lanes[2];
+	uint64_t lane3 = lanes[3];
+	uint64_t* words = (uint64_t*) data;
+	for (uint64_t s = 0; s < steps; s++) {
+		lane0 = (lane0 ^ words[0]) * BITSTREAM_CHECKSUM_PRIME;
+		lane1 = (lane1 ^ words[1]) * BITSTREAM_CHECKSUM_PRIME;
+		lane2 = (lane2 ^ words[2]) * BITSTREAM_CHECKSUM_PRIME;
+		lane3 = (lane3 ^ words[3]) * BITSTREAM_CHECKSUM_PRIME;
+		lane0 = (lane0 << 29) | (lane0 >> 35);
+		lane1 = (lane1 << 29) | (lane1 >> 35);
+		lane2 = (lane2 << 29) | (lane2 >> 35);
+		lane3 = (lane3 << 29) | (lane3 >> 35);
+		words += 4;
+	}
+	lanes[0] = lane0;
+	lanes[1] = lane1;
+	lanes[2] = lane2;
+	lanes[3] = lane3;
+}
+
+void bitstreamChecksumAdd(bitstreamChecksum* checksum, uint8_t* data, uint64_t numBytes) {
+	checksum->bytes += numBytes;
+	if (checksum->pendingBytes > 0) {
+		uint64_t fillBytes = 32 - checksum->pendingBytes;
+		if (fillBytes > numBytes) {
+			fillBytes = numBytes;
+		}
+		memcpyBasic(&(checksum->pending[checksum->pendingBytes]), data, fillBytes);
+		checksum->pendingBytes += fillBytes;
+		data += fillBytes;
+		numBytes -= fillBytes;
+		if (checksum->pendingBytes < 32) {
+			return;
+		}
+		bitstreamChecksumSteps(checksum->lanes, checksum->pending, 1);
+		checksum->pendingBytes = 0;
+	}
+	uint64_t steps = numBytes >> 5;
+	bitstreamChecksumSteps(checksum->lanes, data, steps);
+	checksum->pendingBytes = numBytes & 31;
+	memcpyBasic(checksum->pending, &(data[steps << 5]), checksum->pendingBytes);
+}
+
+//The last partial step goes into the first lane a byte at a time
+uint64_t bitstreamChecksumFinish(bitstreamChecksum* checksum) {
+	for (uint64_t i = 0; i < checksum->pendingBytes; i++) {
+		uint64_t lane = (checksum->lanes[0] ^ checksum->pending[i]) * BITSTREAM_CHECKSUM_PRIME;
+		checksum->lanes[0] = (lane << 29) | (lane >> 35);
+	}
+	checksum->pendingBytes = 0;
+	uint64_t result = checksum->bytes;
+	for (uint64_t l = 0; l < 4; l++) {
+		result = ((result ^ checksum->lanes[l]) * BITSTREAM_CHECKSUM_PRIME);
+		result ^= result >> 31;
+	}
+	return result;
+}
+
+uint64_t bitstreamChecksumData(uint8_t* data, uint64_t numBytes) {
+	bitstreamChecksum checksum;
+	bitstreamChecksumReset(&checksum);
+	bitstreamChecksumAdd(&checksum, data, numBytes);
+	return bitstreamChecksumFinish(&checksum);
+}
+
+uint64_t bitstreamChecksumFold(uint64_t chainChecksum, uint64_t segmentChecksum) {
+	uint64_t checksum = (chainChecksum ^ segmentChecksum) * BITSTREAM_CHECKSUM_PRIME;
+	return (checksum << 29) | (checksum >> 35);
+}
+
+uint64_t bitstreamChecksumChain(uint8_t* chain, uint64_t chainBytes, uint64_t frameCount) {
+	uint32_t startFlags = BITSTREAM_FRAME_RANDOM_ACCESS | BITSTREAM_FRAME_PARAMETER_SETS;
+	uint64_t checksum = 0;
+	uint64_t segmentOffset = 0;
+	uint64_t offset = 0;
+	for (uint64_t f = 0; f < frameCount; f++) {
+		if ((chainBytes - offset) < BITSTREAM_RESERVED_NAL_BYTES) {
+			return 0;
+		}
+		uint64_t accessUnitBytes = *((uint32_t*) (&(chain[offset + 6])));
+		if (accessUnitBytes > (chainBytes - offset - BITSTREAM_RESERVED_NAL_BYTES)) {
+			return 0;
+		}
+		uint64_t classifyBytes = accessUnitBytes;
+		if (classifyBytes > BITSTREAM_CLASSIFY_BYTES) {
+			classifyBytes = BITSTREAM_CLASSIFY_BYTES;
+		}
+		if ((f > 0) && ((bitstreamClassifyAccessUnit(&(chain[offset + BITSTREAM_RESERVED_NAL_BYTES]), classifyBytes) & startFlags) == startFlags)) {
+			checksum = bitstreamChecksumFold(checksum, bitstreamChecksumData(&(chain[segmentOffset]), offset - segmentOffset));
+			segmentOffset = offset;
+		}
+		offset += BITSTREAM_RESERVED_NAL_BYTES + accessUnitBytes;
+	}
+	if (frameCount > 0) {
+		checksum = bitstreamChecksumFold(checksum, bitstreamChecksumData(&(chain[segmentOffset]), offset - segmentOffset));
+	}
+	return checksum;
+}
+
+int bitstreamCheckpointSetup(bitstreamCheckpoint* checkpoint, char* fileName, uint64_t segmentInterval, uint64_t asyncOperation) {
+	checkpoint->journal = NULL;
+	checkpoint->segmentInterval = segmentInterval;
+	checkpoint->asyncOperation = asyncOperation;
+	checkpoint->step = BITSTREAM_CHECKPOINT_IDLE;
+	bitstreamChecksumReset(&(checkpoint->segment));
+	checkpoint->chainChecksum = 0;
+	checkpoint->chainBytes = 0;
+	checkpoint->frameCount = 0;
+	checkpoint->segments = 0;
+	checkpoint->recordCount = 0;
+	checkpoint->skipped = 0;
+	checkpoint->startTime = 0;
+	checkpoint->durationSum = 0;
+	checkpoint->durationMax = 0;
+	if (segmentInterval == 0) {
+		return 0;
+	}
+	
+	char journalName[BITSTREAM_FILE_NAME_MAX];
+	int error = bitstreamSideFileName(journalName, fileName, ".ckpt");
+	RETURN_ON_ERROR(error);
+	return ioOpenFile(&(checkpoint->journal), journalName, -1, IO_FILE_WRITE_ASYNC);
+}
+
+//A checkpoint gets started at the first IDR segment end after segmentInterval segments
+//(the one before has to be done, otherwise the next segment end tries again)
+void bitstreamCheckpointAdd(bitstreamCheckpoint* checkpoint, uint8_t* reservedNAL, uint8_t* accessUnit, uint64_t accessUnitBytes) {
+	if (checkpoint->journal == NULL) {
+		return;
+	}
+	uint32_t startFlags = BITSTREAM_FRAME_RANDOM_ACCESS | BITSTREAM_FRAME_PARAMETER_SETS;
+	uint64_t classifyBytes = accessUnitBytes;
+	if (classifyBytes > BITSTREAM_CLASSIFY_BYTES) {
+		classifyBytes = BITSTREAM_CLASSIFY_BYTES;
+	}
+	if ((checkpoint->frameCount > 0) && ((bitstreamClassifyAccessUnit(accessUnit, classifyBytes) & startFlags) == startFlags)) {
+		checkpoint->chainChecksum = bitstreamChecksumFold(checkpoint->chainChecksum, bitstreamChecksumFinish(&(checkpoint->segment)));
+		bitstreamChecksumReset(&(checkpoint->segment));
+		checkpoint->segments++;
+		if (checkpoint->segments >= checkpoint->segmentInterval) {
+			if (checkpoint->step == BITSTREAM_CHECKPOINT_IDLE) {
+				checkpoint->pending.magic = BITSTREAM_CHECKPOINT_MAGIC;
+				checkpoint->pending.chainBytes = checkpoint->chainBytes;
+				checkpoint->pending.frameCount = checkpoint->frameCount;
+				checkpoint->pending.checksum = checkpoint->chainChecksum;
+				checkpoint->step = BITSTREAM_CHECKPOINT_WAIT_WRITES;
+				checkpoint->segments = 0;
+				checkpoint->startTime = getCurrentTime();
+			}
+			else {
+				checkpoint->skipped++;
+			}
+		}
+	}
+	bitstreamChecksumAdd(&(checkpoint->segment), reservedNAL, BITSTREAM_RESERVED_NAL_BYTES);
+	bitstreamChecksumAdd(&(checkpoint->segment), accessUnit, accessUnitBytes);
+	checkpoint->chainBytes += BITSTREAM_RESERVED_NAL_BYTES + accessUnitBytes;
+	checkpoint->frameCount++;
+}
+
+//Takes as many steps as have finished (or waits for each one)
+static int bitstreamCheckpointSteps(bitstreamCheckpoint* checkpoint, void* bitstreamFile, uint64_t writtenBytes, uint64_t wait) {
+	int error = 0;
+	while (checkpoint->step != BITSTREAM_CHECKPOINT_IDLE) {
+		if (checkpoint->step == BITSTREAM_CHECKPOINT_WAIT_WRITES) {
+			if (writtenBytes < checkpoint->pending.chainBytes) {
+				return 0;
+			}
+			error = ioAsyncSyncFile(bitstreamFile, checkpoint->asyncOperation);
+			RETURN_ON_ERROR(error);
+			checkpoint->step = BITSTREAM_CHECKPOINT_SYNC_DATA;
+			continue;
+		}
+		
+		uint64_t signaled = 1;
+		if (wait > 0) {
+			error = ioAsyncSignalWait(checkpoint->asyncOperation);
+		}
+		else {
+			error = ioAsyncSignalCheck(checkpoint->asyncOperation, &signaled);
+		}
+		RETURN_ON_ERROR(error);
+		if (signaled == 0) {
+			return 0;
+		}
+		if (checkpoint->step == BITSTREAM_CHECKPOINT_SYNC_DATA) {
+			checkpoint->record = checkpoint->pending;
+			uint64_t recordOffset = checkpoint->recordCount * sizeof(bitstreamCheckpointRecord);
+			error = ioAsyncWriteFile(checkpoint->journal, &(checkpoint->record), sizeof(bitstreamCheckpointRecord), checkpoint->asyncOperation, recordOffset);
+			RETURN_ON_ERROR(error);
+			checkpoint->step = BITSTREAM_CHECKPOINT_WRITE_RECORD;
+		}
+		else if (checkpoint->step == BITSTREAM_CHECKPOINT_WRITE_RECORD) {
+			error = ioAsyncSyncFile(checkpoint->journal, checkpoint->asyncOperation);
+			RETURN_ON_ERROR(error);
+			checkpoint->step = BITSTREAM_CHECKPOINT_SYNC_RECORD;
+		}
+		else {
+			uint64_t duration = getDiffTimeMicroseconds(checkpoint->startTime, getCurrentTime());
+			checkpoint->durationSum += duration;
+			if (duration > checkpoint->durationMax) {
+				checkpoint->durationMax = duration;
+			}
+			checkpoint->recordCount++;
+			checkpoint->step = BITSTREAM_CHECKPOINT_IDLE;
+		}
+	}
+	return 0;
+}
+
+int bitstreamCheckpointUpdate(bitstreamCheckpoint* checkpoint, void* bitstreamFile, uint64_t writtenBytes) {
+	if (checkpoint->step == BITSTREAM_CHECKPOINT_IDLE) {
+		return 0;
+	}
+	return bitstreamCheckpointSteps(checkpoint, bitstreamFile, writtenBytes, 0);
+}
+
+int bitstreamCheckpointFinish(bitstreamCheckpoint* checkpoint, void* bitstreamFile, uint64_t writtenBytes) {
+	if (checkpoint->journal == NULL) {
+		return 0;
+	}
+	int error = bitstreamCheckpointSteps(checkpoint, bitstreamFile, writtenBytes, 1);
+	int closeError = ioCloseFile(&(checkpoint->journal));
+	checkpoint->journal = NULL;
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+//Only the last record can be torn (records never cross a sector) so this looks back from the end
+int bitstreamCheckpointLoad(char* fileName, bitstreamCheckpointRecord* record, uint64_t* recordCount) {
+	*recordCount = 0;
+	char journalName[BITSTREAM_FILE_NAME_MAX];
+	int error = bitstreamSideFileName(journalName, fileName, ".ckpt");
+	RETURN_ON_ERROR(error);
+	void* journal = NULL;
+	if (ioOpenFile(&journal, journalName, -1, IO_FILE_READ_NORMAL) != 0) {
+		return 0; //No journal (checkpoints were off or the recorder is older)
+	}
+	uint64_t journalBytes = 0;
+	error = ioGetFileSize(journal, &journalBytes);
+	uint64_t count = journalBytes / sizeof(bitstreamCheckpointRecord);
+	while ((error == 0) && (count > 0)) {
+		uint32_t readBytes = sizeof(bitstreamCheckpointRecord);
+		error = ioReadFileOffset(journal, record, &readBytes, (count - 1) * sizeof(bitstreamCheckpointRecord));
+		if ((error == 0) && (readBytes == sizeof(bitstreamCheckpointRecord)) && (record->magic == BITSTREAM_CHECKPOINT_MAGIC)) {
+			*recordCount = count;
+			break;
+		}
+		count--;
+	}
+	int closeError = ioCloseFile(&journal);
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+int bitstreamReaderIndex(bitstreamReader* reader, uint32_t unitsInTick, uint32_t timeScale, uint64_t* indexSource) {
+	*indexSource = BITSTREAM_INDEX_SEEK_TABLE;
+	int error = bitstreamSeekTableLoad(reader);
+	if (error == 0) {
+		return 0;
+	}
+	
+	*indexSource = BITSTREAM_INDEX_LOADED;
+	error = bitstreamIndexLoad(reader, unitsInTick, timeScale);
+	if (error == 0) {
+		return 0;
+	}
+	
+	*indexSource = BITSTREAM_INDEX_BUILT;
+	error = bitstreamIndexBuild(reader, unitsInTick, timeScale);
+	RETURN_ON_ERROR(error);
+	bitstreamIndexSave(reader); //A read only folder only costs the next open a rebuild
+	return 0;
+}
+
+int bitstreamReaderReadFrame(bitstreamReader* reader, uint64_t frame, void* buffer, uint64_t bufferBytes, uint64_t* frameBytes) {
+	if (frame >= reader->frameCount) {
+		return ERROR_BITSTREAM_FRAME_RANGE;
+	}
+	bitstreamFrameEntry* entry = &(reader->frames[frame]);
+	*frameBytes = entry->bytes;
+	if (entry->bytes > bufferBytes) {
+		return ERROR_BITSTREAM_BUFFER_TOO_SMALL;
+	}
+	return bitstreamReaderRead(reader, entry->offset + BITSTREAM_RESERVED_NAL_BYTES, buffer, entry->bytes);
+}
+
+int bitstreamReaderViewFrame(bitstreamReader* reader, uint64_t frame, uint8_t** view, uint64_t* frameBytes) {
+	if (frame >= reader->frameCount) {
+		return ERROR_BITSTREAM_FRAME_RANGE;
+	}
+	bitstreamFrameEntry* entry = &(reader->frames[frame]);
+	*frameBytes = entry->bytes;
+	return bitstreamReaderView(reader, entry->offset + BITSTREAM_RESERVED_NAL_BYTES, entry->bytes, view);
+}
+
+//Skips ahead 3 bytes whenever the third byte can not end a start code
+uint64_t bitstreamPeekNal(uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t* position, bitstreamNalView* nal) {
+	uint64_t i = *position;
+	while ((i + 4) < accessUnitBytes) { //Start code and a 2 byte NAL unit header
+		if (accessUnit[i + 2] > 1) {
+			i += 3;
+		}
+		else if ((accessUnit[i + 2] == 1) && (accessUnit[i + 1] == 0) && (accessUnit[i] == 0)) {
+			break;
+		}
+		else {
+			i++;
+		}
+	}
+	if ((i + 4) >= accessUnitBytes) {
+		*position = accessUnitBytes;
+		return 0;
+	}
+	*position = i;
+	nal->data = &(accessUnit[i + 3]);
+	nal->bytes = accessUnitBytes - (i + 3);
+	nal->type = (accessUnit[i + 3] >> 1) & 0x3F;
+	return 1;
+}
+
+uint64_t bitstreamNextNal(uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t* position, bitstreamNalView* nal) {
+	if (bitstreamPeekNal(accessUnit, accessUnitBytes, position, nal) == 0) {
+		return 0;
+	}
+	uint64_t start = (*position) + 3;
+	uint64_t i = start + 2;
+	uint64_t end = accessUnitBytes;
+	while ((i + 2) < accessUnitBytes) {
+		if (accessUnit[i + 2] > 1) {
+			i += 3;
+		}
+		else if ((accessUnit[i + 2] == 1) && (accessUnit[i + 1] == 0) && (accessUnit[i] == 0)) {
+			end = i;
+			break;
+		}
+		else {
+			i++;
+		}
+	}
+	*position = end;
+	while ((end > (start + 2)) && (accessUnit[end - 1] == 0)) { //Zero byte of a 4 byte start code or trailing zeros
+		end--;
+	}
+	
+	nal->data = &(accessUnit[start]);
+	nal->bytes = end - start;
+	nal->type = (accessUnit[start] >> 1) & 0x3F;
+	return 1;
+}
+
+uint64_t bitstreamReaderFindRandomAccess(bitstreamReader* reader, uint64_t frame) {
+	if (reader->frameCount == 0) {
+		return 0;
+	}
+	if (frame >= reader->frameCount) {
+		frame = reader->frameCount - 1;
+	}
+	uint32_t startFlags = BITSTREAM_FRAME_RANDOM_ACCESS | BITSTREAM_FRAME_PARAMETER_SETS;
+	while ((frame > 0) && ((reader->frames[frame].flags & startFlags) != startFlags)) {
+		frame--;
+	}
+	return frame;
+}
+
+void bitstreamReaderClose(bitstreamReader* reader) {
+	bitstreamIndexFree(reader);
+	if (reader->window != NULL) {
+		ioUnmapFile((void**) &(reader->window), reader->windowBytes);
+	}
+	if (reader->bounce != NULL) {
+		memoryDeallocate((void**) &(reader->bounce));
+	}
+	if (reader->file != NULL) {
+		ioCloseFile(&(reader->file));
+	}
+}
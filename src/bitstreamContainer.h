@@ -0,0 +1,278 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+//Media Enhanced Bitstream Container Definitions
+//The recorder writes every access unit behind a 10 byte reserved NAL unit
+//(start code, NAL header 0x54 0x01 for type 42, then the access unit size as a
+//little endian uint32) so a bitstream file is a chain of size prefixed frames
+//The frame index of that chain gets kept in a sidecar file next to the
+//bitstream (bitstream.h265 -> bitstream.h265.idx) so any frame can be found
+//and read without walking the file again
+//The recorder can also end the file with a seek table trailer: one more
+//reserved NAL whose payload holds the frame index (with emulation prevention
+//bytes so decoders never see a start code in it) and a 16 byte footer at the
+//very end pointing back to that reserved NAL
+//Frames and NAL units can also be viewed in place through a memory mapped
+//window that slides over the file, so captures of any size get processed
+//without truncation or copies
+//While recording, a checkpoint journal next to the bitstream (.ckpt) gets a
+//record every few IDR segments once everything before it is flushed to disk
+#ifndef MEDIA_ENHANCED_BITSTREAM_CONTAINER_H
+#define MEDIA_ENHANCED_BITSTREAM_CONTAINER_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+#define BITSTREAM_RESERVED_NAL_BYTES 10
+#define BITSTREAM_RESERVED_NAL_MASK 0xFFFFFFFFFFFF //First 6 bytes read as a little endian uint64
+#define BITSTREAM_RESERVED_NAL_START 0x015401000000
+#define BITSTREAM_RESERVED_NAL_TYPE 42
+
+#define ERROR_BITSTREAM_BROKEN_CHAIN 0x5120 //A size prefix does not land on the next reserved NAL or the file end
+#define ERROR_BITSTREAM_INDEX_INVALID 0x5121 //Sidecar does not belong to this bitstream file (rebuild it)
+#define ERROR_BITSTREAM_FRAME_RANGE 0x5122
+#define ERROR_BITSTREAM_BUFFER_TOO_SMALL 0x5123
+
+//Frame Flags (from the NAL units at the start of the access unit)
+#define BITSTREAM_FRAME_IDR 1 //Slices are IDR pictures
+#define BITSTREAM_FRAME_RANDOM_ACCESS 2 //Slices are IRAP pictures (IDR, CRA or BLA)
+#define BITSTREAM_FRAME_PARAMETER_SETS 4 //Access unit starts with its own VPS / SPS / PPS
+
+typedef struct bitstreamFrameEntry {
+	uint64_t offset; //Where the frame's reserved NAL starts in the bitstream file
+	uint32_t bytes; //Access unit bytes that follow the reserved NAL
+	uint32_t flags;
+	uint64_t presentationTime; //Microseconds after the first frame
+} bitstreamFrameEntry;
+
+//Sidecar Index File: this header followed by frameCount entries
+#define BITSTREAM_INDEX_MAGIC 0x3158444E4952534C //"LSRINDX1" as little endian bytes
+#define BITSTREAM_INDEX_FORMAT_VERSION 1
+#define BITSTREAM_FILE_NAME_MAX 512
+
+typedef struct bitstreamIndexHeader {
+	uint64_t magic;
+	uint32_t formatVersion;
+	uint32_t entryBytes;
+	uint64_t frameCount;
+	uint64_t containerBytes; //Size of the bitstream file the index describes
+	uint64_t maxFrameBytes;
+	uint32_t unitsInTick; //Every frame lasts unitsInTick / timeScale seconds
+	uint32_t timeScale;
+	uint64_t padding[2];
+} bitstreamIndexHeader;
+
+//Seek Table Trailer: reserved NAL + escaped (header + entries) + footer
+//The header uses the sidecar layout with containerBytes as the trailer offset
+#define BITSTREAM_SEEK_TABLE_MAGIC 0x314B45455352534C //"LSRSEEK1" as little endian bytes (never starts an access unit)
+#define BITSTREAM_SEEK_FOOTER_MAGIC 0x31544F4F4652534C //"LSRFOOT1"
+#define BITSTREAM_SEEK_FOOTER_BYTES 16 //Trailer offset in 8 x 7 bits (high bit set so no zero bytes) + magic
+
+typedef struct bitstreamSeekTable {
+	bitstreamFrameEntry* frames; //Preallocated for frameCapacity frames
+	uint64_t frameCapacity;
+	uint64_t frameCount;
+	uint64_t maxFrameBytes;
+	uint64_t overflow; //More frames were written than fit (no trailer gets written)
+	uint32_t unitsInTick;
+	uint32_t timeScale;
+	uint8_t* trailer; //Preallocated for the largest trailer
+	uint64_t trailerCapacity;
+} bitstreamSeekTable;
+
+//Allocates everything up front (and touches the entries) so adding frames never allocates or page faults
+int bitstreamSeekTableSetup(bitstreamSeekTable* table, uint64_t frameCapacity, uint32_t unitsInTick, uint32_t timeScale);
+void bitstreamSeekTableReset(bitstreamSeekTable* table);
+//Called when a frame's write gets issued (peeks at the start of the access unit for the flags)
+void bitstreamSeekTableAdd(bitstreamSeekTable* table, uint64_t offset, uint8_t* accessUnit, uint64_t accessUnitBytes);
+//Fills table->trailer for a write at chainBytes (the offset after the last frame)
+//Returns the trailer bytes or 0 when the frames did not all fit
+uint64_t bitstreamSeekTableFinish(bitstreamSeekTable* table, uint64_t chainBytes);
+void bitstreamSeekTableCleanup(bitstreamSeekTable* table);
+
+//Sidecar names are the bitstream file name with an extension added (sideName holds BITSTREAM_FILE_NAME_MAX bytes)
+int bitstreamSideFileName(char* sideName, char* fileName, char* extension);
+
+//Buffered Text Output (the stats, latency and trace reports): puts gather in the caller's buffer
+//and go out in one write once flushBytes are waiting, so the buffer needs room past flushBytes
+//for the longest single put
+typedef struct bitstreamTextWriter {
+	void* file;
+	char* buffer;
+	uint64_t bytes;
+	uint64_t flushBytes;
+} bitstreamTextWriter;
+
+int bitstreamTextOpen(bitstreamTextWriter* writer, char* fileName, char* buffer, uint64_t flushBytes);
+int bitstreamTextFlush(bitstreamTextWriter* writer);
+int bitstreamTextPut(bitstreamTextWriter* writer, char* text);
+int bitstreamTextPutNumber(bitstreamTextWriter* writer, uint64_t number);
+//Flushes (unless error is set already) and closes, returning the first error
+int bitstreamTextClose(bitstreamTextWriter* writer, int error);
+
+//Checksums: four multiply & rotate lanes over the bytes of each IDR segment (split like
+//bitstreamSegmentsFind), folded in segment order into one checksum for the whole chain
+//(the color LUT cache files use bitstreamChecksumData over the table as well)
+typedef struct bitstreamChecksum {
+	uint64_t lanes[4];
+	uint64_t bytes;
+	uint8_t pending[32]; //Bytes that do not fill a whole step yet (added in pieces)
+	uint64_t pendingBytes;
+} bitstreamChecksum;
+
+void bitstreamChecksumReset(bitstreamChecksum* checksum);
+void bitstreamChecksumAdd(bitstreamChecksum* checksum, uint8_t* data, uint64_t numBytes);
+uint64_t bitstreamChecksumFinish(bitstreamChecksum* checksum);
+uint64_t bitstreamChecksumData(uint8_t* data, uint64_t numBytes); //Reset, Add and Finish in one go
+uint64_t bitstreamChecksumFold(uint64_t chainChecksum, uint64_t segmentChecksum);
+
+//Checkpoint Journal: 32 byte records appended to the bitstream file name with ".ckpt" added
+//A record only gets written after the bitstream file is flushed up to its chainBytes
+//and the journal gets flushed after every record
+#define BITSTREAM_CHECKPOINT_MAGIC 0x3154504B4352534C //"LSRCKPT1" as little endian bytes
+
+typedef struct bitstreamCheckpointRecord {
+	uint64_t magic;
+	uint64_t chainBytes; //Durable frames end here (right before an IDR segment)
+	uint64_t frameCount;
+	uint64_t checksum; //Folded segment checksums of those frames
+} bitstreamCheckpointRecord;
+
+//Checkpoint Steps (each one is a single asynchronous operation)
+#define BITSTREAM_CHECKPOINT_IDLE 0
+#define BITSTREAM_CHECKPOINT_WAIT_WRITES 1 //Frame writes before chainBytes still in flight
+#define BITSTREAM_CHECKPOINT_SYNC_DATA 2
+#define BITSTREAM_CHECKPOINT_WRITE_RECORD 3
+#define BITSTREAM_CHECKPOINT_SYNC_RECORD 4
+
+typedef struct bitstreamCheckpoint {
+	void* journal;
+	uint64_t segmentInterval; //IDR segments between checkpoints (0 turns them off)
+	uint64_t asyncOperation; //Used by every step so it needs to be outside the output ring
+	uint64_t step;
+	bitstreamChecksum segment; //Checksum of the segment being added
+	uint64_t chainChecksum;
+	uint64_t chainBytes;
+	uint64_t frameCount;
+	uint64_t segments; //Finished segments since the last checkpoint got started
+	bitstreamCheckpointRecord pending; //Checkpoint going through the steps
+	bitstreamCheckpointRecord record; //Journal write buffer (untouched until the write completes)
+	uint64_t recordCount; //Durable records
+	uint64_t skipped; //Segment ends that found the last checkpoint still in flight
+	uint64_t startTime;
+	uint64_t durationSum; //Time from the checkpoint being started to its record being flushed
+	uint64_t durationMax;
+} bitstreamCheckpoint;
+
+//Opens (and empties) the journal for the bitstream file
+int bitstreamCheckpointSetup(bitstreamCheckpoint* checkpoint, char* fileName, uint64_t segmentInterval, uint64_t asyncOperation);
+//Called when a frame's write gets issued (after bitstreamSeekTableAdd) with the same reserved NAL and access unit
+void bitstreamCheckpointAdd(bitstreamCheckpoint* checkpoint, uint8_t* reservedNAL, uint8_t* accessUnit, uint64_t accessUnitBytes);
+//Moves the checkpoint through its steps without blocking (writtenBytes: where the completed frame writes end)
+int bitstreamCheckpointUpdate(bitstreamCheckpoint* checkpoint, void* bitstreamFile, uint64_t writtenBytes);
+//Waits for the checkpoint in flight (every frame write has to be complete) and closes the journal
+int bitstreamCheckpointFinish(bitstreamCheckpoint* checkpoint, void* bitstreamFile, uint64_t writtenBytes);
+//Last complete record of the bitstream file's journal (recordCount 0 when there is none)
+int bitstreamCheckpointLoad(char* fileName, bitstreamCheckpointRecord* record, uint64_t* recordCount);
+//Folded segment checksums of the first frameCount frames of a mapped chain (0 when the chain ends first)
+uint64_t bitstreamChecksumChain(uint8_t* chain, uint64_t chainBytes, uint64_t frameCount);
+
+//Flags of an access unit from the NAL units before its first slice
+#define BITSTREAM_CLASSIFY_BYTES 512 //Enough for the parameter sets and the first slice NAL header
+uint32_t bitstreamClassifyAccessUnit(uint8_t* data, uint64_t dataBytes);
+
+//Memory Mapped Views
+#define BITSTREAM_WINDOW_BYTES 1073741824 //Part of the file mapped at once (grows for a bigger view)
+#define BITSTREAM_VIEW_PADDING_BYTES 16 //Always readable after a view (the bit readers look a few bytes past the end)
+
+typedef struct bitstreamReader {
+	void* file;
+	char* fileName;
+	uint64_t fileBytes;
+	uint64_t chainBytes; //Where the frames end (a seek table trailer can follow)
+	uint64_t truncatedBytes; //Partial frame left after the last complete one by a cut off recording
+	uint8_t* window; //NULL until the first view
+	uint64_t windowOffset;
+	uint64_t windowBytes;
+	uint8_t* bounce; //Padded copy for a view that ends right at the end of the last mapped page
+	uint64_t bounceBytes;
+	bitstreamFrameEntry* frames; //NULL until the index gets loaded or built
+	uint64_t frameCount;
+	uint64_t maxFrameBytes; //Largest access unit (enough buffer for any frame)
+	uint32_t unitsInTick;
+	uint32_t timeScale;
+} bitstreamReader;
+
+int bitstreamReaderOpen(bitstreamReader* reader, char* fileName);
+
+//Reads exactly numBytes at the file offset (no index needed)
+int bitstreamReaderRead(bitstreamReader* reader, uint64_t offset, void* buffer, uint64_t numBytes);
+
+//Read only pointer to numBytes at the file offset without copying (no index needed)
+//Stays valid until the next view or bitstreamReaderClose
+int bitstreamReaderView(bitstreamReader* reader, uint64_t offset, uint64_t numBytes, uint8_t** view);
+
+//Maps the whole file as the window so any thread can reach any frame with pointer math
+//(no view padding: readers have to stay within the frame bytes) until bitstreamReaderClose
+int bitstreamReaderMapAll(bitstreamReader* reader, uint8_t** data);
+
+//Uses the seek table trailer when the file has one (its timing wins), otherwise
+//loads the sidecar index when it matches the file (size and frame timing) or
+//walks the reserved NAL chain to build it and then saves the sidecar
+#define BITSTREAM_INDEX_LOADED 0
+#define BITSTREAM_INDEX_BUILT 1
+#define BITSTREAM_INDEX_SEEK_TABLE 2
+int bitstreamReaderIndex(bitstreamReader* reader, uint32_t unitsInTick, uint32_t timeScale, uint64_t* indexSource);
+
+//A partial frame at the end of the file (crash, power loss, full disk) ends the walk instead of failing it:
+//the frames before it get indexed and truncatedBytes tells how much is left over (BitstreamSplice repair cuts it)
+int bitstreamIndexBuild(bitstreamReader* reader, uint32_t unitsInTick, uint32_t timeScale);
+int bitstreamIndexLoad(bitstreamReader* reader, uint32_t unitsInTick, uint32_t timeScale);
+int bitstreamIndexSave(bitstreamReader* reader);
+int bitstreamSeekTableLoad(bitstreamReader* reader);
+
+//One positioned read of the access unit (without its reserved NAL) using the index
+int bitstreamReaderReadFrame(bitstreamReader* reader, uint64_t frame, void* buffer, uint64_t bufferBytes, uint64_t* frameBytes);
+
+//Same as bitstreamReaderReadFrame but through a view instead of a copy
+int bitstreamReaderViewFrame(bitstreamReader* reader, uint64_t frame, uint8_t** view, uint64_t* frameBytes);
+
+//NAL Unit Views inside an access unit (start codes split them)
+typedef struct bitstreamNalView {
+	uint8_t* data; //NAL unit header onward (still escaped)
+	uint64_t bytes;
+	uint32_t type;
+} bitstreamNalView;
+
+//Finds the NAL unit after *position and moves *position past it
+//Returns 0 once the access unit has no more NAL units
+uint64_t bitstreamNextNal(uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t* position, bitstreamNalView* nal);
+//Finds the next NAL unit without looking for its end (bytes runs to the end of the access unit)
+//and leaves *position at its start code, so a slice header can be read without scanning the slice data
+uint64_t bitstreamPeekNal(uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t* position, bitstreamNalView* nal);
+
+//Closest frame at or before the given one that can start decoding (random access with parameter sets)
+uint64_t bitstreamReaderFindRandomAccess(bitstreamReader* reader, uint64_t frame);
+
+void bitstreamReaderClose(bitstreamReader* reader);
+
+#endif
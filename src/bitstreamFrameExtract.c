@@ -33,176 +33,21 @@
 
 #define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
 #include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "bitstreamContainer.h" //Reserved NAL chain index and frame reader
+#include "hevcHeaders.h" //Word at a time RBSP reader and the short header parsers
+#include "bitstreamStats.h" //Whole file slice header statistics
+#include "bitstreamSegments.h" //IDR segment thread pool with in order commits
+#ifdef COMPATIBILITY_GRAPHICS_UNNEEDED //Offline (Linux) builds only parse the bitstream
+#include <stddef.h> //NULL definition also normally included by Vulkan
+#include "include/vulkan/vk_video/vulkan_video_codec_h265std.h" //Normally included by Vulkan
+#endif
 
-static uint64_t bitstreamGetValueAndAdvance(uint8_t** bitstreamPtr, uint64_t valueBytes, uint64_t advanceBytes) {
-	uint64_t value = 0;
-	uint8_t* bitstreamBytes = *bitstreamPtr;
-	
-	for (uint64_t i=0; i<valueBytes; i++) {
-		if (*(bitstreamBytes) == 0x03) {
-			if (*(bitstreamBytes - 1) == 0x00) {
-				if (*(bitstreamBytes - 2) == 0x00) {
-					bitstreamBytes++;
-				}
-			}
-		}
-		
-		value <<= 8;
-		value |= (uint64_t) (*bitstreamBytes);
-		
-		bitstreamBytes++;
-	}
-	
-	for (uint64_t i=0; i<advanceBytes; i++) {
-		if (*(bitstreamBytes) == 0x03) {
-			if (*(bitstreamBytes - 1) == 0x00) {
-				if (*(bitstreamBytes - 2) == 0x00) {
-					bitstreamBytes++;
-				}
-			}
-		}
-		
-		bitstreamBytes++;
-	}
-	
-	*bitstreamPtr = bitstreamBytes;
-	return value;
-}
-
-static uint64_t bitstreamGetBitValue(uint8_t** bitstreamPtr, uint64_t* bitPtr, uint64_t numBits) {
-	uint64_t value = 0;
-	uint8_t* bitstreamBytes = *bitstreamPtr;
-	uint64_t bit = *bitPtr;
-	
-	if (bit == 0x80) { //Necessary?
-		if (*(bitstreamBytes) == 0x03) {
-			if (*(bitstreamBytes - 1) == 0x00) {
-				if (*(bitstreamBytes - 2) == 0x00) {
-					bitstreamBytes++;
-				}
-			}
-		}
-	}
-	
-	for (uint64_t i=0; i<numBits; i++) {
-		value <<= 1;
-		if (((*bitstreamBytes) & bit) > 0) {
-			value |= 1;
-		}
-		
-		if (bit > 1) {
-			bit >>= 1;
-		}
-		else {
-			bit = 0x80;
-			bitstreamBytes++;
-			if (*(bitstreamBytes) == 0x03) {
-				if (*(bitstreamBytes - 1) == 0x00) {
-					if (*(bitstreamBytes - 2) == 0x00) {
-						bitstreamBytes++;
-					}
-				}
-			}
-		}
-	}
-	
-	*bitPtr = bit;
-	*bitstreamPtr = bitstreamBytes;
-	return value;
-}
-
-static uint64_t bitstreamGetExpGolombUnsignedValue(uint8_t** bitstreamPtr, uint64_t* bitPtr) {
-	uint64_t value = 0;
-	uint8_t* bitstreamBytes = *bitstreamPtr;
-	uint64_t bit = *bitPtr;
-	
-	if (bit == 0x80) { //Necessary?
-		if (*(bitstreamBytes) == 0x03) {
-			if (*(bitstreamBytes - 1) == 0x00) {
-				if (*(bitstreamBytes - 2) == 0x00) {
-					bitstreamBytes++;
-				}
-			}
-		}
-	}
-	
-	uint64_t zeroCount = 0;
-	while (((*bitstreamBytes) & bit) == 0) {
-		zeroCount++;
-		
-		if (bit > 1) {
-			bit >>= 1;
-		}
-		else {
-			bit = 0x80;
-			bitstreamBytes++;
-			if (*(bitstreamBytes) == 0x03) {
-				if (*(bitstreamBytes - 1) == 0x00) {
-					if (*(bitstreamBytes - 2) == 0x00) {
-						bitstreamBytes++;
-					}
-				}
-			}
-		}
-	}
-	
-	if (bit > 1) {
-		bit >>= 1;
-	}
-	else {
-		bit = 0x80;
-		bitstreamBytes++;
-		if (*(bitstreamBytes) == 0x03) {
-			if (*(bitstreamBytes - 1) == 0x00) {
-				if (*(bitstreamBytes - 2) == 0x00) {
-					bitstreamBytes++;
-				}
-			}
-		}
-	}
-	
-	for (uint64_t i=0; i<zeroCount; i++) {
-		value <<= 1;
-		if (((*bitstreamBytes) & bit) > 0) {
-			value |= 1;
-		}
-		
-		if (bit > 1) {
-			bit >>= 1;
-		}
-		else {
-			bit = 0x80;
-			bitstreamBytes++;
-			if (*(bitstreamBytes) == 0x03) {
-				if (*(bitstreamBytes - 1) == 0x00) {
-					if (*(bitstreamBytes - 2) == 0x00) {
-						bitstreamBytes++;
-					}
-				}
-			}
-		}
-	}
-	
-	if (zeroCount > 0) {
-		value += (1 << zeroCount) - 1;
-	}	
-	
-	*bitPtr = bit;
-	*bitstreamPtr = bitstreamBytes;
-	return value;
-}
-
-static int64_t bitstreamGetExpGolombSignedValue(uint8_t** bitstreamPtr, uint64_t* bitPtr) {
-	int64_t value = (int64_t) bitstreamGetExpGolombUnsignedValue(bitstreamPtr, bitPtr);
-	value++;
-	int64_t bit = value & 0x1;
-	value >>= 1;
-	if (bit == 1) {
-		value *= -1;
-	}	
-	
-	return value;
-}
+//Parameter sets get unescaped once into here (the recorder's are well under a kilobyte)
+#define EXTRACT_PARAMETER_SET_MAX_BYTES 65536
+static uint8_t parameterSetRBSP[EXTRACT_PARAMETER_SET_MAX_BYTES + HEVC_RBSP_EXTRA_BYTES];
+static uint8_t sliceHeaderRBSP[HEVC_SLICE_HEADER_BYTES + HEVC_RBSP_EXTRA_BYTES];
+static uint64_t extractISA = HEVC_ISA_SCALAR;
+static hevcParameterSets extractParameterSets;
 
 static StdVideoH265VideoParameterSet vps;
 static StdVideoH265ProfileTierLevel ptl;
@@ -214,22 +59,30 @@ static StdVideoH265ShortTermRefPicSet strps[1] = {}; //Set to zero...?
 static StdVideoH265SequenceParameterSetVui spsVui;
 static StdVideoH265PictureParameterSet pps;
 
-int readBitstreamParameters(uint8_t** memPtr) {
-	//VPS
-	uint8_t* bitstreamBytes = *memPtr;
-	uint64_t* startCodeCheck = (uint64_t*) bitstreamBytes;
-	if ((*startCodeCheck & 0xFFFFFFFFFFFF) != 0x014001000000) { //VPS
+//The next NAL unit has to be the given parameter set (the reader starts after its NAL unit header)
+static int readParameterSetStart(uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t* position, uint32_t nalType, rbspReader* rbsp) {
+	bitstreamNalView nal;
+	if ((bitstreamNextNal(accessUnit, accessUnitBytes, position, &nal) == 0) || (nal.type != nalType) || (nal.bytes > EXTRACT_PARAMETER_SET_MAX_BYTES)) {
 		return ERROR_PARSE_ISSUE;
 	}
-	bitstreamBytes += 6;
+	hevcReaderSetup(rbsp, parameterSetRBSP, nal.data, nal.bytes, nal.bytes, extractISA);
+	return 0;
+}
+
+//Parses the VPS, SPS and PPS at the start of the access unit and leaves position after the PPS
+int readBitstreamParameters(uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t* position) {
+	//VPS
+	rbspReader rbsp;
+	int error = readParameterSetStart(accessUnit, accessUnitBytes, position, HEVC_NAL_VPS, &rbsp);
+	RETURN_ON_ERROR(error);
 	
-	uint64_t u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 2, 2);
+	uint64_t u64 = rbspReadBytes(&rbsp, 2, 2);
 	vps.vps_video_parameter_set_id = (u64 >> 12) & 0xF;
 	vps.vps_max_sub_layers_minus1 = (u64 >> 1) & 0x7;
 	vps.flags.vps_temporal_id_nesting_flag = u64 & 0x1;
 	
 	//PTL always...?	
-	u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 8, 3);
+	u64 = rbspReadBytes(&rbsp, 8, 3);
 	ptl.flags.general_tier_flag = (u64 >> 61) & 0x1;
 	ptl.general_profile_idc = (u64 >> 56) & 0x1F;
 	ptl.flags.general_progressive_source_flag = (u64 >> 24) & 0x1;
@@ -237,20 +90,20 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	ptl.flags.general_non_packed_constraint_flag = (u64 >> 22) & 0x1;
 	ptl.flags.general_frame_only_constraint_flag = (u64 >> 21) & 0x1;
 	
-	u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 1, 0);
+	u64 = rbspReadBytes(&rbsp, 1, 0);
 	ptl.general_level_idc = u64 & 0xFF;
 	
 	if (vps.vps_max_sub_layers_minus1 > 0) {
-		u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 2, 0);
+		u64 = rbspReadBytes(&rbsp, 2, 0);
 		
 		uint8_t bitShift = 15;
 		for (uint8_t i=0; i<vps.vps_max_sub_layers_minus1; i++) {
 			if (((u64 >> bitShift) & 1) == 1) {
-				bitstreamGetValueAndAdvance(&bitstreamBytes, 0, 11);
+				rbspSkipBits(&rbsp, 88);
 			}
 			bitShift--;
 			if (((u64 >> bitShift) & 1) == 1) {
-				bitstreamGetValueAndAdvance(&bitstreamBytes, 0, 1);
+				rbspSkipBits(&rbsp, 8);
 			}
 			bitShift--;
 		}
@@ -261,8 +114,7 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	//consoleWriteLineWithNumberFast("Val: ", 5, ptl.general_level_idc, NUM_FORMAT_UNSIGNED_INTEGER);	
 	//consoleWriteLineWithNumberFast("Num: ", 5, *bitstreamBytes, NUM_FORMAT_PARTIAL_HEXADECIMAL);
 	
-	uint64_t bit = 0x80;
-	vps.flags.vps_sub_layer_ordering_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	vps.flags.vps_sub_layer_ordering_info_present_flag = rbspReadBits(&rbsp, 1);
 	
 	//decPicBuf
 	for (uint8_t i = (vps.flags.vps_sub_layer_ordering_info_present_flag ? 0 : vps.vps_max_sub_layers_minus1);
@@ -270,35 +122,35 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		
 		//consoleWriteLineWithNumberFast("Val: ", 5, vps.vps_max_sub_layers_minus1, NUM_FORMAT_UNSIGNED_INTEGER);
 		
-		decPicBuf.max_dec_pic_buffering_minus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		decPicBuf.max_num_reorder_pics[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		decPicBuf.max_latency_increase_plus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		decPicBuf.max_dec_pic_buffering_minus1[i] = rbspReadUnsigned(&rbsp);
+		decPicBuf.max_num_reorder_pics[i] = rbspReadUnsigned(&rbsp);
+		decPicBuf.max_latency_increase_plus1[i] = rbspReadUnsigned(&rbsp);
 	}
 	vps.pDecPicBufMgr = &decPicBuf;
 	
-	uint64_t t0 = bitstreamGetBitValue(&bitstreamBytes, &bit, 6); //vps_max_layer_id
+	uint64_t t0 = rbspReadBits(&rbsp, 6); //vps_max_layer_id
 	//consoleWriteLineWithNumberFast("Num: ", 5, *bitstreamBytes, NUM_FORMAT_PARTIAL_HEXADECIMAL);
 	//consoleWriteLineWithNumberFast("Bit: ", 5, bit, NUM_FORMAT_PARTIAL_HEXADECIMAL);
 	//consoleWriteLineWithNumberFast("Val: ", 5, t0, NUM_FORMAT_PARTIAL_HEXADECIMAL);
-	uint64_t t1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit); //vps_num_layer_sets_minus1
+	uint64_t t1 = rbspReadUnsigned(&rbsp); //vps_num_layer_sets_minus1
 	for (uint64_t i = 1; i <= t1; i++) {
 		for (uint64_t j = 0; j <= t0; j++) {
-			bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //layer_id_included_flag
+			rbspReadBits(&rbsp, 1); //layer_id_included_flag
 		}
 	}
 	
-	vps.flags.vps_timing_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	vps.flags.vps_timing_info_present_flag = rbspReadBits(&rbsp, 1);
 	if (vps.flags.vps_timing_info_present_flag == 1) {
-		vps.vps_num_units_in_tick = bitstreamGetBitValue(&bitstreamBytes, &bit, 32);
-		vps.vps_time_scale = bitstreamGetBitValue(&bitstreamBytes, &bit, 32);
-		vps.flags.vps_poc_proportional_to_timing_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		vps.vps_num_units_in_tick = rbspReadBits(&rbsp, 32);
+		vps.vps_time_scale = rbspReadBits(&rbsp, 32);
+		vps.flags.vps_poc_proportional_to_timing_flag = rbspReadBits(&rbsp, 1);
 		if (vps.flags.vps_poc_proportional_to_timing_flag == 1) {
-			vps.vps_num_ticks_poc_diff_one_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+			vps.vps_num_ticks_poc_diff_one_minus1 = rbspReadUnsigned(&rbsp);
 		}
 		else {
 			vps.vps_num_ticks_poc_diff_one_minus1 = 0;
 		}
-		u64 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		u64 = rbspReadUnsigned(&rbsp);
 		if (u64 > 0) {
 			return ERROR_PARSE_ISSUE; //TODO
 		}
@@ -314,20 +166,16 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		vps.pHrdParameters = NULL;
 	}
 	
-	u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //vps_extension_flag
+	u64 = rbspReadBits(&rbsp, 1); //vps_extension_flag
 	if (u64 == 1) {
 		return ERROR_PARSE_ISSUE; //TODO
 	}
 	
 	//Byte alignment
-	u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //stop bit
+	u64 = rbspReadBits(&rbsp, 1); //stop bit
 	if (u64 != 1) {
 		return ERROR_PARSE_ISSUE; //TODO
 	}
-	if (bit != 0x80) {
-		bitstreamBytes++;
-		bit = 0x80;
-	}
 	
 	vps.reserved1 = 0;
 	vps.reserved2 = 0;
@@ -336,22 +184,22 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	
 	
 	
-	startCodeCheck = (uint64_t*) bitstreamBytes;
-	if ((*startCodeCheck & 0xFFFFFFFFFFFF) != 0x014201000000) { //SPS
-		return ERROR_PARSE_ISSUE;
-	}
-	bitstreamBytes += 6;
+	error = readParameterSetStart(accessUnit, accessUnitBytes, position, HEVC_NAL_SPS, &rbsp);
+	RETURN_ON_ERROR(error);
+	rbspReader setsReader = rbsp; //The short parse for the per frame slice headers
+	error = hevcParseSPS(&extractParameterSets, &setsReader);
+	RETURN_ON_ERROR(error);
 		
 	
 	
-	u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 1, 0);
+	u64 = rbspReadBytes(&rbsp, 1, 0);
 	sps.sps_video_parameter_set_id = (u64 >> 4) & 0xF;
 	sps.sps_max_sub_layers_minus1 = (u64 >> 1) & 0x7;
 	sps.flags.sps_temporal_id_nesting_flag = u64 & 0x1;
 	
 	
 	
-	u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 8, 3);
+	u64 = rbspReadBytes(&rbsp, 8, 3);
 	spsPTL.flags.general_tier_flag = (u64 >> 61) & 0x1;
 	spsPTL.general_profile_idc = (u64 >> 56) & 0x1F;
 	spsPTL.flags.general_progressive_source_flag = (u64 >> 24) & 0x1;
@@ -359,20 +207,20 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	spsPTL.flags.general_non_packed_constraint_flag = (u64 >> 22) & 0x1;
 	spsPTL.flags.general_frame_only_constraint_flag = (u64 >> 21) & 0x1;
 	
-	u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 1, 0);
+	u64 = rbspReadBytes(&rbsp, 1, 0);
 	spsPTL.general_level_idc = u64 & 0xFF;
 	
 	if (sps.sps_max_sub_layers_minus1 > 0) {
-		u64 = bitstreamGetValueAndAdvance(&bitstreamBytes, 2, 0);
+		u64 = rbspReadBytes(&rbsp, 2, 0);
 		
 		uint8_t bitShift = 15;
 		for (uint8_t i=0; i<sps.sps_max_sub_layers_minus1; i++) {
 			if (((u64 >> bitShift) & 1) == 1) {
-				bitstreamGetValueAndAdvance(&bitstreamBytes, 0, 11);
+				rbspSkipBits(&rbsp, 88);
 			}
 			bitShift--;
 			if (((u64 >> bitShift) & 1) == 1) {
-				bitstreamGetValueAndAdvance(&bitstreamBytes, 0, 1);
+				rbspSkipBits(&rbsp, 8);
 			}
 			bitShift--;
 		}
@@ -380,27 +228,27 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	
 	sps.pProfileTierLevel = &spsPTL;
 	
-	sps.sps_seq_parameter_set_id = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.chroma_format_idc = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+	sps.sps_seq_parameter_set_id = rbspReadUnsigned(&rbsp);
+	sps.chroma_format_idc = rbspReadUnsigned(&rbsp);
 	if (sps.chroma_format_idc == 3) {
-		sps.flags.separate_colour_plane_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		sps.flags.separate_colour_plane_flag = rbspReadBits(&rbsp, 1);
 	}
 	else {
 		sps.flags.separate_colour_plane_flag = 0;
 	}
 	
-	sps.pic_width_in_luma_samples = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-  sps.pic_height_in_luma_samples = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+	sps.pic_width_in_luma_samples = rbspReadUnsigned(&rbsp);
+  sps.pic_height_in_luma_samples = rbspReadUnsigned(&rbsp);
 	consoleWriteLineWithNumberFast("Val: ", 5, sps.pic_width_in_luma_samples, NUM_FORMAT_UNSIGNED_INTEGER);
 	consoleWriteLineWithNumberFast("Val: ", 5, sps.pic_height_in_luma_samples, NUM_FORMAT_UNSIGNED_INTEGER);
   
 	
-	sps.flags.conformance_window_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	sps.flags.conformance_window_flag = rbspReadBits(&rbsp, 1);
 	if (sps.flags.conformance_window_flag == 1) {
-		sps.conf_win_left_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		sps.conf_win_right_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		sps.conf_win_top_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		sps.conf_win_bottom_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		sps.conf_win_left_offset = rbspReadUnsigned(&rbsp);
+		sps.conf_win_right_offset = rbspReadUnsigned(&rbsp);
+		sps.conf_win_top_offset = rbspReadUnsigned(&rbsp);
+		sps.conf_win_bottom_offset = rbspReadUnsigned(&rbsp);
 	}
 	else {
 		sps.conf_win_left_offset = 0;
@@ -409,33 +257,33 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		sps.conf_win_bottom_offset = 0;
 	}
   
-	sps.bit_depth_luma_minus8 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.bit_depth_chroma_minus8 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+	sps.bit_depth_luma_minus8 = rbspReadUnsigned(&rbsp);
+	sps.bit_depth_chroma_minus8 = rbspReadUnsigned(&rbsp);
 	
-	sps.log2_max_pic_order_cnt_lsb_minus4 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+	sps.log2_max_pic_order_cnt_lsb_minus4 = rbspReadUnsigned(&rbsp);
 	
 	
-	sps.flags.sps_sub_layer_ordering_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	sps.flags.sps_sub_layer_ordering_info_present_flag = rbspReadBits(&rbsp, 1);
 	for (uint8_t i = (sps.flags.sps_sub_layer_ordering_info_present_flag ? 0 : sps.sps_max_sub_layers_minus1);
 		i <= sps.sps_max_sub_layers_minus1; i++) {		
 		
-		spsDecPicBuf.max_dec_pic_buffering_minus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		spsDecPicBuf.max_num_reorder_pics[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		spsDecPicBuf.max_latency_increase_plus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		spsDecPicBuf.max_dec_pic_buffering_minus1[i] = rbspReadUnsigned(&rbsp);
+		spsDecPicBuf.max_num_reorder_pics[i] = rbspReadUnsigned(&rbsp);
+		spsDecPicBuf.max_latency_increase_plus1[i] = rbspReadUnsigned(&rbsp);
 	}
 	sps.pDecPicBufMgr = &spsDecPicBuf;
   
-	sps.log2_min_luma_coding_block_size_minus3 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.log2_diff_max_min_luma_coding_block_size = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.log2_min_luma_transform_block_size_minus2 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.log2_diff_max_min_luma_transform_block_size = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.max_transform_hierarchy_depth_inter = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	sps.max_transform_hierarchy_depth_intra = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+	sps.log2_min_luma_coding_block_size_minus3 = rbspReadUnsigned(&rbsp);
+	sps.log2_diff_max_min_luma_coding_block_size = rbspReadUnsigned(&rbsp);
+	sps.log2_min_luma_transform_block_size_minus2 = rbspReadUnsigned(&rbsp);
+	sps.log2_diff_max_min_luma_transform_block_size = rbspReadUnsigned(&rbsp);
+	sps.max_transform_hierarchy_depth_inter = rbspReadUnsigned(&rbsp);
+	sps.max_transform_hierarchy_depth_intra = rbspReadUnsigned(&rbsp);
 	
 	//SPS Scaling
-	sps.flags.scaling_list_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	sps.flags.scaling_list_enabled_flag = rbspReadBits(&rbsp, 1);
 	if (sps.flags.scaling_list_enabled_flag == 1) {
-		sps.flags.sps_scaling_list_data_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		sps.flags.sps_scaling_list_data_present_flag = rbspReadBits(&rbsp, 1);
 		if (sps.flags.scaling_list_enabled_flag == 1) {
 			return ERROR_PARSE_ISSUE; //TODO
 		}
@@ -448,15 +296,15 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		sps.pScalingLists = NULL;
 	}
 	
-  sps.flags.amp_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  sps.flags.sample_adaptive_offset_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  sps.flags.pcm_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  sps.flags.amp_enabled_flag = rbspReadBits(&rbsp, 1);
+  sps.flags.sample_adaptive_offset_enabled_flag = rbspReadBits(&rbsp, 1);
+  sps.flags.pcm_enabled_flag = rbspReadBits(&rbsp, 1);
 	if (sps.flags.pcm_enabled_flag == 1) {
-		sps.pcm_sample_bit_depth_luma_minus1 = bitstreamGetBitValue(&bitstreamBytes, &bit, 4);
-		sps.pcm_sample_bit_depth_chroma_minus1 = bitstreamGetBitValue(&bitstreamBytes, &bit, 4);
-		sps.log2_min_pcm_luma_coding_block_size_minus3 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		sps.log2_diff_max_min_pcm_luma_coding_block_size = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		sps.flags.pcm_loop_filter_disabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		sps.pcm_sample_bit_depth_luma_minus1 = rbspReadBits(&rbsp, 4);
+		sps.pcm_sample_bit_depth_chroma_minus1 = rbspReadBits(&rbsp, 4);
+		sps.log2_min_pcm_luma_coding_block_size_minus3 = rbspReadUnsigned(&rbsp);
+		sps.log2_diff_max_min_pcm_luma_coding_block_size = rbspReadUnsigned(&rbsp);
+		sps.flags.pcm_loop_filter_disabled_flag = rbspReadBits(&rbsp, 1);
 	}
 	else {
 		sps.pcm_sample_bit_depth_luma_minus1 = 0;
@@ -468,7 +316,7 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	
 	
 	//Short Term Reference Pictures:
-	sps.num_short_term_ref_pic_sets = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+	sps.num_short_term_ref_pic_sets = rbspReadUnsigned(&rbsp);
 	if (sps.num_short_term_ref_pic_sets == 0) {
 		sps.pShortTermRefPicSet = NULL;
 	}
@@ -483,21 +331,21 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		
 		
 		//Max of 16
-		strps[0].num_negative_pics = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		strps[0].num_positive_pics = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		strps[0].num_negative_pics = rbspReadUnsigned(&rbsp);
+		strps[0].num_positive_pics = rbspReadUnsigned(&rbsp);
 		
 		strps[0].used_by_curr_pic_s0_flag = 0;
 		for (uint64_t i = 0; i < strps[0].num_negative_pics; i++) {
-			strps[0].delta_poc_s0_minus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+			strps[0].delta_poc_s0_minus1[i] = rbspReadUnsigned(&rbsp);
 			strps[0].used_by_curr_pic_s0_flag <<= 1;
-			strps[0].used_by_curr_pic_s0_flag |= bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			strps[0].used_by_curr_pic_s0_flag |= rbspReadBits(&rbsp, 1);
 		}
 		
 		strps[0].used_by_curr_pic_s1_flag = 0;
 		for (uint64_t i = 0; i < strps[0].num_positive_pics; i++) {
-			strps[0].delta_poc_s1_minus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+			strps[0].delta_poc_s1_minus1[i] = rbspReadUnsigned(&rbsp);
 			strps[0].used_by_curr_pic_s1_flag <<= 1;
-			strps[0].used_by_curr_pic_s1_flag |= bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			strps[0].used_by_curr_pic_s1_flag |= rbspReadBits(&rbsp, 1);
 		}	
 		
 		strps[0].reserved1 = 0;
@@ -511,9 +359,9 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	}
 	
   //Long term reference pictures
-	sps.flags.long_term_ref_pics_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	sps.flags.long_term_ref_pics_present_flag = rbspReadBits(&rbsp, 1);
 	if (sps.flags.long_term_ref_pics_present_flag == 1) {
-		sps.num_long_term_ref_pics_sps = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		sps.num_long_term_ref_pics_sps = rbspReadUnsigned(&rbsp);
 		if (sps.num_long_term_ref_pics_sps > 0) {
 			return ERROR_PARSE_ISSUE; //TODO
 		}
@@ -527,19 +375,19 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	}
   
 	
-  sps.flags.sps_temporal_mvp_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  sps.flags.strong_intra_smoothing_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  sps.flags.sps_temporal_mvp_enabled_flag = rbspReadBits(&rbsp, 1);
+  sps.flags.strong_intra_smoothing_enabled_flag = rbspReadBits(&rbsp, 1);
 	
 	
 	
-  sps.flags.vui_parameters_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  sps.flags.vui_parameters_present_flag = rbspReadBits(&rbsp, 1);
 	if (sps.flags.vui_parameters_present_flag == 1) {
-		spsVui.flags.aspect_ratio_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.aspect_ratio_info_present_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.aspect_ratio_info_present_flag == 1) {
-			spsVui.aspect_ratio_idc = bitstreamGetBitValue(&bitstreamBytes, &bit, 8);
+			spsVui.aspect_ratio_idc = rbspReadBits(&rbsp, 8);
 			if (spsVui.aspect_ratio_idc == STD_VIDEO_H265_ASPECT_RATIO_IDC_EXTENDED_SAR) {
-				spsVui.sar_width = bitstreamGetBitValue(&bitstreamBytes, &bit, 16);
-				spsVui.sar_height = bitstreamGetBitValue(&bitstreamBytes, &bit, 16);
+				spsVui.sar_width = rbspReadBits(&rbsp, 16);
+				spsVui.sar_height = rbspReadBits(&rbsp, 16);
 			}
 			else {
 				spsVui.sar_width = 0;
@@ -552,23 +400,23 @@ int readBitstreamParameters(uint8_t** memPtr) {
 			spsVui.sar_height = 0;
 		}
 		
-		spsVui.flags.overscan_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.overscan_info_present_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.overscan_info_present_flag == 1) {
-			spsVui.flags.overscan_appropriate_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			spsVui.flags.overscan_appropriate_flag = rbspReadBits(&rbsp, 1);
 		}
 		else {
 			spsVui.flags.overscan_appropriate_flag = 0;
 		}
 		
-		spsVui.flags.video_signal_type_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.video_signal_type_present_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.video_signal_type_present_flag == 1) {
-			spsVui.video_format = bitstreamGetBitValue(&bitstreamBytes, &bit, 3);
-			spsVui.flags.video_full_range_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-			spsVui.flags.colour_description_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			spsVui.video_format = rbspReadBits(&rbsp, 3);
+			spsVui.flags.video_full_range_flag = rbspReadBits(&rbsp, 1);
+			spsVui.flags.colour_description_present_flag = rbspReadBits(&rbsp, 1);
 			if (spsVui.flags.colour_description_present_flag == 1) {
-				spsVui.colour_primaries = bitstreamGetBitValue(&bitstreamBytes, &bit, 8);
-				spsVui.transfer_characteristics = bitstreamGetBitValue(&bitstreamBytes, &bit, 8);
-				spsVui.matrix_coeffs = bitstreamGetBitValue(&bitstreamBytes, &bit, 8);
+				spsVui.colour_primaries = rbspReadBits(&rbsp, 8);
+				spsVui.transfer_characteristics = rbspReadBits(&rbsp, 8);
+				spsVui.matrix_coeffs = rbspReadBits(&rbsp, 8);
 			}
 			else {
 				spsVui.colour_primaries = 0;
@@ -586,26 +434,26 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		}
 		
 		
-		spsVui.flags.chroma_loc_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.chroma_loc_info_present_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.chroma_loc_info_present_flag == 1) {
-			spsVui.chroma_sample_loc_type_top_field = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.chroma_sample_loc_type_bottom_field = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+			spsVui.chroma_sample_loc_type_top_field = rbspReadUnsigned(&rbsp);
+			spsVui.chroma_sample_loc_type_bottom_field = rbspReadUnsigned(&rbsp);
 		}
 		else {
 			spsVui.chroma_sample_loc_type_top_field = 0;
 			spsVui.chroma_sample_loc_type_bottom_field = 0;
 		}
 		
-		spsVui.flags.neutral_chroma_indication_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		spsVui.flags.field_seq_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		spsVui.flags.frame_field_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.neutral_chroma_indication_flag = rbspReadBits(&rbsp, 1);
+		spsVui.flags.field_seq_flag = rbspReadBits(&rbsp, 1);
+		spsVui.flags.frame_field_info_present_flag = rbspReadBits(&rbsp, 1);
 		
-		spsVui.flags.default_display_window_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.default_display_window_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.default_display_window_flag == 1) {
-			spsVui.def_disp_win_left_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.def_disp_win_right_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.def_disp_win_top_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.def_disp_win_bottom_offset = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+			spsVui.def_disp_win_left_offset = rbspReadUnsigned(&rbsp);
+			spsVui.def_disp_win_right_offset = rbspReadUnsigned(&rbsp);
+			spsVui.def_disp_win_top_offset = rbspReadUnsigned(&rbsp);
+			spsVui.def_disp_win_bottom_offset = rbspReadUnsigned(&rbsp);
 		}
 		else {
 			spsVui.def_disp_win_left_offset = 0;
@@ -614,18 +462,18 @@ int readBitstreamParameters(uint8_t** memPtr) {
 			spsVui.def_disp_win_bottom_offset = 0;
 		}
 		
-		spsVui.flags.vui_timing_info_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.vui_timing_info_present_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.vui_timing_info_present_flag == 1) {
-			spsVui.vui_num_units_in_tick = bitstreamGetBitValue(&bitstreamBytes, &bit, 32);
-			spsVui.vui_time_scale = bitstreamGetBitValue(&bitstreamBytes, &bit, 32);
-			spsVui.flags.vui_poc_proportional_to_timing_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			spsVui.vui_num_units_in_tick = rbspReadBits(&rbsp, 32);
+			spsVui.vui_time_scale = rbspReadBits(&rbsp, 32);
+			spsVui.flags.vui_poc_proportional_to_timing_flag = rbspReadBits(&rbsp, 1);
 			if (spsVui.flags.vui_poc_proportional_to_timing_flag == 1) {
-				spsVui.vui_num_ticks_poc_diff_one_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+				spsVui.vui_num_ticks_poc_diff_one_minus1 = rbspReadUnsigned(&rbsp);
 			}
 			else {
 				spsVui.vui_num_ticks_poc_diff_one_minus1 = 0;
 			}
-			spsVui.flags.vui_hrd_parameters_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			spsVui.flags.vui_hrd_parameters_present_flag = rbspReadBits(&rbsp, 1);
 			if (spsVui.flags.vui_hrd_parameters_present_flag == 1) {
 				return ERROR_PARSE_ISSUE; //TODO
 			}
@@ -642,16 +490,16 @@ int readBitstreamParameters(uint8_t** memPtr) {
 			spsVui.pHrdParameters = NULL;
 		}
 		
-		spsVui.flags.bitstream_restriction_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		spsVui.flags.bitstream_restriction_flag = rbspReadBits(&rbsp, 1);
 		if (spsVui.flags.bitstream_restriction_flag == 1) {
-			spsVui.flags.tiles_fixed_structure_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-			spsVui.flags.motion_vectors_over_pic_boundaries_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-			spsVui.flags.restricted_ref_pic_lists_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-			spsVui.min_spatial_segmentation_idc = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.max_bytes_per_pic_denom = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.max_bits_per_min_cu_denom = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.log2_max_mv_length_horizontal = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			spsVui.log2_max_mv_length_vertical = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+			spsVui.flags.tiles_fixed_structure_flag = rbspReadBits(&rbsp, 1);
+			spsVui.flags.motion_vectors_over_pic_boundaries_flag = rbspReadBits(&rbsp, 1);
+			spsVui.flags.restricted_ref_pic_lists_flag = rbspReadBits(&rbsp, 1);
+			spsVui.min_spatial_segmentation_idc = rbspReadUnsigned(&rbsp);
+			spsVui.max_bytes_per_pic_denom = rbspReadUnsigned(&rbsp);
+			spsVui.max_bits_per_min_cu_denom = rbspReadUnsigned(&rbsp);
+			spsVui.log2_max_mv_length_horizontal = rbspReadUnsigned(&rbsp);
+			spsVui.log2_max_mv_length_vertical = rbspReadUnsigned(&rbsp);
 		}
 		else {
 			spsVui.flags.tiles_fixed_structure_flag = 0;
@@ -675,19 +523,19 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	}
 	
 	
-	sps.flags.sps_extension_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	sps.flags.sps_extension_present_flag = rbspReadBits(&rbsp, 1);
 	if (sps.flags.sps_extension_present_flag == 1) {
-		sps.flags.sps_range_extension_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //sps_multilayer_extension_flag
+		sps.flags.sps_range_extension_flag = rbspReadBits(&rbsp, 1);
+		u64 = rbspReadBits(&rbsp, 1); //sps_multilayer_extension_flag
 		if (u64 == 1) {
 			return ERROR_PARSE_ISSUE;
 		}
-		u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //sps_3d_extension_flag
+		u64 = rbspReadBits(&rbsp, 1); //sps_3d_extension_flag
 		if (u64 == 1) {
 			return ERROR_PARSE_ISSUE;
 		}
-		sps.flags.sps_scc_extension_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 4); //sps_extension_4bits
+		sps.flags.sps_scc_extension_flag = rbspReadBits(&rbsp, 1);
+		u64 = rbspReadBits(&rbsp, 4); //sps_extension_4bits
 		if (u64 > 0) {
 			return ERROR_PARSE_ISSUE;
 		}
@@ -699,15 +547,15 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	
 	
 	if (sps.flags.sps_range_extension_flag == 1) {
-		sps.flags.transform_skip_rotation_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.transform_skip_context_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.implicit_rdpcm_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.explicit_rdpcm_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.extended_precision_processing_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.intra_smoothing_disabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.high_precision_offsets_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.persistent_rice_adaptation_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.cabac_bypass_alignment_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		sps.flags.transform_skip_rotation_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.transform_skip_context_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.implicit_rdpcm_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.explicit_rdpcm_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.extended_precision_processing_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.intra_smoothing_disabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.high_precision_offsets_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.persistent_rice_adaptation_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.cabac_bypass_alignment_enabled_flag = rbspReadBits(&rbsp, 1);
 	}
 	else {
 		sps.flags.transform_skip_rotation_enabled_flag = 0;
@@ -722,14 +570,14 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	}
 	
   if (sps.flags.sps_scc_extension_flag == 1) {
-		sps.flags.sps_curr_pic_ref_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		sps.flags.palette_mode_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		sps.flags.sps_curr_pic_ref_enabled_flag = rbspReadBits(&rbsp, 1);
+		sps.flags.palette_mode_enabled_flag = rbspReadBits(&rbsp, 1);
 		if (sps.flags.palette_mode_enabled_flag == 1) {
-			sps.palette_max_size = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			sps.delta_palette_max_predictor_size = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-			sps.flags.sps_palette_predictor_initializers_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+			sps.palette_max_size = rbspReadUnsigned(&rbsp);
+			sps.delta_palette_max_predictor_size = rbspReadUnsigned(&rbsp);
+			sps.flags.sps_palette_predictor_initializers_present_flag = rbspReadBits(&rbsp, 1);
 			if (sps.flags.sps_palette_predictor_initializers_present_flag == 1) {
-				//sps.sps_num_palette_predictor_initializers_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+				//sps.sps_num_palette_predictor_initializers_minus1 = rbspReadUnsigned(&rbsp);
 				return ERROR_PARSE_ISSUE; //TODO
 			}
 			else {
@@ -745,8 +593,8 @@ int readBitstreamParameters(uint8_t** memPtr) {
 			sps.pPredictorPaletteEntries = NULL;
 		}
 		
-		sps.motion_vector_resolution_control_idc = bitstreamGetBitValue(&bitstreamBytes, &bit, 2);
-		sps.flags.intra_boundary_filtering_disabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		sps.motion_vector_resolution_control_idc = rbspReadBits(&rbsp, 2);
+		sps.flags.intra_boundary_filtering_disabled_flag = rbspReadBits(&rbsp, 1);
 	}
 	else {
 		sps.flags.sps_curr_pic_ref_enabled_flag = 0;
@@ -761,25 +609,21 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	}
 	
 	//SPS byte alignment
-	u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //stop bit
+	u64 = rbspReadBits(&rbsp, 1); //stop bit
 	if (u64 != 1) {
 		return ERROR_PARSE_ISSUE; //TODO
 	}
-	if (bit != 0x80) {
-		bitstreamBytes++;
-		bit = 0x80;
-	}
 	
 	sps.reserved1 = 0;
 	sps.reserved2 = 0;
 	//SPS Finished Setup
 	
 	
-	startCodeCheck = (uint64_t*) bitstreamBytes;
-	if ((*startCodeCheck & 0xFFFFFFFFFFFF) != 0x014401000000) { //PPS
-		return ERROR_PARSE_ISSUE;
-	}
-	bitstreamBytes += 6;
+	error = readParameterSetStart(accessUnit, accessUnitBytes, position, HEVC_NAL_PPS, &rbsp);
+	RETURN_ON_ERROR(error);
+	setsReader = rbsp;
+	error = hevcParsePPS(&extractParameterSets, &setsReader);
+	RETURN_ON_ERROR(error);
 	
 	//consoleWriteLineSlow("Got Here YES!");
 	//consoleBufferFlush();
@@ -787,47 +631,47 @@ int readBitstreamParameters(uint8_t** memPtr) {
 	
 	
 	
-	pps.pps_pic_parameter_set_id = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-  pps.pps_seq_parameter_set_id = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	pps.flags.dependent_slice_segments_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.output_flag_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-	pps.num_extra_slice_header_bits = bitstreamGetBitValue(&bitstreamBytes, &bit, 3);
-  pps.flags.sign_data_hiding_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.cabac_init_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);	
-	pps.num_ref_idx_l0_default_active_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-  pps.num_ref_idx_l1_default_active_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-	pps.init_qp_minus26 = bitstreamGetExpGolombSignedValue(&bitstreamBytes, &bit);
-  pps.flags.constrained_intra_pred_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.transform_skip_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	pps.pps_pic_parameter_set_id = rbspReadUnsigned(&rbsp);
+  pps.pps_seq_parameter_set_id = rbspReadUnsigned(&rbsp);
+	pps.flags.dependent_slice_segments_enabled_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.output_flag_present_flag = rbspReadBits(&rbsp, 1);
+	pps.num_extra_slice_header_bits = rbspReadBits(&rbsp, 3);
+  pps.flags.sign_data_hiding_enabled_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.cabac_init_present_flag = rbspReadBits(&rbsp, 1);	
+	pps.num_ref_idx_l0_default_active_minus1 = rbspReadUnsigned(&rbsp);
+  pps.num_ref_idx_l1_default_active_minus1 = rbspReadUnsigned(&rbsp);
+	pps.init_qp_minus26 = rbspReadSigned(&rbsp);
+  pps.flags.constrained_intra_pred_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.transform_skip_enabled_flag = rbspReadBits(&rbsp, 1);
 	
-  pps.flags.cu_qp_delta_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  pps.flags.cu_qp_delta_enabled_flag = rbspReadBits(&rbsp, 1);
 	
 	if (pps.flags.cu_qp_delta_enabled_flag == 1) {
-		pps.diff_cu_qp_delta_depth = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+		pps.diff_cu_qp_delta_depth = rbspReadUnsigned(&rbsp);
 	}
 	else {
 		pps.diff_cu_qp_delta_depth = 0;
 	}
 	
-	pps.pps_cb_qp_offset = bitstreamGetExpGolombSignedValue(&bitstreamBytes, &bit);
-	pps.pps_cr_qp_offset = bitstreamGetExpGolombSignedValue(&bitstreamBytes, &bit);
-  pps.flags.pps_slice_chroma_qp_offsets_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.weighted_pred_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.weighted_bipred_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.transquant_bypass_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.tiles_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-	pps.flags.entropy_coding_sync_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+	pps.pps_cb_qp_offset = rbspReadSigned(&rbsp);
+	pps.pps_cr_qp_offset = rbspReadSigned(&rbsp);
+  pps.flags.pps_slice_chroma_qp_offsets_present_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.weighted_pred_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.weighted_bipred_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.transquant_bypass_enabled_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.tiles_enabled_flag = rbspReadBits(&rbsp, 1);
+	pps.flags.entropy_coding_sync_enabled_flag = rbspReadBits(&rbsp, 1);
   
 	if (pps.flags.tiles_enabled_flag == 1) {
-		pps.num_tile_columns_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		pps.num_tile_rows_minus1 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-		pps.flags.uniform_spacing_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		pps.num_tile_columns_minus1 = rbspReadUnsigned(&rbsp);
+		pps.num_tile_rows_minus1 = rbspReadUnsigned(&rbsp);
+		pps.flags.uniform_spacing_flag = rbspReadBits(&rbsp, 1);
 		if (pps.flags.uniform_spacing_flag == 0) {
 			for (uint64_t i = 0; i < pps.num_tile_columns_minus1; i++) {
-				pps.column_width_minus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+				pps.column_width_minus1[i] = rbspReadUnsigned(&rbsp);
 			}
 			for (uint64_t i = 0; i < pps.num_tile_rows_minus1; i++) {
-				pps.row_height_minus1[i] = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
+				pps.row_height_minus1[i] = rbspReadUnsigned(&rbsp);
 			}
 		}
 		else {
@@ -836,7 +680,7 @@ int readBitstreamParameters(uint8_t** memPtr) {
 				pps.row_height_minus1[i] = 0;
 			}
 		}
-		pps.flags.loop_filter_across_tiles_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		pps.flags.loop_filter_across_tiles_enabled_flag = rbspReadBits(&rbsp, 1);
 	}
 	else {
 		pps.num_tile_columns_minus1 = 0;
@@ -849,14 +693,14 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		pps.flags.loop_filter_across_tiles_enabled_flag = 0;
 	}
 	
-  pps.flags.pps_loop_filter_across_slices_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-  pps.flags.deblocking_filter_control_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);	
+  pps.flags.pps_loop_filter_across_slices_enabled_flag = rbspReadBits(&rbsp, 1);
+  pps.flags.deblocking_filter_control_present_flag = rbspReadBits(&rbsp, 1);	
 	if (pps.flags.deblocking_filter_control_present_flag == 1) {
-		pps.flags.deblocking_filter_override_enabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		pps.flags.pps_deblocking_filter_disabled_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+		pps.flags.deblocking_filter_override_enabled_flag = rbspReadBits(&rbsp, 1);
+		pps.flags.pps_deblocking_filter_disabled_flag = rbspReadBits(&rbsp, 1);
 		if (pps.flags.pps_deblocking_filter_disabled_flag == 0) {
-			pps.pps_beta_offset_div2 = bitstreamGetExpGolombSignedValue(&bitstreamBytes, &bit);
-			pps.pps_tc_offset_div2 = bitstreamGetExpGolombSignedValue(&bitstreamBytes, &bit);
+			pps.pps_beta_offset_div2 = rbspReadSigned(&rbsp);
+			pps.pps_tc_offset_div2 = rbspReadSigned(&rbsp);
 		}
 		else {
 			pps.pps_beta_offset_div2 = 0;
@@ -870,7 +714,7 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		pps.pps_tc_offset_div2 = 0;
 	}
 	
-  pps.flags.pps_scaling_list_data_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  pps.flags.pps_scaling_list_data_present_flag = rbspReadBits(&rbsp, 1);
 	if (pps.flags.pps_scaling_list_data_present_flag == 1) {
 		return ERROR_PARSE_ISSUE; //TODO
 	}
@@ -878,23 +722,23 @@ int readBitstreamParameters(uint8_t** memPtr) {
 		 pps.pScalingLists = NULL;
 	}
 	
-  pps.flags.lists_modification_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);	
-	pps.log2_parallel_merge_level_minus2 = bitstreamGetExpGolombUnsignedValue(&bitstreamBytes, &bit);
-  pps.flags.slice_segment_header_extension_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  pps.flags.lists_modification_present_flag = rbspReadBits(&rbsp, 1);	
+	pps.log2_parallel_merge_level_minus2 = rbspReadUnsigned(&rbsp);
+  pps.flags.slice_segment_header_extension_present_flag = rbspReadBits(&rbsp, 1);
 	
-  pps.flags.pps_extension_present_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
+  pps.flags.pps_extension_present_flag = rbspReadBits(&rbsp, 1);
 	if (pps.flags.pps_extension_present_flag == 1) {
-		pps.flags.pps_range_extension_flag = bitstreamGetBitValue(&bitstreamBytes, &bit, 1);
-		u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //pps_multilayer_extension_flag
+		pps.flags.pps_range_extension_flag = rbspReadBits(&rbsp, 1);
+		u64 = rbspReadBits(&rbsp, 1); //pps_multilayer_extension_flag
 		if (u64 == 1) {
 			return ERROR_PARSE_ISSUE;
 		}
-		u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //pps_3d_extension_flag
+		u64 = rbspReadBits(&rbsp, 1); //pps_3d_extension_flag
 		if (u64 == 1) {
 			return ERROR_PARSE_ISSUE;
 		}
-		t0 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //pps_scc_extension_flag ...???
-		u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 4); //pps_extension_4bits
+		t0 = rbspReadBits(&rbsp, 1); //pps_scc_extension_flag ...???
+		u64 = rbspReadBits(&rbsp, 4); //pps_extension_4bits
 		if (u64 > 0) {
 			return ERROR_PARSE_ISSUE;
 		}
@@ -947,24 +791,20 @@ int readBitstreamParameters(uint8_t** memPtr) {
   pps.sps_video_parameter_set_id = sps.sps_video_parameter_set_id; //Associated with the last sps
   
 	//PPS byte alignment
-	u64 = bitstreamGetBitValue(&bitstreamBytes, &bit, 1); //stop bit
+	u64 = rbspReadBits(&rbsp, 1); //stop bit
 	if (u64 != 1) {
 		return ERROR_PARSE_ISSUE; //TODO
 	}
-	if (bit != 0x80) {
-		bitstreamBytes++;
-		bit = 0x80;
-	}
 	
   pps.reserved1 = 0;
   pps.reserved2 = 0;
   pps.reserved3 = 0;
 	//PPS Final Setup
 	
-	*memPtr = bitstreamBytes;
 	return 0;
 }
 
+#ifndef COMPATIBILITY_GRAPHICS_UNNEEDED
 static VkVideoProfileInfoKHR videoProfileInfo;
 static VkVideoDecodeH265ProfileInfoKHR videoProfileH265Info;
 
@@ -1042,71 +882,341 @@ int setupVulkanVideo() {
 	
 	return 0;
 }
+#endif
 
 
 
 
+static int extractParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+//Segment verification: every frame's reserved NAL, chain link and flags get checked against the index
+//and each segment gets a checksum, which the in order commits fold into one file checksum
+static bitstreamReader* verifyReader = NULL;
+static uint8_t* verifyFileData = NULL;
+static uint64_t* verifySegmentChecksums = NULL; //Both indexed by segment (at most one per frame)
+static uint64_t* verifySegmentMismatches = NULL;
+static uint64_t verifyChecksum = 0;
+static uint64_t verifyMismatches = 0;
+static uint64_t verifyCommits = 0;
+
+static int verifySegment(uint64_t thread, uint64_t segment, uint64_t frameStart, uint64_t frameEnd) {
+	uint64_t mismatches = 0;
+	for (uint64_t f = frameStart; f < frameEnd; f++) {
+		bitstreamFrameEntry* entry = &(verifyReader->frames[f]);
+		uint8_t* reservedNAL = &(verifyFileData[entry->offset]);
+		uint64_t nextOffset = verifyReader->chainBytes;
+		if ((f + 1) < verifyReader->frameCount) {
+			nextOffset = verifyReader->frames[f + 1].offset;
+		}
+		uint64_t classifyBytes = entry->bytes;
+		if (classifyBytes > BITSTREAM_CLASSIFY_BYTES) {
+			classifyBytes = BITSTREAM_CLASSIFY_BYTES;
+		}
+		if (((*((uint64_t*) reservedNAL) & BITSTREAM_RESERVED_NAL_MASK) != BITSTREAM_RESERVED_NAL_START) ||
+			(*((uint32_t*) (&(reservedNAL[6]))) != entry->bytes) || ((entry->offset + BITSTREAM_RESERVED_NAL_BYTES + entry->bytes) != nextOffset) ||
+			(bitstreamClassifyAccessUnit(&(reservedNAL[BITSTREAM_RESERVED_NAL_BYTES]), classifyBytes) != entry->flags)) {
+			mismatches++;
+		}
+	}
+	uint64_t segmentOffset = verifyReader->frames[frameStart].offset;
+	uint64_t segmentEnd = verifyReader->chainBytes;
+	if (frameEnd < verifyReader->frameCount) {
+		segmentEnd = verifyReader->frames[frameEnd].offset;
+	}
+	verifySegmentChecksums[segment] = bitstreamChecksumData(&(verifyFileData[segmentOffset]), segmentEnd - segmentOffset);
+	verifySegmentMismatches[segment] = mismatches;
+	return 0;
+}
+
+//Commits come in segment order so the folded checksum does not depend on the thread count
+static int verifyCommit(uint64_t segment) {
+	verifyChecksum = bitstreamChecksumFold(verifyChecksum, verifySegmentChecksums[segment]);
+	verifyMismatches += verifySegmentMismatches[segment];
+	verifyCommits++;
+	return 0;
+}
+
+static int extractVerify(bitstreamReader* reader) {
+	int error = bitstreamReaderMapAll(reader, &verifyFileData);
+	RETURN_ON_ERROR(error);
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, reader->frameCount * sizeof(uint64_t) * 2, 0);
+	RETURN_ON_ERROR(error);
+	verifySegmentChecksums = (uint64_t*) memAlloc;
+	verifySegmentMismatches = &(verifySegmentChecksums[reader->frameCount]);
+	verifyReader = reader;
+	verifyChecksum = 0;
+	verifyMismatches = 0;
+	verifyCommits = 0;
+	
+	uint64_t segmentCount = 0;
+	uint64_t steals = 0;
+	uint64_t startTime = getCurrentTime();
+	error = bitstreamSegmentsRun(reader, verifySegment, verifyCommit, &segmentCount, &steals);
+	uint64_t stopTime = getCurrentTime();
+	memoryDeallocate(&memAlloc);
+	RETURN_ON_ERROR(error);
+	
+	uint64_t verifyTime = getDiffTimeMicroseconds(startTime, stopTime);
+	if (verifyTime == 0) {
+		verifyTime = 1;
+	}
+	consolePrintLineWithNumber(119, segmentCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(120, bitstreamSegmentsThreadCount(), NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(123, steals, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(124, verifyCommits, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(125, verifyMismatches, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(126, verifyChecksum, NUM_FORMAT_PARTIAL_HEXADECIMAL);
+	consolePrintLineWithNumber(127, reader->chainBytes / verifyTime, NUM_FORMAT_UNSIGNED_INTEGER); //Bytes per us is MB/s
+	if (verifyMismatches > 0) {
+		return ERROR_BITSTREAM_INDEX_INVALID;
+	}
+	return 0;
+}
+
+//Whole file statistics: every slice segment header parsed across the IDR segments in parallel
+static int extractStatistics(bitstreamReader* reader) {
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, reader->frameCount * sizeof(bitstreamStatsFrame), 0);
+	RETURN_ON_ERROR(error);
+	bitstreamStatsFrame* frames = (bitstreamStatsFrame*) memAlloc;
+	
+	uint64_t segmentCount = 0;
+	uint64_t steals = 0;
+	uint64_t startTime = getCurrentTime();
+	error = bitstreamStatsRun(reader, frames, &segmentCount, &steals);
+	uint64_t stopTime = getCurrentTime();
+	if (error == 0) {
+		consolePrintLineWithNumber(119, segmentCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(120, bitstreamSegmentsThreadCount(), NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(123, steals, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(121, getDiffTimeMicroseconds(startTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
+		
+		//The IDR interval is whatever the recorder got set to (-idr) so the gap between the first two IDR frames is the expected one
+		uint64_t idrInterval = 0;
+		uint64_t firstIDR = reader->frameCount;
+		for (uint64_t f = 0; f < reader->frameCount; f++) {
+			if ((reader->frames[f].flags & BITSTREAM_FRAME_IDR) > 0) {
+				if (firstIDR < f) {
+					idrInterval = f - firstIDR;
+					break;
+				}
+				firstIDR = f;
+			}
+		}
+		error = bitstreamStatsWrite(reader, frames, idrInterval);
+	}
+	if (error == 0) {
+		consolePrintLine(122);
+	}
+	memoryDeallocate(&memAlloc);
+	return error;
+}
+
+static uint64_t extractArgumentIs(char* argument, uint64_t argumentBytes, char* text) {
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if (argument[i] != text[i]) { //Also stops at the end of text
+			return 0;
+		}
+	}
+	return (text[argumentBytes] == 0) ? 1 : 0;
+}
+
 //Program Main Function
+//Usage: BitstreamFrameExtract [input bitstream] [frame number]
+//   or: BitstreamFrameExtract [input bitstream] stats [threads]
+//   or: BitstreamFrameExtract [input bitstream] verify [threads]
+#define EXTRACT_MODE_FRAME 0
+#define EXTRACT_MODE_STATS 1
+#define EXTRACT_MODE_VERIFY 2
 int programMain() {
 	int error = 0;
+	char* inputFileName = "bitstream.h265";
+	uint64_t frameNumber = 0;
+	uint64_t mode = EXTRACT_MODE_FRAME;
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		inputFileName = argument;
+	}
+	if (ioGetCommandArgument(2, &argument, &argumentBytes) == 0) {
+		if (extractArgumentIs(argument, argumentBytes, "stats") > 0) {
+			mode = EXTRACT_MODE_STATS;
+		}
+		else if (extractArgumentIs(argument, argumentBytes, "verify") > 0) {
+			mode = EXTRACT_MODE_VERIFY;
+		}
+		else {
+			error = extractParseNumber(argument, argumentBytes, &frameNumber);
+			RETURN_ON_ERROR(error);
+		}
+	}
+	if (mode != EXTRACT_MODE_FRAME) { //Whole file modes spread the IDR segments over a thread pool
+		uint64_t threadCount = syncGetProcessorCount();
+		if (ioGetCommandArgument(3, &argument, &argumentBytes) == 0) {
+			error = extractParseNumber(argument, argumentBytes, &threadCount);
+			RETURN_ON_ERROR(error);
+		}
+		if ((threadCount == 0) || (threadCount > BITSTREAM_SEGMENT_THREAD_MAX)) {
+			threadCount = BITSTREAM_SEGMENT_THREAD_MAX;
+		}
+		error = bitstreamSegmentsSetupThreads(threadCount);
+		RETURN_ON_ERROR(error);
+	}
 	
 	//Open Bitstream File and Extract the Dimensions
 	consolePrintLine(54);
-	void* h265File = NULL;
-	char* inputFileName = "bitstream.h265";
-	error = ioOpenFile(&h265File, inputFileName, -1, IO_FILE_READ_NORMAL);
+	bitstreamReader reader;
+	error = bitstreamReaderOpen(&reader, inputFileName);
 	RETURN_ON_ERROR(error);
 	
-	//16MB Allocate:
-	void* memAlloc = NULL;
-	uint64_t memAllocBytes = 4096 * 4096;
-	error = memoryAllocate(&memAlloc, memAllocBytes, 0);
+	//The first access unit always starts with the parameter sets (viewed in place, the views keep padding for the bit readers)
+	uint8_t* reservedNAL = NULL;
+	error = bitstreamReaderView(&reader, 0, BITSTREAM_RESERVED_NAL_BYTES, &reservedNAL);
 	RETURN_ON_ERROR(error);
-	uint8_t* memPtr = (uint8_t*) memAlloc;
-	
-	uint64_t* nalReservedHeader = (uint64_t*) memPtr;
-	uint32_t* nalReservedSize = (uint32_t*) (&(memPtr[6]));
+	uint64_t* nalReservedHeader = (uint64_t*) reservedNAL;
+	uint32_t nalReservedSize = *((uint32_t*) (&(reservedNAL[6])));
+	if ((*nalReservedHeader & BITSTREAM_RESERVED_NAL_MASK) != BITSTREAM_RESERVED_NAL_START) {
+		bitstreamReaderClose(&reader);
+		return ERROR_BITSTREAM_BROKEN_CHAIN;
+	}
 	
-	uint32_t bytesRead = 10;
-	error = ioReadFile(h265File, memAlloc, &bytesRead);
+	uint8_t* firstAccessUnit = NULL;
+	error = bitstreamReaderView(&reader, BITSTREAM_RESERVED_NAL_BYTES, nalReservedSize, &firstAccessUnit);
 	RETURN_ON_ERROR(error);
-	if (bytesRead != 10) {
-		return 1;
+	
+	extractISA = hevcGetMaxISA();
+	uint64_t paramBytes = 0; //Ends at the start code of the first slice
+	int errorMinor = readBitstreamParameters(firstAccessUnit, nalReservedSize, &paramBytes);
+	if (errorMinor != 0) {
+		bitstreamReaderClose(&reader);
+		return errorMinor;
 	}
-	if ((*nalReservedHeader & 0xFFFFFFFFFFFF) != 0x015401000000) {
-		return 2;
+	uint64_t slicePosition = paramBytes;
+	bitstreamNalView sliceNal;
+	if ((bitstreamNextNal(firstAccessUnit, nalReservedSize, &slicePosition, &sliceNal) == 0) || (sliceNal.type != HEVC_NAL_IDR_W_RADL)) { //IDR Slice
+		consoleWriteLineSlow("NO IDR!");
+		consoleBufferFlush();
+		bitstreamReaderClose(&reader);
+		return ERROR_PARSE_ISSUE;
 	}
 	
-	bytesRead = *nalReservedSize;
-	if (*nalReservedSize > memAllocBytes) {
-		//return 3;
-		bytesRead = memAllocBytes;
+	//Frame Index (the stream timing gives each frame its presentation time)
+	uint32_t unitsInTick = 1;
+	uint32_t timeScale = 60; //Recorder default when the stream has no timing info
+	if ((sps.pSequenceParameterSetVui != NULL) && (spsVui.flags.vui_timing_info_present_flag == 1) && (spsVui.vui_time_scale > 0)) {
+		unitsInTick = spsVui.vui_num_units_in_tick;
+		timeScale = spsVui.vui_time_scale;
+	}
+	else if ((vps.flags.vps_timing_info_present_flag == 1) && (vps.vps_time_scale > 0)) {
+		unitsInTick = vps.vps_num_units_in_tick;
+		timeScale = vps.vps_time_scale;
 	}
 	
-	error = ioReadFile(h265File, memAlloc, &bytesRead);
+	uint64_t startTime = getCurrentTime();
+	uint64_t indexSource = 0;
+	error = bitstreamReaderIndex(&reader, unitsInTick, timeScale, &indexSource);
 	RETURN_ON_ERROR(error);
+	uint64_t stopTime = getCurrentTime();
 	
-	int errorMinor = readBitstreamParameters(&memPtr);
-	if (errorMinor != 0) {
-		error = memoryDeallocate(&memAlloc);
-		RETURN_ON_ERROR(error);
-		error = ioCloseFile(&h265File);
-		RETURN_ON_ERROR(error);
-		return errorMinor;
+	uint64_t randomAccessFrames = 0;
+	for (uint64_t f = 0; f < reader.frameCount; f++) {
+		if ((reader.frames[f].flags & BITSTREAM_FRAME_RANDOM_ACCESS) > 0) {
+			randomAccessFrames++;
+		}
+	}
+	uint64_t indexSourceLines[3] = {97, 98, 107}; //Sidecar loaded, built by walking the chain, or the seek table trailer
+	consolePrintLineWithNumber(indexSourceLines[indexSource], getDiffTimeMicroseconds(startTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(95, reader.frameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(96, randomAccessFrames, NUM_FORMAT_UNSIGNED_INTEGER);
+	if (reader.truncatedBytes > 0) { //Cut off recording: only the complete frames got indexed
+		consolePrintLineWithNumber(200, reader.truncatedBytes, NUM_FORMAT_UNSIGNED_INTEGER);
 	}
-	uint64_t paramBytes = memPtr - ((uint8_t*) (memAlloc));
-	uint64_t sliceOffset = paramBytes + 10;
-	uint64_t sliceBytes = (*nalReservedSize) - paramBytes;
 	
-	uint64_t* startCodeCheck = (uint64_t*) memPtr;
-	if ((*startCodeCheck & 0xFFFFFFFFFFFF) != 0x012601000000) { //IDR Slice
-		consoleWriteLineSlow("NO IDR!");
-		consoleBufferFlush();
-		return ERROR_PARSE_ISSUE;
+	if (mode != EXTRACT_MODE_FRAME) {
+		if (mode == EXTRACT_MODE_STATS) {
+			error = extractStatistics(&reader);
+		}
+		else {
+			error = extractVerify(&reader);
+		}
+		bitstreamSegmentsCleanupThreads();
+		bitstreamReaderClose(&reader);
+		return error;
 	}
 	
+	//Requested Frame (viewed in place at its indexed offset)
+	if (frameNumber >= reader.frameCount) {
+		return ERROR_BITSTREAM_FRAME_RANGE;
+	}
+	uint8_t* frameView = NULL;
+	uint64_t frameBytes = 0;
+	startTime = getCurrentTime();
+	error = bitstreamReaderViewFrame(&reader, frameNumber, &frameView, &frameBytes);
+	RETURN_ON_ERROR(error);
+	uint64_t frameNalUnits = 0;
+	uint64_t position = 0;
+	bitstreamNalView nal;
+	hevcSliceHeader sliceHeader;
+	sliceHeader.nalType = HEVC_NAL_VPS; //Stays a non slice type when the frame has no slices
+	while (bitstreamNextNal(frameView, frameBytes, &position, &nal) > 0) {
+		if ((nal.type < HEVC_NAL_VPS) && (sliceHeader.nalType == HEVC_NAL_VPS)) { //First slice (only its header gets unescaped)
+			rbspReader rbsp;
+			hevcReaderSetup(&rbsp, sliceHeaderRBSP, nal.data, nal.bytes, HEVC_SLICE_HEADER_BYTES, extractISA);
+			error = hevcParseSliceHeader(&extractParameterSets, &rbsp, nal.type, &sliceHeader);
+			RETURN_ON_ERROR(error);
+		}
+		frameNalUnits++;
+	}
+	stopTime = getCurrentTime();
+	
+	bitstreamFrameEntry* entry = &(reader.frames[frameNumber]);
+	consolePrintLineWithNumber(99, frameNumber, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(100, entry->offset, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(101, frameBytes, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(102, entry->presentationTime, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(103, entry->flags, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(104, bitstreamReaderFindRandomAccess(&reader, frameNumber), NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(108, frameNalUnits, NUM_FORMAT_UNSIGNED_INTEGER);
+	if (sliceHeader.nalType < HEVC_NAL_VPS) {
+		consolePrintLineWithNumber(112, sliceHeader.sliceType, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(113, sliceHeader.picOrderCntLsb, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	consolePrintLineWithNumber(105, getDiffTimeMicroseconds(startTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	//Every frame of the whole file through the sliding window (no copies no matter how big the capture is)
+	uint64_t fileNalUnits = 0;
+	startTime = getCurrentTime();
+	for (uint64_t f = 0; f < reader.frameCount; f++) {
+		error = bitstreamReaderViewFrame(&reader, f, &frameView, &frameBytes);
+		RETURN_ON_ERROR(error);
+		position = 0;
+		while (bitstreamNextNal(frameView, frameBytes, &position, &nal) > 0) {
+			fileNalUnits++;
+		}
+	}
+	stopTime = getCurrentTime();
+	uint64_t scanTime = getDiffTimeMicroseconds(startTime, stopTime);
+	if (scanTime == 0) {
+		scanTime = 1;
+	}
+	consolePrintLineWithNumber(109, fileNalUnits, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(110, scanTime, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(111, reader.chainBytes / scanTime, NUM_FORMAT_UNSIGNED_INTEGER); //Bytes per us is MB/s
+	
+	#ifndef COMPATIBILITY_GRAPHICS_UNNEEDED
 	error = setupVulkanVideo();
 	RETURN_ON_ERROR(error);	
+	#endif
 	
 	consolePrintLine(52);
 	
@@ -1121,12 +1231,10 @@ int programMain() {
 	RETURN_ON_ERROR(error);
 	//*/
 	
-	error = ioCloseFile(&h265File);
-	RETURN_ON_ERROR(error);
+	bitstreamReaderClose(&reader);
 	
 	//Cleanup ALL Vulkan Elements
 	
 	
 	return 0; //Exit Program Successfully
 }
-
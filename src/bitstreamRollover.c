@@ -0,0 +1,400 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//Media Enhanced Bitstream Rollover Functions
+//The helper thread only opens, preallocates, closes and deletes files (the
+//asynchronous writes all get issued by the main loop) and shares its jobs
+//through the fields marked in the header with atomic loads and stores
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "bitstreamRollover.h" //Include Bitstream Rollover Function Definitions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define BITSTREAM_ROLLOVER_DIGITS 4 //Segment numbers are zero padded to at least this many digits
+#define BITSTREAM_ROLLOVER_RESERVE_MIN 16777216 //Smallest reservation worth trying after the disk turned down a bigger one
+#define BITSTREAM_ROLLOVER_FREE_MARGIN_DIVISOR 4 //A quarter of the free space never gets reserved
+
+static bitstreamRollover* rolloverActive = NULL; //Thread starts take no arguments
+static void* rolloverThread = NULL;
+static void* rolloverWorkEvent = NULL;
+static void* rolloverIdleEvent = NULL;
+
+static uint64_t bitstreamRolloverSplitting(bitstreamRollover* rollover) {
+	return ((rollover->segmentFrames > 0) || (rollover->segmentBytes > 0)) ? 1 : 0;
+}
+
+void bitstreamRolloverFileName(bitstreamRollover* rollover, uint64_t segment, char* segmentName) {
+	uint64_t index = 0;
+	while (index < rollover->extensionStart) {
+		segmentName[index] = rollover->fileName[index];
+		index++;
+	}
+	if (bitstreamRolloverSplitting(rollover) > 0) {
+		char digits[20];
+		uint64_t digitCount = 0;
+		do {
+			digits[digitCount] = '0' + (segment % 10);
+			segment /= 10;
+			digitCount++;
+		} while ((segment > 0) || (digitCount < BITSTREAM_ROLLOVER_DIGITS));
+		segmentName[index] = '.';
+		index++;
+		while (digitCount > 0) {
+			digitCount--;
+			segmentName[index] = digits[digitCount];
+			index++;
+		}
+	}
+	uint64_t extensionIndex = rollover->extensionStart;
+	while (rollover->fileName[extensionIndex] != 0) {
+		segmentName[index] = rollover->fileName[extensionIndex];
+		index++;
+		extensionIndex++;
+	}
+	segmentName[index] = 0;
+}
+
+//Halves the reservation until the disk has room for it (file systems without preallocation turn all of them down)
+//Never takes more than the free space minus a margin, which stays for the next segment, the sidecars and everything else
+static uint64_t bitstreamRolloverReserve(void* file, uint64_t numBytes) {
+	uint64_t freeBytes = 0;
+	if (ioGetFreeSpace(file, &freeBytes) == 0) {
+		uint64_t limitBytes = freeBytes - (freeBytes / BITSTREAM_ROLLOVER_FREE_MARGIN_DIVISOR);
+		if (numBytes > limitBytes) {
+			numBytes = limitBytes;
+		}
+	}
+	while (numBytes >= BITSTREAM_ROLLOVER_RESERVE_MIN) {
+		if (ioAllocateFileSpace(file, numBytes) == 0) {
+			return numBytes;
+		}
+		numBytes >>= 1;
+	}
+	return 0;
+}
+
+//Gives back the preallocated space that went unused before closing, then drops the segment that fell out of the replay window
+static int bitstreamRolloverCloseSegment(bitstreamRollover* rollover, void* file, uint64_t segment, uint64_t fileBytes) {
+	int error = ioSetFileSize(file, fileBytes);
+	int closeError = ioCloseFile(&file);
+	if (error == 0) {
+		error = closeError;
+	}
+	if ((rollover->keepSegments > 0) && (segment >= rollover->keepSegments)) {
+		char segmentName[BITSTREAM_FILE_NAME_MAX];
+		bitstreamRolloverFileName(rollover, segment - rollover->keepSegments, segmentName);
+		if (ioDeleteFile(segmentName, -1) == 0) {
+			rollover->deleted++;
+		}
+	}
+	return error;
+}
+
+static int bitstreamRolloverThread() {
+	while (1) {
+		int error = syncEventWait(rolloverWorkEvent);
+		RETURN_ON_ERROR(error);
+		bitstreamRollover* rollover = rolloverActive;
+		
+		void* closeFile = __atomic_load_n(&(rollover->closeFile), __ATOMIC_ACQUIRE);
+		if (closeFile != NULL) {
+			bitstreamRolloverCloseSegment(rollover, closeFile, rollover->closeSegment, rollover->closeBytes);
+			__atomic_store_n(&(rollover->closeFile), NULL, __ATOMIC_RELEASE);
+		}
+		
+		if (__atomic_load_n(&(rollover->nextPending), __ATOMIC_ACQUIRE) > 0) {
+			char segmentName[BITSTREAM_FILE_NAME_MAX];
+			bitstreamRolloverFileName(rollover, rollover->segment + 1, segmentName);
+			void* nextFile = NULL;
+			if (ioOpenFile(&nextFile, segmentName, -1, IO_FILE_WRITE_ASYNC) == 0) {
+				bitstreamRolloverReserve(nextFile, rollover->preallocateBytes);
+				rollover->nextFile = nextFile;
+				__atomic_store_n(&(rollover->nextReady), 1, __ATOMIC_RELEASE);
+			}
+			else {
+				__atomic_store_n(&(rollover->nextError), 1, __ATOMIC_RELEASE);
+			}
+			__atomic_store_n(&(rollover->nextPending), 0, __ATOMIC_RELEASE);
+		}
+		
+		error = syncSetEvent(rolloverIdleEvent);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+static int bitstreamRolloverWaitHelper(bitstreamRollover* rollover) {
+	while ((__atomic_load_n(&(rollover->closeFile), __ATOMIC_ACQUIRE) != NULL) || (__atomic_load_n(&(rollover->nextPending), __ATOMIC_ACQUIRE) > 0)) {
+		int error = syncEventWait(rolloverIdleEvent);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+int bitstreamRolloverSetup(bitstreamRollover* rollover, uint64_t frameCapacity, uint64_t segmentFrames, uint64_t segmentBytes, uint64_t keepSegments, uint64_t preallocateBytes, uint32_t unitsInTick, uint32_t timeScale, uint64_t asyncOperation) {
+	memzeroBasic(rollover, sizeof(bitstreamRollover));
+	rollover->segmentFrames = segmentFrames;
+	rollover->segmentBytes = segmentBytes;
+	rollover->keepSegments = keepSegments;
+	rollover->preallocateBytes = preallocateBytes;
+	rollover->asyncOperation = asyncOperation;
+	
+	int error = bitstreamSeekTableSetup(&(rollover->tables[0]), frameCapacity, unitsInTick, timeScale);
+	RETURN_ON_ERROR(error);
+	if (bitstreamRolloverSplitting(rollover) == 0) {
+		return 0;
+	}
+	error = bitstreamSeekTableSetup(&(rollover->tables[1]), frameCapacity, unitsInTick, timeScale);
+	RETURN_ON_ERROR(error);
+	
+	if (rolloverThread == NULL) {
+		error = syncCreateEvent(&rolloverWorkEvent, 0, 0);
+		RETURN_ON_ERROR(error);
+		error = syncCreateEvent(&rolloverIdleEvent, 0, 0);
+		RETURN_ON_ERROR(error);
+		PFN_ThreadStart threadStart = bitstreamRolloverThread;
+		error = syncStartThread(&rolloverThread, threadStart, 0);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+int bitstreamRolloverStart(bitstreamRollover* rollover, char* fileName) {
+	uint64_t nameBytes = 0;
+	rollover->extensionStart = 0;
+	while (fileName[nameBytes] != 0) {
+		if (fileName[nameBytes] == '.') {
+			rollover->extensionStart = nameBytes;
+		}
+		else if ((fileName[nameBytes] == '/') || (fileName[nameBytes] == '\\')) {
+			rollover->extensionStart = 0;
+		}
+		nameBytes++;
+	}
+	if ((nameBytes + 24) > BITSTREAM_FILE_NAME_MAX) { //Room for the segment number and the side file extensions
+		return ERROR_INVALID_ARGUMENT;
+	}
+	if (rollover->extensionStart == 0) {
+		rollover->extensionStart = nameBytes;
+	}
+	memcpyBasic(rollover->fileName, fileName, nameBytes + 1);
+	
+	rollover->segment = 0;
+	rollover->table = 0;
+	rollover->writeOffset = 0;
+	rollover->segmentFramesDue = 0;
+	rollover->startPending = 0;
+	rollover->step = BITSTREAM_ROLLOVER_IDLE;
+	rollover->oldFile = NULL;
+	rollover->nextFile = NULL;
+	rollover->nextReady = 0;
+	rollover->nextPending = 0;
+	rollover->nextError = 0;
+	rollover->closeFile = NULL;
+	rollover->segmentCount = 1;
+	rollover->deferred = 0;
+	rollover->deleted = 0;
+	bitstreamSeekTableReset(&(rollover->tables[0]));
+	
+	char segmentName[BITSTREAM_FILE_NAME_MAX];
+	bitstreamRolloverFileName(rollover, 0, segmentName);
+	int error = ioOpenFile(&(rollover->file), segmentName, -1, IO_FILE_WRITE_ASYNC);
+	RETURN_ON_ERROR(error);
+	rollover->reservedBytes = bitstreamRolloverReserve(rollover->file, rollover->preallocateBytes);
+	
+	if (bitstreamRolloverSplitting(rollover) > 0) {
+		rolloverActive = rollover;
+		__atomic_store_n(&(rollover->nextPending), 1, __ATOMIC_RELEASE);
+		error = syncSetEvent(rolloverWorkEvent);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+uint64_t bitstreamRolloverDue(bitstreamRollover* rollover) {
+	uint64_t startsSegment = 0;
+	uint64_t limitReached = 0;
+	if ((rollover->segmentFrames > 0) && (rollover->segmentFramesDue >= rollover->segmentFrames)) {
+		limitReached = 1;
+	}
+	if ((rollover->segmentBytes > 0) && (rollover->writeOffset >= rollover->segmentBytes)) {
+		limitReached = 1;
+	}
+	if ((limitReached > 0) && (rollover->startPending == 0)) {
+		if ((rollover->step == BITSTREAM_ROLLOVER_IDLE) && (__atomic_load_n(&(rollover->nextReady), __ATOMIC_ACQUIRE) > 0)) {
+			startsSegment = 1;
+			rollover->startPending = 1;
+			rollover->segmentFramesDue = 0;
+		}
+		else { //Tries again with the next frame
+			rollover->deferred++;
+		}
+	}
+	rollover->segmentFramesDue++;
+	return startsSegment;
+}
+
+int bitstreamRolloverWrite(bitstreamRollover* rollover, ioWriteVec* writeVectors, uint64_t vectorCount, uint64_t asyncOperation, uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t frame, uint64_t startsSegment) {
+	if (startsSegment > 0) { //The old segment gets finished by bitstreamRolloverUpdate once its writes are done
+		rollover->oldFile = rollover->file;
+		rollover->oldSegment = rollover->segment;
+		rollover->oldEndOffset = rollover->writeOffset;
+		rollover->oldLastFrame = frame - 1;
+		rollover->step = BITSTREAM_ROLLOVER_WAIT_WRITES;
+		
+		rollover->file = rollover->nextFile;
+		rollover->nextFile = NULL;
+		__atomic_store_n(&(rollover->nextReady), 0, __ATOMIC_RELEASE);
+		rollover->segment++;
+		rollover->segmentCount++;
+		rollover->writeOffset = 0;
+		rollover->table ^= 1;
+		bitstreamSeekTableReset(&(rollover->tables[rollover->table]));
+		rollover->startPending = 0;
+		
+		__atomic_store_n(&(rollover->nextPending), 1, __ATOMIC_RELEASE);
+		int error = syncSetEvent(rolloverWorkEvent);
+		RETURN_ON_ERROR(error);
+	}
+	
+	uint64_t numBytes = 0;
+	for (uint64_t v = 0; v < vectorCount; v++) {
+		numBytes += writeVectors[v].numBytes;
+	}
+	int error = ioAsyncWriteFileV(rollover->file, writeVectors, vectorCount, asyncOperation, rollover->writeOffset);
+	RETURN_ON_ERROR(error);
+	bitstreamSeekTableAdd(&(rollover->tables[rollover->table]), rollover->writeOffset, accessUnit, accessUnitBytes);
+	rollover->writeOffset += numBytes;
+	return 0;
+}
+
+int bitstreamRolloverUpdate(bitstreamRollover* rollover, uint64_t completedFrames) {
+	if (rollover->step == BITSTREAM_ROLLOVER_WAIT_WRITES) {
+		if (completedFrames <= rollover->oldLastFrame) {
+			return 0;
+		}
+		bitstreamSeekTable* table = &(rollover->tables[rollover->table ^ 1]);
+		uint64_t trailerBytes = bitstreamSeekTableFinish(table, rollover->oldEndOffset);
+		if (trailerBytes > 0) {
+			int error = ioAsyncWriteFile(rollover->oldFile, table->trailer, trailerBytes, rollover->asyncOperation, rollover->oldEndOffset);
+			RETURN_ON_ERROR(error);
+			rollover->oldEndOffset += trailerBytes;
+			rollover->step = BITSTREAM_ROLLOVER_WAIT_TRAILER;
+		}
+		else { //More frames than the table holds (tools can still index the segment by walking it)
+			rollover->step = BITSTREAM_ROLLOVER_WAIT_CLOSE;
+		}
+	}
+	
+	if (rollover->step == BITSTREAM_ROLLOVER_WAIT_TRAILER) {
+		uint64_t signaled = 0;
+		int error = ioAsyncSignalCheck(rollover->asyncOperation, &signaled);
+		RETURN_ON_ERROR(error);
+		if (signaled == 0) {
+			return 0;
+		}
+		rollover->step = BITSTREAM_ROLLOVER_WAIT_CLOSE;
+	}
+	
+	if (rollover->step == BITSTREAM_ROLLOVER_WAIT_CLOSE) {
+		if (__atomic_load_n(&(rollover->closeFile), __ATOMIC_ACQUIRE) != NULL) {
+			return 0;
+		}
+		rollover->closeSegment = rollover->oldSegment;
+		rollover->closeBytes = rollover->oldEndOffset;
+		__atomic_store_n(&(rollover->closeFile), rollover->oldFile, __ATOMIC_RELEASE);
+		rollover->oldFile = NULL;
+		rollover->step = BITSTREAM_ROLLOVER_IDLE;
+		int error = syncSetEvent(rolloverWorkEvent);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+int bitstreamRolloverFinish(bitstreamRollover* rollover) {
+	int error = 0;
+	if (rollover->step != BITSTREAM_ROLLOVER_IDLE) {
+		error = bitstreamRolloverUpdate(rollover, UINT64_MAX);
+		RETURN_ON_ERROR(error);
+		if (rollover->step == BITSTREAM_ROLLOVER_WAIT_TRAILER) {
+			error = ioAsyncSignalWait(rollover->asyncOperation);
+			RETURN_ON_ERROR(error);
+		}
+		error = bitstreamRolloverWaitHelper(rollover);
+		RETURN_ON_ERROR(error);
+		error = bitstreamRolloverUpdate(rollover, UINT64_MAX);
+		RETURN_ON_ERROR(error);
+	}
+	
+	bitstreamSeekTable* table = &(rollover->tables[rollover->table]);
+	uint64_t trailerBytes = bitstreamSeekTableFinish(table, rollover->writeOffset);
+	if (trailerBytes == 0) {
+		return ERROR_BITSTREAM_FRAME_RANGE; //More frames than the table was sized for
+	}
+	error = ioAsyncWriteFile(rollover->file, table->trailer, trailerBytes, rollover->asyncOperation, rollover->writeOffset);
+	RETURN_ON_ERROR(error);
+	error = ioAsyncSignalWait(rollover->asyncOperation);
+	RETURN_ON_ERROR(error);
+	rollover->writeOffset += trailerBytes;
+	if (__atomic_load_n(&(rollover->nextError), __ATOMIC_ACQUIRE) > 0) {
+		return ERROR_BITSTREAM_ROLLOVER_OPEN;
+	}
+	return 0;
+}
+
+int bitstreamRolloverClose(bitstreamRollover* rollover) {
+	int error = 0;
+	if (bitstreamRolloverSplitting(rollover) > 0) {
+		error = bitstreamRolloverWaitHelper(rollover);
+		RETURN_ON_ERROR(error);
+	}
+	if (rollover->oldFile != NULL) { //The record failed while finishing a segment
+		error = bitstreamRolloverCloseSegment(rollover, rollover->oldFile, rollover->oldSegment, rollover->oldEndOffset);
+		rollover->oldFile = NULL;
+		rollover->step = BITSTREAM_ROLLOVER_IDLE;
+	}
+	if (rollover->file != NULL) {
+		int closeError = bitstreamRolloverCloseSegment(rollover, rollover->file, rollover->segment, rollover->writeOffset);
+		rollover->file = NULL;
+		if (error == 0) {
+			error = closeError;
+		}
+	}
+	if (__atomic_load_n(&(rollover->nextReady), __ATOMIC_ACQUIRE) > 0) { //Opened ahead of time but never written
+		ioCloseFile(&(rollover->nextFile));
+		char segmentName[BITSTREAM_FILE_NAME_MAX];
+		bitstreamRolloverFileName(rollover, rollover->segment + 1, segmentName);
+		ioDeleteFile(segmentName, -1);
+		rollover->nextReady = 0;
+	}
+	return error;
+}
+
+void bitstreamRolloverCleanup(bitstreamRollover* rollover) {
+	bitstreamSeekTableCleanup(&(rollover->tables[0]));
+	bitstreamSeekTableCleanup(&(rollover->tables[1]));
+}
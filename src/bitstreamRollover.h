@@ -0,0 +1,109 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//Media Enhanced Bitstream Rollover Definitions
+//Splits a recording into segment files that each start with an IDR frame
+//(with its own parameter sets) and end with their own seek table trailer, so
+//every segment plays and indexes on its own. A new segment starts at the
+//first frame after the time or size limit once the next file is ready: a
+//helper thread opens and preallocates the next file ahead of time and closes
+//(and in instant replay mode deletes) the old ones, so the main loop never
+//waits on the file system when switching. Without limits it is just the one
+//output file with its seek table
+#ifndef MEDIA_ENHANCED_BITSTREAM_ROLLOVER_H
+#define MEDIA_ENHANCED_BITSTREAM_ROLLOVER_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+#include "compatibility.h" //ioWriteVec
+#include "bitstreamContainer.h" //Seek table trailers
+
+#define ERROR_BITSTREAM_ROLLOVER_OPEN 0x5140 //Helper thread could not open the next segment file
+
+//Old Segment Steps (each one waits on the last without blocking)
+#define BITSTREAM_ROLLOVER_IDLE 0
+#define BITSTREAM_ROLLOVER_WAIT_WRITES 1 //Frame writes of the old segment still in flight
+#define BITSTREAM_ROLLOVER_WAIT_TRAILER 2
+#define BITSTREAM_ROLLOVER_WAIT_CLOSE 3 //Helper thread still closing the segment before it
+
+typedef struct bitstreamRollover {
+	char fileName[BITSTREAM_FILE_NAME_MAX]; //Output file name (segments get a number before the extension)
+	uint64_t extensionStart; //Where the number goes
+	uint64_t segmentFrames; //Frames per segment (0 is no time limit)
+	uint64_t segmentBytes; //Bytes per segment (0 is no size limit)
+	uint64_t keepSegments; //Only the latest segments are kept (0 keeps them all)
+	uint64_t preallocateBytes; //Disk space reserved for each new segment file (released past the end when it gets closed)
+	uint64_t asyncOperation; //Used for the trailers so it needs to be outside the output ring
+	bitstreamSeekTable tables[2]; //Current segment and the one being finished
+	
+	void* file; //Current segment (frame writes go here)
+	uint64_t segment;
+	uint64_t table;
+	uint64_t writeOffset; //Where the next frame write goes in the current segment
+	uint64_t segmentFramesDue; //Frames handed to bitstreamRolloverDue since the current segment started
+	uint64_t startPending; //A frame that starts a new segment is on its way to the write
+	
+	uint64_t step; //Old segment being finished
+	void* oldFile;
+	uint64_t oldSegment;
+	uint64_t oldEndOffset;
+	uint64_t oldLastFrame;
+	
+	//Shared with the helper thread
+	void* nextFile; //Opened and preallocated when nextReady is set
+	uint64_t nextReady;
+	uint64_t nextPending; //Open requested and not done yet
+	uint64_t nextError;
+	void* closeFile; //Handed over to be closed (set back to NULL when done)
+	uint64_t closeSegment;
+	uint64_t closeBytes;
+	
+	uint64_t segmentCount; //Segments started
+	uint64_t deferred; //Rollovers put off because the next file was not ready yet
+	uint64_t deleted; //Segments removed in instant replay mode
+	uint64_t reservedBytes; //Disk space the first segment got (less than preallocateBytes when the disk is short on space)
+} bitstreamRollover;
+
+//Allocates the seek tables up front (frameCapacity frames per segment) and starts the helper thread when splitting
+int bitstreamRolloverSetup(bitstreamRollover* rollover, uint64_t frameCapacity, uint64_t segmentFrames, uint64_t segmentBytes, uint64_t keepSegments, uint64_t preallocateBytes, uint32_t unitsInTick, uint32_t timeScale, uint64_t asyncOperation);
+//Opens the first segment (the file itself when not splitting) and has the helper thread get the next one ready
+int bitstreamRolloverStart(bitstreamRollover* rollover, char* fileName);
+//Called once for every frame handed to the encoder: 1 means it starts a new segment (force an IDR with parameter sets)
+uint64_t bitstreamRolloverDue(bitstreamRollover* rollover);
+//Issues the frame's write (reserved NAL and access unit vectors, or one vector when the header sits right in front) into its segment
+int bitstreamRolloverWrite(bitstreamRollover* rollover, ioWriteVec* writeVectors, uint64_t vectorCount, uint64_t asyncOperation, uint8_t* accessUnit, uint64_t accessUnitBytes, uint64_t frame, uint64_t startsSegment);
+//Moves the old segment through its steps without blocking (completedFrames: frame writes done so far)
+int bitstreamRolloverUpdate(bitstreamRollover* rollover, uint64_t completedFrames);
+//Writes the trailers that are left (every frame write has to be complete)
+//Returns ERROR_BITSTREAM_FRAME_RANGE when the current segment had more frames than its table and
+//ERROR_BITSTREAM_ROLLOVER_OPEN when a segment could not be opened (the record kept going in the one before)
+int bitstreamRolloverFinish(bitstreamRollover* rollover);
+//Closes every file (also after a failed record) and deletes the next segment that never got used
+int bitstreamRolloverClose(bitstreamRollover* rollover);
+void bitstreamRolloverCleanup(bitstreamRollover* rollover);
+//Segment file name (the file name itself when not splitting)
+void bitstreamRolloverFileName(bitstreamRollover* rollover, uint64_t segment, char* segmentName);
+
+#endif
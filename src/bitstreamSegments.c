@@ -0,0 +1,256 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Bitstream Segment Pool Functions
+//Each thread's block of segments is one packed word (next segment in the low
+//32 bits, block end in the high 32 bits): the owner takes from the front and
+//thieves take from the back, both with a compare exchange on the same word
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "bitstreamSegments.h" //Include Bitstream Segment Pool Function Definitions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+typedef struct segmentBlock {
+	uint64_t range; //(end << 32) | next
+	uint64_t padding[7]; //Own cache line for every thread
+} segmentBlock;
+
+static uint64_t segmentThreadCount = 1; //Calling thread included
+static uint64_t segmentThreadIndex = 0;
+static void* segmentThreadHandles[BITSTREAM_SEGMENT_THREAD_MAX];
+static void* segmentStartEvents[BITSTREAM_SEGMENT_THREAD_MAX];
+static void* segmentDoneEvent = NULL;
+static uint64_t segmentThreadExit = 0;
+
+static segmentBlock segmentBlocks[BITSTREAM_SEGMENT_THREAD_MAX];
+static uint64_t* segmentStarts = NULL;
+static uint8_t* segmentFinished = NULL;
+static uint64_t segmentCountRun = 0;
+static PFN_SegmentWork segmentWork = NULL;
+static PFN_SegmentCommit segmentCommit = NULL;
+static uint64_t segmentCommitNext = 0;
+static uint64_t segmentCommitBusy = 0;
+static uint64_t segmentThreadsLeft = 0;
+static uint64_t segmentSteals = 0;
+static int segmentError = 0;
+
+void bitstreamSegmentsFind(bitstreamReader* reader, uint64_t* starts, uint64_t* segmentCount) {
+	uint32_t startFlags = BITSTREAM_FRAME_RANDOM_ACCESS | BITSTREAM_FRAME_PARAMETER_SETS;
+	uint64_t count = 0;
+	for (uint64_t f = 0; f < reader->frameCount; f++) {
+		if ((f == 0) || ((reader->frames[f].flags & startFlags) == startFlags)) {
+			starts[count] = f;
+			count++;
+		}
+	}
+	starts[count] = reader->frameCount;
+	*segmentCount = count;
+}
+
+static void segmentRecordError(int error) {
+	int noError = 0;
+	__atomic_compare_exchange_n(&segmentError, &noError, error, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+//Own block from the front first, then one segment at a time from the back of the other blocks
+static uint64_t segmentClaim(uint64_t thread, uint64_t* segment) {
+	for (uint64_t v = 0; v < segmentThreadCount; v++) {
+		uint64_t victim = (thread + v) % segmentThreadCount;
+		uint64_t* range = &(segmentBlocks[victim].range);
+		uint64_t packed = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+		while ((packed & 0xFFFFFFFF) < (packed >> 32)) {
+			uint64_t claimed = packed & 0xFFFFFFFF;
+			uint64_t update = packed + 1;
+			if (v > 0) {
+				claimed = (packed >> 32) - 1;
+				update = (claimed << 32) | (packed & 0xFFFFFFFF);
+			}
+			if (__atomic_compare_exchange_n(range, &packed, update, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				if (v > 0) {
+					__atomic_add_fetch(&segmentSteals, 1, __ATOMIC_ACQ_REL);
+				}
+				*segment = claimed;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+//Whoever gets the commit flag commits every finished segment in order, then looks once
+//more after letting go of it in case a segment finished while the flag was taken
+//(that look happens without the flag so segmentCommitNext is only ever touched atomically)
+static int segmentCommitReady() {
+	while (1) {
+		if (__atomic_exchange_n(&segmentCommitBusy, 1, __ATOMIC_SEQ_CST) == 1) {
+			return 0;
+		}
+		uint64_t commitNext = __atomic_load_n(&segmentCommitNext, __ATOMIC_SEQ_CST);
+		while ((commitNext < segmentCountRun) && (__atomic_load_n(&(segmentFinished[commitNext]), __ATOMIC_SEQ_CST) == 1)) {
+			int error = segmentCommit(commitNext);
+			if (error != 0) {
+				segmentRecordError(error);
+			}
+			commitNext++;
+			__atomic_store_n(&segmentCommitNext, commitNext, __ATOMIC_SEQ_CST);
+		}
+		__atomic_store_n(&segmentCommitBusy, 0, __ATOMIC_SEQ_CST);
+		commitNext = __atomic_load_n(&segmentCommitNext, __ATOMIC_SEQ_CST);
+		if ((commitNext >= segmentCountRun) || (__atomic_load_n(&(segmentFinished[commitNext]), __ATOMIC_SEQ_CST) == 0)) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+static int segmentRunThread(uint64_t thread) {
+	uint64_t segment = 0;
+	while (segmentClaim(thread, &segment) > 0) {
+		int error = segmentWork(thread, segment, segmentStarts[segment], segmentStarts[segment + 1]);
+		if (error != 0) {
+			segmentRecordError(error);
+		}
+		__atomic_store_n(&(segmentFinished[segment]), 1, __ATOMIC_SEQ_CST);
+		if (segmentCommit != NULL) {
+			segmentCommitReady();
+		}
+	}
+	if (__atomic_sub_fetch(&segmentThreadsLeft, 1, __ATOMIC_ACQ_REL) == 0) {
+		return syncSetEvent(segmentDoneEvent);
+	}
+	return 0;
+}
+
+static int segmentThread() {
+	uint64_t index = __atomic_fetch_add(&segmentThreadIndex, 1, __ATOMIC_ACQ_REL);
+	while (1) {
+		int error = syncEventWait(segmentStartEvents[index]);
+		RETURN_ON_ERROR(error);
+		if (segmentThreadExit > 0) { //The last one out lets the cleanup close the events
+			if (__atomic_sub_fetch(&segmentThreadsLeft, 1, __ATOMIC_ACQ_REL) == 0) {
+				return syncSetEvent(segmentDoneEvent);
+			}
+			return 0;
+		}
+		error = segmentRunThread(index);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+int bitstreamSegmentsSetupThreads(uint64_t threadCount) {
+	if ((threadCount == 0) || (threadCount > BITSTREAM_SEGMENT_THREAD_MAX) || (segmentThreadCount > 1)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	int error = 0;
+	if (segmentDoneEvent == NULL) {
+		error = syncCreateEvent(&segmentDoneEvent, 0, 0);
+		RETURN_ON_ERROR(error);
+	}
+	segmentThreadExit = 0;
+	segmentThreadIndex = 1;
+	for (uint64_t t = 1; t < threadCount; t++) {
+		error = syncCreateEvent(&(segmentStartEvents[t]), 0, 0);
+		RETURN_ON_ERROR(error);
+	}
+	for (uint64_t t = 1; t < threadCount; t++) {
+		PFN_ThreadStart threadStart = segmentThread;
+		error = syncStartThread(&(segmentThreadHandles[t]), threadStart, 0);
+		RETURN_ON_ERROR(error);
+	}
+	segmentThreadCount = threadCount;
+	return 0;
+}
+
+uint64_t bitstreamSegmentsThreadCount() {
+	return segmentThreadCount;
+}
+
+int bitstreamSegmentsRun(bitstreamReader* reader, PFN_SegmentWork work, PFN_SegmentCommit commit, uint64_t* segmentCount, uint64_t* steals) {
+	if ((reader->frames == NULL) || (reader->frameCount == 0) || (reader->frameCount > 0xFFFFFFFF)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	if (segmentDoneEvent == NULL) { //Without helper threads everything runs on the calling thread
+		int error = syncCreateEvent(&segmentDoneEvent, 0, 0);
+		RETURN_ON_ERROR(error);
+	}
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, ((reader->frameCount + 1) * sizeof(uint64_t)) + reader->frameCount, 0);
+	RETURN_ON_ERROR(error);
+	segmentStarts = (uint64_t*) memAlloc;
+	bitstreamSegmentsFind(reader, segmentStarts, &segmentCountRun);
+	segmentFinished = (uint8_t*) (&(segmentStarts[reader->frameCount + 1]));
+	memzeroBasic(segmentFinished, segmentCountRun);
+	
+	for (uint64_t t = 0; t < segmentThreadCount; t++) {
+		uint64_t blockStart = (t * segmentCountRun) / segmentThreadCount;
+		uint64_t blockEnd = ((t + 1) * segmentCountRun) / segmentThreadCount;
+		segmentBlocks[t].range = (blockEnd << 32) | blockStart;
+	}
+	segmentWork = work;
+	segmentCommit = commit;
+	segmentCommitNext = 0;
+	segmentCommitBusy = 0;
+	segmentSteals = 0;
+	segmentError = 0;
+	segmentThreadsLeft = segmentThreadCount;
+	for (uint64_t t = 1; t < segmentThreadCount; t++) {
+		error = syncSetEvent(segmentStartEvents[t]);
+		RETURN_ON_ERROR(error);
+	}
+	error = segmentRunThread(0);
+	RETURN_ON_ERROR(error);
+	error = syncEventWait(segmentDoneEvent);
+	RETURN_ON_ERROR(error);
+	
+	*segmentCount = segmentCountRun;
+	*steals = segmentSteals;
+	if ((segmentError == 0) && (commit != NULL) && (segmentCommitNext != segmentCountRun)) {
+		segmentError = ERROR_INVALID_ARGUMENT;
+	}
+	memoryDeallocate(&memAlloc);
+	segmentStarts = NULL;
+	segmentFinished = NULL;
+	return segmentError;
+}
+
+//Waits for the helper threads to get past their last event wait before closing the events
+void bitstreamSegmentsCleanupThreads() {
+	if (segmentThreadCount > 1) {
+		segmentThreadExit = 1;
+		segmentThreadsLeft = segmentThreadCount - 1;
+		for (uint64_t t = 1; t < segmentThreadCount; t++) {
+			syncSetEvent(segmentStartEvents[t]);
+		}
+		syncEventWait(segmentDoneEvent);
+		for (uint64_t t = 1; t < segmentThreadCount; t++) {
+			syncCloseEvent(&(segmentStartEvents[t]));
+		}
+	}
+	segmentThreadCount = 1;
+	if (segmentDoneEvent != NULL) {
+		syncCloseEvent(&segmentDoneEvent);
+	}
+}
@@ -0,0 +1,57 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Bitstream Segment Pool Definitions
+//The recorder starts every IDR with its own parameter sets, so a recording
+//splits into segments (IDR to the next IDR) that can be processed on their
+//own. The pool hands each thread a contiguous block of segments, threads that
+//run out steal from the back of the other blocks, and finished segments get
+//committed one at a time in segment order so results come out in file order
+#ifndef MEDIA_ENHANCED_BITSTREAM_SEGMENTS_H
+#define MEDIA_ENHANCED_BITSTREAM_SEGMENTS_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+#include "bitstreamContainer.h" //Frame index
+
+#define BITSTREAM_SEGMENT_THREAD_MAX 64
+
+//Processes the frames [frameStart, frameEnd) of a segment on any thread (thread is 0 to threadCount - 1)
+typedef int (*PFN_SegmentWork)(uint64_t thread, uint64_t segment, uint64_t frameStart, uint64_t frameEnd);
+//Gets called once per segment in segment order (never on two threads at once)
+typedef int (*PFN_SegmentCommit)(uint64_t segment);
+
+//First frame of each segment followed by frameCount (segmentStarts needs frameCount + 1 entries)
+void bitstreamSegmentsFind(bitstreamReader* reader, uint64_t* segmentStarts, uint64_t* segmentCount);
+
+//Starts threadCount - 1 helper threads (the calling thread is thread 0)
+int bitstreamSegmentsSetupThreads(uint64_t threadCount);
+uint64_t bitstreamSegmentsThreadCount();
+
+//Finds the segments and runs work on every one of them (commit can be NULL)
+//Returns the first error and how many segments were stolen from another thread's block
+int bitstreamSegmentsRun(bitstreamReader* reader, PFN_SegmentWork work, PFN_SegmentCommit commit, uint64_t* segmentCount, uint64_t* steals);
+
+void bitstreamSegmentsCleanupThreads();
+
+#endif
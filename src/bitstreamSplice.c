@@ -0,0 +1,553 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//This is the main file for the Bitstream Splice helper program
+//It cuts a frame range out of a recording or joins recordings together without
+//decoding anything: whole reserved NAL framed access units get copied (by the
+//kernel where the OS can) and the output gets its own seek table trailer
+//A cut starts at the closest random access frame at or before the requested
+//first frame so it decodes on its own, and the parameter sets get re-emitted in
+//front of that frame when it does not carry them
+//Joined recordings need the same parameter sets (as parsed) and frame timing
+//A recording the recorder never finished (no seek table trailer) can be checked
+//and repaired in place: it gets truncated after the last complete frame (or the
+//last complete IDR segment) and gets its seek table trailer
+//Usage: BitstreamSplice cut [input bitstream] [output bitstream] [first frame] [frame count]
+//   or: BitstreamSplice concat [output bitstream] [input bitstream] [input bitstream] ...
+//   or: BitstreamSplice check [bitstream]
+//   or: BitstreamSplice repair [bitstream] [frame | gop]
+
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "bitstreamContainer.h" //Frame index, views and the seek table trailer
+#include "hevcHeaders.h" //Parameter set parsers
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define SPLICE_PARAMETER_SET_MAX_BYTES 65536
+#define SPLICE_DEFAULT_UNITS_IN_TICK 1 //Frame timing when an input has neither a seek table nor SPS VUI timing (recorder default)
+#define SPLICE_DEFAULT_TIME_SCALE 60
+
+static uint8_t spliceRBSP[SPLICE_PARAMETER_SET_MAX_BYTES + HEVC_RBSP_EXTRA_BYTES];
+static bitstreamSeekTable spliceTable;
+static void* spliceOutput = NULL;
+static uint64_t spliceOutputBytes = 0;
+static hevcParameterSets spliceFirstSets; //What every joined input has to match
+
+static int spliceParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+//Frame timing from the SPS VUI of the first access unit like BitstreamFrameExtract
+//(the defaults stay when the SPS has none or cannot be parsed)
+static void spliceStreamTiming(uint8_t* accessUnit, uint64_t accessUnitBytes, uint32_t* unitsInTick, uint32_t* timeScale) {
+	*unitsInTick = SPLICE_DEFAULT_UNITS_IN_TICK;
+	*timeScale = SPLICE_DEFAULT_TIME_SCALE;
+	uint64_t position = 0;
+	bitstreamNalView nal;
+	while ((bitstreamPeekNal(accessUnit, accessUnitBytes, &position, &nal) > 0) && (nal.type >= HEVC_NAL_VPS)) {
+		bitstreamNextNal(accessUnit, accessUnitBytes, &position, &nal);
+		if ((nal.type == HEVC_NAL_SPS) && (nal.bytes <= SPLICE_PARAMETER_SET_MAX_BYTES)) {
+			hevcParameterSets sets;
+			rbspReader rbsp;
+			hevcReaderSetup(&rbsp, spliceRBSP, nal.data, nal.bytes, nal.bytes, HEVC_ISA_SCALAR);
+			if ((hevcParseSPS(&sets, &rbsp) == 0) && (sets.timeScale > 0)) {
+				*unitsInTick = sets.unitsInTick;
+				*timeScale = sets.timeScale;
+			}
+			return;
+		}
+	}
+}
+
+static int spliceOpenInput(bitstreamReader* reader, char* fileName) {
+	int error = bitstreamReaderOpen(reader, fileName);
+	RETURN_ON_ERROR(error);
+	
+	//The first access unit gets viewed straight from its reserved NAL (no index needed yet)
+	uint32_t unitsInTick = SPLICE_DEFAULT_UNITS_IN_TICK;
+	uint32_t timeScale = SPLICE_DEFAULT_TIME_SCALE;
+	uint8_t* reservedNAL = NULL;
+	if ((reader->fileBytes > BITSTREAM_RESERVED_NAL_BYTES) && (bitstreamReaderView(reader, 0, BITSTREAM_RESERVED_NAL_BYTES, &reservedNAL) == 0) &&
+		((*((uint64_t*) reservedNAL) & BITSTREAM_RESERVED_NAL_MASK) == BITSTREAM_RESERVED_NAL_START)) {
+		uint64_t accessUnitBytes = *((uint32_t*) (&(reservedNAL[6])));
+		uint8_t* accessUnit = NULL;
+		if ((accessUnitBytes <= (reader->fileBytes - BITSTREAM_RESERVED_NAL_BYTES)) && (bitstreamReaderView(reader, BITSTREAM_RESERVED_NAL_BYTES, accessUnitBytes, &accessUnit) == 0)) {
+			spliceStreamTiming(accessUnit, accessUnitBytes, &unitsInTick, &timeScale);
+		}
+	}
+	
+	uint64_t indexSource = 0;
+	error = bitstreamReaderIndex(reader, unitsInTick, timeScale, &indexSource);
+	if ((error == 0) && (reader->frameCount == 0)) {
+		error = ERROR_BITSTREAM_FRAME_RANGE;
+	}
+	if (error != 0) {
+		bitstreamReaderClose(reader);
+	}
+	return error;
+}
+
+//Parses the SPS and PPS at the start of the frame and finds where its first slice starts
+//(everything before it gets re-emitted as is)
+static int spliceParameterSets(bitstreamReader* reader, uint64_t frame, hevcParameterSets* sets, uint8_t** prefix, uint64_t* prefixBytes) {
+	uint8_t* accessUnit = NULL;
+	uint64_t accessUnitBytes = 0;
+	int error = bitstreamReaderViewFrame(reader, frame, &accessUnit, &accessUnitBytes);
+	RETURN_ON_ERROR(error);
+	uint64_t setsFound = 0;
+	uint64_t position = 0;
+	bitstreamNalView nal;
+	while ((bitstreamPeekNal(accessUnit, accessUnitBytes, &position, &nal) > 0) && (nal.type >= HEVC_NAL_VPS)) {
+		bitstreamNextNal(accessUnit, accessUnitBytes, &position, &nal);
+		if ((nal.type == HEVC_NAL_SPS) || (nal.type == HEVC_NAL_PPS)) {
+			if (nal.bytes > SPLICE_PARAMETER_SET_MAX_BYTES) {
+				return ERROR_PARSE_ISSUE;
+			}
+			rbspReader rbsp;
+			hevcReaderSetup(&rbsp, spliceRBSP, nal.data, nal.bytes, nal.bytes, HEVC_ISA_SCALAR);
+			if (nal.type == HEVC_NAL_SPS) {
+				error = hevcParseSPS(sets, &rbsp);
+				setsFound = 1;
+			}
+			else if (setsFound > 0) {
+				error = hevcParsePPS(sets, &rbsp);
+				setsFound = 3;
+			}
+			RETURN_ON_ERROR(error);
+		}
+	}
+	if ((setsFound != 3) || (position >= accessUnitBytes)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	*prefix = accessUnit;
+	*prefixBytes = position;
+	return 0;
+}
+
+static uint64_t spliceSetsMatch(hevcParameterSets* a, hevcParameterSets* b) {
+	return ((a->chromaFormat == b->chromaFormat) && (a->separateColourPlane == b->separateColourPlane) && (a->width == b->width) && (a->height == b->height) &&
+		(a->bitDepthLuma == b->bitDepthLuma) && (a->bitDepthChroma == b->bitDepthChroma) && (a->log2MaxPicOrderCntLsb == b->log2MaxPicOrderCntLsb) &&
+		(a->log2CtbSize == b->log2CtbSize) && (a->spsId == b->spsId) && (a->ppsId == b->ppsId)) ? 1 : 0;
+}
+
+//Adds the frames to the seek table at their output offsets, then copies them (reserved NALs included) in one go
+static int spliceCopyFrames(bitstreamReader* reader, uint64_t frameStart, uint64_t frameEnd) {
+	uint64_t copyOffset = reader->frames[frameStart].offset;
+	uint64_t copyEnd = reader->chainBytes;
+	if (frameEnd < reader->frameCount) {
+		copyEnd = reader->frames[frameEnd].offset;
+	}
+	for (uint64_t f = frameStart; f < frameEnd; f++) {
+		bitstreamFrameEntry* entry = &(reader->frames[f]);
+		uint64_t peekBytes = entry->bytes;
+		if (peekBytes > BITSTREAM_CLASSIFY_BYTES) {
+			peekBytes = BITSTREAM_CLASSIFY_BYTES;
+		}
+		uint8_t* peek = NULL;
+		int error = bitstreamReaderView(reader, entry->offset + BITSTREAM_RESERVED_NAL_BYTES, peekBytes, &peek);
+		RETURN_ON_ERROR(error);
+		bitstreamSeekTableAdd(&spliceTable, spliceOutputBytes + (entry->offset - copyOffset), peek, entry->bytes);
+	}
+	int error = ioCopyFileRange(spliceOutput, reader->file, copyOffset, copyEnd - copyOffset);
+	RETURN_ON_ERROR(error);
+	spliceOutputBytes += copyEnd - copyOffset;
+	return 0;
+}
+
+//Re-emits the parameter sets of an earlier frame inside the first frame's access unit
+static int spliceCopyFrameWithSets(bitstreamReader* reader, uint64_t frame, uint64_t setsFrame) {
+	hevcParameterSets sets;
+	uint8_t* prefix = NULL;
+	uint64_t prefixBytes = 0;
+	int error = spliceParameterSets(reader, setsFrame, &sets, &prefix, &prefixBytes);
+	RETURN_ON_ERROR(error);
+	bitstreamFrameEntry* entry = &(reader->frames[frame]);
+	if ((prefixBytes + entry->bytes) > 0xFFFFFFFF) {
+		return ERROR_BITSTREAM_BUFFER_TOO_SMALL;
+	}
+	uint8_t reservedNAL[BITSTREAM_RESERVED_NAL_BYTES] = {0, 0, 0, 1, 0x54, 0x01, 0, 0, 0, 0};
+	*((uint32_t*) (&(reservedNAL[6]))) = (uint32_t) (prefixBytes + entry->bytes);
+	bitstreamSeekTableAdd(&spliceTable, spliceOutputBytes, prefix, prefixBytes + entry->bytes);
+	spliceTable.frames[spliceTable.frameCount - 1].flags = entry->flags | BITSTREAM_FRAME_PARAMETER_SETS; //The prefix is not followed by this frame's slices
+	
+	error = ioWriteFile(spliceOutput, reservedNAL, BITSTREAM_RESERVED_NAL_BYTES);
+	RETURN_ON_ERROR(error);
+	error = ioWriteFile(spliceOutput, prefix, (uint32_t) prefixBytes);
+	RETURN_ON_ERROR(error);
+	error = ioCopyFileRange(spliceOutput, reader->file, entry->offset + BITSTREAM_RESERVED_NAL_BYTES, entry->bytes);
+	RETURN_ON_ERROR(error);
+	spliceOutputBytes += BITSTREAM_RESERVED_NAL_BYTES + prefixBytes + entry->bytes;
+	return 0;
+}
+
+static int spliceFinish(uint64_t startTime) {
+	uint64_t trailerBytes = bitstreamSeekTableFinish(&spliceTable, spliceOutputBytes);
+	int error = 0;
+	if (trailerBytes > 0) {
+		error = ioWriteFile(spliceOutput, spliceTable.trailer, (uint32_t) trailerBytes);
+	}
+	else {
+		consolePrintLine(106);
+	}
+	int closeError = ioCloseFile(&spliceOutput);
+	RETURN_ON_ERROR(error);
+	RETURN_ON_ERROR(closeError);
+	uint64_t stopTime = getCurrentTime();
+	consolePrintLineWithNumber(128, spliceTable.frameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(131, spliceOutputBytes + trailerBytes, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(132, getDiffTimeMicroseconds(startTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
+	return 0;
+}
+
+static int spliceCut(char* inputFileName, char* outputFileName, uint64_t firstFrame, uint64_t frameCount) {
+	bitstreamReader reader;
+	int error = spliceOpenInput(&reader, inputFileName);
+	RETURN_ON_ERROR(error);
+	if (firstFrame >= reader.frameCount) {
+		bitstreamReaderClose(&reader);
+		return ERROR_BITSTREAM_FRAME_RANGE;
+	}
+	uint64_t frameEnd = reader.frameCount;
+	if ((frameCount > 0) && (frameCount < (reader.frameCount - firstFrame))) {
+		frameEnd = firstFrame + frameCount;
+	}
+	uint64_t frameStart = firstFrame;
+	while ((frameStart > 0) && ((reader.frames[frameStart].flags & BITSTREAM_FRAME_RANDOM_ACCESS) == 0)) {
+		frameStart--;
+	}
+	uint64_t setsFrame = frameStart;
+	while ((setsFrame > 0) && ((reader.frames[setsFrame].flags & BITSTREAM_FRAME_PARAMETER_SETS) == 0)) {
+		setsFrame--;
+	}
+	consolePrintLineWithNumber(129, frameStart, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	uint64_t startTime = getCurrentTime();
+	error = bitstreamSeekTableSetup(&spliceTable, frameEnd - frameStart, reader.unitsInTick, reader.timeScale);
+	if (error == 0) {
+		spliceOutputBytes = 0;
+		error = ioOpenFile(&spliceOutput, outputFileName, -1, IO_FILE_WRITE_NORMAL);
+	}
+	if ((error == 0) && (setsFrame != frameStart)) {
+		consolePrintLineWithNumber(130, setsFrame, NUM_FORMAT_UNSIGNED_INTEGER);
+		error = spliceCopyFrameWithSets(&reader, frameStart, setsFrame);
+		frameStart++;
+	}
+	if ((error == 0) && (frameStart < frameEnd)) {
+		error = spliceCopyFrames(&reader, frameStart, frameEnd);
+	}
+	if (error == 0) {
+		error = spliceFinish(startTime);
+	}
+	bitstreamSeekTableCleanup(&spliceTable);
+	bitstreamReaderClose(&reader);
+	return error;
+}
+
+//First pass checks every input against the first one and counts the frames, second pass copies
+static int spliceConcat(char* outputFileName, uint64_t inputArgument, uint64_t inputCount) {
+	uint32_t unitsInTick = 0;
+	uint32_t timeScale = 0;
+	uint64_t totalFrames = 0;
+	char* inputFileName = NULL;
+	uint64_t inputFileNameBytes = 0;
+	for (uint64_t i = 0; i < inputCount; i++) {
+		int error = ioGetCommandArgument(inputArgument + i, &inputFileName, &inputFileNameBytes);
+		RETURN_ON_ERROR(error);
+		bitstreamReader reader;
+		error = spliceOpenInput(&reader, inputFileName);
+		RETURN_ON_ERROR(error);
+		hevcParameterSets sets;
+		uint8_t* prefix = NULL;
+		uint64_t prefixBytes = 0;
+		uint32_t startFlags = BITSTREAM_FRAME_RANDOM_ACCESS | BITSTREAM_FRAME_PARAMETER_SETS;
+		error = spliceParameterSets(&reader, 0, &sets, &prefix, &prefixBytes);
+		if ((error == 0) && (i == 0)) {
+			spliceFirstSets = sets;
+			unitsInTick = reader.unitsInTick;
+			timeScale = reader.timeScale;
+		}
+		else if ((error == 0) && ((spliceSetsMatch(&spliceFirstSets, &sets) == 0) || (reader.unitsInTick != unitsInTick) || (reader.timeScale != timeScale))) {
+			error = ERROR_PARSE_ISSUE;
+		}
+		if ((error == 0) && ((reader.frames[0].flags & startFlags) != startFlags)) {
+			error = ERROR_PARSE_ISSUE;
+		}
+		totalFrames += reader.frameCount;
+		bitstreamReaderClose(&reader);
+		if (error != 0) {
+			consolePrintLineWithNumber(134, i + 1, NUM_FORMAT_UNSIGNED_INTEGER);
+			return error;
+		}
+	}
+	consolePrintLineWithNumber(133, inputCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	uint64_t startTime = getCurrentTime();
+	int error = bitstreamSeekTableSetup(&spliceTable, totalFrames, unitsInTick, timeScale);
+	RETURN_ON_ERROR(error);
+	spliceOutputBytes = 0;
+	error = ioOpenFile(&spliceOutput, outputFileName, -1, IO_FILE_WRITE_NORMAL);
+	for (uint64_t i = 0; (i < inputCount) && (error == 0); i++) {
+		error = ioGetCommandArgument(inputArgument + i, &inputFileName, &inputFileNameBytes);
+		RETURN_ON_ERROR(error);
+		bitstreamReader reader;
+		error = spliceOpenInput(&reader, inputFileName);
+		RETURN_ON_ERROR(error);
+		error = spliceCopyFrames(&reader, 0, reader.frameCount); //The seek table trailer (if any) gets left behind
+		bitstreamReaderClose(&reader);
+	}
+	if (error == 0) {
+		error = spliceFinish(startTime);
+	}
+	bitstreamSeekTableCleanup(&spliceTable);
+	return error;
+}
+
+//Walks the reserved NAL chain over the mapped file and checks every access unit against
+//its start codes: it has to start with one, can not hold another reserved NAL (a size
+//prefix that runs past its frame) and can not end with a zero byte (the tail of a file
+//that got extended before its data was written)
+typedef struct spliceChainScan {
+	uint64_t frames; //Complete frames from the start of the file
+	uint64_t bytes; //Where the last complete frame ends
+	uint64_t nalUnits;
+	uint64_t trailer; //1 when a seek table trailer follows the last frame and ends the file
+	uint64_t segmentFrame; //First frame and offset of the last IDR segment
+	uint64_t segmentOffset;
+} spliceChainScan;
+
+static void spliceScanChain(uint8_t* fileData, uint64_t fileBytes, uint64_t isa, spliceChainScan* scan) {
+	scan->frames = 0;
+	scan->bytes = 0;
+	scan->nalUnits = 0;
+	scan->trailer = 0;
+	scan->segmentFrame = 0;
+	scan->segmentOffset = 0;
+	uint32_t startFlags = BITSTREAM_FRAME_RANDOM_ACCESS | BITSTREAM_FRAME_PARAMETER_SETS;
+	uint64_t offset = 0;
+	while ((fileBytes - offset) >= BITSTREAM_RESERVED_NAL_BYTES) {
+		uint8_t* reservedNAL = &(fileData[offset]);
+		uint64_t accessUnitBytes = *((uint32_t*) (&(reservedNAL[6])));
+		if (((*((uint64_t*) reservedNAL) & BITSTREAM_RESERVED_NAL_MASK) != BITSTREAM_RESERVED_NAL_START) ||
+			(accessUnitBytes < 4) || (accessUnitBytes > (fileBytes - offset - BITSTREAM_RESERVED_NAL_BYTES))) {
+			break;
+		}
+		uint8_t* accessUnit = &(reservedNAL[BITSTREAM_RESERVED_NAL_BYTES]);
+		if ((accessUnitBytes >= 8) && (*((uint64_t*) accessUnit) == BITSTREAM_SEEK_TABLE_MAGIC)) {
+			if ((offset + BITSTREAM_RESERVED_NAL_BYTES + accessUnitBytes) == fileBytes) {
+				scan->trailer = 1;
+			}
+			break;
+		}
+		uint64_t reservedPosition = 0;
+		uint64_t nalUnits = hevcCountStartCodes(accessUnit, accessUnitBytes, BITSTREAM_RESERVED_NAL_TYPE, &reservedPosition, isa);
+		uint64_t startsWithCode = ((accessUnit[0] == 0) && (accessUnit[1] == 0) && ((accessUnit[2] == 1) || ((accessUnit[2] == 0) && (accessUnit[3] == 1)))) ? 1 : 0;
+		if ((nalUnits == 0) || (startsWithCode == 0) || (reservedPosition != accessUnitBytes) || (accessUnit[accessUnitBytes - 1] == 0)) {
+			break;
+		}
+		uint64_t classifyBytes = accessUnitBytes;
+		if (classifyBytes > BITSTREAM_CLASSIFY_BYTES) {
+			classifyBytes = BITSTREAM_CLASSIFY_BYTES;
+		}
+		if ((bitstreamClassifyAccessUnit(accessUnit, classifyBytes) & startFlags) == startFlags) {
+			scan->segmentFrame = scan->frames;
+			scan->segmentOffset = offset;
+		}
+		scan->nalUnits += nalUnits;
+		scan->frames++;
+		offset += BITSTREAM_RESERVED_NAL_BYTES + accessUnitBytes;
+		scan->bytes = offset;
+	}
+}
+
+static int spliceRepair(char* fileName, uint64_t repair, uint64_t wholeSegments) {
+	bitstreamReader reader;
+	int error = bitstreamReaderOpen(&reader, fileName);
+	RETURN_ON_ERROR(error);
+	uint8_t* fileData = NULL;
+	error = bitstreamReaderMapAll(&reader, &fileData);
+	if (error != 0) {
+		bitstreamReaderClose(&reader);
+		return error;
+	}
+	
+	spliceChainScan scan;
+	uint64_t startTime = getCurrentTime();
+	spliceScanChain(fileData, reader.fileBytes, hevcGetMaxISA(), &scan);
+	uint64_t stopTime = getCurrentTime();
+	uint64_t scanTime = getDiffTimeMicroseconds(startTime, stopTime);
+	if (scanTime == 0) {
+		scanTime = 1;
+	}
+	consolePrintLineWithNumber(135, scan.frames, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(136, scan.nalUnits, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(137, scanTime, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(138, scan.bytes / scanTime, NUM_FORMAT_UNSIGNED_INTEGER); //Bytes per us is MB/s
+	
+	//The recorder's checkpoint journal (if there is one) says how much of the chain was flushed
+	bitstreamCheckpointRecord checkpoint;
+	uint64_t checkpointCount = 0;
+	error = bitstreamCheckpointLoad(fileName, &checkpoint, &checkpointCount);
+	if ((error == 0) && (checkpointCount > 0)) {
+		if ((checkpoint.chainBytes <= scan.bytes) && (bitstreamChecksumChain(fileData, checkpoint.chainBytes, checkpoint.frameCount) == checkpoint.checksum)) {
+			consolePrintLineWithNumber(154, checkpoint.frameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		}
+		else {
+			consolePrintLine(155);
+		}
+	}
+	if (scan.trailer > 0) {
+		consolePrintLine(139);
+		bitstreamReaderClose(&reader);
+		return 0;
+	}
+	consolePrintLineWithNumber(140, reader.fileBytes - scan.bytes, NUM_FORMAT_UNSIGNED_INTEGER);
+	if ((wholeSegments > 0) && (scan.segmentFrame > 0)) { //Every earlier segment was followed by another IDR
+		scan.frames = scan.segmentFrame;
+		scan.bytes = scan.segmentOffset;
+	}
+	consolePrintLineWithNumber(141, scan.frames, NUM_FORMAT_UNSIGNED_INTEGER);
+	if ((repair == 0) || (scan.frames == 0)) {
+		bitstreamReaderClose(&reader);
+		return (scan.frames == 0) ? ERROR_BITSTREAM_BROKEN_CHAIN : 0;
+	}
+	
+	//The trailer gets built from the mapped frames before the file changes
+	uint32_t unitsInTick = SPLICE_DEFAULT_UNITS_IN_TICK;
+	uint32_t timeScale = SPLICE_DEFAULT_TIME_SCALE;
+	spliceStreamTiming(&(fileData[BITSTREAM_RESERVED_NAL_BYTES]), *((uint32_t*) (&(fileData[6]))), &unitsInTick, &timeScale); //The scan found at least one complete frame
+	error = bitstreamSeekTableSetup(&spliceTable, scan.frames, unitsInTick, timeScale);
+	uint64_t offset = 0;
+	for (uint64_t f = 0; (f < scan.frames) && (error == 0); f++) {
+		uint64_t accessUnitBytes = *((uint32_t*) (&(fileData[offset + 6])));
+		bitstreamSeekTableAdd(&spliceTable, offset, &(fileData[offset + BITSTREAM_RESERVED_NAL_BYTES]), accessUnitBytes);
+		offset += BITSTREAM_RESERVED_NAL_BYTES + accessUnitBytes;
+	}
+	uint64_t trailerBytes = 0;
+	if (error == 0) {
+		trailerBytes = bitstreamSeekTableFinish(&spliceTable, scan.bytes);
+	}
+	bitstreamReaderClose(&reader);
+	
+	void* file = NULL;
+	if (error == 0) {
+		error = ioOpenFile(&file, fileName, -1, IO_FILE_UPDATE_NORMAL);
+	}
+	if (error == 0) {
+		error = ioSetFileSize(file, scan.bytes);
+		if ((error == 0) && (trailerBytes > 0)) {
+			error = ioWriteFile(file, spliceTable.trailer, (uint32_t) trailerBytes);
+		}
+		int closeError = ioCloseFile(&file);
+		if (error == 0) {
+			error = closeError;
+		}
+	}
+	bitstreamSeekTableCleanup(&spliceTable);
+	RETURN_ON_ERROR(error);
+	
+	//Reopened like any other tool would (the trailer should load)
+	error = spliceOpenInput(&reader, fileName);
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(95, reader.frameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLine(142);
+	bitstreamReaderClose(&reader);
+	return 0;
+}
+
+//Program Main Function
+int programMain() {
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	int error = ioGetCommandArgument(1, &argument, &argumentBytes);
+	if ((error != 0) || (argumentBytes < 3)) {
+		return ERROR_ARGUMENT_DNE;
+	}
+	uint64_t concat = 0;
+	uint64_t repair = 0; //1 only checks, 2 repairs
+	if ((argumentBytes == 6) && (argument[0] == 'c') && (argument[1] == 'o') && (argument[2] == 'n') && (argument[3] == 'c') && (argument[4] == 'a') && (argument[5] == 't')) {
+		concat = 1;
+	}
+	else if ((argumentBytes == 5) && (argument[0] == 'c') && (argument[1] == 'h') && (argument[2] == 'e') && (argument[3] == 'c') && (argument[4] == 'k')) {
+		repair = 1;
+	}
+	else if ((argumentBytes == 6) && (argument[0] == 'r') && (argument[1] == 'e') && (argument[2] == 'p') && (argument[3] == 'a') && (argument[4] == 'i') && (argument[5] == 'r')) {
+		repair = 2;
+	}
+	else if ((argumentBytes != 3) || (argument[0] != 'c') || (argument[1] != 'u') || (argument[2] != 't')) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	if (repair > 0) {
+		char* fileName = NULL;
+		error = ioGetCommandArgument(2, &fileName, &argumentBytes);
+		RETURN_ON_ERROR(error);
+		uint64_t wholeSegments = 0;
+		if ((ioGetCommandArgument(3, &argument, &argumentBytes) == 0) && (argumentBytes == 3) && (argument[0] == 'g') && (argument[1] == 'o') && (argument[2] == 'p')) {
+			wholeSegments = 1;
+		}
+		return spliceRepair(fileName, repair - 1, wholeSegments);
+	}
+	
+	if (concat > 0) {
+		char* outputFileName = NULL;
+		error = ioGetCommandArgument(2, &outputFileName, &argumentBytes);
+		RETURN_ON_ERROR(error);
+		uint64_t inputCount = 0;
+		while (ioGetCommandArgument(3 + inputCount, &argument, &argumentBytes) == 0) {
+			inputCount++;
+		}
+		if (inputCount == 0) {
+			return ERROR_ARGUMENT_DNE;
+		}
+		return spliceConcat(outputFileName, 3, inputCount);
+	}
+	
+	char* inputFileName = NULL;
+	char* outputFileName = NULL;
+	error = ioGetCommandArgument(2, &inputFileName, &argumentBytes);
+	RETURN_ON_ERROR(error);
+	error = ioGetCommandArgument(3, &outputFileName, &argumentBytes);
+	RETURN_ON_ERROR(error);
+	uint64_t firstFrame = 0;
+	uint64_t frameCount = 0; //0 runs to the end of the input
+	if (ioGetCommandArgument(4, &argument, &argumentBytes) == 0) {
+		error = spliceParseNumber(argument, argumentBytes, &firstFrame);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(5, &argument, &argumentBytes) == 0) {
+		error = spliceParseNumber(argument, argumentBytes, &frameCount);
+		RETURN_ON_ERROR(error);
+	}
+	return spliceCut(inputFileName, outputFileName, firstFrame, frameCount);
+}
@@ -0,0 +1,284 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Bitstream Statistics Functions
+//Parses every slice segment header of each IDR segment on whichever pool
+//thread gets it, and then writes the records in frame order
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "bitstreamStats.h" //Include Bitstream Statistics Function Definitions
+#include "hevcHeaders.h" //Slice segment header and parameter set parsers
+#include "bitstreamSegments.h" //IDR segments spread over the thread pool
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define STATS_PARAMETER_SET_MAX_BYTES 4096 //The recorder's are well under a kilobyte
+#define STATS_WRITE_BUFFER_BYTES 1048576
+#define STATS_WRITE_FLUSH_BYTES (STATS_WRITE_BUFFER_BYTES - 128) //Every single put is shorter than this margin
+
+//Per thread scratch (index 0 is the calling thread)
+static uint8_t statsSliceRBSP[BITSTREAM_SEGMENT_THREAD_MAX][HEVC_SLICE_HEADER_BYTES + HEVC_RBSP_EXTRA_BYTES];
+static uint8_t statsParameterSetRBSP[BITSTREAM_SEGMENT_THREAD_MAX][STATS_PARAMETER_SET_MAX_BYTES + HEVC_RBSP_EXTRA_BYTES];
+
+static bitstreamReader* statsReader = NULL;
+static uint8_t* statsFileData = NULL;
+static bitstreamStatsFrame* statsFrames = NULL;
+static uint64_t statsISA = HEVC_ISA_SCALAR;
+
+//Parameter sets only carry over inside a segment, so every segment parses its own
+static int statsParseSegment(uint64_t thread, uint64_t segment, uint64_t frameStart, uint64_t frameEnd) {
+	hevcParameterSets sets;
+	uint64_t setsFound = 0; //1 for the SPS and 2 for the PPS
+	for (uint64_t f = frameStart; f < frameEnd; f++) {
+		bitstreamFrameEntry* entry = &(statsReader->frames[f]);
+		uint8_t* accessUnit = &(statsFileData[entry->offset + BITSTREAM_RESERVED_NAL_BYTES]);
+		uint64_t accessUnitBytes = entry->bytes;
+		bitstreamStatsFrame* stats = &(statsFrames[f]);
+		stats->nalType = HEVC_NAL_VPS; //Stays a non slice type when the frame has no slices
+		stats->sliceType = 0;
+		stats->mixedSliceTypes = 0;
+		stats->picOrderCntLsb = 0;
+		stats->sliceSegments = 0;
+		stats->parseErrors = 0;
+		
+		uint64_t position = 0;
+		bitstreamNalView nal;
+		while (bitstreamPeekNal(accessUnit, accessUnitBytes, &position, &nal) > 0) {
+			if (nal.type < HEVC_NAL_VPS) {
+				stats->sliceSegments++;
+				hevcSliceHeader header;
+				rbspReader rbsp;
+				hevcReaderSetup(&rbsp, statsSliceRBSP[thread], nal.data, nal.bytes, HEVC_SLICE_HEADER_BYTES, statsISA);
+				if ((setsFound != 3) || (hevcParseSliceHeader(&sets, &rbsp, nal.type, &header) != 0)) {
+					stats->parseErrors++;
+				}
+				else if (stats->nalType == HEVC_NAL_VPS) {
+					stats->nalType = header.nalType;
+					stats->sliceType = header.sliceType;
+					stats->picOrderCntLsb = header.picOrderCntLsb;
+				}
+				else if ((header.dependentSliceSegment == 0) && (header.sliceType != stats->sliceType)) {
+					stats->mixedSliceTypes = 1;
+				}
+			}
+			bitstreamNextNal(accessUnit, accessUnitBytes, &position, &nal); //Moves past the slice data (and gives the full parameter set)
+			
+			if ((nal.type == HEVC_NAL_SPS) || (nal.type == HEVC_NAL_PPS)) {
+				if (nal.bytes > STATS_PARAMETER_SET_MAX_BYTES) {
+					stats->parseErrors++;
+					continue;
+				}
+				rbspReader rbsp;
+				hevcReaderSetup(&rbsp, statsParameterSetRBSP[thread], nal.data, nal.bytes, nal.bytes, statsISA);
+				if (nal.type == HEVC_NAL_SPS) {
+					setsFound = 0;
+					if (hevcParseSPS(&sets, &rbsp) == 0) {
+						setsFound = 1;
+					}
+					else {
+						stats->parseErrors++;
+					}
+				}
+				else if ((setsFound > 0) && (hevcParsePPS(&sets, &rbsp) == 0)) {
+					setsFound = 3;
+				}
+				else {
+					stats->parseErrors++;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+int bitstreamStatsRun(bitstreamReader* reader, bitstreamStatsFrame* frames, uint64_t* segmentCount, uint64_t* steals) {
+	int error = bitstreamReaderMapAll(reader, &statsFileData);
+	RETURN_ON_ERROR(error);
+	statsReader = reader;
+	statsFrames = frames;
+	statsISA = hevcGetMaxISA();
+	return bitstreamSegmentsRun(reader, statsParseSegment, NULL, segmentCount, steals);
+}
+
+//"name": number followed by a comma and a new line
+static int statsPutField(bitstreamTextWriter* writer, char* name, uint64_t number) {
+	int error = bitstreamTextPut(writer, "\t\"");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(writer, name);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(writer, "\": ");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPutNumber(writer, number);
+	RETURN_ON_ERROR(error);
+	return bitstreamTextPut(writer, ",\n");
+}
+
+//Output names are the bitstream file name with the extension added
+static int statsWriterOpen(bitstreamTextWriter* writer, char* fileName, char* extension, char* buffer) {
+	char outputName[BITSTREAM_FILE_NAME_MAX];
+	int error = bitstreamSideFileName(outputName, fileName, extension);
+	RETURN_ON_ERROR(error);
+	return bitstreamTextOpen(writer, outputName, buffer, STATS_WRITE_FLUSH_BYTES);
+}
+
+static int statsWriteCSV(bitstreamReader* reader, bitstreamStatsFrame* frames, bitstreamTextWriter* writer) {
+	int error = bitstreamTextPut(writer, "frame,offset,bytes,presentation_us,nal_type,slice_type,poc_lsb,slice_segments,mixed_slice_types,parse_errors,flags,idr,frames_since_idr\n");
+	RETURN_ON_ERROR(error);
+	uint64_t lastIDR = 0;
+	for (uint64_t f = 0; f < reader->frameCount; f++) {
+		bitstreamFrameEntry* entry = &(reader->frames[f]);
+		bitstreamStatsFrame* stats = &(frames[f]);
+		uint64_t idr = 0;
+		if ((entry->flags & BITSTREAM_FRAME_IDR) > 0) {
+			idr = 1;
+			lastIDR = f;
+		}
+		uint64_t values[13] = {f, entry->offset, entry->bytes, entry->presentationTime, stats->nalType, stats->sliceType, stats->picOrderCntLsb,
+			stats->sliceSegments, stats->mixedSliceTypes, stats->parseErrors, entry->flags, idr, f - lastIDR};
+		for (uint64_t v = 0; v < 13; v++) {
+			error = bitstreamTextPutNumber(writer, values[v]);
+			RETURN_ON_ERROR(error);
+			error = bitstreamTextPut(writer, (v < 12) ? "," : "\n");
+			RETURN_ON_ERROR(error);
+		}
+	}
+	return 0;
+}
+
+static int statsWriteJSON(bitstreamReader* reader, bitstreamStatsFrame* frames, uint64_t idrInterval, bitstreamTextWriter* writer) {
+	uint64_t durationUs = 0;
+	if (reader->timeScale > 0) {
+		durationUs = (reader->frameCount * reader->unitsInTick * 1000000) / reader->timeScale;
+	}
+	uint64_t totalBytes = 0;
+	uint64_t sliceTypeFrames[3] = {0, 0, 0};
+	uint64_t noSliceFrames = 0;
+	uint64_t mixedFrames = 0;
+	uint64_t parseErrors = 0;
+	uint64_t idrFrames = 0;
+	uint64_t idrIntervalMin = 0;
+	uint64_t idrIntervalMax = 0;
+	uint64_t idrIntervalMismatches = 0;
+	uint64_t lastIDR = 0;
+	for (uint64_t f = 0; f < reader->frameCount; f++) {
+		totalBytes += reader->frames[f].bytes;
+		if (frames[f].nalType >= HEVC_NAL_VPS) {
+			noSliceFrames++;
+		}
+		else if (frames[f].sliceType <= HEVC_SLICE_I) {
+			sliceTypeFrames[frames[f].sliceType]++;
+		}
+		mixedFrames += frames[f].mixedSliceTypes;
+		parseErrors += frames[f].parseErrors;
+		if ((reader->frames[f].flags & BITSTREAM_FRAME_IDR) > 0) {
+			if (idrFrames > 0) {
+				uint64_t interval = f - lastIDR;
+				if ((idrFrames == 1) || (interval < idrIntervalMin)) {
+					idrIntervalMin = interval;
+				}
+				if (interval > idrIntervalMax) {
+					idrIntervalMax = interval;
+				}
+				if (interval != idrInterval) {
+					idrIntervalMismatches++;
+				}
+			}
+			idrFrames++;
+			lastIDR = f;
+		}
+	}
+	
+	//Bitrate over time: the frame bits presented in each bucket
+	uint64_t bucketCount = (durationUs + BITSTREAM_STATS_BUCKET_US - 1) / BITSTREAM_STATS_BUCKET_US;
+	if (bucketCount == 0) {
+		bucketCount = 1;
+	}
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, bucketCount * sizeof(uint64_t), 0);
+	RETURN_ON_ERROR(error);
+	uint64_t* bucketBits = (uint64_t*) memAlloc;
+	memzeroBasic(bucketBits, bucketCount * sizeof(uint64_t));
+	for (uint64_t f = 0; f < reader->frameCount; f++) {
+		uint64_t bucket = reader->frames[f].presentationTime / BITSTREAM_STATS_BUCKET_US;
+		if (bucket >= bucketCount) {
+			bucket = bucketCount - 1;
+		}
+		bucketBits[bucket] += ((uint64_t) reader->frames[f].bytes) << 3;
+	}
+	uint64_t peakBucket = 0;
+	for (uint64_t b = 1; b < bucketCount; b++) {
+		if (bucketBits[b] > bucketBits[peakBucket]) {
+			peakBucket = b;
+		}
+	}
+	uint64_t averageBitsPerSecond = 0;
+	if (durationUs > 0) {
+		averageBitsPerSecond = ((totalBytes << 3) * 1000000) / durationUs;
+	}
+	
+	uint64_t fields[23] = {reader->frameCount, reader->fileBytes, totalBytes, reader->maxFrameBytes, reader->unitsInTick, reader->timeScale, durationUs, averageBitsPerSecond,
+		sliceTypeFrames[HEVC_SLICE_B], sliceTypeFrames[HEVC_SLICE_P], sliceTypeFrames[HEVC_SLICE_I], noSliceFrames, mixedFrames, parseErrors,
+		idrFrames, idrInterval, idrIntervalMin, idrIntervalMax, idrIntervalMismatches, BITSTREAM_STATS_BUCKET_US, bucketCount, peakBucket, bucketBits[peakBucket]};
+	static char* fieldNames[23] = {"frames", "fileBytes", "accessUnitBytes", "maxFrameBytes", "unitsInTick", "timeScale", "durationUs", "averageBitsPerSecond",
+		"framesSliceB", "framesSliceP", "framesSliceI", "framesWithoutSlices", "framesMixedSliceTypes", "parseErrors",
+		"idrFrames", "idrIntervalExpected", "idrIntervalMin", "idrIntervalMax", "idrIntervalMismatches", "bucketUs", "buckets", "peakBucket", "peakBucketBits"};
+	error = bitstreamTextPut(writer, "{\n");
+	for (uint64_t i = 0; (i < 23) && (error == 0); i++) {
+		error = statsPutField(writer, fieldNames[i], fields[i]);
+	}
+	if (error == 0) {
+		error = bitstreamTextPut(writer, "\t\"bucketBits\": [");
+	}
+	for (uint64_t b = 0; (b < bucketCount) && (error == 0); b++) {
+		error = bitstreamTextPutNumber(writer, bucketBits[b]);
+		if ((error == 0) && ((b + 1) < bucketCount)) {
+			error = bitstreamTextPut(writer, ", ");
+		}
+	}
+	if (error == 0) {
+		error = bitstreamTextPut(writer, "]\n}\n");
+	}
+	memoryDeallocate((void**) &bucketBits);
+	return error;
+}
+
+int bitstreamStatsWrite(bitstreamReader* reader, bitstreamStatsFrame* frames, uint64_t idrInterval) {
+	bitstreamTextWriter writer;
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, STATS_WRITE_BUFFER_BYTES, 0);
+	RETURN_ON_ERROR(error);
+	
+	error = statsWriterOpen(&writer, reader->fileName, ".stats.csv", (char*) memAlloc);
+	if (error == 0) {
+		error = bitstreamTextClose(&writer, statsWriteCSV(reader, frames, &writer));
+	}
+	if (error == 0) {
+		error = statsWriterOpen(&writer, reader->fileName, ".stats.json", (char*) memAlloc);
+	}
+	if (error == 0) {
+		error = bitstreamTextClose(&writer, statsWriteJSON(reader, frames, idrInterval, &writer));
+	}
+	memoryDeallocate((void**) &memAlloc);
+	return error;
+}
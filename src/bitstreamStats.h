@@ -0,0 +1,56 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Bitstream Statistics Definitions
+//Parses every slice segment header of a recording and writes per frame records
+//(CSV) plus a summary with the IDR cadence and a bitrate over time histogram
+//(JSON) next to the bitstream file (bitstream.h265 -> bitstream.h265.stats.csv
+//and bitstream.h265.stats.json)
+//Segments that start with an IDR and its parameter sets decode on their own,
+//so the segment pool's threads take whole segments while the frame records stay in order
+#ifndef MEDIA_ENHANCED_BITSTREAM_STATS_H
+#define MEDIA_ENHANCED_BITSTREAM_STATS_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+#include "bitstreamContainer.h" //Frame index and frame data
+
+#define BITSTREAM_STATS_BUCKET_US 1000000 //Bitrate histogram bucket (one second)
+
+typedef struct bitstreamStatsFrame {
+	uint32_t nalType; //First slice segment's NAL unit type
+	uint32_t sliceType; //First slice segment's slice type
+	uint32_t mixedSliceTypes; //1 when the independent slice segments disagree
+	uint32_t picOrderCntLsb;
+	uint32_t sliceSegments;
+	uint32_t parseErrors; //Slice segment headers (or parameter sets) that did not parse
+} bitstreamStatsFrame;
+
+//Maps the whole file and fills one record per indexed frame on the segment pool's threads
+//(bitstreamSegmentsSetupThreads) and returns how many IDR segments there were and how many got stolen
+int bitstreamStatsRun(bitstreamReader* reader, bitstreamStatsFrame* frames, uint64_t* segmentCount, uint64_t* steals);
+
+//Writes the .stats.csv and .stats.json files (idrInterval is the expected frames from one IDR to the next, 0 when unknown)
+int bitstreamStatsWrite(bitstreamReader* reader, bitstreamStatsFrame* frames, uint64_t idrInterval);
+
+#endif
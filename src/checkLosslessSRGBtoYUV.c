@@ -21,18 +21,19 @@
 
 
 //Mini helper program that checks that the various sRGB (8-bit) to YCbCr (10-bit)
-//conversions have inverses
+//conversions have inverses and that the partial LUT conversion
+//(shaderPartial.comp.glsl) matches the full LUT for every sRGB value
 
 //Include C runtime library headers for simple portable mini helper program
 #include <stdint.h>	//Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+#include <inttypes.h> //Format macros for the 64-bit values (long on 64-bit Linux, long long on Windows)
 #include <stdlib.h>	//Needed for easy dynamic memory operations malloc & free
 #include <stdio.h>	//Needed for printf statements and general file operations
 #include <string.h> //Needed for memset
 
 #include "math.h"
+#include "colorConvert.h" //sRGB loop constants & LUT generation
 
-#define SRGB_MAX_VALUE 256
-#define NUM_SRGB_VALUES 16777216 //SRGB_MAX_VALUE ^ 3
 #define NUM_POSSIBLE_RESULTS (1 << 30)
 
 void testSRGBtoYCbCr709(uint32_t* conversionLUT, uint16_t* conversionResults) {
@@ -108,7 +109,7 @@ void testSRGBtoYCbCr709(uint32_t* conversionLUT, uint16_t* conversionResults) {
 }
 
 void analyzeSRGBtoYCbCr(uint64_t red, uint64_t green, uint64_t blue) {
-	printf("Analyzing sRGB: %lld, %lld, %lld:\n", red, green, blue);
+	printf("Analyzing sRGB: %" PRIu64 ", %" PRIu64 ", %" PRIu64 ":\n", red, green, blue);
 	
 	const double sRGBranged = 1.0 / 255.0;
 	
@@ -255,6 +256,44 @@ void yuvCreateTestFile(uint64_t yValue, uint64_t uValue, uint64_t vValue) {
 	fclose(yuvFile);
 }
 
+//Exhaustive check of the partial LUT (3 x 256 entries + tie corrections) against the full LUT
+uint32_t checkPartialLUT() {
+	uint32_t* fullLUT = malloc(NUM_SRGB_VALUES * sizeof(uint32_t));
+	uint32_t* partialLUT = malloc(COLOR_PARTIAL_LUT_WORDS * sizeof(uint32_t));
+	populateSRGBtoXVYCbCrLUT(fullLUT, 1, 1);
+	int error = populateSRGBtoXVYCbCrPartialLUT(partialLUT);
+	if (error != 0) {
+		printf("Partial LUT could NOT be generated: %#X\n", error);
+		free(partialLUT);
+		free(fullLUT);
+		return 1;
+	}
+	
+	uint32_t correctionCount = partialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT];
+	printf("Partial LUT Size: %d bytes (%d tie corrections)\n", (COLOR_PARTIAL_LUT_CORRECTIONS + correctionCount) * 4, correctionCount);
+	
+	uint32_t mismatches = 0;
+	for (uint32_t rgb = 0; rgb < NUM_SRGB_VALUES; rgb++) {
+		uint32_t partialValue = colorConvertPartialPixel(partialLUT, rgb);
+		if (partialValue != fullLUT[rgb]) {
+			if (mismatches < 16) {
+				printf("Mismatch for sRGB value %#08X: %#08X instead of %#08X\n", rgb, partialValue, fullLUT[rgb]);
+			}
+			mismatches++;
+		}
+	}
+	if (mismatches == 0) {
+		printf("Partial LUT Matches for all %d sRGB Values!\n", NUM_SRGB_VALUES);
+	}
+	else {
+		printf("Partial LUT Mismatch Count: %d\n", mismatches);
+	}
+	
+	free(partialLUT);
+	free(fullLUT);
+	return mismatches;
+}
+
 //Main C runtime entry point
 int main(int argc, char* argv[]) {
 	printf("\nConfirming the Lossless sRGB to YCbCr Conversion\n");
@@ -291,9 +330,15 @@ int main(int argc, char* argv[]) {
 	free(conversionLUT);
 	//*/
 	
+	printf("Checking the Partial LUT Conversion:\n");
+	uint32_t partialFailures = checkPartialLUT();
+	
 	//analyzeSRGBtoYCbCr(255, 0, 0);
 	//yuvCreateTestFile(217, 395, 1023);
 	
+	if (partialFailures > 0) {
+		return 1;
+	}
 	printf("Program Successfully Finished!\n");
   return 0;
 }
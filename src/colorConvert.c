@@ -0,0 +1,702 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+//Media Enhanced sRGB to YCbCr Color Conversion Functions
+//Scalar, AVX2, and AVX-512 versions of the compute shader's conversion
+//The LUT variant does the same table gather as the shader
+//The fixed point variant gets the same answers from integers: with the
+//BT.709 constants as exact fractions every result is round(341 * M / d)
+//(M a small integer weighted sum of R, G, B) which only needs a multiply and
+//a division by a constant (done as a multiply and shift)
+//Exact ties (remainder of 0, about 1 in 14000 colors) round whichever way the
+//LUT's double math happened to go, so those few pixels get redone with the
+//same double operations the table was made with
+//The partial LUT variant is the CPU version of shaderPartial.comp.glsl: the
+//same numerators come from 3 x 256 entry tables and the ties look up the
+//correction list instead of redoing the double math
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "colorConvert.h" //Include Color Conversion Function Definitions
+#include "bitstreamContainer.h" //Includes the checksum the cache files share with the bitstream checkpoints
+#include <stddef.h> //NULL definition normally included by Vulkan
+#include <cpuid.h> //CPU feature checks
+#include <immintrin.h> //AVX2 & AVX-512 intrinsics
+
+#define COLOR_PLANE_SHIFT 6 //10-bit values sit in the upper bits of each R16 sample
+#define COLOR_MAX_VALUE 1023
+
+//x stays below 2^31 so (x * magic) >> shift equals x / d when 2^(shift - 31) >= d
+#define COLOR_FIXED_Y_SHIFT 51
+#define COLOR_FIXED_CB_SHIFT 52
+#define COLOR_FIXED_CR_SHIFT 52
+#define COLOR_FIXED_MAGIC(divisor, shift) ((uint32_t) (((((uint64_t) 1) << (shift)) + (divisor) - 1) / (divisor)))
+
+//Two signed 16-bit weights for _madd_epi16 on (B, R) or (G, A) pairs
+#define COLOR_FIXED_PAIR(low, high) ((int32_t) (((uint32_t) ((uint16_t) (low))) | (((uint32_t) ((uint16_t) (high))) << 16)))
+
+static void colorStoreLUTValue(uint16_t* planeY, uint64_t planeSamples, uint64_t pixel, uint32_t xvYCbCr) {
+	planeY[pixel] = (uint16_t) ((xvYCbCr >> 14) & 0xFFC0); //Same unpacking as the shader
+	planeY[pixel + planeSamples] = (uint16_t) ((xvYCbCr >> 4) & 0xFFC0);
+	planeY[pixel + (planeSamples << 1)] = (uint16_t) ((xvYCbCr << 6) & 0xFFC0);
+}
+
+static void colorConvertLUTScalar(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* lutData, uint64_t first, uint64_t end) {
+	for (uint64_t p = first; p < end; p++) {
+		colorStoreLUTValue(planeY, planeSamples, p, lutData[frameData[p] & 0xFFFFFF]);
+	}
+}
+
+//Returns 1 for an exact tie
+static uint32_t colorFixedDivide(int32_t weightedSum, uint32_t offset, uint32_t divisor, uint32_t* value) {
+	uint32_t x = (uint32_t) ((341 * weightedSum) + ((int32_t) offset));
+	uint32_t quotient = x / divisor;
+	if (quotient > COLOR_MAX_VALUE) {
+		quotient = COLOR_MAX_VALUE;
+	}
+	*value = quotient;
+	return ((x % divisor) == 0) ? 1 : 0;
+}
+
+static void colorConvertFixedScalar(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint64_t first, uint64_t end) {
+	for (uint64_t p = first; p < end; p++) {
+		uint32_t bgra = frameData[p];
+		int32_t b = (int32_t) (bgra & 0xFF);
+		int32_t g = (int32_t) ((bgra >> 8) & 0xFF);
+		int32_t r = (int32_t) ((bgra >> 16) & 0xFF);
+		
+		uint32_t Y = 0;
+		uint32_t Cb = 0;
+		uint32_t Cr = 0;
+		uint32_t ties = colorFixedDivide((2126 * r) + (7152 * g) + (722 * b), COLOR_FIXED_Y_OFFSET, COLOR_FIXED_Y_DIVISOR, &Y);
+		ties |= colorFixedDivide((9278 * b) - (2126 * r) - (7152 * g), COLOR_FIXED_CB_OFFSET, COLOR_FIXED_CB_DIVISOR, &Cb);
+		ties |= colorFixedDivide((7874 * r) - (7152 * g) - (722 * b), COLOR_FIXED_CR_OFFSET, COLOR_FIXED_CR_DIVISOR, &Cr);
+		if (ties > 0) {
+			colorStoreLUTValue(planeY, planeSamples, p, colorConvertReferencePixel(bgra));
+		}
+		else {
+			planeY[p] = (uint16_t) (Y << COLOR_PLANE_SHIFT);
+			planeY[p + planeSamples] = (uint16_t) (Cb << COLOR_PLANE_SHIFT);
+			planeY[p + (planeSamples << 1)] = (uint16_t) (Cr << COLOR_PLANE_SHIFT);
+		}
+	}
+}
+
+//Redoes the pixels whose bit is set in tieMask
+static void colorFixTies(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint64_t first, uint32_t tieMask) {
+	while (tieMask > 0) {
+		uint64_t p = first + __builtin_ctz(tieMask);
+		colorStoreLUTValue(planeY, planeSamples, p, colorConvertReferencePixel(frameData[p]));
+		tieMask &= tieMask - 1;
+	}
+}
+
+__attribute__((target("avx2"))) static void colorStorePlanesAVX2(uint16_t* planeY, uint64_t planeSamples, uint64_t p, __m256i* low, __m256i* high) {
+	for (uint64_t c = 0; c < 3; c++) { //packus works per 128-bit lane so the permute puts the pixels back in order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(low[c], high[c]), 0b11011000);
+		_mm256_storeu_si256((__m256i*) (&(planeY[p + (c * planeSamples)])), packed);
+	}
+}
+
+__attribute__((target("avx2"))) static void colorConvertLUTAVX2(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* lutData, uint64_t first, uint64_t end) {
+	const __m256i indexMask = _mm256_set1_epi32(0xFFFFFF);
+	const __m256i valueMask = _mm256_set1_epi32(0xFFC0);
+	uint64_t p = first;
+	for (; (p + 16) <= end; p += 16) {
+		__m256i planes[2][3];
+		for (uint64_t h = 0; h < 2; h++) {
+			__m256i bgra = _mm256_loadu_si256((__m256i*) (&(frameData[p + (h << 3)])));
+			__m256i xvYCbCr = _mm256_i32gather_epi32((const int*) lutData, _mm256_and_si256(bgra, indexMask), 4);
+			planes[h][0] = _mm256_and_si256(_mm256_srli_epi32(xvYCbCr, 14), valueMask);
+			planes[h][1] = _mm256_and_si256(_mm256_srli_epi32(xvYCbCr, 4), valueMask);
+			planes[h][2] = _mm256_and_si256(_mm256_slli_epi32(xvYCbCr, 6), valueMask);
+		}
+		colorStorePlanesAVX2(planeY, planeSamples, p, planes[0], planes[1]);
+	}
+	colorConvertLUTScalar(planeY, planeSamples, frameData, lutData, p, end);
+}
+
+//x / d for every 32-bit lane (x below 2^31) using even and odd lane 32 x 32 -> 64-bit multiplies
+__attribute__((target("avx2"))) static __m256i colorFixedDivideAVX2(__m256i x, __m256i magic, __m128i shift) {
+	__m256i quotientEven = _mm256_srl_epi64(_mm256_mul_epu32(x, magic), shift);
+	__m256i quotientOdd = _mm256_srl_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), shift);
+	return _mm256_or_si256(quotientEven, _mm256_slli_epi64(quotientOdd, 32));
+}
+
+__attribute__((target("avx2"))) static void colorConvertFixedAVX2(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint64_t first, uint64_t end) {
+	const __m256i pairMask = _mm256_set1_epi32(0x00FF00FF);
+	const __m256i weightsBR[3] = {
+		_mm256_set1_epi32(COLOR_FIXED_PAIR(722, 2126)),
+		_mm256_set1_epi32(COLOR_FIXED_PAIR(9278, -2126)),
+		_mm256_set1_epi32(COLOR_FIXED_PAIR(-722, 7874))
+	};
+	const __m256i weightsGA[3] = {
+		_mm256_set1_epi32(COLOR_FIXED_PAIR(7152, 0)),
+		_mm256_set1_epi32(COLOR_FIXED_PAIR(-7152, 0)),
+		_mm256_set1_epi32(COLOR_FIXED_PAIR(-7152, 0))
+	};
+	const __m256i offsets[3] = {
+		_mm256_set1_epi32(COLOR_FIXED_Y_OFFSET),
+		_mm256_set1_epi32(COLOR_FIXED_CB_OFFSET),
+		_mm256_set1_epi32(COLOR_FIXED_CR_OFFSET)
+	};
+	const __m256i divisors[3] = {
+		_mm256_set1_epi32(COLOR_FIXED_Y_DIVISOR),
+		_mm256_set1_epi32(COLOR_FIXED_CB_DIVISOR),
+		_mm256_set1_epi32(COLOR_FIXED_CR_DIVISOR)
+	};
+	const __m256i magics[3] = {
+		_mm256_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_Y_DIVISOR, COLOR_FIXED_Y_SHIFT)),
+		_mm256_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CB_DIVISOR, COLOR_FIXED_CB_SHIFT)),
+		_mm256_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CR_DIVISOR, COLOR_FIXED_CR_SHIFT))
+	};
+	const __m128i shifts[3] = {
+		_mm_set_epi64x(0, COLOR_FIXED_Y_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CB_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CR_SHIFT)
+	};
+	const __m256i maxValue = _mm256_set1_epi32(COLOR_MAX_VALUE);
+	const __m256i multiplier = _mm256_set1_epi32(341);
+	
+	uint64_t p = first;
+	for (; (p + 16) <= end; p += 16) {
+		__m256i planes[2][3];
+		uint32_t tieMask = 0;
+		for (uint64_t h = 0; h < 2; h++) {
+			__m256i bgra = _mm256_loadu_si256((__m256i*) (&(frameData[p + (h << 3)])));
+			__m256i pairsBR = _mm256_and_si256(bgra, pairMask);
+			__m256i pairsGA = _mm256_and_si256(_mm256_srli_epi32(bgra, 8), pairMask);
+			__m256i ties = _mm256_setzero_si256();
+			for (uint64_t c = 0; c < 3; c++) {
+				__m256i weightedSum = _mm256_add_epi32(_mm256_madd_epi16(pairsBR, weightsBR[c]), _mm256_madd_epi16(pairsGA, weightsGA[c]));
+				__m256i x = _mm256_add_epi32(_mm256_mullo_epi32(weightedSum, multiplier), offsets[c]);
+				__m256i quotient = colorFixedDivideAVX2(x, magics[c], shifts[c]);
+				ties = _mm256_or_si256(ties, _mm256_cmpeq_epi32(_mm256_mullo_epi32(quotient, divisors[c]), x));
+				planes[h][c] = _mm256_slli_epi32(_mm256_min_epu32(quotient, maxValue), COLOR_PLANE_SHIFT);
+			}
+			tieMask |= ((uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(ties))) << (h << 3);
+		}
+		colorStorePlanesAVX2(planeY, planeSamples, p, planes[0], planes[1]);
+		if (tieMask > 0) {
+			colorFixTies(planeY, planeSamples, frameData, p, tieMask);
+		}
+	}
+	colorConvertFixedScalar(planeY, planeSamples, frameData, p, end);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void colorConvertLUTAVX512(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* lutData, uint64_t first, uint64_t end) {
+	const __m512i indexMask = _mm512_set1_epi32(0xFFFFFF);
+	const __m512i valueMask = _mm512_set1_epi32(0xFFC0);
+	uint64_t p = first;
+	for (; (p + 16) <= end; p += 16) {
+		__m512i bgra = _mm512_loadu_si512((void*) (&(frameData[p])));
+		__m512i xvYCbCr = _mm512_i32gather_epi32(_mm512_and_si512(bgra, indexMask), (const void*) lutData, 4);
+		__m512i valueY = _mm512_and_si512(_mm512_srli_epi32(xvYCbCr, 14), valueMask);
+		__m512i valueCb = _mm512_and_si512(_mm512_srli_epi32(xvYCbCr, 4), valueMask);
+		__m512i valueCr = _mm512_and_si512(_mm512_slli_epi32(xvYCbCr, 6), valueMask);
+		_mm256_storeu_si256((__m256i*) (&(planeY[p])), _mm512_cvtepi32_epi16(valueY));
+		_mm256_storeu_si256((__m256i*) (&(planeY[p + planeSamples])), _mm512_cvtepi32_epi16(valueCb));
+		_mm256_storeu_si256((__m256i*) (&(planeY[p + (planeSamples << 1)])), _mm512_cvtepi32_epi16(valueCr));
+	}
+	colorConvertLUTScalar(planeY, planeSamples, frameData, lutData, p, end);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static __m512i colorFixedDivideAVX512(__m512i x, __m512i magic, __m128i shift) {
+	__m512i quotientEven = _mm512_srl_epi64(_mm512_mul_epu32(x, magic), shift);
+	__m512i quotientOdd = _mm512_srl_epi64(_mm512_mul_epu32(_mm512_srli_epi64(x, 32), magic), shift);
+	return _mm512_or_si512(quotientEven, _mm512_slli_epi64(quotientOdd, 32));
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void colorConvertFixedAVX512(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint64_t first, uint64_t end) {
+	const __m512i pairMask = _mm512_set1_epi32(0x00FF00FF);
+	const __m512i weightsBR[3] = {
+		_mm512_set1_epi32(COLOR_FIXED_PAIR(722, 2126)),
+		_mm512_set1_epi32(COLOR_FIXED_PAIR(9278, -2126)),
+		_mm512_set1_epi32(COLOR_FIXED_PAIR(-722, 7874))
+	};
+	const __m512i weightsGA[3] = {
+		_mm512_set1_epi32(COLOR_FIXED_PAIR(7152, 0)),
+		_mm512_set1_epi32(COLOR_FIXED_PAIR(-7152, 0)),
+		_mm512_set1_epi32(COLOR_FIXED_PAIR(-7152, 0))
+	};
+	const __m512i offsets[3] = {
+		_mm512_set1_epi32(COLOR_FIXED_Y_OFFSET),
+		_mm512_set1_epi32(COLOR_FIXED_CB_OFFSET),
+		_mm512_set1_epi32(COLOR_FIXED_CR_OFFSET)
+	};
+	const __m512i divisors[3] = {
+		_mm512_set1_epi32(COLOR_FIXED_Y_DIVISOR),
+		_mm512_set1_epi32(COLOR_FIXED_CB_DIVISOR),
+		_mm512_set1_epi32(COLOR_FIXED_CR_DIVISOR)
+	};
+	const __m512i magics[3] = {
+		_mm512_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_Y_DIVISOR, COLOR_FIXED_Y_SHIFT)),
+		_mm512_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CB_DIVISOR, COLOR_FIXED_CB_SHIFT)),
+		_mm512_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CR_DIVISOR, COLOR_FIXED_CR_SHIFT))
+	};
+	const __m128i shifts[3] = {
+		_mm_set_epi64x(0, COLOR_FIXED_Y_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CB_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CR_SHIFT)
+	};
+	const __m512i maxValue = _mm512_set1_epi32(COLOR_MAX_VALUE);
+	const __m512i multiplier = _mm512_set1_epi32(341);
+	
+	uint64_t p = first;
+	for (; (p + 16) <= end; p += 16) {
+		__m512i bgra = _mm512_loadu_si512((void*) (&(frameData[p])));
+		__m512i pairsBR = _mm512_and_si512(bgra, pairMask);
+		__m512i pairsGA = _mm512_and_si512(_mm512_srli_epi32(bgra, 8), pairMask);
+		__mmask16 tieMask = 0;
+		for (uint64_t c = 0; c < 3; c++) {
+			__m512i weightedSum = _mm512_add_epi32(_mm512_madd_epi16(pairsBR, weightsBR[c]), _mm512_madd_epi16(pairsGA, weightsGA[c]));
+			__m512i x = _mm512_add_epi32(_mm512_mullo_epi32(weightedSum, multiplier), offsets[c]);
+			__m512i quotient = colorFixedDivideAVX512(x, magics[c], shifts[c]);
+			tieMask |= _mm512_cmpeq_epi32_mask(_mm512_mullo_epi32(quotient, divisors[c]), x);
+			__m512i value = _mm512_slli_epi32(_mm512_min_epu32(quotient, maxValue), COLOR_PLANE_SHIFT);
+			_mm256_storeu_si256((__m256i*) (&(planeY[p + (c * planeSamples)])), _mm512_cvtepi32_epi16(value));
+		}
+		if (tieMask > 0) {
+			colorFixTies(planeY, planeSamples, frameData, p, (uint32_t) tieMask);
+		}
+	}
+	colorConvertFixedScalar(planeY, planeSamples, frameData, p, end);
+}
+
+static void colorConvertPartialScalar(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* partialLUT, uint64_t first, uint64_t end) {
+	for (uint64_t p = first; p < end; p++) {
+		colorStoreLUTValue(planeY, planeSamples, p, colorConvertPartialPixel(partialLUT, frameData[p]));
+	}
+}
+
+//Redoes the pixels whose bit is set in tieMask with the correction list
+static void colorFixPartialTies(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* partialLUT, uint64_t first, uint32_t tieMask) {
+	while (tieMask > 0) {
+		uint64_t p = first + __builtin_ctz(tieMask);
+		colorStoreLUTValue(planeY, planeSamples, p, colorConvertPartialPixel(partialLUT, frameData[p]));
+		tieMask &= tieMask - 1;
+	}
+}
+
+__attribute__((target("avx2"))) static void colorConvertPartialAVX2(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* partialLUT, uint64_t first, uint64_t end) {
+	const __m256i byteMask = _mm256_set1_epi32(0xFF);
+	const __m256i greenStart = _mm256_set1_epi32(SRGB_MAX_VALUE);
+	const __m256i blueStart = _mm256_set1_epi32(SRGB_MAX_VALUE << 1);
+	const __m256i divisors[3] = {
+		_mm256_set1_epi32(COLOR_FIXED_Y_DIVISOR),
+		_mm256_set1_epi32(COLOR_FIXED_CB_DIVISOR),
+		_mm256_set1_epi32(COLOR_FIXED_CR_DIVISOR)
+	};
+	const __m256i magics[3] = {
+		_mm256_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_Y_DIVISOR, COLOR_FIXED_Y_SHIFT)),
+		_mm256_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CB_DIVISOR, COLOR_FIXED_CB_SHIFT)),
+		_mm256_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CR_DIVISOR, COLOR_FIXED_CR_SHIFT))
+	};
+	const __m128i shifts[3] = {
+		_mm_set_epi64x(0, COLOR_FIXED_Y_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CB_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CR_SHIFT)
+	};
+	const __m256i maxValue = _mm256_set1_epi32(COLOR_MAX_VALUE);
+	
+	uint64_t p = first;
+	for (; (p + 16) <= end; p += 16) {
+		__m256i planes[2][3];
+		uint32_t tieMask = 0;
+		for (uint64_t h = 0; h < 2; h++) {
+			__m256i bgra = _mm256_loadu_si256((__m256i*) (&(frameData[p + (h << 3)])));
+			__m256i indexR = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(bgra, 16), byteMask), 2);
+			__m256i indexG = _mm256_slli_epi32(_mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(bgra, 8), byteMask), greenStart), 2);
+			__m256i indexB = _mm256_slli_epi32(_mm256_add_epi32(_mm256_and_si256(bgra, byteMask), blueStart), 2);
+			__m256i ties = _mm256_setzero_si256();
+			for (uint64_t c = 0; c < 3; c++) {
+				const int* partials = (const int*) (&(partialLUT[c]));
+				__m256i x = _mm256_i32gather_epi32(partials, indexR, 4);
+				x = _mm256_add_epi32(x, _mm256_i32gather_epi32(partials, indexG, 4));
+				x = _mm256_add_epi32(x, _mm256_i32gather_epi32(partials, indexB, 4));
+				__m256i quotient = colorFixedDivideAVX2(x, magics[c], shifts[c]);
+				ties = _mm256_or_si256(ties, _mm256_cmpeq_epi32(_mm256_mullo_epi32(quotient, divisors[c]), x));
+				planes[h][c] = _mm256_slli_epi32(_mm256_min_epu32(quotient, maxValue), COLOR_PLANE_SHIFT);
+			}
+			tieMask |= ((uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(ties))) << (h << 3);
+		}
+		colorStorePlanesAVX2(planeY, planeSamples, p, planes[0], planes[1]);
+		if (tieMask > 0) {
+			colorFixPartialTies(planeY, planeSamples, frameData, partialLUT, p, tieMask);
+		}
+	}
+	colorConvertPartialScalar(planeY, planeSamples, frameData, partialLUT, p, end);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void colorConvertPartialAVX512(uint16_t* planeY, uint64_t planeSamples, uint32_t* frameData, uint32_t* partialLUT, uint64_t first, uint64_t end) {
+	const __m512i byteMask = _mm512_set1_epi32(0xFF);
+	const __m512i greenStart = _mm512_set1_epi32(SRGB_MAX_VALUE);
+	const __m512i blueStart = _mm512_set1_epi32(SRGB_MAX_VALUE << 1);
+	const __m512i divisors[3] = {
+		_mm512_set1_epi32(COLOR_FIXED_Y_DIVISOR),
+		_mm512_set1_epi32(COLOR_FIXED_CB_DIVISOR),
+		_mm512_set1_epi32(COLOR_FIXED_CR_DIVISOR)
+	};
+	const __m512i magics[3] = {
+		_mm512_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_Y_DIVISOR, COLOR_FIXED_Y_SHIFT)),
+		_mm512_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CB_DIVISOR, COLOR_FIXED_CB_SHIFT)),
+		_mm512_set1_epi32((int32_t) COLOR_FIXED_MAGIC(COLOR_FIXED_CR_DIVISOR, COLOR_FIXED_CR_SHIFT))
+	};
+	const __m128i shifts[3] = {
+		_mm_set_epi64x(0, COLOR_FIXED_Y_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CB_SHIFT),
+		_mm_set_epi64x(0, COLOR_FIXED_CR_SHIFT)
+	};
+	const __m512i maxValue = _mm512_set1_epi32(COLOR_MAX_VALUE);
+	
+	uint64_t p = first;
+	for (; (p + 16) <= end; p += 16) {
+		__m512i bgra = _mm512_loadu_si512((void*) (&(frameData[p])));
+		__m512i indexR = _mm512_slli_epi32(_mm512_and_si512(_mm512_srli_epi32(bgra, 16), byteMask), 2);
+		__m512i indexG = _mm512_slli_epi32(_mm512_add_epi32(_mm512_and_si512(_mm512_srli_epi32(bgra, 8), byteMask), greenStart), 2);
+		__m512i indexB = _mm512_slli_epi32(_mm512_add_epi32(_mm512_and_si512(bgra, byteMask), blueStart), 2);
+		__mmask16 tieMask = 0;
+		for (uint64_t c = 0; c < 3; c++) {
+			const void* partials = (const void*) (&(partialLUT[c]));
+			__m512i x = _mm512_i32gather_epi32(indexR, partials, 4);
+			x = _mm512_add_epi32(x, _mm512_i32gather_epi32(indexG, partials, 4));
+			x = _mm512_add_epi32(x, _mm512_i32gather_epi32(indexB, partials, 4));
+			__m512i quotient = colorFixedDivideAVX512(x, magics[c], shifts[c]);
+			tieMask |= _mm512_cmpeq_epi32_mask(_mm512_mullo_epi32(quotient, divisors[c]), x);
+			__m512i value = _mm512_slli_epi32(_mm512_min_epu32(quotient, maxValue), COLOR_PLANE_SHIFT);
+			_mm256_storeu_si256((__m256i*) (&(planeY[p + (c * planeSamples)])), _mm512_cvtepi32_epi16(value));
+		}
+		if (tieMask > 0) {
+			colorFixPartialTies(planeY, planeSamples, frameData, partialLUT, p, (uint32_t) tieMask);
+		}
+	}
+	colorConvertPartialScalar(planeY, planeSamples, frameData, partialLUT, p, end);
+}
+
+uint64_t colorConvertGetMaxISA() {
+	uint32_t eax = 0;
+	uint32_t ebx = 0;
+	uint32_t ecx = 0;
+	uint32_t edx = 0;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+		return COLOR_CONVERT_ISA_SCALAR;
+	}
+	if (((ecx & bit_OSXSAVE) == 0) || ((ecx & bit_AVX) == 0)) {
+		return COLOR_CONVERT_ISA_SCALAR;
+	}
+	uint32_t xcr0 = 0;
+	uint32_t xcr0High = 0;
+	__asm__ volatile ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0)); //Registers the OS saves on context switches
+	if ((xcr0 & 0b110) != 0b110) {
+		return COLOR_CONVERT_ISA_SCALAR;
+	}
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+		return COLOR_CONVERT_ISA_SCALAR;
+	}
+	if ((ebx & bit_AVX2) == 0) {
+		return COLOR_CONVERT_ISA_SCALAR;
+	}
+	if (((ebx & bit_AVX512F) > 0) && ((ebx & bit_AVX512BW) > 0) && ((xcr0 & 0b11100110) == 0b11100110)) {
+		return COLOR_CONVERT_ISA_AVX512;
+	}
+	return COLOR_CONVERT_ISA_AVX2;
+}
+
+void colorConvertRows(uint16_t* planes, uint32_t* frameData, uint32_t* lutData, uint32_t width, uint32_t height, uint32_t rowStart, uint32_t rowEnd, uint64_t variant, uint64_t isa) {
+	uint64_t planeSamples = ((uint64_t) width) * ((uint64_t) height);
+	uint64_t first = ((uint64_t) rowStart) * width;
+	uint64_t end = ((uint64_t) rowEnd) * width;
+	if (variant == COLOR_CONVERT_LUT) {
+		if (isa == COLOR_CONVERT_ISA_AVX512) {
+			colorConvertLUTAVX512(planes, planeSamples, frameData, lutData, first, end);
+		}
+		else if (isa == COLOR_CONVERT_ISA_AVX2) {
+			colorConvertLUTAVX2(planes, planeSamples, frameData, lutData, first, end);
+		}
+		else {
+			colorConvertLUTScalar(planes, planeSamples, frameData, lutData, first, end);
+		}
+	}
+	else if (variant == COLOR_CONVERT_FIXED) {
+		if (isa == COLOR_CONVERT_ISA_AVX512) {
+			colorConvertFixedAVX512(planes, planeSamples, frameData, first, end);
+		}
+		else if (isa == COLOR_CONVERT_ISA_AVX2) {
+			colorConvertFixedAVX2(planes, planeSamples, frameData, first, end);
+		}
+		else {
+			colorConvertFixedScalar(planes, planeSamples, frameData, first, end);
+		}
+	}
+	else {
+		if (isa == COLOR_CONVERT_ISA_AVX512) {
+			colorConvertPartialAVX512(planes, planeSamples, frameData, lutData, first, end);
+		}
+		else if (isa == COLOR_CONVERT_ISA_AVX2) {
+			colorConvertPartialAVX2(planes, planeSamples, frameData, lutData, first, end);
+		}
+		else {
+			colorConvertPartialScalar(planes, planeSamples, frameData, lutData, first, end);
+		}
+	}
+}
+
+//LUT Cache Files
+static void colorLUTCacheAppend(char* fileName, uint64_t* index, char* text) {
+	while (*text != 0) {
+		fileName[*index] = *text;
+		(*index)++;
+		text++;
+	}
+	fileName[*index] = 0;
+}
+
+void colorLUTCacheFileName(char* fileName, uint32_t kind, uint32_t version, uint32_t bits) {
+	uint64_t index = 0;
+	colorLUTCacheAppend(fileName, &index, (kind == COLOR_LUT_KIND_PARTIAL) ? "lutPartial" : "lutFull");
+	colorLUTCacheAppend(fileName, &index, (version > 0) ? "709_" : "601_");
+	colorLUTCacheAppend(fileName, &index, (bits > 0) ? "10.cache" : "8.cache");
+}
+
+int colorLUTCacheLoad(uint32_t* lutData, uint64_t lutBytes, uint32_t kind, uint32_t version, uint32_t bits) {
+	char fileName[COLOR_LUT_CACHE_NAME_MAX];
+	colorLUTCacheFileName(fileName, kind, version, bits);
+	void* cacheFile = NULL;
+	int error = ioOpenFile(&cacheFile, fileName, -1, IO_FILE_READ_NORMAL);
+	if (error != 0) {
+		return ERROR_COLOR_LUT_CACHE_INVALID;
+	}
+	
+	uint64_t fileBytes = 0;
+	colorLUTCacheHeader header;
+	uint32_t readBytes = sizeof(colorLUTCacheHeader);
+	error = ioGetFileSize(cacheFile, &fileBytes);
+	if ((error == 0) && (fileBytes == (sizeof(colorLUTCacheHeader) + lutBytes))) {
+		error = ioReadFile(cacheFile, &header, &readBytes);
+	}
+	else {
+		error = ERROR_COLOR_LUT_CACHE_INVALID;
+	}
+	if ((error == 0) && (readBytes == sizeof(colorLUTCacheHeader)) && (header.magic == COLOR_LUT_CACHE_MAGIC) && (header.formatVersion == COLOR_LUT_CACHE_FORMAT_VERSION) &&
+		(header.kind == kind) && (header.matrix == version) && (header.bits == bits) && (header.rounding == COLOR_LUT_ROUNDING_HALF_EVEN) && (header.dataBytes == lutBytes)) {
+		readBytes = (uint32_t) lutBytes;
+		error = ioReadFile(cacheFile, lutData, &readBytes); //One read straight into the destination
+		if ((error == 0) && ((readBytes != lutBytes) || (bitstreamChecksumData((uint8_t*) lutData, lutBytes) != header.checksum))) {
+			error = ERROR_COLOR_LUT_CACHE_INVALID;
+		}
+	}
+	else {
+		error = ERROR_COLOR_LUT_CACHE_INVALID;
+	}
+	
+	ioCloseFile(&cacheFile);
+	if (error != 0) {
+		return ERROR_COLOR_LUT_CACHE_INVALID;
+	}
+	return 0;
+}
+
+int colorLUTCacheSave(uint32_t* lutData, uint64_t lutBytes, uint32_t kind, uint32_t version, uint32_t bits) {
+	colorLUTCacheHeader header;
+	memzeroBasic(&header, sizeof(colorLUTCacheHeader));
+	header.magic = COLOR_LUT_CACHE_MAGIC;
+	header.formatVersion = COLOR_LUT_CACHE_FORMAT_VERSION;
+	header.kind = kind;
+	header.matrix = version;
+	header.bits = bits;
+	header.rounding = COLOR_LUT_ROUNDING_HALF_EVEN;
+	header.dataBytes = lutBytes;
+	header.checksum = bitstreamChecksumData((uint8_t*) lutData, lutBytes);
+	
+	char fileName[COLOR_LUT_CACHE_NAME_MAX];
+	colorLUTCacheFileName(fileName, kind, version, bits);
+	void* cacheFile = NULL;
+	int error = ioOpenFile(&cacheFile, fileName, -1, IO_FILE_WRITE_NORMAL);
+	RETURN_ON_ERROR(error);
+	error = ioWriteFile(cacheFile, &header, sizeof(colorLUTCacheHeader));
+	if (error == 0) {
+		error = ioWriteFile(cacheFile, lutData, (uint32_t) lutBytes);
+	}
+	int closeError = ioCloseFile(&cacheFile);
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+//Row Band Mode
+static uint64_t colorThreadCount = 0; //Helper threads (the calling thread takes a band too)
+static uint64_t colorThreadIndex = 0;
+static void* colorThreadHandles[COLOR_CONVERT_THREAD_MAX];
+static void* colorStartEvents[COLOR_CONVERT_THREAD_MAX];
+static void* colorDoneEvent = NULL;
+static uint64_t colorThreadExit = 0;
+
+static uint16_t* colorJobPlanes = NULL;
+static uint32_t* colorJobFrame = NULL;
+static uint32_t* colorJobLUT = NULL;
+static uint32_t colorJobWidth = 0;
+static uint32_t colorJobHeight = 0;
+static uint64_t colorJobVariant = 0;
+static uint64_t colorJobISA = 0;
+static uint64_t colorJobTable = 0; //COLOR_JOB_* (LUT red planes instead of frame rows when above 0)
+static uint32_t colorJobVersion = 0;
+static uint32_t colorJobBits = 0;
+static uint64_t colorBandsLeft = 0;
+
+#define COLOR_JOB_ROWS 0
+#define COLOR_JOB_FULL_LUT 1
+#define COLOR_JOB_PARTIAL_LUT 2 //Each band finds the corrections for its red planes
+static uint32_t colorBandCorrections[COLOR_CONVERT_THREAD_MAX][COLOR_PARTIAL_CORRECTION_MAX];
+static uint32_t colorBandCorrectionCounts[COLOR_CONVERT_THREAD_MAX];
+static int colorBandErrors[COLOR_CONVERT_THREAD_MAX];
+
+static int colorConvertBand(uint64_t band) {
+	uint64_t bandCount = colorThreadCount + 1;
+	if (colorJobTable > 0) {
+		uint32_t redStart = (uint32_t) ((band * SRGB_MAX_VALUE) / bandCount);
+		uint32_t redEnd = (uint32_t) (((band + 1) * SRGB_MAX_VALUE) / bandCount);
+		if (colorJobTable == COLOR_JOB_PARTIAL_LUT) {
+			colorBandErrors[band] = populateSRGBtoXVYCbCrPartialCorrections(colorJobLUT, redStart, redEnd, colorBandCorrections[band], &(colorBandCorrectionCounts[band]));
+		}
+		else {
+			populateSRGBtoXVYCbCrPlanes(colorJobLUT, colorJobVersion, colorJobBits, redStart, redEnd, colorJobISA);
+		}
+	}
+	else {
+		uint32_t rowStart = (uint32_t) ((band * colorJobHeight) / bandCount);
+		uint32_t rowEnd = (uint32_t) (((band + 1) * colorJobHeight) / bandCount);
+		colorConvertRows(colorJobPlanes, colorJobFrame, colorJobLUT, colorJobWidth, colorJobHeight, rowStart, rowEnd, colorJobVariant, colorJobISA);
+	}
+	if (__atomic_sub_fetch(&colorBandsLeft, 1, __ATOMIC_ACQ_REL) == 0) {
+		return syncSetEvent(colorDoneEvent);
+	}
+	return 0;
+}
+
+static int colorConvertThread() {
+	uint64_t index = __atomic_fetch_add(&colorThreadIndex, 1, __ATOMIC_ACQ_REL);
+	while (1) {
+		int error = syncEventWait(colorStartEvents[index]);
+		RETURN_ON_ERROR(error);
+		if (colorThreadExit > 0) {
+			return 0;
+		}
+		error = colorConvertBand(index + 1);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+int colorConvertSetupThreads(uint64_t threadCount) {
+	if ((threadCount == 0) || (threadCount > COLOR_CONVERT_THREAD_MAX) || (colorDoneEvent != NULL)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	int error = syncCreateEvent(&colorDoneEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	colorThreadExit = 0;
+	colorThreadIndex = 0;
+	for (uint64_t t = 0; t < (threadCount - 1); t++) {
+		error = syncCreateEvent(&(colorStartEvents[t]), 0, 0);
+		RETURN_ON_ERROR(error);
+	}
+	for (uint64_t t = 0; t < (threadCount - 1); t++) {
+		PFN_ThreadStart threadStart = colorConvertThread;
+		error = syncStartThread(&(colorThreadHandles[t]), threadStart, 0);
+		RETURN_ON_ERROR(error);
+	}
+	colorThreadCount = threadCount - 1;
+	return 0;
+}
+
+//Hands one band to each helper thread and takes band 0 on the calling thread
+static int colorRunBands() {
+	colorBandsLeft = colorThreadCount + 1;
+	for (uint64_t t = 0; t < colorThreadCount; t++) {
+		int error = syncSetEvent(colorStartEvents[t]);
+		RETURN_ON_ERROR(error);
+	}
+	int error = colorConvertBand(0);
+	RETURN_ON_ERROR(error);
+	return syncEventWait(colorDoneEvent);
+}
+
+int colorConvertFrame(uint16_t* planes, uint32_t* frameData, uint32_t* lutData, uint32_t width, uint32_t height, uint64_t variant, uint64_t isa) {
+	if (colorDoneEvent == NULL) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	colorJobTable = COLOR_JOB_ROWS;
+	colorJobPlanes = planes;
+	colorJobFrame = frameData;
+	colorJobLUT = lutData;
+	colorJobWidth = width;
+	colorJobHeight = height;
+	colorJobVariant = variant;
+	colorJobISA = isa;
+	return colorRunBands();
+}
+
+int populateSRGBtoXVYCbCrLUTParallel(uint32_t* lutData, uint32_t version, uint32_t bits, uint64_t isa) {
+	if (colorDoneEvent == NULL) {
+		populateSRGBtoXVYCbCrPlanes(lutData, version, bits, 0, SRGB_MAX_VALUE, isa);
+		return 0;
+	}
+	colorJobTable = COLOR_JOB_FULL_LUT;
+	colorJobLUT = lutData;
+	colorJobVersion = version;
+	colorJobBits = bits;
+	colorJobISA = isa;
+	return colorRunBands();
+}
+
+//The channel tables are tiny so the calling thread fills them and the bands only search for ties,
+//then the band lists get joined in red plane order so the corrections stay sorted
+int populateSRGBtoXVYCbCrPartialLUTParallel(uint32_t* partialLUT) {
+	if (colorDoneEvent == NULL) {
+		return populateSRGBtoXVYCbCrPartialLUT(partialLUT);
+	}
+	populateSRGBtoXVYCbCrPartialTables(partialLUT);
+	colorJobTable = COLOR_JOB_PARTIAL_LUT;
+	colorJobLUT = partialLUT;
+	int error = colorRunBands();
+	RETURN_ON_ERROR(error);
+	
+	uint32_t correctionCount = 0;
+	for (uint64_t band = 0; band <= colorThreadCount; band++) {
+		RETURN_ON_ERROR(colorBandErrors[band]);
+		if ((correctionCount + colorBandCorrectionCounts[band]) > COLOR_PARTIAL_CORRECTION_MAX) {
+			return ERROR_COLOR_CONVERT_MISMATCH;
+		}
+		memcpyBasic(&(partialLUT[COLOR_PARTIAL_LUT_CORRECTIONS + correctionCount]), colorBandCorrections[band], colorBandCorrectionCounts[band] * sizeof(uint32_t));
+		correctionCount += colorBandCorrectionCounts[band];
+	}
+	partialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT] = correctionCount;
+	return 0;
+}
+
+void colorConvertCleanupThreads() {
+	colorThreadExit = 1;
+	for (uint64_t t = 0; t < colorThreadCount; t++) {
+		syncSetEvent(colorStartEvents[t]);
+	}
+	colorThreadCount = 0;
+	colorDoneEvent = NULL; //Helper threads are detached and exit on their own
+}
@@ -0,0 +1,127 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//Media Enhanced sRGB to YCbCr Color Conversion Definitions
+//CPU versions of the compute shader (shader.comp.glsl): BGRA8 frames go in and
+//three R16 planes come out with the 10-bit values in the upper bits
+//(Y << 6, Cb << 6, Cr << 6 stacked at rows 0, height, 2 * height)
+#ifndef MEDIA_ENHANCED_COLOR_CONVERT_H
+#define MEDIA_ENHANCED_COLOR_CONVERT_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+//Definition constants used for sRGB loops:
+#define SRGB_MAX_VALUE 256
+#define NUM_SRGB_VALUES 16777216
+
+#define COLOR_CONVERT_LUT 0 //Gathers from the populateSRGBtoXVYCbCrLUT(..., 1, 1) table just like the shader
+#define COLOR_CONVERT_FIXED 1 //Integer arithmetic without the table (BT.709 10-bit only)
+#define COLOR_CONVERT_PARTIAL 2 //Same math as shaderPartial.comp.glsl (lutData is the partial LUT)
+#define COLOR_CONVERT_VARIANT_COUNT 3
+
+#define COLOR_CONVERT_ISA_SCALAR 0
+#define COLOR_CONVERT_ISA_AVX2 1
+#define COLOR_CONVERT_ISA_AVX512 2 //AVX-512 F + BW
+#define COLOR_CONVERT_ISA_COUNT 3
+
+#define COLOR_CONVERT_THREAD_MAX 64
+
+#define ERROR_COLOR_CONVERT_MISMATCH 0x5110
+#define ERROR_COLOR_LUT_CACHE_INVALID 0x5111 //Missing, different key, or checksum mismatch (regenerate)
+
+//Fixed point: x = (341 * M) + offset, result = x / d (0.5 is already in the offset)
+//M for Y is 2126 R + 7152 G + 722 B (10000 * Kr, Kg, Kb)
+//M for Cb and Cr are 10000 * (B - Y) and 10000 * (R - Y)
+#define COLOR_FIXED_Y_DIVISOR 850000 //255 * 10000 / 3
+#define COLOR_FIXED_CB_DIVISOR 1577260 //255 * 10000 * (2 * (1 - Kb)) / 3
+#define COLOR_FIXED_CR_DIVISOR 1338580 //255 * 10000 * (2 * (1 - Kr)) / 3
+#define COLOR_FIXED_Y_OFFSET (COLOR_FIXED_Y_DIVISOR >> 1)
+#define COLOR_FIXED_CB_OFFSET ((512 * COLOR_FIXED_CB_DIVISOR) + (COLOR_FIXED_CB_DIVISOR >> 1)) //512.5 like the LUT's 0.5 + 0.5
+#define COLOR_FIXED_CR_OFFSET ((512 * COLOR_FIXED_CR_DIVISOR) + (COLOR_FIXED_CR_DIVISOR >> 1))
+
+//Partial LUT layout (uint32_t words, same as the std430 buffer in shaderPartial.comp.glsl):
+//[0, 3072): 4 words (Y, Cb, Cr numerator parts, unused) for each red, then green, then blue value
+//[3072]: correction count
+//[3073, ...): sorted corrections: (rgb << 8) | round down bits (bit 0 Y, bit 1 Cb, bit 2 Cr)
+#define COLOR_PARTIAL_CORRECTION_MAX 1024
+#define COLOR_PARTIAL_LUT_CORRECTION_COUNT 3072
+#define COLOR_PARTIAL_LUT_CORRECTIONS 3073
+#define COLOR_PARTIAL_LUT_WORDS (COLOR_PARTIAL_LUT_CORRECTIONS + COLOR_PARTIAL_CORRECTION_MAX)
+
+//LUT cache file: this header followed by the table exactly as it goes into the staging buffer
+//The key (kind, matrix, bits, rounding) is part of the file name and gets checked again
+#define COLOR_LUT_CACHE_MAGIC 0x314354554C52534C //"LSRLUTC1"
+#define COLOR_LUT_CACHE_FORMAT_VERSION 2 //2: bitstreamChecksumData over the table bytes
+#define COLOR_LUT_KIND_FULL 0 //populateSRGBtoXVYCbCrLUT
+#define COLOR_LUT_KIND_PARTIAL 1 //populateSRGBtoXVYCbCrPartialLUT
+#define COLOR_LUT_ROUNDING_HALF_EVEN 0 //The only rounding so far: chroma + 0.5, then round half to even
+#define COLOR_LUT_CACHE_NAME_MAX 32
+
+typedef struct colorLUTCacheHeader {
+	uint64_t magic;
+	uint32_t formatVersion;
+	uint32_t kind;
+	uint32_t matrix; //Version argument: 0 for 601, 1 for 709
+	uint32_t bits; //0 for 8-bit, 1 for 10-bit
+	uint32_t rounding;
+	uint32_t reserved;
+	uint64_t dataBytes;
+	uint64_t checksum; //bitstreamChecksumData of the table
+	uint64_t padding[2]; //64 bytes total
+} colorLUTCacheHeader;
+
+//10-bit version when bits > 0 and BT.709 when version > 0 (the recorder uses 1, 1)
+void populateSRGBtoXVYCbCrLUT(uint32_t* lutData, uint32_t version, uint32_t bits);
+//Same table (byte identical) for just the red planes redStart to redEnd - 1, AVX2 when isa allows
+void populateSRGBtoXVYCbCrPlanes(uint32_t* lutData, uint32_t version, uint32_t bits, uint32_t redStart, uint32_t redEnd, uint64_t isa);
+uint32_t colorConvertReferencePixel(uint32_t bgra); //One populateSRGBtoXVYCbCrLUT(..., 1, 1) entry
+int populateSRGBtoXVYCbCrPartialLUT(uint32_t* partialLUT); //COLOR_PARTIAL_LUT_WORDS words
+//The partial LUT in two steps: the channel tables, then the sorted corrections for the
+//red planes redStart to redEnd - 1 (at most COLOR_PARTIAL_CORRECTION_MAX) found with them
+void populateSRGBtoXVYCbCrPartialTables(uint32_t* partialLUT);
+int populateSRGBtoXVYCbCrPartialCorrections(uint32_t* partialLUT, uint32_t redStart, uint32_t redEnd, uint32_t* corrections, uint32_t* correctionCount);
+uint32_t colorConvertPartialPixel(uint32_t* partialLUT, uint32_t bgra); //Same packing as the LUT entries
+
+//Cache files live next to the program as lut[Full|Partial][601|709]_[8|10].cache
+void colorLUTCacheFileName(char* fileName, uint32_t kind, uint32_t version, uint32_t bits);
+//One read of the table straight into lutData (lutBytes long), ERROR_COLOR_LUT_CACHE_INVALID when it has to be regenerated
+int colorLUTCacheLoad(uint32_t* lutData, uint64_t lutBytes, uint32_t kind, uint32_t version, uint32_t bits);
+int colorLUTCacheSave(uint32_t* lutData, uint64_t lutBytes, uint32_t kind, uint32_t version, uint32_t bits);
+
+uint64_t colorConvertGetMaxISA(); //Best instruction set the CPU and OS support
+
+//Converts rows rowStart to rowEnd - 1 of a width x height frame on the calling thread
+//(lutData is the full LUT, unused, or the partial LUT depending on the variant and
+//isa must not be above colorConvertGetMaxISA)
+void colorConvertRows(uint16_t* planes, uint32_t* frameData, uint32_t* lutData, uint32_t width, uint32_t height, uint32_t rowStart, uint32_t rowEnd, uint64_t variant, uint64_t isa);
+
+//Row Band Mode: the frame gets split into one band of rows per thread (the calling thread included)
+int colorConvertSetupThreads(uint64_t threadCount);
+int colorConvertFrame(uint16_t* planes, uint32_t* frameData, uint32_t* lutData, uint32_t width, uint32_t height, uint64_t variant, uint64_t isa);
+//Whole populateSRGBtoXVYCbCrLUT table split by red planes across the row band threads
+//(just the calling thread when colorConvertSetupThreads was not called)
+int populateSRGBtoXVYCbCrLUTParallel(uint32_t* lutData, uint32_t version, uint32_t bits, uint64_t isa);
+//Same as populateSRGBtoXVYCbCrPartialLUT with the tie search split by red planes the same way
+int populateSRGBtoXVYCbCrPartialLUTParallel(uint32_t* partialLUT);
+void colorConvertCleanupThreads();
+
+#endif //MEDIA_ENHANCED_COLOR_CONVERT_H
@@ -0,0 +1,274 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+//This is the main file for the Color Convert Benchmark helper program
+//It first checks that the parallel LUT generation gives the same table as the
+//scalar generation for every matrix and bit depth (and times both along with a
+//round trip through the LUT cache file)
+//Then it checks every CPU version of the compute shader's sRGB to YCbCr conversion
+//against the lookup table (every 24-bit sRGB value, bit for bit) and then
+//times each one on a single core followed by the row band mode on every core
+//Usage: ColorConvertBenchmark [row band threads] [passes]
+
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "colorConvert.h" //Includes the Color Conversion functions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define CONVERT_FRAME_WIDTH 4096 //4096 x 4096 holds every 24-bit color exactly once
+#define CONVERT_FRAME_HEIGHT 4096
+#define CONVERT_COLOR_STEP 0x9E3779 //Odd so every color still shows up once but the LUT reads jump around
+
+static uint32_t* convertLUT = NULL;
+static uint32_t* convertPartialLUT = NULL;
+static uint32_t* convertFrame = NULL;
+static uint16_t* convertReference = NULL;
+static uint16_t* convertOutput = NULL;
+static uint64_t convertMismatchTotal = 0;
+
+static int convertParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+//Fills the output with a value no conversion can produce so skipped pixels show up as mismatches
+static void convertClearOutput(uint64_t sampleCount) {
+	for (uint64_t i = 0; i < sampleCount; i++) {
+		convertOutput[i] = 0xFFFF;
+	}
+}
+
+static uint64_t convertCountMismatches(uint64_t sampleCount) {
+	uint64_t mismatches = 0;
+	for (uint64_t i = 0; i < sampleCount; i++) {
+		if (convertOutput[i] != convertReference[i]) {
+			mismatches++;
+		}
+	}
+	convertMismatchTotal += mismatches;
+	return mismatches;
+}
+
+//Generates one table with the scalar code and one split across the threads and counts the differing entries
+static uint64_t convertCheckLUT(uint32_t* scalarLUT, uint32_t* parallelLUT, uint32_t version, uint32_t bits, uint64_t isa, uint64_t* scalarTime, uint64_t* parallelTime, int* error) {
+	uint64_t startTime = getCurrentTime();
+	populateSRGBtoXVYCbCrLUT(scalarLUT, version, bits);
+	uint64_t middleTime = getCurrentTime();
+	*error = populateSRGBtoXVYCbCrLUTParallel(parallelLUT, version, bits, isa);
+	uint64_t stopTime = getCurrentTime();
+	*scalarTime = getDiffTimeMicroseconds(startTime, middleTime);
+	*parallelTime = getDiffTimeMicroseconds(middleTime, stopTime);
+	
+	uint64_t differences = 0;
+	for (uint64_t i = 0; i < NUM_SRGB_VALUES; i++) {
+		if (parallelLUT[i] != scalarLUT[i]) {
+			differences++;
+		}
+	}
+	return differences;
+}
+
+static void convertPrintThroughput(uint32_t line, uint64_t passes, uint64_t startTime, uint64_t stopTime) {
+	uint64_t runTime = getDiffTimeMicroseconds(startTime, stopTime);
+	if (runTime == 0) {
+		runTime = 1;
+	}
+	uint64_t frameBytes = ((uint64_t) CONVERT_FRAME_WIDTH) * CONVERT_FRAME_HEIGHT * sizeof(uint32_t);
+	consolePrintLineWithNumber(line, (frameBytes * passes) / runTime, NUM_FORMAT_UNSIGNED_INTEGER); //BGRA bytes per us is MB/s
+}
+
+int programMain() {
+	uint64_t threadCount = syncGetProcessorCount();
+	uint64_t passes = 4;
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	int error = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		error = convertParseNumber(argument, argumentBytes, &threadCount);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(2, &argument, &argumentBytes) == 0) {
+		error = convertParseNumber(argument, argumentBytes, &passes);
+		RETURN_ON_ERROR(error);
+	}
+	if ((threadCount == 0) || (threadCount > COLOR_CONVERT_THREAD_MAX) || (passes == 0)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	uint64_t pixelCount = ((uint64_t) CONVERT_FRAME_WIDTH) * CONVERT_FRAME_HEIGHT;
+	uint64_t sampleCount = pixelCount * 3;
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, NUM_SRGB_VALUES * sizeof(uint32_t), 0);
+	RETURN_ON_ERROR(error);
+	convertLUT = (uint32_t*) memAlloc;
+	error = memoryAllocate(&memAlloc, COLOR_PARTIAL_LUT_WORDS * sizeof(uint32_t), 0);
+	RETURN_ON_ERROR(error);
+	convertPartialLUT = (uint32_t*) memAlloc;
+	error = memoryAllocate(&memAlloc, pixelCount * sizeof(uint32_t), 0);
+	RETURN_ON_ERROR(error);
+	convertFrame = (uint32_t*) memAlloc;
+	error = memoryAllocate(&memAlloc, sampleCount * sizeof(uint16_t), 0);
+	RETURN_ON_ERROR(error);
+	convertReference = (uint16_t*) memAlloc;
+	error = memoryAllocate(&memAlloc, sampleCount * sizeof(uint16_t), 0);
+	RETURN_ON_ERROR(error);
+	convertOutput = (uint16_t*) memAlloc;
+	
+	uint64_t maxISA = colorConvertGetMaxISA();
+	error = colorConvertSetupThreads(threadCount);
+	RETURN_ON_ERROR(error);
+	
+	//The plane buffers are big enough to hold the tables until the conversion checks
+	consolePrintLine(84);
+	consolePrintLineWithNumber(85, threadCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	uint64_t differences = 0;
+	uint64_t scalarTime = 0;
+	uint64_t parallelTime = 0;
+	for (uint32_t version = 0; version < 2; version++) {
+		for (uint32_t bits = 0; bits < 2; bits++) {
+			for (uint64_t isa = 0; isa <= maxISA; isa++) {
+				if (isa == COLOR_CONVERT_ISA_AVX512) { //Uses the AVX2 generation
+					continue;
+				}
+				differences += convertCheckLUT((uint32_t*) convertReference, (uint32_t*) convertOutput, version, bits, isa, &scalarTime, &parallelTime, &error);
+				RETURN_ON_ERROR(error);
+				if ((version > 0) && (bits > 0)) { //Times for the recorder's table
+					if (isa == COLOR_CONVERT_ISA_SCALAR) {
+						consolePrintLineWithNumber(86, scalarTime, NUM_FORMAT_UNSIGNED_INTEGER);
+					}
+					consolePrintLineWithNumber(87 + isa, parallelTime, NUM_FORMAT_UNSIGNED_INTEGER);
+				}
+			}
+		}
+	}
+	
+	//The recorder's table through the cache file (same file the recorder uses for the full LUT)
+	populateSRGBtoXVYCbCrLUT(convertLUT, 1, 1);
+	uint64_t lutBytes = NUM_SRGB_VALUES * sizeof(uint32_t);
+	uint64_t startTime = getCurrentTime();
+	error = colorLUTCacheSave(convertLUT, lutBytes, COLOR_LUT_KIND_FULL, 1, 1);
+	RETURN_ON_ERROR(error);
+	uint64_t middleTime = getCurrentTime();
+	error = colorLUTCacheLoad((uint32_t*) convertOutput, lutBytes, COLOR_LUT_KIND_FULL, 1, 1);
+	RETURN_ON_ERROR(error);
+	uint64_t stopTime = getCurrentTime();
+	consolePrintLineWithNumber(93, getDiffTimeMicroseconds(startTime, middleTime), NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(94, getDiffTimeMicroseconds(middleTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
+	uint32_t* cachedLUT = (uint32_t*) convertOutput;
+	for (uint64_t i = 0; i < NUM_SRGB_VALUES; i++) {
+		if (cachedLUT[i] != convertLUT[i]) {
+			differences++;
+		}
+	}
+	
+	//The partial table the recorder generates with its tie search split across the threads
+	error = populateSRGBtoXVYCbCrPartialLUT(convertPartialLUT);
+	RETURN_ON_ERROR(error);
+	uint32_t* parallelPartialLUT = (uint32_t*) convertOutput;
+	startTime = getCurrentTime();
+	error = populateSRGBtoXVYCbCrPartialLUTParallel(parallelPartialLUT);
+	RETURN_ON_ERROR(error);
+	stopTime = getCurrentTime();
+	consolePrintLineWithNumber(199, getDiffTimeMicroseconds(startTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
+	uint64_t partialWords = COLOR_PARTIAL_LUT_CORRECTIONS + convertPartialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT];
+	for (uint64_t i = 0; i < partialWords; i++) {
+		if (parallelPartialLUT[i] != convertPartialLUT[i]) {
+			differences++;
+		}
+	}
+	consolePrintLineWithNumber(89, differences, NUM_FORMAT_UNSIGNED_INTEGER);
+	convertMismatchTotal += differences;
+	for (uint64_t i = 0; i < pixelCount; i++) { //Alpha changes too since the shader ignores it
+		uint32_t color = (uint32_t) ((i * CONVERT_COLOR_STEP) & 0xFFFFFF);
+		convertFrame[i] = color | (((uint32_t) (i * 7)) << 24);
+	}
+	
+	consolePrintLine(69);
+	colorConvertRows(convertReference, convertFrame, convertLUT, CONVERT_FRAME_WIDTH, CONVERT_FRAME_HEIGHT, 0, CONVERT_FRAME_HEIGHT, COLOR_CONVERT_LUT, COLOR_CONVERT_ISA_SCALAR);
+	
+	for (uint64_t variant = 0; variant < COLOR_CONVERT_VARIANT_COUNT; variant++) {
+		uint32_t* lutData = (variant == COLOR_CONVERT_PARTIAL) ? convertPartialLUT : convertLUT;
+		for (uint64_t isa = 0; isa < COLOR_CONVERT_ISA_COUNT; isa++) {
+			consolePrintLine(71 + (variant * COLOR_CONVERT_ISA_COUNT) + isa);
+			if (isa > maxISA) {
+				consolePrintLine(83);
+				continue;
+			}
+			
+			convertClearOutput(sampleCount);
+			colorConvertRows(convertOutput, convertFrame, lutData, CONVERT_FRAME_WIDTH, CONVERT_FRAME_HEIGHT, 0, CONVERT_FRAME_HEIGHT, variant, isa);
+			consolePrintLineWithNumber(70, convertCountMismatches(sampleCount), NUM_FORMAT_UNSIGNED_INTEGER);
+			
+			uint64_t startTime = getCurrentTime();
+			for (uint64_t p = 0; p < passes; p++) {
+				colorConvertRows(convertOutput, convertFrame, lutData, CONVERT_FRAME_WIDTH, CONVERT_FRAME_HEIGHT, 0, CONVERT_FRAME_HEIGHT, variant, isa);
+			}
+			uint64_t stopTime = getCurrentTime();
+			convertPrintThroughput(80, passes, startTime, stopTime);
+		}
+	}
+	
+	for (uint64_t variant = 0; variant < COLOR_CONVERT_VARIANT_COUNT; variant++) {
+		uint32_t* lutData = (variant == COLOR_CONVERT_PARTIAL) ? convertPartialLUT : convertLUT;
+		consolePrintLine(71 + (variant * COLOR_CONVERT_ISA_COUNT) + maxISA);
+		consolePrintLineWithNumber(81, threadCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		
+		convertClearOutput(sampleCount);
+		error = colorConvertFrame(convertOutput, convertFrame, lutData, CONVERT_FRAME_WIDTH, CONVERT_FRAME_HEIGHT, variant, maxISA);
+		RETURN_ON_ERROR(error);
+		consolePrintLineWithNumber(70, convertCountMismatches(sampleCount), NUM_FORMAT_UNSIGNED_INTEGER);
+		
+		uint64_t startTime = getCurrentTime();
+		for (uint64_t p = 0; p < passes; p++) {
+			error = colorConvertFrame(convertOutput, convertFrame, lutData, CONVERT_FRAME_WIDTH, CONVERT_FRAME_HEIGHT, variant, maxISA);
+			RETURN_ON_ERROR(error);
+		}
+		uint64_t stopTime = getCurrentTime();
+		convertPrintThroughput(82, passes, startTime, stopTime);
+	}
+	colorConvertCleanupThreads();
+	
+	error = memoryDeallocate((void**) &convertOutput);
+	RETURN_ON_ERROR(error);
+	error = memoryDeallocate((void**) &convertReference);
+	RETURN_ON_ERROR(error);
+	error = memoryDeallocate((void**) &convertFrame);
+	RETURN_ON_ERROR(error);
+	error = memoryDeallocate((void**) &convertPartialLUT);
+	RETURN_ON_ERROR(error);
+	error = memoryDeallocate((void**) &convertLUT);
+	RETURN_ON_ERROR(error);
+	
+	consoleBufferFlush();
+	if (convertMismatchTotal > 0) {
+		return ERROR_COLOR_CONVERT_MISMATCH;
+	}
+	return 0;
+}
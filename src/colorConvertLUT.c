@@ -0,0 +1,397 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+//Media Enhanced sRGB to xvYCbCr Table Generation Functions
+//The full 2^24 entry LUT (the compute shader's original input), the
+//reference double math for a single color, and the partial LUTs used by
+//shaderPartial.comp.glsl: one 256 entry table per sRGB channel holding that
+//channel's part of the fixed point numerators plus a short sorted list of the
+//tie colors where the full LUT rounded down instead of up
+//No compatibility layer functions are needed so the C runtime helper
+//programs (CheckLosslessSRGBtoYUV) can link this file too
+#include "math.h" //Includes the math function definitions
+#include "colorConvert.h" //Include Color Conversion Function Definitions
+#include <immintrin.h> //AVX2 intrinsics
+
+//sRGB to xvYCbCr LUT generation for both 601 (sYCC) and 709 (version > 0)
+//Using ITU-T H.273 as a reference
+//Color Primaries are always from 709:
+//    x       y    primary
+// 0.300   0.600   green
+// 0.150   0.060   blue
+// 0.640   0.330   red
+// 0.3127  0.3290  white D65
+//10-bit version when bits > 0, otherwise 8-bit version
+//Only the red planes redStart to redEnd - 1 (65536 entries each) get written
+static void populateSRGBtoXVYCbCrPlanesScalar(uint32_t* lutData, uint32_t version, uint32_t bits, uint32_t redStart, uint32_t redEnd) {
+	double Kr = 0.299;
+	double Kb = 0.114;
+	if (version > 0) {
+		Kr = 0.2126;
+		Kb = 0.0722;
+	}
+	double Kg = (1.0 - Kr) - Kb;	
+	double CbMult = 0.5 / (1.0 - Kb);
+	double CrMult = 0.5 / (1.0 - Kr);
+	
+	double sRGBranged = 1.0 / 255.0;
+	
+	double bitFactor = 255.0;
+	if (bits > 0) {
+		bitFactor = 1023.0;
+	}
+	
+	uint32_t* xvYCbCr = &(lutData[redStart << 16]);
+	
+	for (uint32_t red = redStart; red < redEnd; red++) {
+		double R = ((double) red) * sRGBranged;
+		double Yr = Kr * R;
+		for (uint32_t green = 0; green < SRGB_MAX_VALUE; green++) {
+			double G = ((double) green) * sRGBranged;
+			double Yrg = (Kg * G) + Yr;
+			for (uint32_t blue = 0; blue < SRGB_MAX_VALUE; blue++) {
+				double B = ((double) blue) * sRGBranged;
+				double Y = (Kb * B) + Yrg;
+				
+				double Cb = B - Y;
+				double Cr = R - Y;
+				Cb *= CbMult;
+				Cr *= CrMult;
+				Cb += 0.5;
+				Cr += 0.5;
+				
+				Y *= bitFactor;
+				if (Y > bitFactor) {
+					Y = bitFactor;
+				}
+				else if (Y < 0.0) {
+					Y = 0.0;
+				}
+				
+				Cb *= bitFactor;
+				Cb += 0.5; //Needed only for FFMPEG almost perfect conversion
+				if (Cb > bitFactor) {
+					Cb = bitFactor;
+				}
+				else if (Cb < 0.0) {
+					Cb = 0.0;
+				}
+				
+				Cr *= bitFactor;
+				Cr += 0.5; //Needed only for FFMPEG almost perfect conversion
+				if (Cr > bitFactor) {
+					Cr = bitFactor;
+				}
+				else if (Cr < 0.0) {
+					Cr = 0.0;
+				}
+				
+				int32_t Yint = roundDouble(Y);
+				int32_t Cbint = roundDouble(Cb);
+				int32_t Crint = roundDouble(Cr);
+				
+				if (bits == 0) {
+					*xvYCbCr = (Yint << 16) | (Cbint << 8) | Crint;
+				}
+				else {
+					*xvYCbCr = (Yint << 20) | (Cbint << 10) | Crint;
+				}
+				xvYCbCr++;
+			}
+		}
+	}
+}
+
+//Same double operations in the same order as the scalar version on 4 blue values at a time
+//(AVX2 without FMA so nothing gets fused, and vcvtpd2dq rounds half to even just like
+//the vcvtsd2si in roundDouble) so the table comes out byte identical
+__attribute__((target("avx2"))) static void populateSRGBtoXVYCbCrPlanesAVX2(uint32_t* lutData, uint32_t version, uint32_t bits, uint32_t redStart, uint32_t redEnd) {
+	double Kr = 0.299;
+	double Kb = 0.114;
+	if (version > 0) {
+		Kr = 0.2126;
+		Kb = 0.0722;
+	}
+	double Kg = (1.0 - Kr) - Kb;
+	double CbMult = 0.5 / (1.0 - Kb);
+	double CrMult = 0.5 / (1.0 - Kr);
+	
+	double sRGBranged = 1.0 / 255.0;
+	
+	double bitFactor = 255.0;
+	int shiftY = 16;
+	int shiftCb = 8;
+	if (bits > 0) {
+		bitFactor = 1023.0;
+		shiftY = 20;
+		shiftCb = 10;
+	}
+	
+	const __m256d KbVector = _mm256_set1_pd(Kb);
+	const __m256d CbMultVector = _mm256_set1_pd(CbMult);
+	const __m256d CrMultVector = _mm256_set1_pd(CrMult);
+	const __m256d rangedVector = _mm256_set1_pd(sRGBranged);
+	const __m256d bitFactorVector = _mm256_set1_pd(bitFactor);
+	const __m256d halfVector = _mm256_set1_pd(0.5);
+	const __m256d zeroVector = _mm256_setzero_pd();
+	const __m256d blueStep = _mm256_set1_pd(4.0);
+	
+	__m128i* xvYCbCr = (__m128i*) (&(lutData[redStart << 16]));
+	for (uint32_t red = redStart; red < redEnd; red++) {
+		double R = ((double) red) * sRGBranged;
+		double Yr = Kr * R;
+		__m256d RVector = _mm256_set1_pd(R);
+		for (uint32_t green = 0; green < SRGB_MAX_VALUE; green++) {
+			double G = ((double) green) * sRGBranged;
+			double Yrg = (Kg * G) + Yr;
+			__m256d YrgVector = _mm256_set1_pd(Yrg);
+			__m256d blue = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+			for (uint32_t b = 0; b < SRGB_MAX_VALUE; b += 4) {
+				__m256d B = _mm256_mul_pd(blue, rangedVector);
+				__m256d Y = _mm256_add_pd(_mm256_mul_pd(KbVector, B), YrgVector);
+				
+				__m256d Cb = _mm256_sub_pd(B, Y);
+				__m256d Cr = _mm256_sub_pd(RVector, Y);
+				Cb = _mm256_mul_pd(Cb, CbMultVector);
+				Cr = _mm256_mul_pd(Cr, CrMultVector);
+				Cb = _mm256_add_pd(Cb, halfVector);
+				Cr = _mm256_add_pd(Cr, halfVector);
+				
+				Y = _mm256_mul_pd(Y, bitFactorVector);
+				Y = _mm256_max_pd(_mm256_min_pd(Y, bitFactorVector), zeroVector);
+				
+				Cb = _mm256_add_pd(_mm256_mul_pd(Cb, bitFactorVector), halfVector);
+				Cb = _mm256_max_pd(_mm256_min_pd(Cb, bitFactorVector), zeroVector);
+				
+				Cr = _mm256_add_pd(_mm256_mul_pd(Cr, bitFactorVector), halfVector);
+				Cr = _mm256_max_pd(_mm256_min_pd(Cr, bitFactorVector), zeroVector);
+				
+				__m128i Yint = _mm256_cvtpd_epi32(Y);
+				__m128i Cbint = _mm256_cvtpd_epi32(Cb);
+				__m128i Crint = _mm256_cvtpd_epi32(Cr);
+				__m128i packed = _mm_or_si128(_mm_sll_epi32(Yint, _mm_cvtsi32_si128(shiftY)), _mm_sll_epi32(Cbint, _mm_cvtsi32_si128(shiftCb)));
+				_mm_storeu_si128(xvYCbCr, _mm_or_si128(packed, Crint));
+				xvYCbCr++;
+				blue = _mm256_add_pd(blue, blueStep);
+			}
+		}
+	}
+}
+
+void populateSRGBtoXVYCbCrPlanes(uint32_t* lutData, uint32_t version, uint32_t bits, uint32_t redStart, uint32_t redEnd, uint64_t isa) {
+	if (isa >= COLOR_CONVERT_ISA_AVX2) { //The 4 doubles per AVX2 register already keep up with memory
+		populateSRGBtoXVYCbCrPlanesAVX2(lutData, version, bits, redStart, redEnd);
+	}
+	else {
+		populateSRGBtoXVYCbCrPlanesScalar(lutData, version, bits, redStart, redEnd);
+	}
+}
+
+void populateSRGBtoXVYCbCrLUT(uint32_t* lutData, uint32_t version, uint32_t bits) {
+	populateSRGBtoXVYCbCrPlanesScalar(lutData, version, bits, 0, SRGB_MAX_VALUE);
+}
+
+//One pixel with the same double operations in the same order as populateSRGBtoXVYCbCrLUT(..., 1, 1)
+uint32_t colorConvertReferencePixel(uint32_t bgra) {
+	double Kr = 0.2126;
+	double Kb = 0.0722;
+	double Kg = (1.0 - Kr) - Kb;
+	double CbMult = 0.5 / (1.0 - Kb);
+	double CrMult = 0.5 / (1.0 - Kr);
+	double sRGBranged = 1.0 / 255.0;
+	double bitFactor = 1023.0;
+	
+	double R = ((double) ((bgra >> 16) & 0xFF)) * sRGBranged;
+	double G = ((double) ((bgra >> 8) & 0xFF)) * sRGBranged;
+	double B = ((double) (bgra & 0xFF)) * sRGBranged;
+	double Yr = Kr * R;
+	double Yrg = (Kg * G) + Yr;
+	double Y = (Kb * B) + Yrg;
+	
+	double Cb = B - Y;
+	double Cr = R - Y;
+	Cb *= CbMult;
+	Cr *= CrMult;
+	Cb += 0.5;
+	Cr += 0.5;
+	
+	Y *= bitFactor;
+	if (Y > bitFactor) {
+		Y = bitFactor;
+	}
+	else if (Y < 0.0) {
+		Y = 0.0;
+	}
+	
+	Cb *= bitFactor;
+	Cb += 0.5;
+	if (Cb > bitFactor) {
+		Cb = bitFactor;
+	}
+	else if (Cb < 0.0) {
+		Cb = 0.0;
+	}
+	
+	Cr *= bitFactor;
+	Cr += 0.5;
+	if (Cr > bitFactor) {
+		Cr = bitFactor;
+	}
+	else if (Cr < 0.0) {
+		Cr = 0.0;
+	}
+	
+	int32_t Yint = roundDouble(Y);
+	int32_t Cbint = roundDouble(Cb);
+	int32_t Crint = roundDouble(Cr);
+	return (Yint << 20) | (Cbint << 10) | Crint;
+}
+
+//Which of the tie channels (bit 0 Y, bit 1 Cb, bit 2 Cr) round down for this color
+static uint32_t colorPartialCorrection(uint32_t* partialLUT, uint32_t rgb) {
+	uint32_t* corrections = &(partialLUT[COLOR_PARTIAL_LUT_CORRECTIONS]);
+	uint32_t low = 0;
+	uint32_t high = partialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT];
+	while (low < high) {
+		uint32_t middle = (low + high) >> 1;
+		if ((corrections[middle] >> 8) < rgb) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	if ((low < partialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT]) && ((corrections[low] >> 8) == rgb)) {
+		return corrections[low] & 0b111;
+	}
+	return 0;
+}
+
+uint32_t colorConvertPartialPixel(uint32_t* partialLUT, uint32_t bgra) {
+	uint32_t* red = &(partialLUT[((bgra >> 16) & 0xFF) << 2]);
+	uint32_t* green = &(partialLUT[(SRGB_MAX_VALUE + ((bgra >> 8) & 0xFF)) << 2]);
+	uint32_t* blue = &(partialLUT[((SRGB_MAX_VALUE << 1) + (bgra & 0xFF)) << 2]);
+	const uint32_t divisors[3] = {COLOR_FIXED_Y_DIVISOR, COLOR_FIXED_CB_DIVISOR, COLOR_FIXED_CR_DIVISOR};
+	
+	uint32_t values[3];
+	uint32_t tieMask = 0;
+	for (uint32_t c = 0; c < 3; c++) {
+		uint32_t x = red[c] + green[c] + blue[c]; //Wraps back into [0, 2^31) like the shader's uint math
+		values[c] = x / divisors[c];
+		if ((values[c] * divisors[c]) == x) {
+			tieMask |= 1 << c;
+		}
+	}
+	if (tieMask > 0) {
+		tieMask &= colorPartialCorrection(partialLUT, bgra & 0xFFFFFF);
+		for (uint32_t c = 0; c < 3; c++) {
+			values[c] -= (tieMask >> c) & 1;
+		}
+	}
+	for (uint32_t c = 0; c < 3; c++) {
+		if (values[c] > 1023) {
+			values[c] = 1023;
+		}
+	}
+	return (values[0] << 20) | (values[1] << 10) | values[2];
+}
+
+void populateSRGBtoXVYCbCrPartialTables(uint32_t* partialLUT) {
+	for (int32_t v = 0; v < SRGB_MAX_VALUE; v++) {
+		uint32_t* red = &(partialLUT[v << 2]);
+		uint32_t* green = &(partialLUT[(SRGB_MAX_VALUE + v) << 2]);
+		uint32_t* blue = &(partialLUT[((SRGB_MAX_VALUE << 1) + v) << 2]);
+		red[0] = (uint32_t) ((341 * 2126 * v) + COLOR_FIXED_Y_OFFSET); //The red table also carries the offsets
+		red[1] = (uint32_t) ((341 * -2126 * v) + COLOR_FIXED_CB_OFFSET);
+		red[2] = (uint32_t) ((341 * 7874 * v) + COLOR_FIXED_CR_OFFSET);
+		red[3] = 0;
+		green[0] = (uint32_t) (341 * 7152 * v);
+		green[1] = (uint32_t) (341 * -7152 * v);
+		green[2] = (uint32_t) (341 * -7152 * v);
+		green[3] = 0;
+		blue[0] = (uint32_t) (341 * 722 * v);
+		blue[1] = (uint32_t) (341 * 9278 * v);
+		blue[2] = (uint32_t) (341 * -722 * v);
+		blue[3] = 0;
+	}
+	partialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT] = 0;
+}
+
+//Only exact ties can round differently than the LUT so only those get compared
+//(CheckLosslessSRGBtoYUV compares every color)
+int populateSRGBtoXVYCbCrPartialCorrections(uint32_t* partialLUT, uint32_t redStart, uint32_t redEnd, uint32_t* corrections, uint32_t* correctionCount) {
+	uint32_t count = 0;
+	const uint32_t divisors[3] = {COLOR_FIXED_Y_DIVISOR, COLOR_FIXED_CB_DIVISOR, COLOR_FIXED_CR_DIVISOR};
+	for (uint32_t rgb = redStart << 16; rgb < (redEnd << 16); rgb++) {
+		uint32_t* red = &(partialLUT[(rgb >> 16) << 2]);
+		uint32_t* green = &(partialLUT[(SRGB_MAX_VALUE + ((rgb >> 8) & 0xFF)) << 2]);
+		uint32_t* blue = &(partialLUT[((SRGB_MAX_VALUE << 1) + (rgb & 0xFF)) << 2]);
+		uint32_t values[3];
+		uint32_t tieMask = 0;
+		for (uint32_t c = 0; c < 3; c++) {
+			uint32_t x = red[c] + green[c] + blue[c];
+			values[c] = x / divisors[c];
+			if ((values[c] * divisors[c]) == x) {
+				tieMask |= 1 << c;
+			}
+		}
+		if (tieMask == 0) {
+			continue;
+		}
+		
+		uint32_t reference = colorConvertReferencePixel(rgb);
+		uint32_t correction = 0;
+		for (uint32_t c = 0; c < 3; c++) {
+			uint32_t expected = (reference >> (20 - (c * 10))) & 0x3FF;
+			uint32_t roundedUp = (values[c] > 1023) ? 1023 : values[c];
+			uint32_t roundedDown = ((values[c] - 1) > 1023) ? 1023 : (values[c] - 1);
+			if (roundedUp == expected) {
+				continue;
+			}
+			if ((((tieMask >> c) & 1) == 0) || (roundedDown != expected)) {
+				return ERROR_COLOR_CONVERT_MISMATCH;
+			}
+			correction |= 1 << c;
+		}
+		if (correction > 0) {
+			if (count >= COLOR_PARTIAL_CORRECTION_MAX) {
+				return ERROR_COLOR_CONVERT_MISMATCH;
+			}
+			corrections[count] = (rgb << 8) | correction; //Colors go up so the list stays sorted
+			count++;
+		}
+	}
+	*correctionCount = count;
+	return 0;
+}
+
+int populateSRGBtoXVYCbCrPartialLUT(uint32_t* partialLUT) {
+	populateSRGBtoXVYCbCrPartialTables(partialLUT);
+	uint32_t correctionCount = 0;
+	int error = populateSRGBtoXVYCbCrPartialCorrections(partialLUT, 0, SRGB_MAX_VALUE, &(partialLUT[COLOR_PARTIAL_LUT_CORRECTIONS]), &correctionCount);
+	if (error != 0) {
+		return error;
+	}
+	partialLUT[COLOR_PARTIAL_LUT_CORRECTION_COUNT] = correctionCount;
+	return 0;
+}
@@ -62,6 +62,7 @@ void compatibilityGetExtraError(int* error);
 
 int timeFunctionSetup();
 uint64_t getCurrentTime();
+uint64_t getDiffTimeNanoseconds(uint64_t startTime, uint64_t endTime);
 uint64_t getDiffTimeMicroseconds(uint64_t startTime, uint64_t endTime);
 uint64_t getDiffTimeMilliseconds(uint64_t startTime, uint64_t endTime);
 uint64_t getDiffTimeSeconds(uint64_t startTime, uint64_t endTime);
@@ -71,6 +72,7 @@ uint64_t getFrameIntervalTime(uint64_t fps);
 uint64_t getMicrosecondDivider();
 uint64_t getTimestampNTP();
 uint64_t getTimestamp100us();
+uint64_t getProcessTimeMicroseconds(); //CPU time used so far by all of the program's threads
 
 
 // Memory Functions
@@ -125,6 +127,17 @@ void compatibilitySleepFast(uint64_t milliseconds);
 #define IO_FILE_WRITE_NORMAL 1
 #define IO_FILE_READ_ASYNC 2
 #define IO_FILE_WRITE_ASYNC 3
+#define IO_FILE_WRITE_ASYNC_DIRECT 4 //Block aligned (4096: memory, size and offset) asynchronous writes bypass the OS file cache where the file system supports it, the rest go through the cache
+#define IO_FILE_UPDATE_NORMAL 5 //Existing file opened for reading and writing (nothing gets truncated)
+
+// Asynchronous Scatter / Gather Write Vectors:
+#define IO_ASYNC_VECTOR_MAX 4
+struct ioWriteVector {
+	void* dataPtr;
+	uint64_t numBytes;
+};
+
+typedef struct ioWriteVector ioWriteVec;
 
 // Argument and File Management Functions:
 int ioSetup();
@@ -134,11 +147,24 @@ int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t f
 int ioCloseFile(void** filePtr);
 int ioGetFileSize(void* filePtr, uint64_t* fileSizeBytes);
 int ioReadFile(void* filePtr, void* dataPtr, uint32_t* numBytess);
+int ioReadFileOffset(void* filePtr, void* dataPtr, uint32_t* numBytes, uint64_t offset); //Reads at the offset (numBytes ends as the bytes actually read)
 int ioWriteFile(void* filePtr, void* dataPtr, uint32_t numBytes);
+int ioSetFileSize(void* filePtr, uint64_t fileSizeBytes); //Truncates or extends the file and moves the file position to the new end
+int ioAllocateFileSpace(void* filePtr, uint64_t numBytes); //Reserves disk space for the first numBytes without changing the file size (ioSetFileSize releases what goes unused)
+int ioGetFreeSpace(void* filePtr, uint64_t* freeBytes); //Space left for the user on the disk the file is on
+int ioDeleteFile(char* filePathUTF8, int filePathBytes);
+#define IO_MAP_ALIGNMENT 65536 //Mapping offsets have to be a multiple of this (allocation granularity on Windows)
+int ioMapFile(void* filePtr, uint64_t offset, uint64_t numBytes, void** mapPtr); //Read only view of numBytes of the file at the offset
+int ioUnmapFile(void** mapPtr, uint64_t numBytes);
+int ioCopyFileRange(void* outputFilePtr, void* inputFilePtr, uint64_t offset, uint64_t numBytes); //Input bytes at the offset appended at the output's position
 int ioAsyncSetup(uint64_t asyncOperationCount);
+int ioAsyncRegisterBuffer(void* dataPtr, uint64_t numBytes);
 int ioAsyncSignalWait(uint64_t asyncOperation);
 int ioAsyncSignalCheck(uint64_t asyncOperation, uint64_t* signaled);
 int ioAsyncWriteFile(void* filePtr, void* dataPtr, uint64_t numBytes, uint64_t asyncOperation, uint64_t offset);
+int ioAsyncWriteFileV(void* filePtr, ioWriteVec* writeVectors, uint64_t vectorCount, uint64_t asyncOperation, uint64_t offset);
+int ioAsyncSyncFile(void* filePtr, uint64_t asyncOperation); //Flushes the file's completed writes to the storage device (checked / waited on like a write)
+uint64_t ioAsyncGetSystemCallCount();
 void ioAsyncCleanup();
 int ioSelectAndOpenFile(void** filePtr, uint64_t flags, char* filePathUTF8);
 int ioLoadLibrary(void** libraryPtr, char* libraryNameUTF8);
@@ -158,8 +184,18 @@ int syncEventWait(void* eventPtr);
 int syncEventCheck(void* eventPtr, uint64_t* signaled);
 void syncCloseEvent(void** eventPtr);
 
+// Wait Sets: sleep until an added event signals, an asynchronous write completes, or the end time passes
+// Waking does not consume any of the signals so the caller checks each source again afterwards
+// (added events should only be signaled for work the caller is actually waiting on)
+#define SYNC_WAIT_NONE 0xFFFFFFFFFFFFFFFF //No asynchronous operation or no end time
+int syncCreateWaitSet(void** waitSetPtr);
+int syncWaitSetAddEvent(void* waitSetPtr, void* eventPtr);
+int syncWaitSetWait(void* waitSetPtr, uint64_t asyncOperation, uint64_t endTime);
+void syncCloseWaitSet(void** waitSetPtr);
+
 typedef int (*PFN_ThreadStart)();
 int syncStartThread(void** threadPtr, PFN_ThreadStart threadStart, uint64_t initialState);
+uint64_t syncGetProcessorCount(); //Logical processors available for worker threads
 //thread check if running
 
 
@@ -189,6 +225,14 @@ int syncStartThread(void** threadPtr, PFN_ThreadStart threadStart, uint64_t init
 #define ERROR_IO_WRONG_WRITE_SIZE 0x1013
 #define ERROR_IO_CANNOT_LOAD_LIBRARY 0x01040
 #define ERROR_IO_CANNOT_FIND_LIBRARY_FUNCTION 0x01041
+#define ERROR_IO_CANNOT_MAP_FILE 0x1042
+#define ERROR_IO_CANNOT_UNMAP_FILE 0x1043
+#define ERROR_IO_CANNOT_COPY_FILE 0x1044
+#define ERROR_IO_CANNOT_SET_FILE_SIZE 0x1045
+#define ERROR_IO_CANNOT_SYNC_FILE 0x1046
+#define ERROR_IO_CANNOT_ALLOCATE_FILE_SPACE 0x1047
+#define ERROR_IO_CANNOT_DELETE_FILE 0x1048
+#define ERROR_IO_CANNOT_GET_FREE_SPACE 0x1049
 #define ERROR_EVENT_NOT_CREATED 0x1014
 #define ERROR_THREAD_NOT_CREATED 0x1015
 #define ERROR_EVENT_NOT_SET 0x1016
@@ -0,0 +1,1986 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//Media Enhanced Linux Compatibility Implementation
+//Used for the offline tooling (bitstream processing and LUT helpers) that runs
+//on Linux machines, so unlike the Windows version it links against the C
+//runtime library and calls the POSIX / Linux system interfaces directly
+//All strings are already UTF-8 so no translation is needed
+//Complete error checking is still a work in progress
+#define _GNU_SOURCE //Needed for MAP_HUGETLB, eventfd, and the other Linux specific definitions
+#define COMPATIBILITY_GRAPHICS_UNNEEDED
+#define COMPATIBILITY_NETWORK_UNNEEDED
+#include "compatibility.h" //Includes stdint.h
+
+#include <stdlib.h> //exit
+#include <errno.h> //errno for the extra error information
+#include <time.h> //clock_gettime & nanosleep
+#include <unistd.h> //read, write, close, isatty, sysconf
+#include <fcntl.h> //open flags
+#include <poll.h> //poll for non-blocking checks
+#include <termios.h> //tcflush
+#include <pthread.h> //Threads
+#include <dlfcn.h> //dlopen & dlsym
+#include <sys/mman.h> //mmap
+#include <sys/stat.h> //fstat
+#include <sys/statvfs.h> //fstatvfs for the free disk space
+#include <sys/eventfd.h> //Events
+#include <sys/epoll.h> //Wait Sets
+#include <sys/timerfd.h> //Wait Set end times
+#include <sys/uio.h> //Vectored writes
+#include <sys/sendfile.h> //sendfile when copy_file_range can not be used
+#include <sys/syscall.h> //io_uring system call numbers
+#include <linux/io_uring.h> //io_uring structures (kernel header)
+
+//The C runtime calls main which hands off to the program entry function
+//(defined in programEntry.h) after storing the command arguments
+void programEntry();
+
+static int ioArgumentCount = 0;
+static char** ioArgumentValues = NULL;
+
+int main(int argc, char** argv) {
+	ioArgumentCount = argc;
+	ioArgumentValues = argv;
+	programEntry();
+	return 0; //Never reached, programEntry calls compatibilityExit
+}
+
+void compatibilityExit(int returnError) {
+	exit(returnError);
+}
+
+void compatibilityGetExtraError(int* error) {
+	*error = errno;
+}
+
+
+//Time State and Functions:
+//The monotonic clock is read in nanoseconds so the counter frequency is fixed
+#define TIME_COUNTER_FREQUENCY 1000000000
+static uint64_t timeCounterFrequency = 0;
+static uint64_t timeSecondDivider = 0;
+static uint64_t timeMillisecondDivider = 0;
+static uint64_t timeMicrosecondDivider = 0;
+
+int timeFunctionSetup() {
+	struct timespec timeResolution;
+	int result = clock_getres(CLOCK_MONOTONIC, &timeResolution);
+	if (result != 0) {
+		return ERROR_TIMER_BAD; //Will probably NEVER happen
+	}
+	timeCounterFrequency = TIME_COUNTER_FREQUENCY;
+	timeSecondDivider = timeCounterFrequency / SECOND_FREQUENCY;
+	timeMillisecondDivider = timeCounterFrequency / MILLISECOND_FREQUENCY;
+	timeMicrosecondDivider = timeCounterFrequency / MICROSECOND_FREQUENCY;
+	
+	return 0;
+}
+
+uint64_t getCurrentTime() {
+	struct timespec currentTime;
+	clock_gettime(CLOCK_MONOTONIC, &currentTime);
+	return (((uint64_t) currentTime.tv_sec) * TIME_COUNTER_FREQUENCY) + ((uint64_t) currentTime.tv_nsec);
+}
+
+uint64_t getDiffTimeNanoseconds(uint64_t startTime, uint64_t endTime) {
+	return (endTime - startTime);
+}
+
+uint64_t getDiffTimeMicroseconds(uint64_t startTime, uint64_t endTime) {
+	return ((endTime - startTime) / timeMicrosecondDivider);
+}
+
+uint64_t getDiffTimeMilliseconds(uint64_t startTime, uint64_t endTime) {
+	return ((endTime - startTime) / timeMillisecondDivider);
+}
+
+uint64_t getDiffTimeSeconds(uint64_t startTime, uint64_t endTime) {
+	return ((endTime - startTime) / timeSecondDivider);
+}
+
+uint64_t getEndTimeFromMicroDiff(uint64_t startTime, uint64_t usDiff) {
+	return (startTime + (usDiff * timeMicrosecondDivider));
+}
+
+uint64_t getEndTimeFromMilliDiff(uint64_t startTime, uint64_t msDiff) {
+	return (startTime + (msDiff * timeMillisecondDivider));
+}
+
+uint64_t getFrameIntervalTime(uint64_t fps) {
+	return timeCounterFrequency / fps;
+}
+
+uint64_t getMicrosecondDivider() {
+	return timeMicrosecondDivider;
+}
+
+uint64_t getProcessTimeMicroseconds() {
+	struct timespec processTime;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &processTime);
+	return (((uint64_t) processTime.tv_sec) * MICROSECOND_FREQUENCY) + (((uint64_t) processTime.tv_nsec) / 1000);
+}
+
+#define TIME_SECONDS_1900_TO_1970 2208988800
+
+uint64_t getTimestampNTP() {
+	struct timespec sysTimeUTC;
+	clock_gettime(CLOCK_REALTIME, &sysTimeUTC);
+	
+	uint64_t seconds = ((uint64_t) sysTimeUTC.tv_sec) + TIME_SECONDS_1900_TO_1970;
+	seconds <<= 32;
+	
+	uint64_t secondFraction = (uint64_t) sysTimeUTC.tv_nsec;
+	secondFraction <<= 32;
+	secondFraction /= 1000000000;
+	secondFraction &= 0xFFFFFFFF;
+	
+	return seconds | secondFraction;
+}
+
+uint64_t getTimestamp100us() {
+	struct timespec sysTimeUTC;
+	clock_gettime(CLOCK_REALTIME, &sysTimeUTC);
+	
+	uint64_t us100 = (((uint64_t) sysTimeUTC.tv_sec) + TIME_SECONDS_1900_TO_1970) * 10000;
+	us100 += ((uint64_t) sysTimeUTC.tv_nsec) / 100000;
+	
+	return us100;
+}
+
+
+// Memory Operations:
+//munmap needs the size of the mapping and there is no VirtualQuery equivalent
+//so every allocation is remembered in a small fixed table (guarded for threads)
+#define MEMORY_ALLOCATION_MAX 256
+#define MEMORY_LARGE_PAGE_BYTES 2097152 //2MB huge pages on x64
+static void* memoryAllocationPtrs[MEMORY_ALLOCATION_MAX];
+static uint64_t memoryAllocationBytes[MEMORY_ALLOCATION_MAX];
+static pthread_mutex_t memoryAllocationLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t largePageSupport = 0;
+
+static int memoryTrackAllocation(void* memoryPtr, uint64_t memoryBytes) {
+	pthread_mutex_lock(&memoryAllocationLock);
+	for (uint64_t i = 0; i < MEMORY_ALLOCATION_MAX; i++) {
+		if (memoryAllocationPtrs[i] == NULL) {
+			memoryAllocationPtrs[i] = memoryPtr;
+			memoryAllocationBytes[i] = memoryBytes;
+			pthread_mutex_unlock(&memoryAllocationLock);
+			return 0;
+		}
+	}
+	pthread_mutex_unlock(&memoryAllocationLock);
+	munmap(memoryPtr, memoryBytes);
+	return ERROR_MEMORY_CANNOT_ALLOC;
+}
+
+static uint64_t memoryFindAllocation(void* memoryPtr) {
+	for (uint64_t i = 0; i < MEMORY_ALLOCATION_MAX; i++) {
+		if (memoryAllocationPtrs[i] == memoryPtr) {
+			return i;
+		}
+	}
+	return MEMORY_ALLOCATION_MAX;
+}
+
+int memoryLargePageSetup() { //Try to allow the creation of large page memory
+	//Huge pages need to be reserved by the system (vm.nr_hugepages) so test with one
+	void* testPtr = mmap(NULL, MEMORY_LARGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (testPtr == MAP_FAILED) {
+		largePageSupport = 0;
+		return ERROR_LARGE_PAGE_NOT_ALLOWED;
+	}
+	munmap(testPtr, MEMORY_LARGE_PAGE_BYTES);
+	
+	largePageSupport = 1;
+	return 0;
+}
+
+int memoryAllocateOnePage(void** memoryPtr, uint64_t* memoryBytes) {
+	uint64_t defaultPageSize = (uint64_t) sysconf(_SC_PAGESIZE); //Expecting to be set to 4KB (1024 * 4 bytes) for x64 Architecture
+	
+	*memoryBytes = defaultPageSize;
+	return memoryAllocate(memoryPtr, defaultPageSize, 0);
+}
+
+int memoryAllocate(void** memoryPtr, uint64_t memoryBytes, uint64_t largePage) {
+	int allocationType = MAP_PRIVATE | MAP_ANONYMOUS;
+	if (largePage > 0) {
+		if (largePageSupport == 0) {
+			return ERROR_LARGE_PAGE_NOT_ALLOWED;
+		}
+		if ((memoryBytes % MEMORY_LARGE_PAGE_BYTES) != 0) {
+			return ERROR_LARGE_PAGE_NOT_ENOUGH_BYTES;
+		}
+		allocationType |= MAP_HUGETLB;
+	}
+	void* mapPtr = mmap(NULL, (size_t) memoryBytes, PROT_READ | PROT_WRITE, allocationType, -1, 0);
+	if (mapPtr == MAP_FAILED) {
+		*memoryPtr = NULL;
+		return ERROR_MEMORY_CANNOT_ALLOC;
+	}
+	
+	int error = memoryTrackAllocation(mapPtr, memoryBytes);
+	if (error != 0) {
+		*memoryPtr = NULL;
+		return error;
+	}
+	*memoryPtr = mapPtr;
+	return 0;
+}
+
+int memoryGetSize(void* memoryPtr, uint64_t* memoryBytes) {
+	pthread_mutex_lock(&memoryAllocationLock);
+	uint64_t index = memoryFindAllocation(memoryPtr);
+	uint64_t allocationBytes = 0;
+	if (index < MEMORY_ALLOCATION_MAX) {
+		allocationBytes = memoryAllocationBytes[index];
+	}
+	pthread_mutex_unlock(&memoryAllocationLock);
+	if (index == MEMORY_ALLOCATION_MAX) {
+		return ERROR_MEMORY_CANNOT_GET_SIZE;
+	}
+	//Report the page rounded size like VirtualQuery does on Windows
+	uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+	*memoryBytes = (allocationBytes + pageSize - 1) & ~(pageSize - 1);
+	return 0;
+}
+
+int memoryDeallocate(void** memoryPtr) {
+	pthread_mutex_lock(&memoryAllocationLock);
+	uint64_t index = memoryFindAllocation(*memoryPtr);
+	uint64_t allocationBytes = 0;
+	if (index < MEMORY_ALLOCATION_MAX) {
+		allocationBytes = memoryAllocationBytes[index];
+		memoryAllocationPtrs[index] = NULL;
+		memoryAllocationBytes[index] = 0;
+	}
+	pthread_mutex_unlock(&memoryAllocationLock);
+	if (index == MEMORY_ALLOCATION_MAX) {
+		return ERROR_MEMORY_CANNOT_FREE;
+	}
+	int result = munmap(*memoryPtr, allocationBytes);
+	if (result != 0) {
+		return ERROR_MEMORY_CANNOT_FREE;
+	}
+	*memoryPtr = NULL;
+	return 0;
+}
+
+
+// Console State Codes:
+#define CONSOLE_STATE_UNDEFINED 0
+#define CONSOLE_STATE_MINIMUM 1
+#define CONSOLE_STATE_FULL 2
+static uint64_t consoleState = CONSOLE_STATE_UNDEFINED;
+
+static int consoleOut = STDOUT_FILENO;
+static int consoleIn = STDIN_FILENO;
+
+//Writes everything even when the terminal / pipe only accepts part of it
+static int consoleWriteAll(char* strUTF8, uint64_t strBytes) {
+	while (strBytes > 0) {
+		ssize_t bytesWritten = write(consoleOut, strUTF8, (size_t) strBytes);
+		if (bytesWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return ERROR_CONSOLE_WRITE;
+		}
+		if (bytesWritten == 0) {
+			return ERROR_CONSOLE_WRITE_SIZE;
+		}
+		strUTF8 += bytesWritten;
+		strBytes -= (uint64_t) bytesWritten;
+	}
+	return 0;
+}
+
+void consoleSetupMinimum() {
+	if (consoleState > CONSOLE_STATE_UNDEFINED) {
+		return;
+	}
+	
+	consoleOut = STDOUT_FILENO;
+	consoleIn = STDIN_FILENO;
+	
+	consoleState = CONSOLE_STATE_MINIMUM;
+}
+
+void consoleWriteDirectLine(char* strUTF8, uint64_t strBytes) {
+	if (consoleState < CONSOLE_STATE_MINIMUM) {
+		return;
+	}
+	
+	consoleWriteAll(strUTF8, strBytes);
+	char newLine = '\n';
+	consoleWriteAll(&newLine, 1);
+}
+
+void consoleWriteDirectLineWithNumber(char* strUTF8, uint64_t strBytes, uint64_t number, uint64_t numberFormat) {
+	if (consoleState < CONSOLE_STATE_MINIMUM) {
+		return;
+	}
+	
+	consoleWriteAll(strUTF8, strBytes);
+	
+	char strBuffer[32];
+	uint64_t numCharacters = 0;
+	char newLine = '\n';
+	
+	if (numberFormat == NUM_FORMAT_FULL_HEXADECIMAL) {
+		numToFHexStr(number, &strBuffer[2]);
+		strBuffer[0] = '0';
+		strBuffer[1] = 'x';
+		strBuffer[18] = newLine;
+		numCharacters = 19;
+	}
+	else if (numberFormat == NUM_FORMAT_PARTIAL_HEXADECIMAL) {
+		uint64_t digits = numToPHexStr(number, &strBuffer[2]);
+		strBuffer[0] = '0';
+		strBuffer[1] = 'x';
+		strBuffer[digits + 2] = newLine;
+		numCharacters = digits + 3;
+	}
+	else if (numberFormat == NUM_FORMAT_UNSIGNED_INTEGER) {
+		uint64_t digits = numToUDecStr(strBuffer, number);
+		strBuffer[digits] = newLine;
+		numCharacters = digits + 1;
+	}
+	
+	consoleWriteAll(strBuffer, numCharacters);
+}
+
+void consoleWaitForEnter() {
+	if (consoleState < CONSOLE_STATE_MINIMUM) {
+		return;
+	}
+	
+	//If there is an enter already "waiting" clear it first
+	if (isatty(consoleIn) == 1) {
+		tcflush(consoleIn, TCIFLUSH);
+	}
+	
+	//A closed or redirected input (batch jobs) counts as an enter
+	char inChar = 0;
+	while (inChar != '\n') {
+		ssize_t bytesRead = read(consoleIn, &inChar, 1);
+		if (bytesRead <= 0) {
+			if ((bytesRead < 0) && (errno == EINTR)) {
+				continue;
+			}
+			return;
+		}
+	}
+}
+
+// Console (With Buffer) State and Functions:
+#define CONSOLE_FLUSH_MS 20
+static void* consoleBuffer = NULL;
+static char* consoleBufferPos = NULL;
+static uint64_t consoleByteSize = 0;
+static uint64_t consoleBytesRemaining = 0;
+static uint64_t consoleLastFlushTime = 0;
+
+int consoleSetupFull() {
+	if (consoleState != CONSOLE_STATE_MINIMUM) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	int error = memoryAllocateOnePage(&consoleBuffer, &consoleByteSize);
+	if (error != 0) {
+		return error;
+	}
+	
+	consoleBufferPos = (char*) consoleBuffer;
+	consoleBytesRemaining = consoleByteSize;
+	consoleLastFlushTime = getCurrentTime();
+	
+	consoleState = CONSOLE_STATE_FULL;
+	
+	return 0;
+}
+
+int consoleBufferFlush() {
+	if (consoleState < CONSOLE_STATE_FULL) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	uint64_t bytesToWrite = consoleByteSize - consoleBytesRemaining;
+	if (bytesToWrite > 0) {
+		int error = consoleWriteAll((char*) consoleBuffer, bytesToWrite);
+		if (error != 0) {
+			return error;
+		}
+		
+		consoleBufferPos = (char*) consoleBuffer;
+		consoleBytesRemaining = consoleByteSize;
+	}
+	
+	consoleLastFlushTime = getCurrentTime();
+	return 0;
+}
+
+//Throws no error on invalid extra info
+int consoleWrite(char* strUTF8, uint64_t strBytes, uint64_t conExtraInfo) {
+	if (consoleState < CONSOLE_STATE_FULL) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	if (strUTF8 == NULL) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	if (strBytes > consoleBytesRemaining) {
+		int error = consoleBufferFlush();
+		if (error != 0) {
+			return error;
+		}
+	}
+	
+	//Write Direct if strBytes is too much for buffer
+	if (strBytes > consoleByteSize) {
+		int error = consoleWriteAll(strUTF8, strBytes);
+		if (error != 0) {
+			return error;
+		}
+	}
+	else {
+		memcpyBasic(consoleBufferPos, strUTF8, strBytes);
+		consoleBufferPos += strBytes;
+		consoleBytesRemaining -= strBytes;
+	}
+	
+	if (consoleBytesRemaining < 64) {
+		int error = consoleBufferFlush();
+		if (error != 0) {
+			return error;
+		}
+	}
+	
+	if (conExtraInfo == CON_NEW_LINE) {
+		char newLine = '\n';
+		*consoleBufferPos = newLine;
+		consoleBufferPos++;
+		consoleBytesRemaining--;
+	}
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t diffTimeMS = getDiffTimeMilliseconds(consoleLastFlushTime, currentTime);
+	
+	if ((consoleBytesRemaining < 256) || (diffTimeMS > CONSOLE_FLUSH_MS)) {
+		int error = consoleBufferFlush();
+		if (error != 0) {
+			return error;
+		}
+	}
+	
+	return 0;
+}
+
+//Fast Functions Assume Proper Console State
+void consoleWriteLineFast(char* strUTF8, uint64_t strBytes) {
+	if ((strBytes+1) > consoleBytesRemaining) {
+		consoleBufferFlush();
+	}
+	
+	memcpyBasic(consoleBufferPos, strUTF8, strBytes);
+	consoleBufferPos += strBytes;
+	consoleBytesRemaining -= strBytes;
+	
+	char newLine = '\n';
+	*consoleBufferPos = newLine;
+	consoleBufferPos++;
+	consoleBytesRemaining--;
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t diffTimeMS = getDiffTimeMilliseconds(consoleLastFlushTime, currentTime);
+	
+	if (diffTimeMS > CONSOLE_FLUSH_MS) {
+		consoleBufferFlush();
+	}
+}
+
+int consoleWriteLineSlow(char* strUTF8) {
+	if (consoleState < CONSOLE_STATE_FULL) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	while (*strUTF8 != 0) {
+		if (consoleBytesRemaining == 0) {
+			consoleBufferFlush();
+		}
+		
+		*consoleBufferPos = *strUTF8;
+		consoleBufferPos++;
+		strUTF8++;
+		consoleBytesRemaining--;
+	}
+	
+	if (consoleBytesRemaining == 0) {
+		consoleBufferFlush();
+	}
+	char newLine = '\n';
+	*consoleBufferPos = newLine;
+	consoleBufferPos++;
+	consoleBytesRemaining--;
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t diffTimeMS = getDiffTimeMilliseconds(consoleLastFlushTime, currentTime);
+	
+	if (diffTimeMS > CONSOLE_FLUSH_MS) {
+		consoleBufferFlush();
+	}
+	
+	return 0;
+}
+
+//Appends the number in the requested format to the buffer (expects at least 20 bytes remaining)
+static void consoleBufferNumber(uint64_t number, uint64_t numberFormat) {
+	if (numberFormat == NUM_FORMAT_FULL_HEXADECIMAL) {
+		consoleBufferPos[0] = '0';
+		consoleBufferPos[1] = 'x';
+		consoleBufferPos += 2;
+		numToFHexStr(number, consoleBufferPos);
+		consoleBufferPos += 16;
+		consoleBytesRemaining -= 18;
+	}
+	else if (numberFormat == NUM_FORMAT_PARTIAL_HEXADECIMAL) {
+		consoleBufferPos[0] = '0';
+		consoleBufferPos[1] = 'x';
+		consoleBufferPos += 2;
+		uint64_t numBytes = numToPHexStr(number, consoleBufferPos);
+		consoleBufferPos += numBytes;
+		numBytes += 2;
+		consoleBytesRemaining -= numBytes;
+	}
+	else if (numberFormat == NUM_FORMAT_UNSIGNED_INTEGER) {
+		uint64_t numBytes = numToUDecStr(consoleBufferPos, number);
+		consoleBufferPos += numBytes;
+		consoleBytesRemaining -= numBytes;
+	}
+}
+
+int consoleWriteWithNumber(char* strUTF8, uint64_t strBytes, uint64_t number, uint64_t numberFormat, uint64_t conExtraInfo) {
+	if (consoleState < CONSOLE_STATE_FULL) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	if (strUTF8 == NULL) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	if ((conExtraInfo == CON_FLIP_ORDER) || (conExtraInfo == CON_FLIP_ORDER_NEW_LINE)) {
+		if (consoleBytesRemaining < 64) {
+			int error = consoleBufferFlush();
+			if (error != 0) {
+				return error;
+			}
+		}
+		
+		consoleBufferNumber(number, numberFormat);
+		
+		if ((strBytes+1) > consoleBytesRemaining) {
+			int error = consoleBufferFlush();
+			if (error != 0) {
+				return error;
+			}
+		}
+		
+		//Write Direct if strBytes is too much for buffer
+		if (strBytes > consoleByteSize) {
+			int error = consoleWriteAll(strUTF8, strBytes);
+			if (error != 0) {
+				return error;
+			}
+		}
+		else {
+			memcpyBasic(consoleBufferPos, strUTF8, strBytes);
+			consoleBufferPos += strBytes;
+			consoleBytesRemaining -= strBytes;
+		}
+		
+		if (conExtraInfo == CON_FLIP_ORDER_NEW_LINE) {
+			char newLine = '\n';
+			*consoleBufferPos = newLine;
+			consoleBufferPos++;
+			consoleBytesRemaining--;
+		}
+	}
+	else {
+		if (strBytes > consoleBytesRemaining) {
+			int error = consoleBufferFlush();
+			if (error != 0) {
+				return error;
+			}
+		}
+		
+		//Write Direct if strBytes is too much for buffer
+		if (strBytes > consoleByteSize) {
+			int error = consoleWriteAll(strUTF8, strBytes);
+			if (error != 0) {
+				return error;
+			}
+		}
+		else {
+			memcpyBasic(consoleBufferPos, strUTF8, strBytes);
+			consoleBufferPos += strBytes;
+			consoleBytesRemaining -= strBytes;
+		}
+		
+		if (consoleBytesRemaining < 64) {
+			int error = consoleBufferFlush();
+			if (error != 0) {
+				return error;
+			}
+		}
+		
+		consoleBufferNumber(number, numberFormat);
+		
+		char newLine = '\n';
+		*consoleBufferPos = newLine;
+		consoleBufferPos++;
+		consoleBytesRemaining--;
+	}
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t diffTimeMS = getDiffTimeMilliseconds(consoleLastFlushTime, currentTime);
+	
+	if ((consoleBytesRemaining < 256) || (diffTimeMS > CONSOLE_FLUSH_MS)) {
+		int error = consoleBufferFlush();
+		if (error != 0) {
+			return error;
+		}
+	}
+	
+	return 0;
+}
+
+void consoleWriteLineWithNumberFast(char* strUTF8, uint64_t strBytes, uint64_t number, uint64_t numberFormat) {
+	if (strBytes > consoleBytesRemaining) {
+		consoleBufferFlush();
+	}
+	
+	memcpyBasic(consoleBufferPos, strUTF8, strBytes);
+	consoleBufferPos += strBytes;
+	consoleBytesRemaining -= strBytes;
+	
+	if (consoleBytesRemaining < 64) {
+		consoleBufferFlush();
+	}
+	
+	consoleBufferNumber(number, numberFormat);
+	
+	char newLine = '\n';
+	*consoleBufferPos = newLine;
+	consoleBufferPos++;
+	consoleBytesRemaining--;
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t diffTimeMS = getDiffTimeMilliseconds(consoleLastFlushTime, currentTime);
+	
+	if (diffTimeMS > CONSOLE_FLUSH_MS) {
+		consoleBufferFlush();
+	}
+}
+
+int consoleControl(uint64_t conInstruction, uint64_t conExtraValue) {
+	if (consoleState < CONSOLE_STATE_FULL) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	char newLine = '\n';
+	char escape = 0x1B;
+	char leftBraket = '['; //0x5B
+	
+	if (conInstruction == CON_NEW_LINE) {
+		*consoleBufferPos = newLine;
+		consoleBufferPos++;
+		consoleBytesRemaining--;
+	}
+	else if (conInstruction == CON_CURSOR_ADVANCE) {
+		consoleBufferPos[0] = escape;
+		consoleBufferPos[1] = leftBraket;
+		consoleBufferPos += 2;
+		uint64_t digits = shortToDecStr(consoleBufferPos, conExtraValue);
+		consoleBufferPos += digits;
+		*consoleBufferPos = 'C';
+		consoleBufferPos++;
+		digits += 3;
+		consoleBytesRemaining -= digits;
+	}
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t diffTimeMS = getDiffTimeMilliseconds(consoleLastFlushTime, currentTime);
+	
+	if ((consoleBytesRemaining < 256) || (diffTimeMS > CONSOLE_FLUSH_MS)) {
+		int error = consoleBufferFlush();
+		if (error != 0) {
+			return error;
+		}
+	}
+	
+	return 0;
+}
+
+//The terminal only hands over input after an enter (canonical mode) so any
+//readable input that contains a new line counts, other input gets consumed
+int consoleCheckForEnter(uint64_t* enterResult) {
+	if (consoleState < CONSOLE_STATE_MINIMUM) {
+		return ERROR_CONSOLE_WRONG_STATE;
+	}
+	
+	*enterResult = 0;
+	
+	struct pollfd inPoll;
+	inPoll.fd = consoleIn;
+	inPoll.events = POLLIN;
+	inPoll.revents = 0;
+	int pollRes = poll(&inPoll, 1, 0);
+	while (pollRes > 0) {
+		char inChars[32];
+		ssize_t bytesRead = read(consoleIn, inChars, 32);
+		if (bytesRead < 0) {
+			return ERROR_CONSOLE_PEAK_INPUT;
+		}
+		if (bytesRead == 0) { //Closed input is treated like an enter
+			*enterResult = 1;
+			return 0;
+		}
+		for (ssize_t c = 0; c < bytesRead; c++) {
+			if (inChars[c] == '\n') {
+				*enterResult = 1;
+			}
+		}
+		if (*enterResult == 1) {
+			return 0;
+		}
+		pollRes = poll(&inPoll, 1, 0);
+	}
+	if (pollRes < 0) {
+		return ERROR_CONSOLE_PEAK_INPUT;
+	}
+	
+	return 0;
+}
+
+void consoleCleanup() {
+	if (consoleState == CONSOLE_STATE_FULL) {
+		consoleBufferFlush();
+		
+		memoryDeallocate(&consoleBuffer);
+		consoleBuffer = NULL;
+		consoleBufferPos = NULL;
+		consoleByteSize = 0;
+		consoleBytesRemaining = 0;
+	}
+	
+	consoleState = CONSOLE_STATE_UNDEFINED;
+}
+
+
+int compatibilitySleep(uint64_t milliseconds) {
+	if (consoleState == CONSOLE_STATE_FULL) {
+		consoleBufferFlush();
+	}
+	
+	struct timespec sleepTime;
+	sleepTime.tv_sec = (time_t) (milliseconds / 1000);
+	sleepTime.tv_nsec = (long) ((milliseconds % 1000) * 1000000);
+	int res = nanosleep(&sleepTime, NULL);
+	if (res != 0) { //Interrupted early (signal) similar to the Windows alertable sleep
+		return SLEEP_RETURN_IO_COMPLETION;
+	}
+	return 0;
+}
+
+void compatibilitySleepFast(uint64_t milliseconds) {
+	struct timespec sleepTime;
+	sleepTime.tv_sec = (time_t) (milliseconds / 1000);
+	sleepTime.tv_nsec = (long) ((milliseconds % 1000) * 1000000);
+	nanosleep(&sleepTime, NULL);
+}
+
+
+// I/O State Codes:
+#define IO_STATE_UNDEFINED 0
+#define IO_STATE_SETUP 1
+static uint64_t ioState = IO_STATE_UNDEFINED;
+
+static int ioCommandArgumentPosition = 0;
+
+//File pointers are the file descriptors offset by one so that NULL stays invalid
+#define IO_FILE_DESCRIPTOR(filePtr) ((int) (((intptr_t) (filePtr)) - 1))
+#define IO_FILE_POINTER(fileDescriptor) ((void*) (((intptr_t) (fileDescriptor)) + 1))
+
+//O_DIRECT only accepts block aligned memory, sizes, and offsets so direct files
+//keep a second normal descriptor for the unaligned writes (headers, file tails)
+//Entries get claimed and released atomically since helper threads open and close files too
+//([0] is the normal descriptor, -1 when the entry is free)
+#define IO_DIRECT_FILE_MAX 8
+#define IO_DIRECT_ALIGNMENT 4096
+static int ioDirectFileDescriptors[IO_DIRECT_FILE_MAX][2] = {{-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}};
+
+int ioSetup() {
+	ioCommandArgumentPosition = 0;
+	
+	ioState = IO_STATE_SETUP;
+	return 0;
+}
+
+//The arguments are already split by the C runtime (first one is the program)
+int ioGetNextCommandArgument(char** argumentUTF8, uint64_t* argumentByteLength) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	
+	if (ioCommandArgumentPosition >= ioArgumentCount) {
+		*argumentUTF8 = NULL;
+		*argumentByteLength = 0;
+		return ERROR_ARGUMENT_DNE;
+	}
+	
+	char* argument = ioArgumentValues[ioCommandArgumentPosition];
+	uint64_t byteLength = 0;
+	while (argument[byteLength] != 0) {
+		byteLength++;
+	}
+	*argumentUTF8 = argument;
+	*argumentByteLength = byteLength;
+	ioCommandArgumentPosition++;
+	
+	return 0;
+}
+
+int ioGetCommandArgument(uint64_t argumentNumber, char** argumentUTF8, uint64_t* argumentByteLength) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	
+	if (argumentNumber >= ((uint64_t) ioArgumentCount)) {
+		*argumentUTF8 = NULL;
+		*argumentByteLength = 0;
+		return ERROR_ARGUMENT_DNE;
+	}
+	
+	char* argument = ioArgumentValues[argumentNumber];
+	uint64_t byteLength = 0;
+	while (argument[byteLength] != 0) {
+		byteLength++;
+	}
+	*argumentUTF8 = argument;
+	*argumentByteLength = byteLength;
+	
+	return 0;
+}
+
+//Copies the (possibly not NULL terminated) UTF-8 path into the caller's stack buffer
+//so that helper threads (the segment rollover) can open and delete files too
+#define IO_PATH_BYTES_MAX 1024
+static int ioTerminatedPath(char* filePathUTF8, int filePathBytes, char* pathStr) {
+	uint64_t pathBytes = 0;
+	if (filePathBytes < 0) {
+		while (filePathUTF8[pathBytes] != 0) {
+			pathBytes++;
+		}
+	}
+	else {
+		pathBytes = (uint64_t) filePathBytes;
+	}
+	if (pathBytes >= IO_PATH_BYTES_MAX) {
+		return ERROR_IO_TEMP_BUFF_NOT_ENOUGH_MEMORY;
+	}
+	
+	memcpyBasic(pathStr, filePathUTF8, pathBytes);
+	pathStr[pathBytes] = 0;
+	return 0;
+}
+
+int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t flags) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	
+	char filePath[IO_PATH_BYTES_MAX];
+	int error = ioTerminatedPath(filePathUTF8, filePathBytes, filePath);
+	if (error != 0) {
+		return error;
+	}
+	
+	int fileDescriptor = -1;
+	if ((flags == IO_FILE_READ_NORMAL) || (flags == IO_FILE_READ_ASYNC)) {
+		fileDescriptor = open(filePath, O_RDONLY | O_CLOEXEC);
+	}
+	else if ((flags == IO_FILE_WRITE_NORMAL) || (flags == IO_FILE_WRITE_ASYNC) || (flags == IO_FILE_WRITE_ASYNC_DIRECT)) {
+		fileDescriptor = open(filePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	}
+	else if (flags == IO_FILE_UPDATE_NORMAL) {
+		fileDescriptor = open(filePath, O_RDWR | O_CLOEXEC);
+	}
+	else {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	if (fileDescriptor < 0) {
+		return ERROR_IO_CANNOT_OPEN_FILE;
+	}
+	
+	if (flags == IO_FILE_WRITE_ASYNC_DIRECT) {
+		int directFileDescriptor = open(filePath, O_WRONLY | O_DIRECT | O_CLOEXEC);
+		if (directFileDescriptor >= 0) { //Not every file system supports it (tmpfs)
+			uint64_t d = 0;
+			for (; d < IO_DIRECT_FILE_MAX; d++) {
+				int freeEntry = -1;
+				if (__atomic_compare_exchange_n(&(ioDirectFileDescriptors[d][0]), &freeEntry, fileDescriptor, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+					__atomic_store_n(&(ioDirectFileDescriptors[d][1]), directFileDescriptor, __ATOMIC_RELEASE);
+					break;
+				}
+			}
+			if (d >= IO_DIRECT_FILE_MAX) { //Writes just keep going through the cache
+				close(directFileDescriptor);
+			}
+		}
+	}
+	
+	*filePtr = IO_FILE_POINTER(fileDescriptor);
+	return 0;
+}
+
+int ioCloseFile(void** filePtr) {
+	int fileDescriptor = IO_FILE_DESCRIPTOR(*filePtr);
+	for (uint64_t d = 0; d < IO_DIRECT_FILE_MAX; d++) {
+		if (__atomic_load_n(&(ioDirectFileDescriptors[d][0]), __ATOMIC_ACQUIRE) == fileDescriptor) {
+			close(ioDirectFileDescriptors[d][1]);
+			ioDirectFileDescriptors[d][1] = -1;
+			__atomic_store_n(&(ioDirectFileDescriptors[d][0]), -1, __ATOMIC_RELEASE); //Released before the descriptor number can get reused
+		}
+	}
+	int result = close(fileDescriptor);
+	if (result != 0) {
+		return ERROR_IO_CANNOT_CLOSE_FILE;
+	}
+	*filePtr = NULL;
+	return 0;
+}
+
+int ioGetFileSize(void* filePtr, uint64_t* fileSizeBytes) {
+	struct stat fileStats;
+	int result = fstat(IO_FILE_DESCRIPTOR(filePtr), &fileStats);
+	if (result != 0) {
+		return ERROR_IO_CANNOT_GET_FILE_SIZE;
+	}
+	*fileSizeBytes = (uint64_t) fileStats.st_size;
+	return 0;
+}
+
+//Keeps reading until the request is filled or the end of the file is reached (like ReadFile)
+int ioReadFile(void* filePtr, void* dataPtr, uint32_t* numBytes) {
+	int fileDescriptor = IO_FILE_DESCRIPTOR(filePtr);
+	uint8_t* readPtr = (uint8_t*) dataPtr;
+	uint32_t readBytes = 0;
+	while (readBytes < *numBytes) {
+		ssize_t result = read(fileDescriptor, readPtr + readBytes, (size_t) (*numBytes - readBytes));
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			*numBytes = 0;
+			return ERROR_IO_CANNOT_READ_FILE;
+		}
+		if (result == 0) {
+			break;
+		}
+		readBytes += (uint32_t) result;
+	}
+	*numBytes = readBytes;
+	return 0;
+}
+
+int ioReadFileOffset(void* filePtr, void* dataPtr, uint32_t* numBytes, uint64_t offset) {
+	int fileDescriptor = IO_FILE_DESCRIPTOR(filePtr);
+	uint8_t* readPtr = (uint8_t*) dataPtr;
+	uint32_t readBytes = 0;
+	while (readBytes < *numBytes) {
+		ssize_t result = pread(fileDescriptor, readPtr + readBytes, (size_t) (*numBytes - readBytes), (off_t) (offset + readBytes));
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			*numBytes = 0;
+			return ERROR_IO_CANNOT_READ_FILE;
+		}
+		if (result == 0) {
+			break;
+		}
+		readBytes += (uint32_t) result;
+	}
+	*numBytes = readBytes;
+	return 0;
+}
+
+//Shared read only mapping so the pages come straight from the OS file cache
+int ioMapFile(void* filePtr, uint64_t offset, uint64_t numBytes, void** mapPtr) {
+	if (((offset % IO_MAP_ALIGNMENT) != 0) || (numBytes == 0)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	void* viewPtr = mmap(NULL, (size_t) numBytes, PROT_READ, MAP_SHARED, IO_FILE_DESCRIPTOR(filePtr), (off_t) offset);
+	if (viewPtr == MAP_FAILED) {
+		return ERROR_IO_CANNOT_MAP_FILE;
+	}
+	madvise(viewPtr, (size_t) numBytes, MADV_SEQUENTIAL); //Only a hint for the read ahead
+	*mapPtr = viewPtr;
+	return 0;
+}
+
+int ioUnmapFile(void** mapPtr, uint64_t numBytes) {
+	int result = munmap(*mapPtr, (size_t) numBytes);
+	if (result != 0) {
+		return ERROR_IO_CANNOT_UNMAP_FILE;
+	}
+	*mapPtr = NULL;
+	return 0;
+}
+
+int ioSetFileSize(void* filePtr, uint64_t fileSizeBytes) {
+	int fileDescriptor = IO_FILE_DESCRIPTOR(filePtr);
+	if (ftruncate(fileDescriptor, (off_t) fileSizeBytes) != 0) {
+		return ERROR_IO_CANNOT_SET_FILE_SIZE;
+	}
+	if (lseek(fileDescriptor, (off_t) fileSizeBytes, SEEK_SET) < 0) {
+		return ERROR_IO_CANNOT_SET_FILE_SIZE;
+	}
+	return 0;
+}
+
+//Keep size so the file still ends at the last write (file systems without fallocate return an error)
+int ioAllocateFileSpace(void* filePtr, uint64_t numBytes) {
+	if (numBytes == 0) {
+		return 0;
+	}
+	if (fallocate(IO_FILE_DESCRIPTOR(filePtr), FALLOC_FL_KEEP_SIZE, 0, (off_t) numBytes) != 0) {
+		return ERROR_IO_CANNOT_ALLOCATE_FILE_SPACE;
+	}
+	return 0;
+}
+
+int ioGetFreeSpace(void* filePtr, uint64_t* freeBytes) {
+	struct statvfs fileSystemStats;
+	if (fstatvfs(IO_FILE_DESCRIPTOR(filePtr), &fileSystemStats) != 0) {
+		return ERROR_IO_CANNOT_GET_FREE_SPACE;
+	}
+	*freeBytes = ((uint64_t) fileSystemStats.f_bavail) * fileSystemStats.f_frsize;
+	return 0;
+}
+
+int ioDeleteFile(char* filePathUTF8, int filePathBytes) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	char filePath[IO_PATH_BYTES_MAX];
+	int error = ioTerminatedPath(filePathUTF8, filePathBytes, filePath);
+	if (error != 0) {
+		return error;
+	}
+	if (unlink(filePath) != 0) {
+		return ERROR_IO_CANNOT_DELETE_FILE;
+	}
+	return 0;
+}
+
+//The kernel copies the bytes (copy_file_range shares extents on file systems that can)
+//Copies between file systems on older kernels fall back to sendfile
+#define IO_COPY_CHUNK_BYTES 1073741824
+int ioCopyFileRange(void* outputFilePtr, void* inputFilePtr, uint64_t offset, uint64_t numBytes) {
+	int inputDescriptor = IO_FILE_DESCRIPTOR(inputFilePtr);
+	int outputDescriptor = IO_FILE_DESCRIPTOR(outputFilePtr);
+	off_t readOffset = (off_t) offset;
+	uint64_t copiedBytes = 0;
+	uint64_t useSendFile = 0;
+	while (copiedBytes < numBytes) {
+		size_t chunkBytes = IO_COPY_CHUNK_BYTES;
+		if ((numBytes - copiedBytes) < IO_COPY_CHUNK_BYTES) {
+			chunkBytes = (size_t) (numBytes - copiedBytes);
+		}
+		ssize_t result = 0;
+		if (useSendFile == 0) {
+			result = copy_file_range(inputDescriptor, &readOffset, outputDescriptor, NULL, chunkBytes, 0);
+			if ((result < 0) && ((errno == EXDEV) || (errno == ENOSYS) || (errno == EINVAL) || (errno == EOPNOTSUPP))) {
+				useSendFile = 1;
+				continue;
+			}
+		}
+		else {
+			result = sendfile(outputDescriptor, inputDescriptor, &readOffset, chunkBytes);
+		}
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return ERROR_IO_CANNOT_COPY_FILE;
+		}
+		if (result == 0) {
+			return ERROR_IO_WRONG_READ_SIZE;
+		}
+		copiedBytes += (uint64_t) result;
+	}
+	return 0;
+}
+
+int ioWriteFile(void* filePtr, void* dataPtr, uint32_t numBytes) {
+	int fileDescriptor = IO_FILE_DESCRIPTOR(filePtr);
+	uint8_t* writePtr = (uint8_t*) dataPtr;
+	uint32_t writtenBytes = 0;
+	while (writtenBytes < numBytes) {
+		ssize_t result = write(fileDescriptor, writePtr + writtenBytes, (size_t) (numBytes - writtenBytes));
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return ERROR_IO_CANNOT_WRITE_FILE;
+		}
+		if (result == 0) {
+			return ERROR_IO_WRONG_WRITE_SIZE;
+		}
+		writtenBytes += (uint32_t) result;
+	}
+	return 0;
+}
+
+//Asynchronous writes are queued on an io_uring (through the raw system calls so
+//liburing is not needed) and every queued write gets submitted together with a
+//single system call during the next check / wait on any asynchronous operation
+//Each asynchronous operation number tracks one queued write like the Windows
+//OVERLAPPED slots and a successful check / wait consumes its completion
+//When io_uring is not available (older kernels / restricted containers) the
+//writes complete before returning instead
+#define ASYNC_OPERATION_MAX 256
+#define ASYNC_BUFFER_MAX 16
+#define ASYNC_STATE_IDLE 0
+#define ASYNC_STATE_QUEUED 1
+#define ASYNC_STATE_COMPLETE 2
+static uint64_t ioAsyncOperationCount = 0;
+static uint8_t ioAsyncStates[ASYNC_OPERATION_MAX];
+static int64_t ioAsyncResults[ASYNC_OPERATION_MAX];
+static uint64_t ioAsyncExpectedBytes[ASYNC_OPERATION_MAX];
+static struct iovec ioAsyncVectors[ASYNC_OPERATION_MAX][IO_ASYNC_VECTOR_MAX]; //Stay valid until submitted
+static struct iovec ioAsyncBuffers[ASYNC_BUFFER_MAX];
+static uint64_t ioAsyncBufferCount = 0;
+static uint64_t ioAsyncSystemCalls = 0;
+
+static int ioRingFD = -1;
+static uint32_t ioRingEntries = 0;
+static void* ioRingSQPtr = NULL;
+static uint64_t ioRingSQBytes = 0;
+static void* ioRingCQPtr = NULL;
+static uint64_t ioRingCQBytes = 0;
+static struct io_uring_sqe* ioRingSQEs = NULL;
+static uint64_t ioRingSQEBytes = 0;
+static uint32_t* ioRingSQHead = NULL;
+static uint32_t* ioRingSQTail = NULL;
+static uint32_t* ioRingSQArray = NULL;
+static uint32_t ioRingSQMask = 0;
+static uint32_t* ioRingCQHead = NULL;
+static uint32_t* ioRingCQTail = NULL;
+static uint32_t ioRingCQMask = 0;
+static struct io_uring_cqe* ioRingCQEs = NULL;
+static uint32_t ioRingSQLocalTail = 0; //Written entries not yet made visible to the kernel
+static uint32_t ioRingToSubmit = 0;
+static int ioRingEventFD = -1; //Signaled by the kernel on every completion (for the Wait Sets)
+
+static int ioRingSetup(uint32_t entries) {
+	struct io_uring_params ringParams;
+	memzeroBasic(&ringParams, sizeof(struct io_uring_params));
+	int ringFD = (int) syscall(__NR_io_uring_setup, entries, &ringParams);
+	if (ringFD < 0) {
+		return ERROR_TBD;
+	}
+	
+	ioRingSQBytes = ringParams.sq_off.array + (ringParams.sq_entries * sizeof(uint32_t));
+	ioRingCQBytes = ringParams.cq_off.cqes + (ringParams.cq_entries * sizeof(struct io_uring_cqe));
+	if ((ringParams.features & IORING_FEAT_SINGLE_MMAP) > 0) {
+		if (ioRingCQBytes > ioRingSQBytes) {
+			ioRingSQBytes = ioRingCQBytes;
+		}
+	}
+	ioRingSQPtr = mmap(NULL, ioRingSQBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQ_RING);
+	if (ioRingSQPtr == MAP_FAILED) {
+		close(ringFD);
+		return ERROR_TBD;
+	}
+	if ((ringParams.features & IORING_FEAT_SINGLE_MMAP) > 0) {
+		ioRingCQPtr = ioRingSQPtr;
+		ioRingCQBytes = 0;
+	}
+	else {
+		ioRingCQPtr = mmap(NULL, ioRingCQBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_CQ_RING);
+		if (ioRingCQPtr == MAP_FAILED) {
+			munmap(ioRingSQPtr, ioRingSQBytes);
+			close(ringFD);
+			return ERROR_TBD;
+		}
+	}
+	ioRingSQEBytes = ringParams.sq_entries * sizeof(struct io_uring_sqe);
+	ioRingSQEs = (struct io_uring_sqe*) mmap(NULL, ioRingSQEBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQES);
+	if (ioRingSQEs == MAP_FAILED) {
+		if (ioRingCQBytes > 0) {
+			munmap(ioRingCQPtr, ioRingCQBytes);
+		}
+		munmap(ioRingSQPtr, ioRingSQBytes);
+		close(ringFD);
+		return ERROR_TBD;
+	}
+	
+	uint8_t* sqPtr = (uint8_t*) ioRingSQPtr;
+	ioRingSQHead = (uint32_t*) (sqPtr + ringParams.sq_off.head);
+	ioRingSQTail = (uint32_t*) (sqPtr + ringParams.sq_off.tail);
+	ioRingSQArray = (uint32_t*) (sqPtr + ringParams.sq_off.array);
+	ioRingSQMask = *((uint32_t*) (sqPtr + ringParams.sq_off.ring_mask));
+	uint8_t* cqPtr = (uint8_t*) ioRingCQPtr;
+	ioRingCQHead = (uint32_t*) (cqPtr + ringParams.cq_off.head);
+	ioRingCQTail = (uint32_t*) (cqPtr + ringParams.cq_off.tail);
+	ioRingCQMask = *((uint32_t*) (cqPtr + ringParams.cq_off.ring_mask));
+	ioRingCQEs = (struct io_uring_cqe*) (cqPtr + ringParams.cq_off.cqes);
+	
+	ioRingEntries = ringParams.sq_entries;
+	ioRingSQLocalTail = *ioRingSQTail;
+	ioRingToSubmit = 0;
+	ioRingFD = ringFD;
+	
+	ioRingEventFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (ioRingEventFD >= 0) {
+		int result = (int) syscall(__NR_io_uring_register, ioRingFD, IORING_REGISTER_EVENTFD, &ioRingEventFD, 1);
+		if (result < 0) { //Wait Sets fall back to short timeouts
+			close(ioRingEventFD);
+			ioRingEventFD = -1;
+		}
+	}
+	return 0;
+}
+
+//Moves every finished write from the completion queue to its operation
+static void ioRingReap() {
+	uint32_t head = *ioRingCQHead;
+	uint32_t tail = __atomic_load_n(ioRingCQTail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		struct io_uring_cqe* cqe = &(ioRingCQEs[head & ioRingCQMask]);
+		uint64_t asyncOperation = (uint64_t) cqe->user_data;
+		if (asyncOperation < ASYNC_OPERATION_MAX) {
+			ioAsyncResults[asyncOperation] = (int64_t) cqe->res;
+			ioAsyncStates[asyncOperation] = ASYNC_STATE_COMPLETE;
+		}
+		head++;
+	}
+	__atomic_store_n(ioRingCQHead, head, __ATOMIC_RELEASE);
+}
+
+//Hands all of the queued writes to the kernel in one go and optionally waits
+static int ioRingEnter(uint32_t minComplete) {
+	uint32_t enterFlags = 0;
+	if (minComplete > 0) {
+		enterFlags = IORING_ENTER_GETEVENTS;
+	}
+	while ((ioRingToSubmit > 0) || (minComplete > 0)) {
+		int result = (int) syscall(__NR_io_uring_enter, ioRingFD, ioRingToSubmit, minComplete, enterFlags, NULL, 0);
+		ioAsyncSystemCalls++;
+		if (result < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY)) {
+				ioRingReap();
+				if (minComplete > 0) {
+					continue;
+				}
+				return 0; //Try again during the next check
+			}
+			return ERROR_IO_CANNOT_WRITE_FILE;
+		}
+		ioRingToSubmit -= (uint32_t) result;
+		if (ioRingToSubmit == 0) {
+			break;
+		}
+	}
+	ioRingReap();
+	return 0;
+}
+
+static int ioRingGetSQE(struct io_uring_sqe** sqePtr) {
+	uint32_t head = __atomic_load_n(ioRingSQHead, __ATOMIC_ACQUIRE);
+	if ((ioRingSQLocalTail - head) >= ioRingEntries) { //Full so submit what is queued first
+		int error = ioRingEnter(0);
+		if (error != 0) {
+			return error;
+		}
+		head = __atomic_load_n(ioRingSQHead, __ATOMIC_ACQUIRE);
+		if ((ioRingSQLocalTail - head) >= ioRingEntries) {
+			return ERROR_TBD;
+		}
+	}
+	uint32_t index = ioRingSQLocalTail & ioRingSQMask;
+	struct io_uring_sqe* sqe = &(ioRingSQEs[index]);
+	memzeroBasic(sqe, sizeof(struct io_uring_sqe));
+	ioRingSQArray[index] = index;
+	*sqePtr = sqe;
+	return 0;
+}
+
+static void ioRingQueueSQE() {
+	ioRingSQLocalTail++;
+	ioRingToSubmit++;
+	__atomic_store_n(ioRingSQTail, ioRingSQLocalTail, __ATOMIC_RELEASE);
+}
+
+static void ioRingCleanup() {
+	munmap(ioRingSQEs, ioRingSQEBytes);
+	if (ioRingCQBytes > 0) {
+		munmap(ioRingCQPtr, ioRingCQBytes);
+	}
+	munmap(ioRingSQPtr, ioRingSQBytes);
+	close(ioRingFD);
+	ioRingFD = -1;
+	if (ioRingEventFD >= 0) {
+		close(ioRingEventFD);
+		ioRingEventFD = -1;
+	}
+	ioRingSQEs = NULL;
+	ioRingSQPtr = NULL;
+	ioRingCQPtr = NULL;
+}
+
+int ioAsyncSetup(uint64_t asyncOperationCount) {
+	if (asyncOperationCount > ASYNC_OPERATION_MAX) {
+		return ERROR_TBD;
+	}
+	for (uint64_t i = 0; i < ASYNC_OPERATION_MAX; i++) {
+		ioAsyncStates[i] = ASYNC_STATE_IDLE;
+		ioAsyncResults[i] = 0;
+		ioAsyncExpectedBytes[i] = 0;
+	}
+	ioAsyncOperationCount = asyncOperationCount;
+	ioAsyncBufferCount = 0;
+	
+	uint32_t entries = 8;
+	while (entries < asyncOperationCount) {
+		entries <<= 1;
+	}
+	if (ioRingFD >= 0) {
+		ioRingCleanup();
+	}
+	ioRingSetup(entries); //Falls back to completing writes immediately on failure
+	
+	return 0;
+}
+
+//The fixed (registered) buffers save the kernel from mapping the pages on every write
+//Everything registered gets re-registered as a set so call during setup only
+int ioAsyncRegisterBuffer(void* dataPtr, uint64_t numBytes) {
+	if (ioAsyncBufferCount >= ASYNC_BUFFER_MAX) {
+		return ERROR_TBD;
+	}
+	ioAsyncBuffers[ioAsyncBufferCount].iov_base = dataPtr;
+	ioAsyncBuffers[ioAsyncBufferCount].iov_len = (size_t) numBytes;
+	ioAsyncBufferCount++;
+	
+	if (ioRingFD < 0) {
+		return 0;
+	}
+	if (ioAsyncBufferCount > 1) {
+		syscall(__NR_io_uring_register, ioRingFD, IORING_UNREGISTER_BUFFERS, NULL, 0);
+	}
+	int result = (int) syscall(__NR_io_uring_register, ioRingFD, IORING_REGISTER_BUFFERS, ioAsyncBuffers, (unsigned int) ioAsyncBufferCount);
+	if (result < 0) { //Usually the locked memory limit (ulimit -l), writes still work unregistered
+		ioAsyncBufferCount = 0;
+	}
+	return 0;
+}
+
+static uint64_t ioAsyncFindBuffer(void* dataPtr, uint64_t numBytes) {
+	uint8_t* dataStart = (uint8_t*) dataPtr;
+	for (uint64_t b = 0; b < ioAsyncBufferCount; b++) {
+		uint8_t* bufferStart = (uint8_t*) ioAsyncBuffers[b].iov_base;
+		uint8_t* bufferEnd = bufferStart + ioAsyncBuffers[b].iov_len;
+		if ((dataStart >= bufferStart) && ((dataStart + numBytes) <= bufferEnd)) {
+			return b;
+		}
+	}
+	return ASYNC_BUFFER_MAX;
+}
+
+static int ioAsyncConsume(uint64_t asyncOperation, uint64_t* signaled) {
+	if (ioAsyncStates[asyncOperation] != ASYNC_STATE_COMPLETE) {
+		*signaled = 0;
+		return 0;
+	}
+	*signaled = 1;
+	ioAsyncStates[asyncOperation] = ASYNC_STATE_IDLE;
+	if (ioAsyncResults[asyncOperation] < 0) {
+		return (ioAsyncExpectedBytes[asyncOperation] == 0) ? ERROR_IO_CANNOT_SYNC_FILE : ERROR_IO_CANNOT_WRITE_FILE; //Only flushes expect no bytes
+	}
+	if (((uint64_t) ioAsyncResults[asyncOperation]) != ioAsyncExpectedBytes[asyncOperation]) {
+		return ERROR_IO_WRONG_WRITE_SIZE;
+	}
+	return 0;
+}
+
+int ioAsyncSignalWait(uint64_t asyncOperation) {
+	if (ioAsyncStates[asyncOperation] == ASYNC_STATE_IDLE) {
+		return ERROR_TBD; //Nothing to wait on would block forever
+	}
+	if (ioRingFD >= 0) {
+		int error = ioRingEnter(0);
+		if (error != 0) {
+			return error;
+		}
+		while (ioAsyncStates[asyncOperation] != ASYNC_STATE_COMPLETE) {
+			error = ioRingEnter(1);
+			if (error != 0) {
+				return error;
+			}
+		}
+	}
+	uint64_t signaled = 0;
+	return ioAsyncConsume(asyncOperation, &signaled);
+}
+
+int ioAsyncSignalCheck(uint64_t asyncOperation, uint64_t* signaled) {
+	if ((ioRingFD >= 0) && (ioAsyncStates[asyncOperation] == ASYNC_STATE_QUEUED)) {
+		int error = ioRingEnter(0);
+		if (error != 0) {
+			return error;
+		}
+	}
+	return ioAsyncConsume(asyncOperation, signaled);
+}
+
+//Block aligned writes go to the direct (page cache bypassing) descriptor when the file has one
+static int ioAsyncFileDescriptor(void* filePtr, struct iovec* vectors, uint64_t vectorCount, uint64_t offset) {
+	int fileDescriptor = IO_FILE_DESCRIPTOR(filePtr);
+	uint64_t alignCheck = offset;
+	for (uint64_t v = 0; v < vectorCount; v++) {
+		alignCheck |= (uint64_t) ((uintptr_t) vectors[v].iov_base);
+		alignCheck |= (uint64_t) vectors[v].iov_len;
+	}
+	if ((alignCheck & (IO_DIRECT_ALIGNMENT - 1)) != 0) {
+		return fileDescriptor;
+	}
+	for (uint64_t d = 0; d < IO_DIRECT_FILE_MAX; d++) {
+		if (__atomic_load_n(&(ioDirectFileDescriptors[d][0]), __ATOMIC_ACQUIRE) == fileDescriptor) {
+			int directFileDescriptor = __atomic_load_n(&(ioDirectFileDescriptors[d][1]), __ATOMIC_ACQUIRE);
+			return (directFileDescriptor >= 0) ? directFileDescriptor : fileDescriptor;
+		}
+	}
+	return fileDescriptor;
+}
+
+static int ioAsyncQueueWrite(void* filePtr, struct iovec* vectors, uint64_t vectorCount, uint64_t numBytes, uint64_t asyncOperation, uint64_t offset) {
+	if ((asyncOperation >= ioAsyncOperationCount) || (ioAsyncStates[asyncOperation] != ASYNC_STATE_IDLE)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	int fileDescriptor = ioAsyncFileDescriptor(filePtr, vectors, vectorCount, offset);
+	ioAsyncExpectedBytes[asyncOperation] = numBytes;
+	
+	if (ioRingFD < 0) {
+		uint64_t writtenBytes = 0;
+		int64_t result = 0;
+		while (writtenBytes < numBytes) {
+			result = (int64_t) pwritev(fileDescriptor, vectors, (int) vectorCount, (off_t) (offset + writtenBytes));
+			ioAsyncSystemCalls++;
+			if (result < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				break;
+			}
+			if (result == 0) {
+				break;
+			}
+			writtenBytes += (uint64_t) result;
+			while ((vectorCount > 0) && (((uint64_t) result) >= vectors[0].iov_len)) { //Skip what was written
+				result -= (int64_t) vectors[0].iov_len;
+				vectors++;
+				vectorCount--;
+			}
+			if (vectorCount > 0) {
+				vectors[0].iov_base = ((uint8_t*) vectors[0].iov_base) + result;
+				vectors[0].iov_len -= (size_t) result;
+			}
+		}
+		if (result >= 0) {
+			result = (int64_t) writtenBytes;
+		}
+		ioAsyncResults[asyncOperation] = result;
+		ioAsyncStates[asyncOperation] = ASYNC_STATE_COMPLETE;
+		return 0;
+	}
+	
+	struct io_uring_sqe* sqe = NULL;
+	int error = ioRingGetSQE(&sqe);
+	if (error != 0) {
+		return error;
+	}
+	sqe->fd = fileDescriptor;
+	sqe->off = offset;
+	sqe->user_data = asyncOperation;
+	if (vectorCount == 1) {
+		sqe->addr = (uint64_t) ((uintptr_t) vectors[0].iov_base);
+		sqe->len = (uint32_t) vectors[0].iov_len;
+		uint64_t bufferIndex = ioAsyncFindBuffer(vectors[0].iov_base, vectors[0].iov_len);
+		if (bufferIndex < ASYNC_BUFFER_MAX) {
+			sqe->opcode = IORING_OP_WRITE_FIXED;
+			sqe->buf_index = (uint16_t) bufferIndex;
+		}
+		else {
+			sqe->opcode = IORING_OP_WRITE;
+		}
+	}
+	else {
+		sqe->opcode = IORING_OP_WRITEV;
+		sqe->addr = (uint64_t) ((uintptr_t) vectors);
+		sqe->len = (uint32_t) vectorCount;
+	}
+	ioAsyncStates[asyncOperation] = ASYNC_STATE_QUEUED;
+	ioRingQueueSQE();
+	return 0;
+}
+
+int ioAsyncWriteFile(void* filePtr, void* dataPtr, uint64_t numBytes, uint64_t asyncOperation, uint64_t offset) {
+	if (asyncOperation >= ioAsyncOperationCount) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	struct iovec* vectors = ioAsyncVectors[asyncOperation];
+	vectors[0].iov_base = dataPtr;
+	vectors[0].iov_len = (size_t) numBytes;
+	return ioAsyncQueueWrite(filePtr, vectors, 1, numBytes, asyncOperation, offset);
+}
+
+//Header and payload (or any other pieces) go out as one write
+int ioAsyncWriteFileV(void* filePtr, ioWriteVec* writeVectors, uint64_t vectorCount, uint64_t asyncOperation, uint64_t offset) {
+	if ((asyncOperation >= ioAsyncOperationCount) || (vectorCount == 0) || (vectorCount > IO_ASYNC_VECTOR_MAX)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	struct iovec* vectors = ioAsyncVectors[asyncOperation];
+	uint64_t numBytes = 0;
+	for (uint64_t v = 0; v < vectorCount; v++) {
+		vectors[v].iov_base = writeVectors[v].dataPtr;
+		vectors[v].iov_len = (size_t) writeVectors[v].numBytes;
+		numBytes += writeVectors[v].numBytes;
+	}
+	return ioAsyncQueueWrite(filePtr, vectors, vectorCount, numBytes, asyncOperation, offset);
+}
+
+//Queued behind the writes on the same ring but io_uring does not order them, so only
+//writes that already completed are guaranteed to be covered by the flush
+int ioAsyncSyncFile(void* filePtr, uint64_t asyncOperation) {
+	if ((asyncOperation >= ioAsyncOperationCount) || (ioAsyncStates[asyncOperation] != ASYNC_STATE_IDLE)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	int fileDescriptor = IO_FILE_DESCRIPTOR(filePtr);
+	ioAsyncExpectedBytes[asyncOperation] = 0;
+	
+	if (ioRingFD < 0) {
+		int result = fdatasync(fileDescriptor);
+		ioAsyncSystemCalls++;
+		ioAsyncResults[asyncOperation] = (result == 0) ? 0 : -1;
+		ioAsyncStates[asyncOperation] = ASYNC_STATE_COMPLETE;
+		return 0;
+	}
+	
+	struct io_uring_sqe* sqe = NULL;
+	int error = ioRingGetSQE(&sqe);
+	if (error != 0) {
+		return ERROR_IO_CANNOT_SYNC_FILE;
+	}
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fileDescriptor;
+	sqe->fsync_flags = IORING_FSYNC_DATASYNC; //File size changes still get flushed (needed to read the data back)
+	sqe->user_data = asyncOperation;
+	ioAsyncStates[asyncOperation] = ASYNC_STATE_QUEUED;
+	ioRingQueueSQE();
+	return 0;
+}
+
+uint64_t ioAsyncGetSystemCallCount() {
+	return ioAsyncSystemCalls;
+}
+
+void ioAsyncCleanup() {
+	if (ioRingFD >= 0) {
+		ioRingEnter(0);
+		for (uint64_t i = 0; i < ioAsyncOperationCount; i++) {
+			while (ioAsyncStates[i] == ASYNC_STATE_QUEUED) {
+				if (ioRingEnter(1) != 0) {
+					break;
+				}
+			}
+			ioAsyncStates[i] = ASYNC_STATE_IDLE;
+		}
+		ioRingCleanup();
+	}
+	ioAsyncOperationCount = 0;
+	ioAsyncBufferCount = 0;
+}
+
+//No file dialog for the console only Linux tools so the given path gets opened
+int ioSelectAndOpenFile(void** filePtr, uint64_t flags, char* filePathUTF8) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	
+	return ioOpenFile(filePtr, filePathUTF8, -1, flags);
+}
+
+int ioLoadLibrary(void** libraryPtr, char* libraryNameUTF8) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	
+	void* library = dlopen(libraryNameUTF8, RTLD_NOW | RTLD_LOCAL);
+	if (library == NULL) {
+		return ERROR_IO_CANNOT_LOAD_LIBRARY;
+	}
+	
+	*libraryPtr = library;
+	return 0;
+}
+
+int ioGetLibraryFunction(void* libraryPtr, char* functionNameUTF8, void** functionPtr) {
+	void* funcPtr = dlsym(libraryPtr, functionNameUTF8);
+	if (funcPtr == NULL) {
+		return ERROR_IO_CANNOT_FIND_LIBRARY_FUNCTION;
+	}
+	
+	*functionPtr = funcPtr;
+	return 0;
+}
+
+void ioCleanup() {
+	if (ioState == IO_STATE_SETUP) {
+		ioCommandArgumentPosition = 0;
+	}
+	
+	ioState = IO_STATE_UNDEFINED;
+}
+
+
+// Compatibility Setup and Cleanup Helper Functions:
+int compatibilitySetup() {
+	int error = timeFunctionSetup();
+	if (error != 0) {
+		return error;
+	}
+	
+	consoleSetupMinimum();
+	
+	error = consoleSetupFull();
+	if (error != 0) {
+		return error;
+	}
+	
+	error = ioSetup();
+	if (error != 0) {
+		return error;
+	}
+	
+	return 0;
+}
+
+void compatibilityCleanup() {
+	ioCleanup();
+	consoleCleanup();
+}
+
+
+//Create Event and Threads:
+//Events are eventfd counters, a read consumes (resets) the signal
+//Manual reset events are only consumed by syncResetEvent
+typedef struct syncEventLinux {
+	int fileDescriptor;
+	uint64_t manualReset;
+} syncEventLinux;
+
+int syncCreateEvent(void** eventPtr, uint64_t manualReset, uint64_t initialState) {
+	syncEventLinux* event = (syncEventLinux*) malloc(sizeof(syncEventLinux));
+	if (event == NULL) {
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	
+	unsigned int initValue = 0;
+	if (initialState > 0) {
+		initValue = 1;
+	}
+	event->fileDescriptor = eventfd(initValue, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (event->fileDescriptor < 0) {
+		free(event);
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	event->manualReset = manualReset;
+	
+	*eventPtr = (void*) event;
+	return 0;
+}
+
+int syncSetEvent(void* eventPtr) {
+	syncEventLinux* event = (syncEventLinux*) eventPtr;
+	uint64_t eventValue = 1;
+	ssize_t res = write(event->fileDescriptor, &eventValue, sizeof(uint64_t));
+	if (res != sizeof(uint64_t)) {
+		return ERROR_EVENT_NOT_SET;
+	}
+	return 0;
+}
+
+int syncResetEvent(void* eventPtr) {
+	syncEventLinux* event = (syncEventLinux*) eventPtr;
+	uint64_t eventValue = 0;
+	ssize_t res = read(event->fileDescriptor, &eventValue, sizeof(uint64_t));
+	if ((res != sizeof(uint64_t)) && (errno != EAGAIN)) {
+		return ERROR_EVENT_NOT_RESET;
+	}
+	return 0;
+}
+
+//Returns 1 if signaled (and consumes the signal for auto reset events)
+static int syncEventTryConsume(syncEventLinux* event, uint64_t* signaled) {
+	if (event->manualReset > 0) {
+		struct pollfd eventPoll;
+		eventPoll.fd = event->fileDescriptor;
+		eventPoll.events = POLLIN;
+		eventPoll.revents = 0;
+		int pollRes = poll(&eventPoll, 1, 0);
+		if (pollRes < 0) {
+			return ERROR_TBD;
+		}
+		*signaled = (uint64_t) pollRes;
+		return 0;
+	}
+	
+	uint64_t eventValue = 0;
+	ssize_t res = read(event->fileDescriptor, &eventValue, sizeof(uint64_t));
+	if (res == sizeof(uint64_t)) {
+		*signaled = 1;
+	}
+	else if ((errno == EAGAIN) || (errno == EINTR)) {
+		*signaled = 0;
+	}
+	else {
+		return ERROR_TBD;
+	}
+	return 0;
+}
+
+int syncEventWait(void* eventPtr) {
+	syncEventLinux* event = (syncEventLinux*) eventPtr;
+	struct pollfd eventPoll;
+	eventPoll.fd = event->fileDescriptor;
+	eventPoll.events = POLLIN;
+	
+	uint64_t signaled = 0;
+	int error = syncEventTryConsume(event, &signaled);
+	while ((error == 0) && (signaled == 0)) {
+		eventPoll.revents = 0;
+		poll(&eventPoll, 1, -1);
+		error = syncEventTryConsume(event, &signaled);
+	}
+	return error;
+}
+
+int syncEventCheck(void* eventPtr, uint64_t* signaled) {
+	return syncEventTryConsume((syncEventLinux*) eventPtr, signaled);
+}
+
+void syncCloseEvent(void** eventPtr) {
+	syncEventLinux* event = (syncEventLinux*) (*eventPtr);
+	close(event->fileDescriptor);
+	free(event);
+	*eventPtr = NULL;
+}
+
+//Wait Sets are an epoll instance holding a timerfd (for the end time), the added
+//events' eventfds, and the io_uring completion eventfd
+//Everything is level triggered and only the timer & completion counters get read
+typedef struct syncWaitSetLinux {
+	int epollFileDescriptor;
+	int timerFileDescriptor;
+	int ringEventFileDescriptor; //The completion eventfd currently in the set
+	uint64_t timerArmed;
+} syncWaitSetLinux;
+
+static int syncWaitSetAddFileDescriptor(syncWaitSetLinux* waitSet, int fileDescriptor) {
+	struct epoll_event waitEvent;
+	waitEvent.events = EPOLLIN;
+	waitEvent.data.fd = fileDescriptor;
+	int res = epoll_ctl(waitSet->epollFileDescriptor, EPOLL_CTL_ADD, fileDescriptor, &waitEvent);
+	if (res != 0) {
+		return ERROR_TBD;
+	}
+	return 0;
+}
+
+int syncCreateWaitSet(void** waitSetPtr) {
+	syncWaitSetLinux* waitSet = (syncWaitSetLinux*) malloc(sizeof(syncWaitSetLinux));
+	if (waitSet == NULL) {
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	waitSet->epollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+	if (waitSet->epollFileDescriptor < 0) {
+		free(waitSet);
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	waitSet->timerFileDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (waitSet->timerFileDescriptor < 0) {
+		close(waitSet->epollFileDescriptor);
+		free(waitSet);
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	waitSet->ringEventFileDescriptor = -1;
+	waitSet->timerArmed = 0;
+	
+	int error = syncWaitSetAddFileDescriptor(waitSet, waitSet->timerFileDescriptor);
+	if (error != 0) {
+		close(waitSet->timerFileDescriptor);
+		close(waitSet->epollFileDescriptor);
+		free(waitSet);
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	
+	*waitSetPtr = (void*) waitSet;
+	return 0;
+}
+
+int syncWaitSetAddEvent(void* waitSetPtr, void* eventPtr) {
+	syncWaitSetLinux* waitSet = (syncWaitSetLinux*) waitSetPtr;
+	syncEventLinux* event = (syncEventLinux*) eventPtr;
+	return syncWaitSetAddFileDescriptor(waitSet, event->fileDescriptor);
+}
+
+//Reads a counter (timerfd / eventfd) so it stops signaling
+static void syncDrainFileDescriptor(int fileDescriptor) {
+	uint64_t counterValue = 0;
+	ssize_t res = read(fileDescriptor, &counterValue, sizeof(uint64_t));
+	(void) res;
+}
+
+int syncWaitSetWait(void* waitSetPtr, uint64_t asyncOperation, uint64_t endTime) {
+	syncWaitSetLinux* waitSet = (syncWaitSetLinux*) waitSetPtr;
+	int timeout = -1;
+	
+	if (asyncOperation != SYNC_WAIT_NONE) {
+		if (asyncOperation >= ioAsyncOperationCount) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		if (ioRingFD >= 0) { //Queued writes are only handed to the kernel here or during a check
+			int error = ioRingEnter(0);
+			if (error != 0) {
+				return error;
+			}
+		}
+		if (ioAsyncStates[asyncOperation] != ASYNC_STATE_QUEUED) {
+			return 0; //Already finished so the caller can check it right away
+		}
+		if (ioRingEventFD < 0) {
+			timeout = 1; //No completion eventfd so check back every millisecond
+		}
+		else if (waitSet->ringEventFileDescriptor != ioRingEventFD) { //Ring (re)created since the last wait
+			int error = syncWaitSetAddFileDescriptor(waitSet, ioRingEventFD);
+			if (error != 0) {
+				return error;
+			}
+			waitSet->ringEventFileDescriptor = ioRingEventFD;
+		}
+	}
+	
+	if (endTime != SYNC_WAIT_NONE) {
+		if (getCurrentTime() >= endTime) {
+			return 0;
+		}
+		struct itimerspec timerValue;
+		timerValue.it_interval.tv_sec = 0;
+		timerValue.it_interval.tv_nsec = 0;
+		timerValue.it_value.tv_sec = (time_t) (endTime / TIME_COUNTER_FREQUENCY); //Same clock as getCurrentTime
+		timerValue.it_value.tv_nsec = (long) (endTime % TIME_COUNTER_FREQUENCY);
+		int res = timerfd_settime(waitSet->timerFileDescriptor, TFD_TIMER_ABSTIME, &timerValue, NULL);
+		if (res != 0) {
+			return ERROR_TBD;
+		}
+		waitSet->timerArmed = 1;
+	}
+	else if (waitSet->timerArmed > 0) { //Stop an old end time from waking this wait
+		struct itimerspec timerValue;
+		memzeroBasic(&timerValue, sizeof(struct itimerspec));
+		timerfd_settime(waitSet->timerFileDescriptor, 0, &timerValue, NULL);
+		syncDrainFileDescriptor(waitSet->timerFileDescriptor);
+		waitSet->timerArmed = 0;
+	}
+	
+	struct epoll_event waitEvents[8];
+	int eventCount = epoll_wait(waitSet->epollFileDescriptor, waitEvents, 8, timeout);
+	if (eventCount < 0) {
+		if (errno == EINTR) {
+			return 0;
+		}
+		return ERROR_TBD;
+	}
+	for (int e = 0; e < eventCount; e++) {
+		if (waitEvents[e].data.fd == waitSet->timerFileDescriptor) {
+			syncDrainFileDescriptor(waitSet->timerFileDescriptor);
+			waitSet->timerArmed = 0;
+		}
+		else if (waitEvents[e].data.fd == waitSet->ringEventFileDescriptor) {
+			syncDrainFileDescriptor(waitSet->ringEventFileDescriptor);
+		}
+	}
+	return 0;
+}
+
+void syncCloseWaitSet(void** waitSetPtr) {
+	syncWaitSetLinux* waitSet = (syncWaitSetLinux*) (*waitSetPtr);
+	close(waitSet->timerFileDescriptor);
+	close(waitSet->epollFileDescriptor);
+	free(waitSet);
+	*waitSetPtr = NULL;
+}
+
+static void* syncThreadStart(void* threadParam) {
+	PFN_ThreadStart threadStart = (PFN_ThreadStart) (threadParam);
+	return (void*) ((intptr_t) threadStart());
+}
+
+//pthreads cannot be created suspended (and there is no resume function yet)
+int syncStartThread(void** threadPtr, PFN_ThreadStart threadStart, uint64_t initialState) {
+	if (initialState > 0) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	pthread_t thread;
+	int res = pthread_create(&thread, NULL, syncThreadStart, (void*) threadStart);
+	if (res != 0) {
+		return ERROR_THREAD_NOT_CREATED;
+	}
+	pthread_detach(thread);
+	
+	*threadPtr = (void*) thread;
+	return 0;
+}
+
+uint64_t syncGetProcessorCount() {
+	long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+	if (processorCount < 1) {
+		return 1;
+	}
+	return (uint64_t) processorCount;
+}
@@ -0,0 +1,275 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Linux Network Compatibility Implementation
+//Same IPv6 UDP interface as the Windows version (server on port 4567, client
+//connected to the server) on plain POSIX sockets: the sends complete right
+//away so there is one send buffer that is never pending, and receives wait
+//up to the same 1 second socket timeout
+//Complete error checking is still a work in progress
+#define _GNU_SOURCE //Needed for the Linux specific socket definitions
+#define COMPATIBILITY_GRAPHICS_UNNEEDED
+#include "compatibility.h" //Includes stdint.h
+
+#include <errno.h> //errno for the extra error information
+#include <unistd.h> //close
+#include <sys/socket.h> //Sockets
+#include <sys/time.h> //Socket timeouts
+#include <netinet/in.h> //IPv6 addresses
+#include <arpa/inet.h> //inet_pton & inet_ntop
+
+static const char localHostStr[] = "::"; //IPv6 Any Address "::1" is specifically loopback only
+static const uint64_t serverPort = 4567;
+static const uint64_t msgBufSize = 1200; //Datagrams of 1200 bytes or fewer are never fragmented over IPv6
+
+// Network State Codes:
+#define NETWORK_STATE_UNDEFINED 0
+#define NETWORK_STATE_STARTED 1
+#define NETWORK_STATE_SOCKET_CONFIGURED 3
+#define NETWORK_STATE_CLIENT 4
+#define NETWORK_STATE_SERVER 5
+static uint64_t networkState = NETWORK_STATE_UNDEFINED;
+
+static int networkLastError = 0;
+
+void compatibilityGetNetworkError(int* error) {
+	if (networkState == NETWORK_STATE_UNDEFINED) {
+		return;
+	}
+	
+	*error = networkLastError;
+}
+
+static int networkSocket = -1;
+static struct sockaddr_in6 networkServerAddress;
+static struct sockaddr_in6 networkRecvAddress;
+static uint8_t networkRecvBuffer[1200];
+static uint8_t networkSendBuffer[1200];
+
+#define RETURN_ON_SOCKET_ERROR(result) ({if (result < 0) { networkLastError = errno; return ERROR_NETWORK_TBD; }})
+
+//NULL terminated server address string
+int networkStartup(uint64_t isServer, char* serverAddress) {
+	if (networkState > NETWORK_STATE_UNDEFINED) {
+		return ERROR_NETWORK_WRONG_STATE;
+	}
+	networkState = NETWORK_STATE_STARTED;
+	
+	networkSocket = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	RETURN_ON_SOCKET_ERROR(networkSocket);
+	
+	// IPv6 Only Mode (same as the Windows version)
+	int optValue = 1;
+	int error = setsockopt(networkSocket, IPPROTO_IPV6, IPV6_V6ONLY, &optValue, sizeof(int));
+	RETURN_ON_SOCKET_ERROR(error);
+	
+	// IPv6 Don't Let OS Fragment Packets
+	optValue = IPV6_PMTUDISC_DO;
+	error = setsockopt(networkSocket, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &optValue, sizeof(int));
+	RETURN_ON_SOCKET_ERROR(error);
+	
+	// IPv6 Set Max Hops (TTL)
+	optValue = 150;
+	error = setsockopt(networkSocket, IPPROTO_IPV6, IPV6_UNICAST_HOPS, &optValue, sizeof(int));
+	RETURN_ON_SOCKET_ERROR(error);
+	
+	// Socket Timeout Options:
+	struct timeval timeout;
+	timeout.tv_sec = 1;
+	timeout.tv_usec = 0;
+	error = setsockopt(networkSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	RETURN_ON_SOCKET_ERROR(error);
+	error = setsockopt(networkSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	RETURN_ON_SOCKET_ERROR(error);
+	
+	networkState = NETWORK_STATE_SOCKET_CONFIGURED;
+	
+	memzeroBasic(&networkServerAddress, sizeof(networkServerAddress));
+	networkServerAddress.sin6_family = AF_INET6;
+	const char* addressStr = serverAddress;
+	if (isServer) {
+		addressStr = localHostStr;
+	}
+	if ((addressStr == NULL) || (inet_pton(AF_INET6, addressStr, &(networkServerAddress.sin6_addr)) != 1)) {
+		return ERROR_NETWORK_BAD_ADDRESS;
+	}
+	networkServerAddress.sin6_port = htons((uint16_t) serverPort);
+	
+	if (isServer) {
+		error = bind(networkSocket, (struct sockaddr*) &networkServerAddress, sizeof(networkServerAddress));
+		RETURN_ON_SOCKET_ERROR(error);
+		
+		networkState = NETWORK_STATE_SERVER;
+	}
+	else {
+		//Datagrams from other addresses get discarded
+		error = connect(networkSocket, (struct sockaddr*) &networkServerAddress, sizeof(networkServerAddress));
+		RETURN_ON_SOCKET_ERROR(error);
+		
+		networkState = NETWORK_STATE_CLIENT;
+	}
+	
+	return 0;
+}
+
+int networkCleanup() {
+	if (networkState == NETWORK_STATE_UNDEFINED) {
+		return 0;
+	}
+	
+	if (networkSocket >= 0) {
+		close(networkSocket);
+		networkSocket = -1;
+	}
+	
+	networkState = NETWORK_STATE_UNDEFINED;
+	return 0;
+}
+
+
+
+int networkGetServerAddrPort(netAddrPortFlow* addrPort) {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	memcpyBasic(addrPort->address, &(networkServerAddress.sin6_addr), 16);
+	addrPort->port = networkServerAddress.sin6_port;
+	addrPort->flow = networkServerAddress.sin6_flowinfo;
+	
+	return 0;
+}
+
+//The buffer stays valid until the next call
+int networkGetNextRecvMessageBuffer(uint8_t** recvMsgBuf, uint64_t* recvMsgBytes, uint64_t wait) {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	socklen_t addressSize = sizeof(networkRecvAddress);
+	ssize_t bytes = recvfrom(networkSocket, networkRecvBuffer, msgBufSize, (wait > 0) ? 0 : MSG_DONTWAIT, (struct sockaddr*) &networkRecvAddress, &addressSize);
+	if (bytes < 0) {
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+			return NETWORK_RECV_PENDING;
+		}
+		networkLastError = errno;
+		return ERROR_NETWORK_TBD;
+	}
+	
+	*recvMsgBuf = networkRecvBuffer;
+	*recvMsgBytes = (uint64_t) bytes;
+	return 0;
+}
+
+//addrPort char array should have an allocated length of at least 64
+int networkGetAddrPortStr(char* addrPortStr, uint64_t* addrPortBytes, uint64_t currRecvAddr) {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	if (*addrPortBytes < 64) {
+		return ERROR_NETWORK_LOW_BSIZE;
+	}
+	
+	struct sockaddr_in6 localAddress;
+	struct sockaddr_in6* address = &networkRecvAddress;
+	if (currRecvAddr == 0) {
+		socklen_t addressSize = sizeof(localAddress);
+		int error = getsockname(networkSocket, (struct sockaddr*) &localAddress, &addressSize);
+		RETURN_ON_SOCKET_ERROR(error);
+		address = &localAddress;
+	}
+	
+	//Same [address]:port form as WSAAddressToString
+	addrPortStr[0] = '[';
+	if (inet_ntop(AF_INET6, &(address->sin6_addr), &(addrPortStr[1]), 46) == NULL) {
+		networkLastError = errno;
+		return ERROR_NETWORK_TBD;
+	}
+	uint64_t bytes = 1;
+	while (addrPortStr[bytes] != 0) {
+		bytes++;
+	}
+	addrPortStr[bytes] = ']';
+	addrPortStr[bytes + 1] = ':';
+	bytes += 2;
+	bytes += numToUDecStr(&(addrPortStr[bytes]), ntohs(address->sin6_port));
+	addrPortStr[bytes] = 0;
+	*addrPortBytes = bytes;
+	
+	return 0;
+}
+
+int networkGetRecvAddrPort(netAddrPortFlow* addrPort) {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	memcpyBasic(addrPort->address, &(networkRecvAddress.sin6_addr), 16);
+	addrPort->port = networkRecvAddress.sin6_port;
+	addrPort->flow = networkRecvAddress.sin6_flowinfo;
+	
+	return 0;
+}
+
+int networkGetNextSendMessageBuffer(uint8_t** sendMsgBuf, uint64_t* sendMsgMaxBytes, uint64_t wait) {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	*sendMsgBuf = networkSendBuffer;
+	*sendMsgMaxBytes = msgBufSize;
+	
+	return 0;
+}
+
+int networkSendMessage(netAddrPortFlow* addrPort, uint64_t sendBytes) {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	if (sendBytes > msgBufSize) {
+		return ERROR_NETWORK_TOO_MANY_BYTES;
+	}
+	
+	struct sockaddr_in6 address;
+	memzeroBasic(&address, sizeof(address));
+	address.sin6_family = AF_INET6;
+	memcpyBasic(&(address.sin6_addr), addrPort->address, 16);
+	address.sin6_port = (uint16_t) addrPort->port;
+	address.sin6_flowinfo = (uint32_t) addrPort->flow;
+	
+	ssize_t bytes = sendto(networkSocket, networkSendBuffer, sendBytes, 0, (struct sockaddr*) &address, sizeof(address));
+	RETURN_ON_SOCKET_ERROR(bytes);
+	
+	return 0;
+}
+
+int networkWaitOnSentMessages() {
+	if (networkState < NETWORK_STATE_CLIENT) {
+		return ERROR_NETWORK_NOT_SETUP;
+	}
+	
+	return 0; //Sends already completed
+}
@@ -68,6 +68,11 @@ uint64_t getCurrentTime() {
 	return (uint64_t) performanceCounter.QuadPart;
 }
 
+uint64_t getDiffTimeNanoseconds(uint64_t startTime, uint64_t endTime) {
+	uint64_t diffTime = endTime - startTime; //Split so long differences do not overflow
+	return ((diffTime / timeCounterFrequency) * 1000000000) + (((diffTime % timeCounterFrequency) * 1000000000) / timeCounterFrequency);
+}
+
 uint64_t getDiffTimeMicroseconds(uint64_t startTime, uint64_t endTime) {
 	return ((endTime - startTime) / timeMicrosecondDivider);
 }
@@ -96,6 +101,15 @@ uint64_t getMicrosecondDivider() {
 	return timeMicrosecondDivider;
 }
 
+uint64_t getProcessTimeMicroseconds() {
+	uint64_t creationTime = 0;
+	uint64_t exitTime = 0;
+	uint64_t kernelTime = 0;
+	uint64_t userTime = 0;
+	GetProcessTimes(GetCurrentProcess(), (FILETIME*) &creationTime, (FILETIME*) &exitTime, (FILETIME*) &kernelTime, (FILETIME*) &userTime);
+	return (kernelTime + userTime) / 10; //100ns units
+}
+
 uint64_t getTimestampNTP() {
 	uint64_t nanoseconds100 = 0;
 	FILETIME* sysTimeUTC = (FILETIME*) &nanoseconds100;
@@ -139,23 +153,23 @@ int memoryLargePageSetup() { //Try to allow the creation of large page memory
 	
 	HANDLE hToken = NULL;
 	TOKEN_PRIVILEGES tp;
-
+	
 	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY | TOKEN_ADJUST_PRIVILEGES, &hToken)) {
 		//printf("OpenProcessToken #2 failed. GetLastError returned: %ld\n", GetLastError());
 		return -20;
 	}
-
+	
 	tp.PrivilegeCount = 1;
 	tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
-
+	
 	if (!LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid)) {
 		//printf("LookupPrivilegeValue failed. GetLastError returned: %ld\n", GetLastError());
 		return -21;
 	}
-
+	
 	BOOL adjResult = AdjustTokenPrivileges(hToken, FALSE, &tp, 0, (PTOKEN_PRIVILEGES)NULL, 0);
 	DWORD lastError = GetLastError();
-
+	
 	if (!adjResult || (lastError != ERROR_SUCCESS)) {
 		//printf("AdjustTokenPrivileges failed. GetLastError returned: %ld\n", lastError);
 		return -22;
@@ -901,7 +915,57 @@ static uint64_t ioState = IO_STATE_UNDEFINED;
 static void* ioTempBuffer = NULL;
 static uint64_t ioTempBufferByteSize = 0;
 static void* ioCommandArgumentBuffer = NULL;
-static char* ioCommandArgumentPosition = NULL;
+#define IO_ARGUMENT_MAX 64
+static char* ioArgumentValues[IO_ARGUMENT_MAX];
+static uint64_t ioArgumentBytes[IO_ARGUMENT_MAX];
+static uint64_t ioArgumentCount = 0;
+static uint64_t ioCommandArgumentPosition = 0;
+
+//Splits the command line in place into NULL terminated arguments (the first one is the program)
+//Quotes group spaces into one argument and get removed
+static void ioSplitCommandArguments(char* commandLine) {
+	ioArgumentCount = 0;
+	char* readPtr = commandLine;
+	char* writePtr = commandLine;
+	while (*readPtr != 0) {
+		while (*readPtr == 32) { // SPACE (' ') character
+			readPtr++;
+		}
+		if (*readPtr == 0) {
+			break;
+		}
+		char* argument = writePtr;
+		char quote = 0;
+		while (*readPtr != 0) {
+			if (quote != 0) {
+				if (*readPtr == quote) {
+					quote = 0;
+					readPtr++;
+					continue;
+				}
+			}
+			else if ((*readPtr == 34) || (*readPtr == 39)) { // " or ' character
+				quote = *readPtr;
+				readPtr++;
+				continue;
+			}
+			else if (*readPtr == 32) {
+				readPtr++;
+				break;
+			}
+			*writePtr = *readPtr;
+			writePtr++;
+			readPtr++;
+		}
+		if (ioArgumentCount < IO_ARGUMENT_MAX) {
+			ioArgumentValues[ioArgumentCount] = argument;
+			ioArgumentBytes[ioArgumentCount] = (uint64_t) (writePtr - argument);
+			ioArgumentCount++;
+		}
+		*writePtr = 0; //Never past readPtr - 1 so the next argument is still intact
+		writePtr++;
+	}
+}
 
 int ioSetup() {
 	int error = memoryAllocateOnePage(&ioTempBuffer, &ioTempBufferByteSize);
@@ -921,132 +985,59 @@ int ioSetup() {
 		return error;
 	}
 	
-	//uint64_t memBytes = 0;
-	//error = memoryGetSize(ioCommandArgumentBuffer, &memBytes);
-	//if (error != 0) {
-	//	return error;
-	//}
-	//consoleWriteLineWithNumberFast("Bytes: ", 7, memBytes, NUM_FORMAT_UNSIGNED_INTEGER);
-	
 	error = WideCharToMultiByte(CP_UTF8, 0, commandArguments, -1, (LPSTR) ioCommandArgumentBuffer, characters, NULL, NULL);
 	if (error != characters) {
 		consoleWriteLineWithNumberFast("ERROR: ", 7, (uint64_t) GetLastError(), NUM_FORMAT_FULL_HEXADECIMAL);
 		return ERROR_IO_UNICODE_TRANSLATE;
 	}
 	
-	
-	ioCommandArgumentPosition = (char*) ioCommandArgumentBuffer;
+	ioSplitCommandArguments((char*) ioCommandArgumentBuffer);
+	ioCommandArgumentPosition = 0;
 	
 	ioState = IO_STATE_SETUP;
 	return 0;
 }
 
-//Needs update
 int ioGetNextCommandArgument(char** argumentUTF8, uint64_t* argumentByteLength) {
 	if (ioState != IO_STATE_SETUP) {
 		return ERROR_IO_WRONG_STATE;
 	}
 	
-	char* charIterator = ioCommandArgumentPosition;
-	*argumentUTF8 = charIterator;
-	uint64_t byteLength = 0;
-	while (*charIterator != 0) { // NULL character
-		if (*charIterator == 32) { // SPACE (' ') character
-			if (byteLength != 0) {
-				*argumentByteLength = byteLength;
-				charIterator++;
-				ioCommandArgumentPosition = charIterator;
-				return 0;
-			}
-			charIterator++;
-			*argumentUTF8 = charIterator;
-		}
-		else if (*charIterator == 34) { // " character
-			while (*charIterator != 34) { //Not double check looking for NULL character
-				byteLength++;
-				charIterator++;
-			}
-		}
-		else if (*charIterator == 39) { // ' character
-			while (*charIterator != 39) { //Not double check looking for NULL character
-				byteLength++;
-				charIterator++;
-			}
-		}
-		byteLength++;
-		charIterator++;
+	if (ioCommandArgumentPosition >= ioArgumentCount) {
+		*argumentUTF8 = NULL;
+		*argumentByteLength = 0;
+		return ERROR_ARGUMENT_DNE;
 	}
-	*argumentByteLength = byteLength;
-	ioCommandArgumentPosition = NULL;
+	*argumentUTF8 = ioArgumentValues[ioCommandArgumentPosition];
+	*argumentByteLength = ioArgumentBytes[ioCommandArgumentPosition];
+	ioCommandArgumentPosition++;
 	
 	return 0;
 }
 
-//Needs update
 int ioGetCommandArgument(uint64_t argumentNumber, char** argumentUTF8, uint64_t* argumentByteLength) {
 	if (ioState != IO_STATE_SETUP) {
 		return ERROR_IO_WRONG_STATE;
 	}
 	
-	char* charIterator = (char*) ioCommandArgumentBuffer;
-	*argumentUTF8 = charIterator;
-	uint64_t byteLength = 0;
-	uint64_t argumentCounter = 0;
-	while (*charIterator != 0) { // NULL character
-		if (*charIterator == 32) { // SPACE (' ') character
-			if (byteLength != 0) {
-				if (argumentCounter < argumentNumber) {
-					charIterator++;
-					*argumentUTF8 = charIterator;
-					byteLength = 0;
-					argumentCounter++;
-				}
-				else {
-					*charIterator = 0;
-				}
-			}
-			else {
-				charIterator++;
-				*argumentUTF8 = charIterator;
-			}
-		}
-		else if (*charIterator == 34) { // " character
-			while (*charIterator != 34) { //Not double check looking for NULL character
-				byteLength++;
-				charIterator++;
-			}
-			byteLength++;
-			charIterator++;
-		}
-		else if (*charIterator == 39) { // ' character
-			while (*charIterator != 39) { //Not double check looking for NULL character
-				byteLength++;
-				charIterator++;
-			}
-			byteLength++;
-			charIterator++;
-		}
-		else {
-			byteLength++;
-			charIterator++;
-		}
-	}
-	*argumentByteLength = byteLength;
-	if (argumentCounter < argumentNumber) {
-			return ERROR_ARGUMENT_DNE;
+	if (argumentNumber >= ioArgumentCount) {
+		*argumentUTF8 = NULL;
+		*argumentByteLength = 0;
+		return ERROR_ARGUMENT_DNE;
 	}
+	*argumentUTF8 = ioArgumentValues[argumentNumber];
+	*argumentByteLength = ioArgumentBytes[argumentNumber];
 	return 0;
 }
 
-int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t flags) {
-	if (ioState != IO_STATE_SETUP) {
-		return ERROR_IO_WRONG_STATE;
-	}
+//File paths get converted into the caller's stack buffer instead of ioTempBuffer
+//so that helper threads (the segment rollover) can open and delete files too
+#define IO_PATH_CHARACTERS_MAX 1024
+static int ioPathUTF16(char* filePathUTF8, int filePathBytes, WCHAR* filePathUTF16) {
 	int characters = MultiByteToWideChar(CP_UTF8, 0, filePathUTF8, filePathBytes, NULL, 0);
-	if (characters >= (ioTempBufferByteSize>>1)) { //Account for NULL termination not fitting in future
+	if (characters >= IO_PATH_CHARACTERS_MAX) { //Account for NULL termination not fitting in future
 		return ERROR_IO_TEMP_BUFF_NOT_ENOUGH_MEMORY;
 	}
-	LPWSTR filePathUTF16 = (LPWSTR) ioTempBuffer;
 	int result = MultiByteToWideChar(CP_UTF8, 0, filePathUTF8, filePathBytes, filePathUTF16, characters);
 	if (result == 0) {
 		return ERROR_IO_UNICODE_TRANSLATE;
@@ -1054,6 +1045,26 @@ int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t f
 	//if (filePathBytes > 0) { //-1 for file path bytes writes a null...?
 		filePathUTF16[result] = 0;
 	//}
+	return 0;
+}
+
+//FILE_FLAG_NO_BUFFERING only accepts sector aligned memory, sizes, and offsets so direct files
+//keep a second unbuffered handle for the aligned writes (headers and file tails use the normal one)
+//Entries get claimed and released atomically since helper threads open and close files too
+//([0] is the normal handle, NULL when the entry is free)
+#define IO_DIRECT_FILE_MAX 8
+#define IO_DIRECT_ALIGNMENT 4096 //Covers 512 and 4096 byte sectors
+static HANDLE ioDirectFileHandles[IO_DIRECT_FILE_MAX][2];
+
+int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t flags) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	WCHAR filePathUTF16[IO_PATH_CHARACTERS_MAX];
+	int error = ioPathUTF16(filePathUTF8, filePathBytes, filePathUTF16);
+	if (error != 0) {
+		return error;
+	}
 	
 	HANDLE fileHandle = NULL;
 	if (flags == IO_FILE_READ_NORMAL) {
@@ -1062,12 +1073,18 @@ int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t f
 	else if (flags == IO_FILE_WRITE_NORMAL) {
 		fileHandle = CreateFile(filePathUTF16, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
 	}
+	else if (flags == IO_FILE_UPDATE_NORMAL) {
+		fileHandle = CreateFile(filePathUTF16, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	}
 	else if (flags == IO_FILE_READ_ASYNC) {
 		fileHandle = CreateFile(filePathUTF16, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
 	}
 	else if (flags == IO_FILE_WRITE_ASYNC) {
 		fileHandle = CreateFile(filePathUTF16, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_OVERLAPPED, NULL);
 	}
+	else if (flags == IO_FILE_WRITE_ASYNC_DIRECT) { //Shared with its own unbuffered handle
+		fileHandle = CreateFile(filePathUTF16, GENERIC_WRITE, FILE_SHARE_WRITE, NULL, CREATE_ALWAYS, FILE_FLAG_OVERLAPPED, NULL);
+	}
 	else {
 		return ERROR_INVALID_ARGUMENT;
 	}
@@ -1075,11 +1092,35 @@ int ioOpenFile(void** filePtr, char* filePathUTF8, int filePathBytes, uint64_t f
 		return ERROR_IO_CANNOT_OPEN_FILE;
 	}
 	
+	if (flags == IO_FILE_WRITE_ASYNC_DIRECT) {
+		HANDLE directFileHandle = CreateFile(filePathUTF16, GENERIC_WRITE, FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING, NULL);
+		if (directFileHandle != INVALID_HANDLE_VALUE) {
+			uint64_t d = 0;
+			for (; d < IO_DIRECT_FILE_MAX; d++) {
+				HANDLE freeEntry = NULL;
+				if (__atomic_compare_exchange_n(&(ioDirectFileHandles[d][0]), &freeEntry, fileHandle, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+					__atomic_store_n(&(ioDirectFileHandles[d][1]), directFileHandle, __ATOMIC_RELEASE);
+					break;
+				}
+			}
+			if (d >= IO_DIRECT_FILE_MAX) { //Writes just keep going through the cache
+				CloseHandle(directFileHandle);
+			}
+		}
+	}
+	
 	*filePtr = fileHandle;
 	return 0;
 }
 
 int ioCloseFile(void** filePtr) {
+	for (uint64_t d = 0; d < IO_DIRECT_FILE_MAX; d++) {
+		if (__atomic_load_n(&(ioDirectFileHandles[d][0]), __ATOMIC_ACQUIRE) == (HANDLE) *filePtr) {
+			CloseHandle(ioDirectFileHandles[d][1]);
+			ioDirectFileHandles[d][1] = NULL;
+			__atomic_store_n(&(ioDirectFileHandles[d][0]), NULL, __ATOMIC_RELEASE); //Released before the handle value can get reused
+		}
+	}
 	BOOL result = CloseHandle((HANDLE) *filePtr);
 	if (result == 0) {
 		return ERROR_IO_CANNOT_CLOSE_FILE;
@@ -1109,6 +1150,53 @@ int ioReadFile(void* filePtr, void* dataPtr, uint32_t* numBytes) {
 	return 0;
 }
 
+int ioReadFileOffset(void* filePtr, void* dataPtr, uint32_t* numBytes, uint64_t offset) {
+	OVERLAPPED readOffset; //Synchronous handle so the read still finishes before returning
+	readOffset.Internal = 0;
+	readOffset.InternalHigh = 0;
+	readOffset.hEvent = NULL;
+	readOffset.Offset = (DWORD) (offset & 0xFFFFFFFF);
+	readOffset.OffsetHigh = (DWORD) (offset >> 32);
+	DWORD readBytes = 0;
+	BOOL result = ReadFile((HANDLE) filePtr, dataPtr, *numBytes, &readBytes, &readOffset);
+	if (result == 0) {
+		*numBytes = 0;
+		if (GetLastError() == ERROR_HANDLE_EOF) { //Reading at or past the end is not a failure
+			return 0;
+		}
+		return ERROR_IO_CANNOT_READ_FILE;
+	}
+	*numBytes = (uint32_t) readBytes;
+	return 0;
+}
+
+//The view keeps the file mapping object alive so its handle can be closed right away
+int ioMapFile(void* filePtr, uint64_t offset, uint64_t numBytes, void** mapPtr) {
+	if (((offset % IO_MAP_ALIGNMENT) != 0) || (numBytes == 0)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	HANDLE mapping = CreateFileMappingW((HANDLE) filePtr, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		return ERROR_IO_CANNOT_MAP_FILE;
+	}
+	void* viewPtr = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD) (offset >> 32), (DWORD) (offset & 0xFFFFFFFF), (SIZE_T) numBytes);
+	CloseHandle(mapping);
+	if (viewPtr == NULL) {
+		return ERROR_IO_CANNOT_MAP_FILE;
+	}
+	*mapPtr = viewPtr;
+	return 0;
+}
+
+int ioUnmapFile(void** mapPtr, uint64_t numBytes) {
+	BOOL result = UnmapViewOfFile(*mapPtr);
+	if (result == 0) {
+		return ERROR_IO_CANNOT_UNMAP_FILE;
+	}
+	*mapPtr = NULL;
+	return 0;
+}
+
 int ioWriteFile(void* filePtr, void* dataPtr, uint32_t numBytes) {
 	DWORD writtenBytes = 0;
 	BOOL result = WriteFile((HANDLE) filePtr, dataPtr, numBytes, &writtenBytes, NULL);
@@ -1121,8 +1209,106 @@ int ioWriteFile(void* filePtr, void* dataPtr, uint32_t numBytes) {
 	return 0;
 }
 
-#define ASYNC_OPERATION_MAX 4
+int ioSetFileSize(void* filePtr, uint64_t fileSizeBytes) {
+	LARGE_INTEGER position;
+	position.QuadPart = (LONGLONG) fileSizeBytes;
+	if (SetFilePointerEx((HANDLE) filePtr, position, NULL, FILE_BEGIN) == 0) {
+		return ERROR_IO_CANNOT_SET_FILE_SIZE;
+	}
+	if (SetEndOfFile((HANDLE) filePtr) == 0) {
+		return ERROR_IO_CANNOT_SET_FILE_SIZE;
+	}
+	return 0;
+}
+
+//The allocation size beyond the end of the file gets released when the file is closed
+int ioAllocateFileSpace(void* filePtr, uint64_t numBytes) {
+	if (numBytes == 0) {
+		return 0;
+	}
+	FILE_ALLOCATION_INFO allocationInfo;
+	allocationInfo.AllocationSize.QuadPart = (LONGLONG) numBytes;
+	if (SetFileInformationByHandle((HANDLE) filePtr, FileAllocationInfo, &allocationInfo, sizeof(FILE_ALLOCATION_INFO)) == 0) {
+		return ERROR_IO_CANNOT_ALLOCATE_FILE_SPACE;
+	}
+	return 0;
+}
+
+//The volume GUID path of the file (\\?\Volume{...}\) names the disk it is on
+int ioGetFreeSpace(void* filePtr, uint64_t* freeBytes) {
+	WCHAR volumePath[IO_PATH_CHARACTERS_MAX];
+	DWORD pathCharacters = GetFinalPathNameByHandleW((HANDLE) filePtr, volumePath, IO_PATH_CHARACTERS_MAX, VOLUME_NAME_GUID);
+	if ((pathCharacters == 0) || (pathCharacters >= IO_PATH_CHARACTERS_MAX)) {
+		return ERROR_IO_CANNOT_GET_FREE_SPACE;
+	}
+	DWORD rootEnd = 0;
+	while ((rootEnd < pathCharacters) && (volumePath[rootEnd] != L'}')) {
+		rootEnd++;
+	}
+	if ((rootEnd + 1) >= pathCharacters) {
+		return ERROR_IO_CANNOT_GET_FREE_SPACE;
+	}
+	volumePath[rootEnd + 2] = 0; //Keeps the backslash after the GUID
+	ULARGE_INTEGER freeBytesAvailable;
+	if (GetDiskFreeSpaceExW(volumePath, &freeBytesAvailable, NULL, NULL) == 0) {
+		return ERROR_IO_CANNOT_GET_FREE_SPACE;
+	}
+	*freeBytes = (uint64_t) freeBytesAvailable.QuadPart;
+	return 0;
+}
+
+int ioDeleteFile(char* filePathUTF8, int filePathBytes) {
+	if (ioState != IO_STATE_SETUP) {
+		return ERROR_IO_WRONG_STATE;
+	}
+	WCHAR filePathUTF16[IO_PATH_CHARACTERS_MAX];
+	int error = ioPathUTF16(filePathUTF8, filePathBytes, filePathUTF16);
+	if (error != 0) {
+		return error;
+	}
+	if (DeleteFileW(filePathUTF16) == 0) {
+		return ERROR_IO_CANNOT_DELETE_FILE;
+	}
+	return 0;
+}
+
+//Windows has no kernel copy of a file range so the input gets mapped a chunk at a
+//time and written straight from the mapped view (no extra buffer copy)
+#define IO_COPY_CHUNK_BYTES 1073741824
+int ioCopyFileRange(void* outputFilePtr, void* inputFilePtr, uint64_t offset, uint64_t numBytes) {
+	uint64_t copiedBytes = 0;
+	while (copiedBytes < numBytes) {
+		uint64_t chunkOffset = offset + copiedBytes;
+		uint64_t mapOffset = chunkOffset - (chunkOffset % IO_MAP_ALIGNMENT);
+		uint64_t chunkBytes = IO_COPY_CHUNK_BYTES;
+		if ((numBytes - copiedBytes) < IO_COPY_CHUNK_BYTES) {
+			chunkBytes = numBytes - copiedBytes;
+		}
+		void* viewPtr = NULL;
+		int error = ioMapFile(inputFilePtr, mapOffset, (chunkOffset - mapOffset) + chunkBytes, &viewPtr);
+		if (error != 0) {
+			return ERROR_IO_CANNOT_COPY_FILE;
+		}
+		error = ioWriteFile(outputFilePtr, &(((uint8_t*) viewPtr)[chunkOffset - mapOffset]), (uint32_t) chunkBytes);
+		int unmapError = ioUnmapFile(&viewPtr, (chunkOffset - mapOffset) + chunkBytes);
+		if (error != 0) {
+			return error;
+		}
+		if (unmapError != 0) {
+			return unmapError;
+		}
+		copiedBytes += chunkBytes;
+	}
+	return 0;
+}
+
+#define ASYNC_OPERATION_MAX 64
 static OVERLAPPED ioAsyncOperations[ASYNC_OPERATION_MAX];
+static OVERLAPPED ioAsyncGatherOperations[ASYNC_OPERATION_MAX][IO_ASYNC_VECTOR_MAX - 1]; //Extra vectors of a vectored write
+static HANDLE ioAsyncEvents[ASYNC_OPERATION_MAX][IO_ASYNC_VECTOR_MAX]; //[0] is the main operation's event
+static DWORD ioAsyncEventCount[ASYNC_OPERATION_MAX];
+static volatile int ioAsyncOperationErrors[ASYNC_OPERATION_MAX]; //Reported along with the operation's signal (set before its event)
+static uint64_t ioAsyncSystemCalls = 0;
 int ioAsyncSetup(uint64_t asyncOperationCount) {
 	if (asyncOperationCount > ASYNC_OPERATION_MAX) {
 		return ERROR_TBD;
@@ -1137,22 +1323,42 @@ int ioAsyncSetup(uint64_t asyncOperationCount) {
 		if (ioAsyncOperations[i].hEvent == NULL) {
 			return ERROR_EVENT_NOT_CREATED;
 		}
+		ioAsyncEvents[i][0] = ioAsyncOperations[i].hEvent;
+		ioAsyncEventCount[i] = 1;
+		ioAsyncOperationErrors[i] = 0;
+		for (uint64_t v = 0; v < IO_ASYNC_VECTOR_MAX - 1; v++) {
+			ioAsyncGatherOperations[i][v].Internal = 0;
+			ioAsyncGatherOperations[i][v].InternalHigh = 0;
+			ioAsyncGatherOperations[i][v].Pointer = 0;
+			ioAsyncGatherOperations[i][v].hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+			if (ioAsyncGatherOperations[i][v].hEvent == NULL) {
+				return ERROR_EVENT_NOT_CREATED;
+			}
+			ioAsyncEvents[i][v + 1] = ioAsyncGatherOperations[i][v].hEvent;
+		}
 	}
 	return 0;
 }
 
+//Overlapped writes do not need the buffers registered ahead of time
+int ioAsyncRegisterBuffer(void* dataPtr, uint64_t numBytes) {
+	return 0;
+}
+
+//Waits on every write of the operation at once so the auto-reset events are only consumed together
 int ioAsyncSignalWait(uint64_t asyncOperation) {
-	DWORD waitRes = WaitForSingleObject(ioAsyncOperations[asyncOperation].hEvent, INFINITE);
-	if (waitRes != 0) { //Write Event Signaled
+	DWORD waitRes = WaitForMultipleObjects(ioAsyncEventCount[asyncOperation], ioAsyncEvents[asyncOperation], TRUE, INFINITE);
+	if (waitRes >= ioAsyncEventCount[asyncOperation]) { //Write Events Signaled
 		return ERROR_TBD;
 	}
-	return 0;
+	return ioAsyncOperationErrors[asyncOperation];
 }
 
 int ioAsyncSignalCheck(uint64_t asyncOperation, uint64_t* signaled) {
-	DWORD waitRes = WaitForSingleObject(ioAsyncOperations[asyncOperation].hEvent, 0);
-	if (waitRes == 0) { //Write Event Signaled
+	DWORD waitRes = WaitForMultipleObjects(ioAsyncEventCount[asyncOperation], ioAsyncEvents[asyncOperation], TRUE, 0);
+	if (waitRes < ioAsyncEventCount[asyncOperation]) { //Write Events Signaled
 		*signaled = 1;
+		return ioAsyncOperationErrors[asyncOperation];
 	}
 	else if (waitRes == WAIT_TIMEOUT) {
 		*signaled = 0;
@@ -1163,19 +1369,132 @@ int ioAsyncSignalCheck(uint64_t asyncOperation, uint64_t* signaled) {
 	return 0;
 }
 
+//Sector aligned writes go to the unbuffered handle when the file has one
+static HANDLE ioAsyncFileHandle(void* filePtr, void* dataPtr, uint64_t numBytes, uint64_t offset) {
+	uint64_t alignCheck = offset | numBytes | ((uint64_t) ((uintptr_t) dataPtr));
+	if ((alignCheck & (IO_DIRECT_ALIGNMENT - 1)) != 0) {
+		return (HANDLE) filePtr;
+	}
+	for (uint64_t d = 0; d < IO_DIRECT_FILE_MAX; d++) {
+		if (__atomic_load_n(&(ioDirectFileHandles[d][0]), __ATOMIC_ACQUIRE) == (HANDLE) filePtr) {
+			HANDLE directFileHandle = __atomic_load_n(&(ioDirectFileHandles[d][1]), __ATOMIC_ACQUIRE);
+			return (directFileHandle != NULL) ? directFileHandle : (HANDLE) filePtr;
+		}
+	}
+	return (HANDLE) filePtr;
+}
+
 int ioAsyncWriteFile(void* filePtr, void* dataPtr, uint64_t numBytes, uint64_t asyncOperation, uint64_t offset) {
 	ioAsyncOperations[asyncOperation].Offset     = (DWORD) (offset &  0xFFFFFFFF);
 	ioAsyncOperations[asyncOperation].OffsetHigh = (DWORD) (offset >> 32);
-	WriteFile((HANDLE) filePtr, dataPtr, numBytes, NULL, &(ioAsyncOperations[asyncOperation]));
-	//Error checking in future...?
+	ioAsyncEventCount[asyncOperation] = 1;
+	ioAsyncOperationErrors[asyncOperation] = 0;
+	BOOL result = WriteFile(ioAsyncFileHandle(filePtr, dataPtr, numBytes, offset), dataPtr, numBytes, NULL, &(ioAsyncOperations[asyncOperation]));
+	ioAsyncSystemCalls++;
+	if ((result == 0) && (GetLastError() != ERROR_IO_PENDING)) { //Never started: signal it like the flush thread does so waits still finish
+		ioAsyncOperationErrors[asyncOperation] = ERROR_IO_CANNOT_WRITE_FILE;
+		SetEvent(ioAsyncOperations[asyncOperation].hEvent);
+		return ERROR_IO_CANNOT_WRITE_FILE;
+	}
 	return 0;
 }
 
+//WriteFileGather only takes whole unbuffered pages, so each vector gets its own overlapped write under the one operation
+//(the recorder puts the reserved NAL right in front of the access unit so a frame is one vector and one WriteFile)
+int ioAsyncWriteFileV(void* filePtr, ioWriteVec* writeVectors, uint64_t vectorCount, uint64_t asyncOperation, uint64_t offset) {
+	if ((asyncOperation >= ASYNC_OPERATION_MAX) || (vectorCount == 0) || (vectorCount > IO_ASYNC_VECTOR_MAX)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	ioAsyncEventCount[asyncOperation] = (DWORD) vectorCount;
+	ioAsyncOperationErrors[asyncOperation] = 0;
+	for (uint64_t v = 0; v < vectorCount; v++) {
+		OVERLAPPED* overlapped = (v == 0) ? &(ioAsyncOperations[asyncOperation]) : &(ioAsyncGatherOperations[asyncOperation][v - 1]);
+		overlapped->Offset     = (DWORD) (offset &  0xFFFFFFFF);
+		overlapped->OffsetHigh = (DWORD) (offset >> 32);
+		BOOL result = WriteFile(ioAsyncFileHandle(filePtr, writeVectors[v].dataPtr, writeVectors[v].numBytes, offset), writeVectors[v].dataPtr, (DWORD) writeVectors[v].numBytes, NULL, overlapped);
+		ioAsyncSystemCalls++;
+		if ((result == 0) && (GetLastError() != ERROR_IO_PENDING)) { //Signal the writes that never started so waits on the operation still finish
+			ioAsyncOperationErrors[asyncOperation] = ERROR_IO_CANNOT_WRITE_FILE;
+			for (uint64_t u = v; u < vectorCount; u++) {
+				SetEvent(ioAsyncEvents[asyncOperation][u]);
+			}
+			return ERROR_IO_CANNOT_WRITE_FILE;
+		}
+		offset += writeVectors[v].numBytes;
+	}
+	return 0;
+}
+
+//There is no overlapped version of FlushFileBuffers so one helper thread does the flushes
+//and then signals the operation's event like a finished overlapped write would (a failed
+//flush gets stored first so that operation's signal check or wait returns it)
+static HANDLE ioAsyncFlushThread = NULL;
+static HANDLE ioAsyncFlushEvent = NULL;
+static HANDLE ioAsyncFlushFile = NULL;
+static uint64_t ioAsyncFlushOperation = 0;
+static volatile uint64_t ioAsyncFlushStop = 0;
+
+static DWORD WINAPI ioAsyncFlushThreadStart(LPVOID parameter) {
+	while (1) {
+		WaitForSingleObject(ioAsyncFlushEvent, INFINITE);
+		if (ioAsyncFlushStop > 0) {
+			break;
+		}
+		ioAsyncOperationErrors[ioAsyncFlushOperation] = (FlushFileBuffers(ioAsyncFlushFile) == 0) ? ERROR_IO_CANNOT_SYNC_FILE : 0;
+		SetEvent(ioAsyncOperations[ioAsyncFlushOperation].hEvent);
+	}
+	return 0;
+}
+
+int ioAsyncSyncFile(void* filePtr, uint64_t asyncOperation) {
+	if (asyncOperation >= ASYNC_OPERATION_MAX) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	if (ioAsyncFlushThread == NULL) {
+		ioAsyncFlushEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if (ioAsyncFlushEvent == NULL) {
+			return ERROR_IO_CANNOT_SYNC_FILE;
+		}
+		ioAsyncFlushStop = 0;
+		ioAsyncFlushThread = CreateThread(NULL, 1, ioAsyncFlushThreadStart, NULL, 0, NULL);
+		if (ioAsyncFlushThread == NULL) {
+			CloseHandle(ioAsyncFlushEvent);
+			ioAsyncFlushEvent = NULL;
+			return ERROR_THREAD_NOT_CREATED;
+		}
+	}
+	ioAsyncFlushFile = (HANDLE) filePtr;
+	ioAsyncFlushOperation = asyncOperation;
+	ioAsyncEventCount[asyncOperation] = 1;
+	ioAsyncOperationErrors[asyncOperation] = 0;
+	SetEvent(ioAsyncFlushEvent);
+	ioAsyncSystemCalls++;
+	return 0;
+}
+
+uint64_t ioAsyncGetSystemCallCount() {
+	return ioAsyncSystemCalls;
+}
+
 void ioAsyncCleanup() {
+	if (ioAsyncFlushThread != NULL) { //Any flush still running finishes first
+		ioAsyncFlushStop = 1;
+		SetEvent(ioAsyncFlushEvent);
+		WaitForSingleObject(ioAsyncFlushThread, INFINITE);
+		CloseHandle(ioAsyncFlushThread);
+		CloseHandle(ioAsyncFlushEvent);
+		ioAsyncFlushThread = NULL;
+		ioAsyncFlushEvent = NULL;
+	}
 	for (uint64_t i = 0; i < ASYNC_OPERATION_MAX; i++) {
 		if (ioAsyncOperations[i].hEvent != NULL) {
 			CloseHandle(ioAsyncOperations[i].hEvent);
 		}
+		for (uint64_t v = 0; v < IO_ASYNC_VECTOR_MAX - 1; v++) {
+			if (ioAsyncGatherOperations[i][v].hEvent != NULL) {
+				CloseHandle(ioAsyncGatherOperations[i][v].hEvent);
+			}
+		}
 	}
 }
 
@@ -1300,7 +1619,8 @@ int ioGetLibraryFunction(void* libraryPtr, char* functionNameUTF8, void** functi
 void ioCleanup() {
 	if (ioState == IO_STATE_SETUP) {		
 		memoryDeallocate(&ioCommandArgumentBuffer);
-		ioCommandArgumentPosition = NULL;
+		ioArgumentCount = 0;
+		ioCommandArgumentPosition = 0;
 		
 		memoryDeallocate(&ioTempBuffer);
 		ioTempBufferByteSize = 0;
@@ -1403,6 +1723,133 @@ void syncCloseEvent(void** eventPtr) {
 	*eventPtr = NULL;
 }
 
+//Wait Sets: one waitable timer (high resolution when available) for the end time
+//and the added events, all waited on with WaitForMultipleObjects
+//The signal that woke the wait gets set again so the caller's check still sees it
+//Both timers are auto reset so a timeout that fired is consumed by the wait it ended
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#define SYNC_WAIT_SET_MAX 4
+#define SYNC_WAIT_SET_EVENT_MAX (MAXIMUM_WAIT_OBJECTS - 2) //Room for the timer and an asynchronous write
+typedef struct syncWaitSetWin32 {
+	HANDLE handles[MAXIMUM_WAIT_OBJECTS]; //[0] is the timer
+	DWORD eventCount;
+	uint64_t timerArmed;
+} syncWaitSetWin32;
+static syncWaitSetWin32 syncWaitSets[SYNC_WAIT_SET_MAX];
+
+int syncCreateWaitSet(void** waitSetPtr) {
+	syncWaitSetWin32* waitSet = NULL;
+	for (uint64_t i = 0; i < SYNC_WAIT_SET_MAX; i++) {
+		if (syncWaitSets[i].handles[0] == NULL) {
+			waitSet = &(syncWaitSets[i]);
+			break;
+		}
+	}
+	if (waitSet == NULL) {
+		return ERROR_EVENT_NOT_CREATED;
+	}
+	
+	waitSet->handles[0] = CreateWaitableTimerEx(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (waitSet->handles[0] == NULL) { //Older than Windows 10 1803
+		waitSet->handles[0] = CreateWaitableTimer(NULL, FALSE, NULL);
+		if (waitSet->handles[0] == NULL) {
+			return ERROR_EVENT_NOT_CREATED;
+		}
+	}
+	waitSet->eventCount = 0;
+	waitSet->timerArmed = 0;
+	
+	*waitSetPtr = (void*) waitSet;
+	return 0;
+}
+
+int syncWaitSetAddEvent(void* waitSetPtr, void* eventPtr) {
+	syncWaitSetWin32* waitSet = (syncWaitSetWin32*) waitSetPtr;
+	if (waitSet->eventCount >= SYNC_WAIT_SET_EVENT_MAX) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	waitSet->eventCount++;
+	waitSet->handles[waitSet->eventCount] = (HANDLE) eventPtr;
+	return 0;
+}
+
+int syncWaitSetWait(void* waitSetPtr, uint64_t asyncOperation, uint64_t endTime) {
+	syncWaitSetWin32* waitSet = (syncWaitSetWin32*) waitSetPtr;
+	HANDLE* handles = &(waitSet->handles[1]);
+	DWORD handleCount = waitSet->eventCount;
+	
+	if (asyncOperation != SYNC_WAIT_NONE) {
+		if (asyncOperation >= ASYNC_OPERATION_MAX) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		//Waits on the operation's first write that is still going (the ones already done keep their signal)
+		HANDLE pendingEvent = NULL;
+		for (DWORD v = 0; v < ioAsyncEventCount[asyncOperation]; v++) {
+			HANDLE vectorEvent = ioAsyncEvents[asyncOperation][v];
+			if (WaitForSingleObject(vectorEvent, 0) == WAIT_OBJECT_0) {
+				SetEvent(vectorEvent); //Put the auto reset signal back
+			}
+			else {
+				pendingEvent = vectorEvent;
+				break;
+			}
+		}
+		if (pendingEvent == NULL) { //Every write of the operation is done
+			return 0;
+		}
+		waitSet->handles[waitSet->eventCount + 1] = pendingEvent;
+		handleCount++;
+	}
+	
+	if (endTime != SYNC_WAIT_NONE) {
+		uint64_t currentTime = getCurrentTime();
+		if (currentTime >= endTime) {
+			return 0;
+		}
+		LARGE_INTEGER dueTime; //Negative is relative in 100ns units
+		dueTime.QuadPart = -((int64_t) (((endTime - currentTime) * 10000000) / timeCounterFrequency));
+		if (dueTime.QuadPart == 0) {
+			dueTime.QuadPart = -1;
+		}
+		BOOL res = SetWaitableTimer(waitSet->handles[0], &dueTime, 0, NULL, NULL, FALSE);
+		if (res == FALSE) {
+			return ERROR_TBD;
+		}
+		waitSet->timerArmed = 1;
+		handles = waitSet->handles;
+		handleCount++;
+	}
+	else if (waitSet->timerArmed > 0) {
+		CancelWaitableTimer(waitSet->handles[0]);
+		waitSet->timerArmed = 0;
+	}
+	
+	if (handleCount == 0) {
+		return 0;
+	}
+	DWORD waitRes = WaitForMultipleObjects(handleCount, handles, FALSE, INFINITE);
+	if (waitRes >= handleCount) {
+		return ERROR_TBD;
+	}
+	if (handles[waitRes] == waitSet->handles[0]) {
+		waitSet->timerArmed = 0;
+	}
+	else {
+		SetEvent(handles[waitRes]); //Put the auto reset signal back
+	}
+	return 0;
+}
+
+void syncCloseWaitSet(void** waitSetPtr) {
+	syncWaitSetWin32* waitSet = (syncWaitSetWin32*) (*waitSetPtr);
+	CloseHandle(waitSet->handles[0]);
+	waitSet->handles[0] = NULL;
+	waitSet->eventCount = 0;
+	*waitSetPtr = NULL;
+}
+
 static DWORD WINAPI syncThreadStart(LPVOID lpParam) {
 	PFN_ThreadStart threadStart = (PFN_ThreadStart) (lpParam);
 	return (DWORD) threadStart();
@@ -1422,6 +1869,12 @@ int syncStartThread(void** threadPtr, PFN_ThreadStart threadStart, uint64_t init
 	return 0;
 }
 
+uint64_t syncGetProcessorCount() {
+	SYSTEM_INFO sSysInfo;
+	GetSystemInfo(&sSysInfo);
+	return (uint64_t) sSysInfo.dwNumberOfProcessors;
+}
+
 
 
 
@@ -552,7 +552,7 @@ int networkWaitOnSentMessages() {
 		return ERROR_NETWORK_NOT_SETUP;
 	}
 	
-	uint64_t previousSendBuffer = sendMsgBuffers;
+	uint64_t previousSendBuffer = sendMsgBuffers - 1;
 	if (networkCurrentSendBuffer > 0) {
 		previousSendBuffer = networkCurrentSendBuffer - 1;
 	}
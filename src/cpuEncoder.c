@@ -0,0 +1,776 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//Media Enhanced CPU Lossless HEVC Encoder
+//Stand in for NVENC that runs anywhere: every 32x32 coding unit is coded as
+//PCM at the full 10-bit depth (no transforms, no loop filters) so decoding
+//gives back the exact input samples
+//The only CABAC coded syntax left is part_mode (one context that always codes
+//its most probable symbol), pcm_flag and end_of_slice_segment_flag
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "encoderBackend.h" //Include Encoder Backend Function Definitions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define CPU_ENCODER_THREAD_MAX 64
+#define CPU_ENCODER_CTB_LOG2 5
+#define CPU_ENCODER_CTB_SIZE 32
+#define CPU_ENCODER_BIT_DEPTH 10
+#define CPU_ENCODER_PARAMETER_SET_BYTES 256 //Room for the VPS + SPS + PPS
+#define CPU_ENCODER_CTU_RBSP_BYTES ((CPU_ENCODER_CTB_SIZE * CPU_ENCODER_CTB_SIZE * 3 * CPU_ENCODER_BIT_DEPTH) / 8 + 16)
+#define CPU_ENCODER_POC_LSB_BITS 8
+
+#define HEVC_NAL_TRAIL_R 1
+#define HEVC_NAL_IDR_W_RADL 19
+#define HEVC_NAL_VPS 32
+#define HEVC_NAL_SPS 33
+#define HEVC_NAL_PPS 34
+
+//CABAC tables from the HEVC specification (9.3.4.3.2)
+static const uint8_t cabacRangeTabLps[64][4] = {
+	{128, 176, 208, 240}, {128, 167, 197, 227}, {128, 158, 187, 216}, {123, 150, 178, 205},
+	{116, 142, 169, 195}, {111, 135, 160, 185}, {105, 128, 152, 175}, {100, 122, 144, 166},
+	{95, 116, 137, 158}, {90, 110, 130, 150}, {85, 104, 123, 142}, {81, 99, 117, 135},
+	{77, 94, 111, 128}, {73, 89, 105, 122}, {69, 85, 100, 116}, {66, 80, 95, 110},
+	{62, 76, 90, 104}, {59, 72, 86, 99}, {56, 69, 81, 94}, {53, 65, 77, 89},
+	{51, 62, 73, 85}, {48, 59, 69, 80}, {46, 56, 66, 76}, {43, 53, 63, 72},
+	{41, 50, 59, 69}, {39, 48, 56, 65}, {37, 45, 54, 62}, {35, 43, 51, 59},
+	{33, 41, 48, 56}, {32, 39, 46, 53}, {30, 37, 43, 50}, {29, 35, 41, 48},
+	{27, 33, 39, 45}, {26, 31, 37, 43}, {24, 30, 35, 41}, {23, 28, 33, 39},
+	{22, 27, 32, 37}, {21, 26, 30, 35}, {20, 24, 29, 33}, {19, 23, 27, 31},
+	{18, 22, 26, 30}, {17, 21, 25, 28}, {16, 20, 23, 27}, {15, 19, 22, 25},
+	{14, 18, 21, 24}, {14, 17, 20, 23}, {13, 16, 19, 22}, {12, 15, 18, 21},
+	{12, 14, 17, 20}, {11, 14, 16, 19}, {11, 13, 15, 18}, {10, 12, 15, 17},
+	{10, 12, 14, 16}, {9, 11, 13, 15}, {9, 11, 12, 14}, {8, 10, 12, 14},
+	{8, 9, 11, 13}, {7, 9, 11, 12}, {7, 9, 10, 12}, {7, 8, 10, 11},
+	{6, 8, 9, 11}, {6, 7, 9, 10}, {6, 7, 8, 9}, {2, 2, 2, 2}
+};
+
+static const uint8_t cabacTransIdxLps[64] = {
+	0, 0, 1, 2, 2, 4, 4, 5, 6, 7, 8, 9, 9, 11, 11, 12,
+	13, 13, 15, 15, 16, 16, 18, 18, 19, 19, 21, 21, 22, 22, 23, 24,
+	24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 30, 30, 31, 32, 32, 33,
+	33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 37, 38, 38, 63
+};
+
+#define CABAC_INIT_PART_MODE 184 //part_mode initValue for I slices
+#define CABAC_SLICE_QP 26 //init_qp_minus26 and slice_qp_delta are both 0
+
+typedef struct cpuEncoderBitWriter {
+	uint8_t* data;
+	uint64_t bytes;
+	uint64_t accumulator;
+	uint64_t accumulatorBits;
+} cpuEncoderBitWriter;
+
+typedef struct cpuEncoderCabac {
+	uint32_t low;
+	uint32_t range;
+	int32_t bitsLeft;
+	uint32_t bufferedByte;
+	uint32_t numBufferedBytes;
+	uint8_t state; //part_mode context
+	uint8_t valMps;
+} cpuEncoderCabac;
+
+static uint16_t* cpuEncInput = NULL;
+static uint32_t cpuEncWidth = 0;
+static uint32_t cpuEncHeight = 0;
+static uint32_t cpuEncCodedWidth = 0; //Padded up to whole CTUs and cropped back with the conformance window
+static uint32_t cpuEncCodedHeight = 0;
+static uint32_t cpuEncCtbColumns = 0;
+static uint32_t cpuEncCtbRows = 0;
+static uint32_t cpuEncAddressBits = 0; //slice_segment_address length
+static uint64_t cpuEncFps = 0;
+
+static uint8_t cpuEncParameterSets[CPU_ENCODER_PARAMETER_SET_BYTES];
+static uint64_t cpuEncParameterSetBytes = 0;
+
+static uint64_t cpuEncSlotCount = 0;
+static uint64_t cpuEncSlotCapacity = 0;
+static uint8_t* cpuEncSlotData[ENCODER_SLOT_MAX];
+static uint64_t cpuEncSlotBytes[ENCODER_SLOT_MAX];
+
+//One slice per band of CTU rows (as many slices as worker threads)
+static uint64_t cpuEncSliceCount = 0;
+static uint64_t cpuEncSliceRBSPCapacity = 0;
+static uint64_t cpuEncSliceNALCapacity = 0;
+static uint8_t* cpuEncSliceRBSP = NULL;
+static uint8_t* cpuEncSliceNAL = NULL;
+static uint64_t cpuEncSliceNALBytes[CPU_ENCODER_THREAD_MAX];
+
+static uint64_t cpuEncThreadCount = 0;
+static uint64_t cpuEncThreadIndex = 0; //Handed out once to each worker as it starts
+static void* cpuEncThreadHandles[CPU_ENCODER_THREAD_MAX];
+static void* cpuEncStartEvents[CPU_ENCODER_THREAD_MAX];
+static void* cpuEncDoneEvent = NULL;
+static uint64_t cpuEncThreadExit = 0;
+
+//Current frame (only one gets encoded at a time)
+static uint64_t cpuEncBusy = 0;
+static uint64_t cpuEncJobSlot = 0;
+static uint64_t cpuEncJobIDR = 0;
+static uint64_t cpuEncPOC = 0;
+static uint64_t cpuEncNextSlice = 0;
+static uint64_t cpuEncWorkersLeft = 0;
+
+static void cpuEncoderPutBits(cpuEncoderBitWriter* writer, uint64_t value, uint64_t numBits) { //numBits <= 32
+	value &= (((uint64_t) 1) << numBits) - 1;
+	writer->accumulator = (writer->accumulator << numBits) | value;
+	writer->accumulatorBits += numBits;
+	while (writer->accumulatorBits >= 8) {
+		writer->accumulatorBits -= 8;
+		writer->data[writer->bytes] = (uint8_t) (writer->accumulator >> writer->accumulatorBits);
+		writer->bytes++;
+	}
+}
+
+static void cpuEncoderPutUnsignedExpGolomb(cpuEncoderBitWriter* writer, uint64_t value) {
+	uint64_t codeNum = value + 1;
+	uint64_t numBits = 0;
+	while ((codeNum >> numBits) > 1) {
+		numBits++;
+	}
+	cpuEncoderPutBits(writer, 0, numBits);
+	cpuEncoderPutBits(writer, codeNum, numBits + 1);
+}
+
+static void cpuEncoderPutSignedExpGolomb(cpuEncoderBitWriter* writer, int64_t value) {
+	if (value > 0) {
+		cpuEncoderPutUnsignedExpGolomb(writer, (((uint64_t) value) << 1) - 1);
+	}
+	else {
+		cpuEncoderPutUnsignedExpGolomb(writer, ((uint64_t) (-value)) << 1);
+	}
+}
+
+static uint64_t cpuEncoderByteAligned(cpuEncoderBitWriter* writer) {
+	return (writer->accumulatorBits == 0) ? 1 : 0;
+}
+
+//rbsp_trailing_bits / byte_alignment
+static void cpuEncoderPutTrailingBits(cpuEncoderBitWriter* writer) {
+	cpuEncoderPutBits(writer, 1, 1);
+	if (writer->accumulatorBits > 0) {
+		cpuEncoderPutBits(writer, 0, 8 - writer->accumulatorBits);
+	}
+}
+
+//Start code + NAL header + payload with emulation prevention bytes added
+static uint64_t cpuEncoderWriteNAL(uint8_t* nalData, uint64_t nalUnitType, uint8_t* rbspData, uint64_t rbspBytes) {
+	nalData[0] = 0;
+	nalData[1] = 0;
+	nalData[2] = 0;
+	nalData[3] = 1;
+	nalData[4] = (uint8_t) (nalUnitType << 1);
+	nalData[5] = 1; //nuh_temporal_id_plus1
+	
+	uint64_t nalBytes = 6;
+	uint64_t zeroCount = 0;
+	for (uint64_t i = 0; i < rbspBytes; i++) {
+		uint8_t byte = rbspData[i];
+		if ((zeroCount >= 2) && (byte <= 3)) {
+			nalData[nalBytes] = 3;
+			nalBytes++;
+			zeroCount = 0;
+		}
+		nalData[nalBytes] = byte;
+		nalBytes++;
+		zeroCount = (byte == 0) ? (zeroCount + 1) : 0;
+	}
+	return nalBytes;
+}
+
+static void cpuEncoderPutProfileTierLevel(cpuEncoderBitWriter* writer) {
+	uint64_t lumaSampleRate = ((uint64_t) cpuEncCodedWidth) * ((uint64_t) cpuEncCodedHeight) * cpuEncFps;
+	uint64_t levelIdc = 186; //6.2
+	if (lumaSampleRate <= 133693440) {
+		levelIdc = 123; //4.1
+	}
+	else if (lumaSampleRate <= 534773760) {
+		levelIdc = 153; //5.1
+	}
+	else if (lumaSampleRate <= 1069547520) {
+		levelIdc = 156; //5.2
+	}
+	
+	cpuEncoderPutBits(writer, 0, 2); //general_profile_space
+	cpuEncoderPutBits(writer, 0, 1); //general_tier_flag
+	cpuEncoderPutBits(writer, 4, 5); //general_profile_idc (Format Range Extensions)
+	cpuEncoderPutBits(writer, 0x08000000, 32); //general_profile_compatibility_flag[4]
+	cpuEncoderPutBits(writer, 1, 1); //general_progressive_source_flag
+	cpuEncoderPutBits(writer, 0, 1); //general_interlaced_source_flag
+	cpuEncoderPutBits(writer, 0, 1); //general_non_packed_constraint_flag
+	cpuEncoderPutBits(writer, 1, 1); //general_frame_only_constraint_flag
+	//Main 4:4:4 10: max_12bit, max_10bit, !max_8bit, !max_422chroma, !max_420chroma, !max_monochrome, !intra, !one_picture_only, lower_bit_rate
+	cpuEncoderPutBits(writer, 0b110000001, 9);
+	cpuEncoderPutBits(writer, 0, 32); //general_reserved_zero_34bits
+	cpuEncoderPutBits(writer, 0, 2);
+	cpuEncoderPutBits(writer, 0, 1); //general_inbld_flag
+	cpuEncoderPutBits(writer, levelIdc, 8); //general_level_idc
+}
+
+static uint64_t cpuEncoderWriteVPS(uint8_t* nalData, uint8_t* rbspData) {
+	cpuEncoderBitWriter writer = {rbspData, 0, 0, 0};
+	cpuEncoderPutBits(&writer, 0, 4); //vps_video_parameter_set_id
+	cpuEncoderPutBits(&writer, 1, 1); //vps_base_layer_internal_flag
+	cpuEncoderPutBits(&writer, 1, 1); //vps_base_layer_available_flag
+	cpuEncoderPutBits(&writer, 0, 6); //vps_max_layers_minus1
+	cpuEncoderPutBits(&writer, 0, 3); //vps_max_sub_layers_minus1
+	cpuEncoderPutBits(&writer, 1, 1); //vps_temporal_id_nesting_flag
+	cpuEncoderPutBits(&writer, 0xFFFF, 16); //vps_reserved_0xffff_16bits
+	cpuEncoderPutProfileTierLevel(&writer);
+	cpuEncoderPutBits(&writer, 1, 1); //vps_sub_layer_ordering_info_present_flag
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //vps_max_dec_pic_buffering_minus1
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //vps_max_num_reorder_pics
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //vps_max_latency_increase_plus1
+	cpuEncoderPutBits(&writer, 0, 6); //vps_max_layer_id
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //vps_num_layer_sets_minus1
+	cpuEncoderPutBits(&writer, 0, 1); //vps_timing_info_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //vps_extension_flag
+	cpuEncoderPutTrailingBits(&writer);
+	return cpuEncoderWriteNAL(nalData, HEVC_NAL_VPS, rbspData, writer.bytes);
+}
+
+static uint64_t cpuEncoderWriteSPS(uint8_t* nalData, uint8_t* rbspData) {
+	cpuEncoderBitWriter writer = {rbspData, 0, 0, 0};
+	cpuEncoderPutBits(&writer, 0, 4); //sps_video_parameter_set_id
+	cpuEncoderPutBits(&writer, 0, 3); //sps_max_sub_layers_minus1
+	cpuEncoderPutBits(&writer, 1, 1); //sps_temporal_id_nesting_flag
+	cpuEncoderPutProfileTierLevel(&writer);
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //sps_seq_parameter_set_id
+	cpuEncoderPutUnsignedExpGolomb(&writer, 3); //chroma_format_idc (4:4:4)
+	cpuEncoderPutBits(&writer, 0, 1); //separate_colour_plane_flag
+	cpuEncoderPutUnsignedExpGolomb(&writer, cpuEncCodedWidth); //pic_width_in_luma_samples
+	cpuEncoderPutUnsignedExpGolomb(&writer, cpuEncCodedHeight); //pic_height_in_luma_samples
+	if ((cpuEncCodedWidth != cpuEncWidth) || (cpuEncCodedHeight != cpuEncHeight)) {
+		cpuEncoderPutBits(&writer, 1, 1); //conformance_window_flag (4:4:4 so offsets are in luma samples)
+		cpuEncoderPutUnsignedExpGolomb(&writer, 0);
+		cpuEncoderPutUnsignedExpGolomb(&writer, cpuEncCodedWidth - cpuEncWidth);
+		cpuEncoderPutUnsignedExpGolomb(&writer, 0);
+		cpuEncoderPutUnsignedExpGolomb(&writer, cpuEncCodedHeight - cpuEncHeight);
+	}
+	else {
+		cpuEncoderPutBits(&writer, 0, 1);
+	}
+	cpuEncoderPutUnsignedExpGolomb(&writer, CPU_ENCODER_BIT_DEPTH - 8); //bit_depth_luma_minus8
+	cpuEncoderPutUnsignedExpGolomb(&writer, CPU_ENCODER_BIT_DEPTH - 8); //bit_depth_chroma_minus8
+	cpuEncoderPutUnsignedExpGolomb(&writer, CPU_ENCODER_POC_LSB_BITS - 4); //log2_max_pic_order_cnt_lsb_minus4
+	cpuEncoderPutBits(&writer, 1, 1); //sps_sub_layer_ordering_info_present_flag
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //sps_max_dec_pic_buffering_minus1 (intra only)
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //sps_max_num_reorder_pics
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //sps_max_latency_increase_plus1
+	cpuEncoderPutUnsignedExpGolomb(&writer, CPU_ENCODER_CTB_LOG2 - 3); //log2_min_luma_coding_block_size_minus3 (so no split flags)
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //log2_diff_max_min_luma_coding_block_size
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //log2_min_luma_transform_block_size_minus2
+	cpuEncoderPutUnsignedExpGolomb(&writer, 3); //log2_diff_max_min_luma_transform_block_size
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //max_transform_hierarchy_depth_inter
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //max_transform_hierarchy_depth_intra
+	cpuEncoderPutBits(&writer, 0, 1); //scaling_list_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //amp_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //sample_adaptive_offset_enabled_flag
+	cpuEncoderPutBits(&writer, 1, 1); //pcm_enabled_flag
+	cpuEncoderPutBits(&writer, CPU_ENCODER_BIT_DEPTH - 1, 4); //pcm_sample_bit_depth_luma_minus1
+	cpuEncoderPutBits(&writer, CPU_ENCODER_BIT_DEPTH - 1, 4); //pcm_sample_bit_depth_chroma_minus1
+	cpuEncoderPutUnsignedExpGolomb(&writer, CPU_ENCODER_CTB_LOG2 - 3); //log2_min_pcm_luma_coding_block_size_minus3
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //log2_diff_max_min_pcm_luma_coding_block_size
+	cpuEncoderPutBits(&writer, 1, 1); //pcm_loop_filter_disabled_flag
+	cpuEncoderPutUnsignedExpGolomb(&writer, 1); //num_short_term_ref_pic_sets
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //num_negative_pics (empty set for the non-IDR intra frames)
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //num_positive_pics
+	cpuEncoderPutBits(&writer, 0, 1); //long_term_ref_pics_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //sps_temporal_mvp_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //strong_intra_smoothing_enabled_flag
+	
+	//VUI matches what the recorder asks NVENC for
+	cpuEncoderPutBits(&writer, 1, 1); //vui_parameters_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //aspect_ratio_info_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //overscan_info_present_flag
+	cpuEncoderPutBits(&writer, 1, 1); //video_signal_type_present_flag
+	cpuEncoderPutBits(&writer, 0, 3); //video_format (component)
+	cpuEncoderPutBits(&writer, 1, 1); //video_full_range_flag
+	cpuEncoderPutBits(&writer, 1, 1); //colour_description_present_flag
+	cpuEncoderPutBits(&writer, 1, 8); //colour_primaries (BT.709)
+	cpuEncoderPutBits(&writer, 1, 8); //transfer_characteristics (BT.709)
+	cpuEncoderPutBits(&writer, 1, 8); //matrix_coeffs (BT.709)
+	cpuEncoderPutBits(&writer, 0, 1); //chroma_loc_info_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //neutral_chroma_indication_flag
+	cpuEncoderPutBits(&writer, 0, 1); //field_seq_flag
+	cpuEncoderPutBits(&writer, 0, 1); //frame_field_info_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //default_display_window_flag
+	cpuEncoderPutBits(&writer, 1, 1); //vui_timing_info_present_flag
+	cpuEncoderPutBits(&writer, 1, 32); //vui_num_units_in_tick
+	cpuEncoderPutBits(&writer, cpuEncFps, 32); //vui_time_scale
+	cpuEncoderPutBits(&writer, 0, 1); //vui_poc_proportional_to_timing_flag
+	cpuEncoderPutBits(&writer, 0, 1); //vui_hrd_parameters_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //bitstream_restriction_flag
+	
+	cpuEncoderPutBits(&writer, 0, 1); //sps_extension_present_flag
+	cpuEncoderPutTrailingBits(&writer);
+	return cpuEncoderWriteNAL(nalData, HEVC_NAL_SPS, rbspData, writer.bytes);
+}
+
+static uint64_t cpuEncoderWritePPS(uint8_t* nalData, uint8_t* rbspData) {
+	cpuEncoderBitWriter writer = {rbspData, 0, 0, 0};
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //pps_pic_parameter_set_id
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //pps_seq_parameter_set_id
+	cpuEncoderPutBits(&writer, 0, 1); //dependent_slice_segments_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //output_flag_present_flag
+	cpuEncoderPutBits(&writer, 0, 3); //num_extra_slice_header_bits
+	cpuEncoderPutBits(&writer, 0, 1); //sign_data_hiding_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //cabac_init_present_flag
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //num_ref_idx_l0_default_active_minus1
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //num_ref_idx_l1_default_active_minus1
+	cpuEncoderPutSignedExpGolomb(&writer, CABAC_SLICE_QP - 26); //init_qp_minus26
+	cpuEncoderPutBits(&writer, 0, 1); //constrained_intra_pred_flag
+	cpuEncoderPutBits(&writer, 0, 1); //transform_skip_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //cu_qp_delta_enabled_flag
+	cpuEncoderPutSignedExpGolomb(&writer, 0); //pps_cb_qp_offset
+	cpuEncoderPutSignedExpGolomb(&writer, 0); //pps_cr_qp_offset
+	cpuEncoderPutBits(&writer, 0, 1); //pps_slice_chroma_qp_offsets_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //weighted_pred_flag
+	cpuEncoderPutBits(&writer, 0, 1); //weighted_bipred_flag
+	cpuEncoderPutBits(&writer, 0, 1); //transquant_bypass_enabled_flag (PCM is already lossless)
+	cpuEncoderPutBits(&writer, 0, 1); //tiles_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //entropy_coding_sync_enabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //pps_loop_filter_across_slices_enabled_flag
+	cpuEncoderPutBits(&writer, 1, 1); //deblocking_filter_control_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //deblocking_filter_override_enabled_flag
+	cpuEncoderPutBits(&writer, 1, 1); //pps_deblocking_filter_disabled_flag
+	cpuEncoderPutBits(&writer, 0, 1); //pps_scaling_list_data_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //lists_modification_present_flag
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //log2_parallel_merge_level_minus2
+	cpuEncoderPutBits(&writer, 0, 1); //slice_segment_header_extension_present_flag
+	cpuEncoderPutBits(&writer, 0, 1); //pps_extension_present_flag
+	cpuEncoderPutTrailingBits(&writer);
+	return cpuEncoderWriteNAL(nalData, HEVC_NAL_PPS, rbspData, writer.bytes);
+}
+
+static void cpuEncoderCabacStart(cpuEncoderCabac* cabac) {
+	cabac->low = 0;
+	cabac->range = 510;
+	cabac->bitsLeft = 23;
+	cabac->bufferedByte = 0xFF;
+	cabac->numBufferedBytes = 0;
+}
+
+static void cpuEncoderCabacInitContext(cpuEncoderCabac* cabac, int32_t initValue, int32_t sliceQp) {
+	int32_t slope = ((initValue >> 4) * 5) - 45;
+	int32_t offset = ((initValue & 15) << 3) - 16;
+	int32_t preCtxState = ((slope * sliceQp) >> 4) + offset;
+	if (preCtxState < 1) {
+		preCtxState = 1;
+	}
+	else if (preCtxState > 126) {
+		preCtxState = 126;
+	}
+	if (preCtxState <= 63) {
+		cabac->state = (uint8_t) (63 - preCtxState);
+		cabac->valMps = 0;
+	}
+	else {
+		cabac->state = (uint8_t) (preCtxState - 64);
+		cabac->valMps = 1;
+	}
+}
+
+static void cpuEncoderCabacWriteOut(cpuEncoderCabac* cabac, cpuEncoderBitWriter* writer) {
+	uint32_t leadByte = cabac->low >> (24 - cabac->bitsLeft);
+	cabac->bitsLeft += 8;
+	cabac->low &= 0xFFFFFFFF >> cabac->bitsLeft;
+	if (leadByte == 0xFF) {
+		cabac->numBufferedBytes++;
+	}
+	else if (cabac->numBufferedBytes > 0) {
+		uint32_t carry = leadByte >> 8;
+		cpuEncoderPutBits(writer, cabac->bufferedByte + carry, 8);
+		cabac->bufferedByte = leadByte & 0xFF;
+		uint32_t byte = (0xFF + carry) & 0xFF;
+		while (cabac->numBufferedBytes > 1) {
+			cpuEncoderPutBits(writer, byte, 8);
+			cabac->numBufferedBytes--;
+		}
+	}
+	else {
+		cabac->numBufferedBytes = 1;
+		cabac->bufferedByte = leadByte;
+	}
+}
+
+static void cpuEncoderCabacEncodeBin(cpuEncoderCabac* cabac, cpuEncoderBitWriter* writer, uint32_t binValue) {
+	uint32_t lps = cabacRangeTabLps[cabac->state][(cabac->range >> 6) & 3];
+	cabac->range -= lps;
+	if (binValue != cabac->valMps) {
+		int32_t numBits = 0;
+		while ((lps << numBits) < 256) {
+			numBits++;
+		}
+		cabac->low = (cabac->low + cabac->range) << numBits;
+		cabac->range = lps << numBits;
+		if (cabac->state == 0) {
+			cabac->valMps = 1 - cabac->valMps;
+		}
+		cabac->state = cabacTransIdxLps[cabac->state];
+		cabac->bitsLeft -= numBits;
+	}
+	else {
+		if (cabac->state < 62) {
+			cabac->state++;
+		}
+		if (cabac->range >= 256) {
+			return;
+		}
+		cabac->low <<= 1;
+		cabac->range <<= 1;
+		cabac->bitsLeft--;
+	}
+	if (cabac->bitsLeft < 12) {
+		cpuEncoderCabacWriteOut(cabac, writer);
+	}
+}
+
+static void cpuEncoderCabacEncodeTerminate(cpuEncoderCabac* cabac, cpuEncoderBitWriter* writer, uint32_t binValue) {
+	cabac->range -= 2;
+	if (binValue > 0) {
+		cabac->low += cabac->range;
+		cabac->low <<= 7;
+		cabac->range = 2 << 7;
+		cabac->bitsLeft -= 7;
+	}
+	else if (cabac->range >= 256) {
+		return;
+	}
+	else {
+		cabac->low <<= 1;
+		cabac->range <<= 1;
+		cabac->bitsLeft--;
+	}
+	if (cabac->bitsLeft < 12) {
+		cpuEncoderCabacWriteOut(cabac, writer);
+	}
+}
+
+//Flush after a terminating bin of 1 (the final 1 bit comes from the caller's trailing bits)
+static void cpuEncoderCabacFinish(cpuEncoderCabac* cabac, cpuEncoderBitWriter* writer) {
+	if ((cabac->low >> (32 - cabac->bitsLeft)) > 0) {
+		cpuEncoderPutBits(writer, cabac->bufferedByte + 1, 8);
+		while (cabac->numBufferedBytes > 1) {
+			cpuEncoderPutBits(writer, 0x00, 8);
+			cabac->numBufferedBytes--;
+		}
+		cabac->low -= 1 << (32 - cabac->bitsLeft);
+	}
+	else {
+		if (cabac->numBufferedBytes > 0) {
+			cpuEncoderPutBits(writer, cabac->bufferedByte, 8);
+		}
+		while (cabac->numBufferedBytes > 1) {
+			cpuEncoderPutBits(writer, 0xFF, 8);
+			cabac->numBufferedBytes--;
+		}
+	}
+	cpuEncoderPutBits(writer, cabac->low >> 8, 24 - cabac->bitsLeft);
+}
+
+//pcm_sample() for one CTU sized block of one plane (samples past the picture edge repeat the last row / column)
+static void cpuEncoderPutPCMBlock(cpuEncoderBitWriter* writer, uint16_t* plane, uint32_t ctbX, uint32_t ctbY) {
+	uint32_t x0 = ctbX * CPU_ENCODER_CTB_SIZE;
+	uint32_t y0 = ctbY * CPU_ENCODER_CTB_SIZE;
+	for (uint32_t y = y0; y < (y0 + CPU_ENCODER_CTB_SIZE); y++) {
+		uint32_t rowY = (y < cpuEncHeight) ? y : (cpuEncHeight - 1);
+		uint16_t* row = &(plane[((uint64_t) rowY) * cpuEncWidth]);
+		if ((x0 + CPU_ENCODER_CTB_SIZE) <= cpuEncWidth) {
+			for (uint32_t x = x0; x < (x0 + CPU_ENCODER_CTB_SIZE); x += 2) { //Two 10-bit samples at a time
+				cpuEncoderPutBits(writer, (((uint64_t) (row[x] >> 6)) << 10) | (row[x + 1] >> 6), 20);
+			}
+		}
+		else {
+			for (uint32_t x = x0; x < (x0 + CPU_ENCODER_CTB_SIZE); x++) {
+				uint32_t columnX = (x < cpuEncWidth) ? x : (cpuEncWidth - 1);
+				cpuEncoderPutBits(writer, row[columnX] >> 6, 10);
+			}
+		}
+	}
+}
+
+//Slice header + slice data for the CTU rows of one slice, returns the NAL size
+static uint64_t cpuEncoderEncodeSlice(uint64_t slice, uint8_t* nalData, uint8_t* rbspData) {
+	uint32_t firstRow = (uint32_t) ((slice * cpuEncCtbRows) / cpuEncSliceCount);
+	uint32_t endRow = (uint32_t) (((slice + 1) * cpuEncCtbRows) / cpuEncSliceCount);
+	uint64_t planeSamples = ((uint64_t) cpuEncWidth) * ((uint64_t) cpuEncHeight);
+	cpuEncoderBitWriter writer = {rbspData, 0, 0, 0};
+	
+	//Slice Segment Header
+	cpuEncoderPutBits(&writer, (slice == 0) ? 1 : 0, 1); //first_slice_segment_in_pic_flag
+	if (cpuEncJobIDR > 0) {
+		cpuEncoderPutBits(&writer, 0, 1); //no_output_of_prior_pics_flag
+	}
+	cpuEncoderPutUnsignedExpGolomb(&writer, 0); //slice_pic_parameter_set_id
+	if (slice > 0) {
+		cpuEncoderPutBits(&writer, firstRow * cpuEncCtbColumns, cpuEncAddressBits); //slice_segment_address
+	}
+	cpuEncoderPutUnsignedExpGolomb(&writer, 2); //slice_type (I)
+	if (cpuEncJobIDR == 0) {
+		cpuEncoderPutBits(&writer, cpuEncPOC, CPU_ENCODER_POC_LSB_BITS); //slice_pic_order_cnt_lsb
+		cpuEncoderPutBits(&writer, 1, 1); //short_term_ref_pic_set_sps_flag (the empty set)
+	}
+	cpuEncoderPutSignedExpGolomb(&writer, 0); //slice_qp_delta
+	cpuEncoderPutTrailingBits(&writer); //byte_alignment()
+	
+	//Slice Segment Data
+	cpuEncoderCabac cabac;
+	cpuEncoderCabacStart(&cabac);
+	cpuEncoderCabacInitContext(&cabac, CABAC_INIT_PART_MODE, CABAC_SLICE_QP);
+	for (uint32_t ctbY = firstRow; ctbY < endRow; ctbY++) {
+		for (uint32_t ctbX = 0; ctbX < cpuEncCtbColumns; ctbX++) {
+			cpuEncoderCabacEncodeBin(&cabac, &writer, 1); //part_mode (PART_2Nx2N)
+			cpuEncoderCabacEncodeTerminate(&cabac, &writer, 1); //pcm_flag
+			cpuEncoderCabacFinish(&cabac, &writer);
+			cpuEncoderPutBits(&writer, 1, 1);
+			while (cpuEncoderByteAligned(&writer) == 0) {
+				cpuEncoderPutBits(&writer, 0, 1); //pcm_alignment_zero_bit
+			}
+			cpuEncoderPutPCMBlock(&writer, cpuEncInput, ctbX, ctbY);
+			cpuEncoderPutPCMBlock(&writer, &(cpuEncInput[planeSamples]), ctbX, ctbY);
+			cpuEncoderPutPCMBlock(&writer, &(cpuEncInput[planeSamples << 1]), ctbX, ctbY);
+			cpuEncoderCabacStart(&cabac); //Arithmetic coder restarts after PCM samples (contexts stay)
+			
+			uint32_t endOfSlice = ((ctbY == (endRow - 1)) && (ctbX == (cpuEncCtbColumns - 1))) ? 1 : 0;
+			cpuEncoderCabacEncodeTerminate(&cabac, &writer, endOfSlice); //end_of_slice_segment_flag
+		}
+	}
+	cpuEncoderCabacFinish(&cabac, &writer);
+	cpuEncoderPutTrailingBits(&writer); //rbsp_slice_segment_trailing_bits
+	
+	return cpuEncoderWriteNAL(nalData, (cpuEncJobIDR > 0) ? HEVC_NAL_IDR_W_RADL : HEVC_NAL_TRAIL_R, rbspData, writer.bytes);
+}
+
+static int cpuEncoderThread() {
+	uint64_t index = __atomic_fetch_add(&cpuEncThreadIndex, 1, __ATOMIC_ACQ_REL);
+	while (1) {
+		int error = syncEventWait(cpuEncStartEvents[index]);
+		RETURN_ON_ERROR(error);
+		if (cpuEncThreadExit > 0) { //The last one out lets the cleanup close the events
+			if (__atomic_sub_fetch(&cpuEncWorkersLeft, 1, __ATOMIC_ACQ_REL) == 0) {
+				return syncSetEvent(cpuEncDoneEvent);
+			}
+			return 0;
+		}
+		
+		uint64_t slice = __atomic_fetch_add(&cpuEncNextSlice, 1, __ATOMIC_ACQ_REL);
+		while (slice < cpuEncSliceCount) {
+			cpuEncSliceNALBytes[slice] = cpuEncoderEncodeSlice(slice, &(cpuEncSliceNAL[slice * cpuEncSliceNALCapacity]), &(cpuEncSliceRBSP[slice * cpuEncSliceRBSPCapacity]));
+			slice = __atomic_fetch_add(&cpuEncNextSlice, 1, __ATOMIC_ACQ_REL);
+		}
+		
+		//Last worker to finish puts the access unit together
+		if (__atomic_sub_fetch(&cpuEncWorkersLeft, 1, __ATOMIC_ACQ_REL) == 0) {
+			uint8_t* slotData = &(cpuEncSlotData[cpuEncJobSlot][ENCODER_HEADER_ROOM_BYTES]);
+			uint64_t slotBytes = 0;
+			if (cpuEncJobIDR > 0) {
+				memcpyBasic(slotData, cpuEncParameterSets, cpuEncParameterSetBytes);
+				slotBytes = cpuEncParameterSetBytes;
+			}
+			for (uint64_t s = 0; s < cpuEncSliceCount; s++) {
+				memcpyBasic(&(slotData[slotBytes]), &(cpuEncSliceNAL[s * cpuEncSliceNALCapacity]), cpuEncSliceNALBytes[s]);
+				slotBytes += cpuEncSliceNALBytes[s];
+			}
+			cpuEncSlotBytes[cpuEncJobSlot] = slotBytes;
+			
+			error = syncSetEvent(cpuEncDoneEvent);
+			RETURN_ON_ERROR(error);
+		}
+	}
+	return 0;
+}
+
+static int cpuEncoderEncodeFrame(uint64_t slot, uint64_t forceIDR) {
+	if ((cpuEncBusy > 0) || (slot >= cpuEncSlotCount)) {
+		return ERROR_ENCODER_WRONG_STATE;
+	}
+	
+	if (forceIDR > 0) {
+		cpuEncPOC = 0;
+	}
+	else {
+		cpuEncPOC = (cpuEncPOC + 1) & ((1 << CPU_ENCODER_POC_LSB_BITS) - 1);
+	}
+	cpuEncJobSlot = slot;
+	cpuEncJobIDR = forceIDR;
+	cpuEncNextSlice = 0;
+	cpuEncWorkersLeft = cpuEncThreadCount;
+	cpuEncBusy = 1;
+	
+	for (uint64_t t = 0; t < cpuEncThreadCount; t++) {
+		int error = syncSetEvent(cpuEncStartEvents[t]);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+static int cpuEncoderLockBitstream(uint64_t slot, uint8_t** bitstreamPtr, uint64_t* bitstreamBytes) {
+	if ((cpuEncBusy == 0) || (slot != cpuEncJobSlot)) {
+		return ERROR_ENCODER_WRONG_STATE;
+	}
+	int error = syncEventWait(cpuEncDoneEvent);
+	RETURN_ON_ERROR(error);
+	cpuEncBusy = 0;
+	
+	*bitstreamPtr = &(cpuEncSlotData[slot][ENCODER_HEADER_ROOM_BYTES]);
+	*bitstreamBytes = cpuEncSlotBytes[slot];
+	return 0;
+}
+
+static int cpuEncoderUnlockBitstream(uint64_t slot) {
+	if (slot >= cpuEncSlotCount) {
+		return ERROR_ENCODER_WRONG_STATE;
+	}
+	return 0; //Nothing to give back (the slot buffer only gets reused by the next encode into it)
+}
+
+static void cpuEncoderCleanup() {
+	if (cpuEncThreadCount > 0) {
+		if (cpuEncBusy > 0) { //Frame never got locked so let the workers finish it first
+			syncEventWait(cpuEncDoneEvent);
+			cpuEncBusy = 0;
+		}
+		cpuEncThreadExit = 1;
+		cpuEncWorkersLeft = cpuEncThreadCount;
+		for (uint64_t t = 0; t < cpuEncThreadCount; t++) {
+			syncSetEvent(cpuEncStartEvents[t]);
+		}
+		syncEventWait(cpuEncDoneEvent);
+		for (uint64_t t = 0; t < cpuEncThreadCount; t++) {
+			syncCloseEvent(&(cpuEncStartEvents[t]));
+			cpuEncThreadHandles[t] = NULL;
+		}
+	}
+	cpuEncThreadCount = 0;
+	cpuEncThreadIndex = 0;
+	if (cpuEncDoneEvent != NULL) {
+		syncCloseEvent(&cpuEncDoneEvent);
+	}
+	
+	for (uint64_t s = 0; s < ENCODER_SLOT_MAX; s++) {
+		if (cpuEncSlotData[s] != NULL) {
+			memoryDeallocate((void**) &(cpuEncSlotData[s]));
+		}
+		cpuEncSlotBytes[s] = 0;
+	}
+	cpuEncSlotCount = 0;
+	cpuEncSlotCapacity = 0;
+	if (cpuEncSliceRBSP != NULL) {
+		memoryDeallocate((void**) &cpuEncSliceRBSP);
+	}
+	if (cpuEncSliceNAL != NULL) {
+		memoryDeallocate((void**) &cpuEncSliceNAL);
+	}
+	cpuEncSliceCount = 0;
+	cpuEncSliceRBSPCapacity = 0;
+	cpuEncSliceNALCapacity = 0;
+	cpuEncParameterSetBytes = 0;
+	cpuEncWorkersLeft = 0;
+	cpuEncNextSlice = 0;
+	cpuEncPOC = 0;
+	cpuEncThreadExit = 0;
+}
+
+int encoderSetupCPU(encoderBackend* encoder, uint16_t* inputPlanes, uint32_t width, uint32_t height, uint64_t fps, uint64_t slotCount, uint64_t threadCount) {
+	if ((width == 0) || (height == 0) || (fps == 0)) {
+		return ERROR_ENCODER_BAD_DIMENSIONS;
+	}
+	if ((slotCount == 0) || (slotCount > ENCODER_SLOT_MAX) || (threadCount == 0) || (cpuEncThreadCount > 0)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	cpuEncInput = inputPlanes;
+	cpuEncWidth = width;
+	cpuEncHeight = height;
+	cpuEncFps = fps;
+	cpuEncCtbColumns = (width + CPU_ENCODER_CTB_SIZE - 1) / CPU_ENCODER_CTB_SIZE;
+	cpuEncCtbRows = (height + CPU_ENCODER_CTB_SIZE - 1) / CPU_ENCODER_CTB_SIZE;
+	cpuEncCodedWidth = cpuEncCtbColumns * CPU_ENCODER_CTB_SIZE;
+	cpuEncCodedHeight = cpuEncCtbRows * CPU_ENCODER_CTB_SIZE;
+	cpuEncAddressBits = 0;
+	while ((((uint64_t) 1) << cpuEncAddressBits) < (((uint64_t) cpuEncCtbColumns) * cpuEncCtbRows)) {
+		cpuEncAddressBits++;
+	}
+	
+	if (threadCount > CPU_ENCODER_THREAD_MAX) {
+		threadCount = CPU_ENCODER_THREAD_MAX;
+	}
+	if (threadCount > cpuEncCtbRows) {
+		threadCount = cpuEncCtbRows;
+	}
+	cpuEncSliceCount = threadCount;
+	
+	//Worst case sizes: every CTU at full PCM size and an emulation prevention byte for every two payload bytes
+	uint64_t maxSliceCtbs = ((cpuEncCtbRows + cpuEncSliceCount - 1) / cpuEncSliceCount) * cpuEncCtbColumns;
+	cpuEncSliceRBSPCapacity = 64 + (maxSliceCtbs * CPU_ENCODER_CTU_RBSP_BYTES);
+	cpuEncSliceNALCapacity = 6 + ((cpuEncSliceRBSPCapacity * 3) >> 1);
+	cpuEncSlotCapacity = ENCODER_HEADER_ROOM_BYTES + CPU_ENCODER_PARAMETER_SET_BYTES + (cpuEncSliceCount * cpuEncSliceNALCapacity);
+	
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, cpuEncSliceCount * cpuEncSliceRBSPCapacity, 0);
+	RETURN_ON_ERROR(error);
+	cpuEncSliceRBSP = (uint8_t*) memAlloc;
+	error = memoryAllocate(&memAlloc, cpuEncSliceCount * cpuEncSliceNALCapacity, 0);
+	RETURN_ON_ERROR(error);
+	cpuEncSliceNAL = (uint8_t*) memAlloc;
+	for (uint64_t s = 0; s < slotCount; s++) {
+		error = memoryAllocate(&memAlloc, cpuEncSlotCapacity, 0);
+		RETURN_ON_ERROR(error);
+		cpuEncSlotData[s] = (uint8_t*) memAlloc;
+		cpuEncSlotBytes[s] = 0;
+	}
+	cpuEncSlotCount = slotCount;
+	
+	//Parameter sets go in front of every IDR (same as the NVENC output)
+	cpuEncParameterSetBytes = cpuEncoderWriteVPS(cpuEncParameterSets, cpuEncSliceRBSP);
+	cpuEncParameterSetBytes += cpuEncoderWriteSPS(&(cpuEncParameterSets[cpuEncParameterSetBytes]), cpuEncSliceRBSP);
+	cpuEncParameterSetBytes += cpuEncoderWritePPS(&(cpuEncParameterSets[cpuEncParameterSetBytes]), cpuEncSliceRBSP);
+	
+	error = syncCreateEvent(&cpuEncDoneEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	cpuEncThreadExit = 0;
+	cpuEncThreadIndex = 0;
+	cpuEncBusy = 0;
+	cpuEncPOC = 0;
+	for (uint64_t t = 0; t < threadCount; t++) {
+		error = syncCreateEvent(&(cpuEncStartEvents[t]), 0, 0);
+		RETURN_ON_ERROR(error);
+	}
+	for (uint64_t t = 0; t < threadCount; t++) {
+		PFN_ThreadStart threadStart = cpuEncoderThread;
+		error = syncStartThread(&(cpuEncThreadHandles[t]), threadStart, 0);
+		RETURN_ON_ERROR(error);
+	}
+	cpuEncThreadCount = threadCount;
+	
+	encoder->encodeFrame = cpuEncoderEncodeFrame;
+	encoder->lockBitstream = cpuEncoderLockBitstream;
+	encoder->unlockBitstream = cpuEncoderUnlockBitstream;
+	encoder->cleanup = cpuEncoderCleanup;
+	encoder->slotCount = slotCount;
+	return 0;
+}
@@ -0,0 +1,65 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//Media Enhanced Encoder Backend Definitions
+//An encoder backend turns the compute stage output (three R16 planes with the
+//10-bit samples in the upper bits: Y, Cb, Cr stacked at 0, height, 2 * height)
+//into one HEVC access unit per output ring slot the same way NVENC does
+//(start encode -> lock bitstream (waits) -> write -> unlock)
+#ifndef MEDIA_ENHANCED_ENCODER_BACKEND_H
+#define MEDIA_ENHANCED_ENCODER_BACKEND_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+#define ENCODER_SLOT_MAX 32 //Same limit as the recorder's output ring
+#define ENCODER_HEADER_ROOM_BYTES 16 //Writable bytes right before every locked access unit (the reserved NAL goes there so a frame is one contiguous write)
+
+//forceIDR Values
+#define ENCODER_FORCE_INTRA 1 //Periodic refresh point
+#define ENCODER_FORCE_IDR 2 //IDR with its own parameter sets (so the bitstream can be cut there)
+
+#define ERROR_ENCODER_WRONG_STATE 0x5100
+#define ERROR_ENCODER_BAD_DIMENSIONS 0x5101
+#define ERROR_ENCODER_BITSTREAM_TOO_BIG 0x5102 //Access unit does not fit the slot's buffer
+
+typedef int (*PFN_EncoderEncodeFrame)(uint64_t slot, uint64_t forceIDR);
+typedef int (*PFN_EncoderLockBitstream)(uint64_t slot, uint8_t** bitstreamPtr, uint64_t* bitstreamBytes);
+typedef int (*PFN_EncoderUnlockBitstream)(uint64_t slot);
+typedef void (*PFN_EncoderCleanup)();
+
+typedef struct encoderBackend {
+	PFN_EncoderEncodeFrame encodeFrame; //Starts encoding the current input into the slot (returns right away)
+	PFN_EncoderLockBitstream lockBitstream; //Waits for the slot's encode and hands back its access unit
+	PFN_EncoderUnlockBitstream unlockBitstream; //Slot can be encoded into again
+	PFN_EncoderCleanup cleanup;
+	uint64_t slotCount;
+} encoderBackend;
+
+//CPU Lossless HEVC Encoder (Main 4:4:4 10 RExt profile, intra only)
+//Every 32x32 coding unit is sent as PCM samples at the full 10-bit depth so the
+//output is lossless without needing transforms, and each frame gets split into
+//one slice per band of CTU rows that the worker threads encode in parallel
+//Only one frame is encoded at a time (the input planes must stay untouched
+//until that frame's bitstream gets locked)
+int encoderSetupCPU(encoderBackend* encoder, uint16_t* inputPlanes, uint32_t width, uint32_t height, uint64_t fps, uint64_t slotCount, uint64_t threadCount);
+
+#endif
@@ -0,0 +1,288 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//Media Enhanced Frame Source Functions
+//CPU frame sources that stand in for Desktop Duplication so the capture
+//pipeline can be driven (and timed) on machines without a desktop or GPU
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "frameSource.h" //Include Frame Source Function Definitions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define FRAME_SOURCE_READ_CHUNK_BYTES 1073741824
+#define FRAME_SOURCE_GLYPH_WIDTH 8
+#define FRAME_SOURCE_GLYPH_HEIGHT 16
+#define FRAME_SOURCE_SCROLL_ROWS 2 //Rows of pixels the text moves up per present
+#define FRAME_SOURCE_BACKGROUND 0xFFFFFFFF
+#define FRAME_SOURCE_FOREGROUND 0xFF202020
+
+static uint64_t sourcePattern = 0;
+static uint32_t sourceWidth = 0;
+static uint32_t sourceHeight = 0;
+static uint64_t sourceFrameBytes = 0;
+static uint8_t* sourceFrameData = NULL; //Drawn frame for the synthetic patterns
+static uint8_t* sourceReplayData = NULL;
+static uint64_t sourceReplayFrames = 0;
+static frameSource* sourcePtr = NULL;
+static void* sourceWaitSet = NULL; //Empty Wait Set only used to sleep until a present / timeout
+
+static uint64_t sourceStartTime = 0;
+static uint64_t sourcePresentInterval = 0;
+static uint64_t sourceJitterTime = 0;
+static uint64_t sourceNextPresent = 0; //First present that has not been acquired yet
+static uint64_t sourceAcquired = 0;
+
+//SplitMix64 so the jitter and patterns are random looking but repeatable between runs
+static uint64_t frameSourceHash(uint64_t x) {
+	x += 0x9E3779B97F4A7C15;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+	return x ^ (x >> 31);
+}
+
+static uint64_t frameSourcePresentTime(uint64_t present) {
+	uint64_t presentTime = sourceStartTime + (present * sourcePresentInterval);
+	if (sourceJitterTime > 0) {
+		presentTime += frameSourceHash(present) % (sourceJitterTime + 1);
+	}
+	return presentTime;
+}
+
+static void frameSourceDrawScrollText(uint64_t present) {
+	uint32_t* pixels = (uint32_t*) sourceFrameData;
+	uint64_t cellsPerLine = sourceWidth / FRAME_SOURCE_GLYPH_WIDTH;
+	uint64_t scroll = present * FRAME_SOURCE_SCROLL_ROWS;
+	
+	for (uint64_t y = 0; y < sourceHeight; y++) {
+		uint32_t* pixelRow = &(pixels[y * sourceWidth]);
+		uint64_t textY = y + scroll;
+		uint64_t textLine = textY / FRAME_SOURCE_GLYPH_HEIGHT;
+		uint64_t glyphRow = (textY % FRAME_SOURCE_GLYPH_HEIGHT) >> 1; //8 bits per glyph row, each row 2 pixels tall
+		uint64_t lineLength = frameSourceHash(textLine) % (cellsPerLine + 1);
+		
+		uint64_t x = 0;
+		for (uint64_t c = 0; c < cellsPerLine; c++) {
+			uint64_t glyph = frameSourceHash((textLine << 16) + c);
+			uint64_t glyphBits = 0;
+			if ((c < lineLength) && ((glyph & 7) != 0)) { //1 in 8 cells is a space
+				glyphBits = (glyph >> (glyphRow << 3)) & 0xFF;
+			}
+			for (uint64_t b = 0; b < FRAME_SOURCE_GLYPH_WIDTH; b++) {
+				pixelRow[x] = ((glyphBits >> b) & 1) ? FRAME_SOURCE_FOREGROUND : FRAME_SOURCE_BACKGROUND;
+				x++;
+			}
+		}
+		for (; x < sourceWidth; x++) {
+			pixelRow[x] = FRAME_SOURCE_BACKGROUND;
+		}
+	}
+}
+
+static void frameSourceDrawNoise(uint64_t present) {
+	uint64_t* pixels = (uint64_t*) sourceFrameData;
+	uint64_t state = frameSourceHash(present) | 1;
+	uint64_t count = sourceFrameBytes >> 3;
+	for (uint64_t i = 0; i < count; i++) { //xorshift64 (two pixels at a time)
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		pixels[i] = state | 0xFF000000FF000000; //Opaque alpha like the desktop
+	}
+}
+
+//Static gradient with a block of text that gets shown for the one and only present
+static void frameSourceDrawStatic() {
+	frameSourceDrawScrollText(0);
+	uint32_t* pixels = (uint32_t*) sourceFrameData;
+	for (uint64_t y = 0; y < (sourceHeight >> 2); y++) {
+		for (uint64_t x = 0; x < sourceWidth; x++) {
+			uint32_t shade = (uint32_t) ((x * 255) / sourceWidth);
+			pixels[y * sourceWidth + x] = 0xFF000000 | (shade << 16) | (((uint32_t) y & 0xFF) << 8) | (255 - shade);
+		}
+	}
+}
+
+static int frameSourceSleepUntil(uint64_t endTime) {
+	while (getCurrentTime() < endTime) {
+		int error = syncWaitSetWait(sourceWaitSet, SYNC_WAIT_NONE, endTime);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+static int frameSourceAcquireNextFrame(uint64_t millisecondTimeout, uint64_t* presentationTime, uint64_t* accumulatedFrames) {
+	if (sourceAcquired > 0) {
+		return ERROR_FRAME_SOURCE_WRONG_STATE;
+	}
+	
+	uint64_t currentTime = getCurrentTime();
+	uint64_t endTime = getEndTimeFromMilliDiff(currentTime, millisecondTimeout);
+	if ((sourcePattern == FRAME_SOURCE_PATTERN_STATIC) && (sourceNextPresent > 0)) {
+		int error = frameSourceSleepUntil(endTime); //Nothing ever changes again
+		RETURN_ON_ERROR(error);
+		return ERROR_FRAME_SOURCE_TIMEOUT;
+	}
+	
+	uint64_t nextPresentTime = frameSourcePresentTime(sourceNextPresent);
+	if (nextPresentTime > endTime) {
+		int error = frameSourceSleepUntil(endTime);
+		RETURN_ON_ERROR(error);
+		return ERROR_FRAME_SOURCE_TIMEOUT;
+	}
+	if (nextPresentTime > currentTime) {
+		int error = frameSourceSleepUntil(nextPresentTime);
+		RETURN_ON_ERROR(error);
+		currentTime = getCurrentTime();
+	}
+	
+	//Latest present that already happened (older ones count as accumulated frames)
+	uint64_t present = sourceNextPresent;
+	if (sourcePattern != FRAME_SOURCE_PATTERN_STATIC) {
+		uint64_t estimate = (currentTime - sourceStartTime) / sourcePresentInterval;
+		if (estimate > (present + 1)) {
+			present = estimate - 1;
+		}
+		while (frameSourcePresentTime(present + 1) <= currentTime) {
+			present++;
+		}
+	}
+	*accumulatedFrames = present - sourceNextPresent + 1;
+	*presentationTime = frameSourcePresentTime(present);
+	
+	if (sourcePattern == FRAME_SOURCE_PATTERN_SCROLL_TEXT) {
+		frameSourceDrawScrollText(present);
+	}
+	else if (sourcePattern == FRAME_SOURCE_PATTERN_NOISE) {
+		frameSourceDrawNoise(present);
+	}
+	else if (sourcePattern == FRAME_SOURCE_PATTERN_REPLAY) {
+		sourcePtr->frameData = &(sourceReplayData[(present % sourceReplayFrames) * sourceFrameBytes]);
+	}
+	
+	sourceNextPresent = present + 1;
+	sourceAcquired = 1;
+	return 0;
+}
+
+static int frameSourceReleaseFrame() {
+	sourceAcquired = 0; //Releasing an already released frame is fine like Desktop Duplication
+	return 0;
+}
+
+static void frameSourceCleanup() {
+	if (sourceFrameData != NULL) {
+		memoryDeallocate((void**) &sourceFrameData);
+	}
+	if (sourceReplayData != NULL) {
+		memoryDeallocate((void**) &sourceReplayData);
+	}
+	syncCloseWaitSet(&sourceWaitSet);
+	sourcePtr = NULL;
+}
+
+static int frameSourceSetupTiming(frameSource* source, uint32_t width, uint32_t height, uint64_t pattern, uint64_t presentFps, uint64_t jitterMicroseconds) {
+	if ((sourcePtr != NULL) || (width == 0) || (height == 0) || (presentFps == 0)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	
+	int error = syncCreateWaitSet(&sourceWaitSet);
+	RETURN_ON_ERROR(error);
+	
+	sourcePattern = pattern;
+	sourceWidth = width;
+	sourceHeight = height;
+	sourceFrameBytes = ((uint64_t) width) * ((uint64_t) height) * 4;
+	sourcePresentInterval = getFrameIntervalTime(presentFps);
+	sourceJitterTime = jitterMicroseconds * getMicrosecondDivider();
+	if (sourceJitterTime >= sourcePresentInterval) { //Presents must stay in order
+		sourceJitterTime = sourcePresentInterval - 1;
+	}
+	sourceStartTime = getCurrentTime();
+	sourceNextPresent = 0;
+	sourceAcquired = 0;
+	
+	source->acquireNextFrame = frameSourceAcquireNextFrame;
+	source->releaseFrame = frameSourceReleaseFrame;
+	source->cleanup = frameSourceCleanup;
+	source->frameData = NULL;
+	source->width = width;
+	source->height = height;
+	sourcePtr = source;
+	return 0;
+}
+
+int frameSourceSetupSynthetic(frameSource* source, uint32_t width, uint32_t height, uint64_t pattern, uint64_t presentFps, uint64_t jitterMicroseconds) {
+	if ((pattern > FRAME_SOURCE_PATTERN_NOISE) || ((width % FRAME_SOURCE_GLYPH_WIDTH) != 0)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	int error = frameSourceSetupTiming(source, width, height, pattern, presentFps, jitterMicroseconds);
+	RETURN_ON_ERROR(error);
+	
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, sourceFrameBytes, 0);
+	RETURN_ON_ERROR(error);
+	sourceFrameData = (uint8_t*) memAlloc;
+	if (pattern == FRAME_SOURCE_PATTERN_STATIC) {
+		frameSourceDrawStatic();
+	}
+	source->frameData = sourceFrameData;
+	return 0;
+}
+
+int frameSourceSetupReplay(frameSource* source, char* fileName, uint32_t width, uint32_t height, uint64_t presentFps, uint64_t jitterMicroseconds) {
+	int error = frameSourceSetupTiming(source, width, height, FRAME_SOURCE_PATTERN_REPLAY, presentFps, jitterMicroseconds);
+	RETURN_ON_ERROR(error);
+	
+	void* replayFile = NULL;
+	error = ioOpenFile(&replayFile, fileName, -1, IO_FILE_READ_NORMAL);
+	RETURN_ON_ERROR(error);
+	uint64_t replayBytes = 0;
+	error = ioGetFileSize(replayFile, &replayBytes);
+	RETURN_ON_ERROR(error);
+	if ((replayBytes == 0) || ((replayBytes % sourceFrameBytes) != 0)) {
+		return ERROR_IO_WRONG_READ_SIZE; //Not a whole number of width x height frames
+	}
+	sourceReplayFrames = replayBytes / sourceFrameBytes;
+	
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, replayBytes, 0);
+	RETURN_ON_ERROR(error);
+	sourceReplayData = (uint8_t*) memAlloc;
+	
+	uint64_t readBytes = 0;
+	while (readBytes < replayBytes) {
+		uint32_t bytesRead = FRAME_SOURCE_READ_CHUNK_BYTES;
+		if ((replayBytes - readBytes) < FRAME_SOURCE_READ_CHUNK_BYTES) {
+			bytesRead = (uint32_t) (replayBytes - readBytes);
+		}
+		error = ioReadFile(replayFile, &(sourceReplayData[readBytes]), &bytesRead);
+		RETURN_ON_ERROR(error);
+		if (bytesRead == 0) {
+			return ERROR_IO_WRONG_READ_SIZE;
+		}
+		readBytes += bytesRead;
+	}
+	source->frameData = sourceReplayData;
+	
+	return ioCloseFile(&replayFile);
+}
@@ -0,0 +1,63 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//Media Enhanced Frame Source Definitions
+//A frame source hands the capture pipeline one frame at a time the same way
+//Desktop Duplication does (acquire with a timeout -> use -> release)
+#ifndef MEDIA_ENHANCED_FRAME_SOURCE_H
+#define MEDIA_ENHANCED_FRAME_SOURCE_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+//Same values as the Desktop Duplication errors so its functions plug in directly
+#define ERROR_FRAME_SOURCE_TIMEOUT 0x500B
+#define ERROR_FRAME_SOURCE_WRONG_STATE 0x5011
+
+//Synthetic Patterns
+#define FRAME_SOURCE_PATTERN_STATIC 0 //Presents once then never changes (idle desktop)
+#define FRAME_SOURCE_PATTERN_SCROLL_TEXT 1 //Lines of glyphs scrolling up (terminal / document)
+#define FRAME_SOURCE_PATTERN_NOISE 2 //Every pixel changes every present (video / game)
+#define FRAME_SOURCE_PATTERN_REPLAY 3 //Frames loaded from a raw .rgb file
+
+typedef int (*PFN_FrameSourceAcquireNextFrame)(uint64_t millisecondTimeout, uint64_t* presentationTime, uint64_t* accumulatedFrames);
+typedef int (*PFN_FrameSourceReleaseFrame)();
+typedef void (*PFN_FrameSourceCleanup)();
+
+typedef struct frameSource {
+	PFN_FrameSourceAcquireNextFrame acquireNextFrame;
+	PFN_FrameSourceReleaseFrame releaseFrame;
+	PFN_FrameSourceCleanup cleanup;
+	uint8_t* frameData; //BGRA pixels of the acquired frame (NULL when the frame only lives on the GPU)
+	uint32_t width;
+	uint32_t height;
+} frameSource;
+
+//Only one of these CPU frame sources can be set up at a time
+//presentFps is how often the source "presents" a new frame and jitterMicroseconds
+//randomly delays each present by up to that much (kept below one present interval)
+int frameSourceSetupSynthetic(frameSource* source, uint32_t width, uint32_t height, uint64_t pattern, uint64_t presentFps, uint64_t jitterMicroseconds);
+
+//Replays the concatenated width * height * 4 byte BGRA frames of a raw .rgb file
+//(same layout as image0.rgb) in a loop
+int frameSourceSetupReplay(frameSource* source, char* fileName, uint32_t width, uint32_t height, uint64_t presentFps, uint64_t jitterMicroseconds);
+
+#endif
@@ -0,0 +1,126 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//Media Enhanced Frame Trace Functions
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "frameTrace.h" //Include Frame Trace Function Definitions
+#include "bitstreamContainer.h" //Include Bitstream Container Function Definitions (side file names)
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define FRAME_TRACE_WRITE_CHUNK_BYTES 1073741824 //ioWriteFile takes 32 bit sizes
+
+int frameTraceSetup(frameTrace* trace, uint64_t recordCount) {
+	trace->records = NULL;
+	trace->mask = 0;
+	trace->head = 0;
+	if (recordCount == 0) {
+		return 0;
+	}
+	uint64_t count = 1;
+	while (count < recordCount) {
+		count <<= 1;
+	}
+	void* memAlloc = NULL;
+	int error = memoryAllocate(&memAlloc, count * sizeof(frameTraceRecord), 0);
+	RETURN_ON_ERROR(error);
+	trace->records = (frameTraceRecord*) memAlloc;
+	trace->mask = count - 1;
+	return 0;
+}
+
+void frameTraceReset(frameTrace* trace) {
+	trace->head = 0;
+}
+
+void frameTraceAdd(frameTrace* trace, uint64_t event, uint64_t frame, uint64_t slot, uint64_t time) {
+	if (trace->records == NULL) {
+		return;
+	}
+	frameTraceRecord* record = &(trace->records[trace->head & trace->mask]);
+	record->time = time;
+	record->frame = (uint32_t) frame;
+	record->event = (uint16_t) event;
+	record->slot = (uint16_t) slot;
+	trace->head++;
+}
+
+static int frameTraceWriteRecords(void* file, frameTraceRecord* records, uint64_t recordCount) {
+	uint8_t* data = (uint8_t*) records;
+	uint64_t bytes = recordCount * sizeof(frameTraceRecord);
+	while (bytes > 0) {
+		uint64_t writeBytes = (bytes < FRAME_TRACE_WRITE_CHUNK_BYTES) ? bytes : FRAME_TRACE_WRITE_CHUNK_BYTES;
+		int error = ioWriteFile(file, data, (uint32_t) writeBytes);
+		RETURN_ON_ERROR(error);
+		data += writeBytes;
+		bytes -= writeBytes;
+	}
+	return 0;
+}
+
+//Unwraps the ring so the file is in time order (apart from presentation times)
+int frameTraceWrite(frameTrace* trace, char* bitstreamFileName) {
+	if (trace->records == NULL) {
+		return 0;
+	}
+	char traceName[BITSTREAM_FILE_NAME_MAX];
+	int error = bitstreamSideFileName(traceName, bitstreamFileName, ".trace");
+	RETURN_ON_ERROR(error);
+	
+	frameTraceHeader header;
+	header.magic = FRAME_TRACE_MAGIC;
+	header.ticksPerMicrosecond = getMicrosecondDivider();
+	header.recordCount = trace->head;
+	header.overwritten = 0;
+	uint64_t first = 0;
+	if (trace->head > (trace->mask + 1)) {
+		header.recordCount = trace->mask + 1;
+		header.overwritten = trace->head - header.recordCount;
+		first = trace->head & trace->mask;
+	}
+	
+	void* file = NULL;
+	error = ioOpenFile(&file, traceName, -1, IO_FILE_WRITE_NORMAL);
+	RETURN_ON_ERROR(error);
+	error = ioWriteFile(file, &header, sizeof(frameTraceHeader));
+	if (error == 0) {
+		error = frameTraceWriteRecords(file, &(trace->records[first]), header.recordCount - first);
+	}
+	if ((error == 0) && (first > 0)) {
+		error = frameTraceWriteRecords(file, trace->records, first);
+	}
+	int closeError = ioCloseFile(&file);
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+int frameTraceCleanup(frameTrace* trace) {
+	if (trace->records == NULL) {
+		return 0;
+	}
+	return memoryDeallocate((void**) &(trace->records));
+}
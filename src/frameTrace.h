@@ -0,0 +1,87 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//Media Enhanced Frame Trace Definitions
+//Fixed size records of every step a frame takes through the recorder's
+//pipeline (acquire, compute submit / fence, encode submit / lock, write
+//submit / complete) kept in a preallocated ring, so recording one is a few
+//stores with no allocation or I/O. When the ring is full the oldest records
+//get overwritten. The ring gets saved as a binary file at the end of a
+//recording and FrameTraceExport turns it into Chrome trace JSON
+#ifndef MEDIA_ENHANCED_FRAME_TRACE_H
+#define MEDIA_ENHANCED_FRAME_TRACE_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+#define ERROR_FRAME_TRACE_INVALID 0x5130 //Not a trace file or cut short
+
+#define FRAME_TRACE_MAGIC 0x454341525452534C //"LSRTRACE"
+#define FRAME_TRACE_DEFAULT_RECORDS 1048576 //16 MiB (about 25 minutes of 60 fps)
+
+//Acquire and compute events count frame periods (ddNextFrame) while the
+//encode and write events count output frames (repeats make them differ)
+#define FRAME_TRACE_PRESENT 0 //Time is when the acquired image got presented
+#define FRAME_TRACE_ACQUIRE 1
+#define FRAME_TRACE_ACQUIRE_MISSED 2 //Acquire window passed without an acquire attempt
+#define FRAME_TRACE_REPEAT 3 //Previous image gets encoded again
+#define FRAME_TRACE_MISC_ISSUE 4 //A stage got a new request before starting the last one
+#define FRAME_TRACE_COMPUTE_SUBMIT 5
+#define FRAME_TRACE_COMPUTE_DONE 6
+#define FRAME_TRACE_ENCODE_SUBMIT 7 //Slot is the output ring slot
+#define FRAME_TRACE_ENCODE_LOCK 8
+#define FRAME_TRACE_WRITE_SUBMIT 9
+#define FRAME_TRACE_WRITE_COMPLETE 10
+#define FRAME_TRACE_EVENTS 11
+
+typedef struct frameTraceRecord {
+	uint64_t time; //getCurrentTime ticks
+	uint32_t frame;
+	uint16_t event;
+	uint16_t slot;
+} frameTraceRecord;
+
+//File layout: this header followed by the records oldest first
+typedef struct frameTraceHeader {
+	uint64_t magic;
+	uint64_t ticksPerMicrosecond;
+	uint64_t recordCount;
+	uint64_t overwritten; //Records lost to the ring wrapping
+} frameTraceHeader;
+
+typedef struct frameTrace {
+	frameTraceRecord* records; //NULL when tracing is off (adding does nothing)
+	uint64_t mask; //Record count - 1
+	uint64_t head; //Records added since the last reset
+} frameTrace;
+
+//Record count gets rounded up to a power of two (0 turns tracing off)
+int frameTraceSetup(frameTrace* trace, uint64_t recordCount);
+void frameTraceReset(frameTrace* trace);
+void frameTraceAdd(frameTrace* trace, uint64_t event, uint64_t frame, uint64_t slot, uint64_t time);
+int frameTraceWrite(frameTrace* trace, char* bitstreamFileName); //Saved as the bitstream's name with .trace added
+int frameTraceCleanup(frameTrace* trace);
+
+#endif
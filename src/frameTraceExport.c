@@ -0,0 +1,329 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//This is the main file for the Frame Trace Export helper program
+//It reads the binary frame trace the recorder saves next to a recording and
+//writes it out as Chrome trace JSON: the acquire (presentation to acquire),
+//compute and encode stages as slices on their own tracks, the writes (which
+//overlap) as async slices, and missed acquire windows, repeated frames and
+//misc issues as instant markers, so pipeline stalls show up on a timeline
+//Usage: FrameTraceExport [trace file] [json file]
+
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "frameTrace.h" //Includes the trace record layout
+#include "bitstreamContainer.h" //Shared buffered text writer
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define EXPORT_READ_CHUNK_BYTES 1073741824 //ioReadFile takes 32 bit sizes
+#define EXPORT_FILE_NAME_MAX 4096
+#define EXPORT_JSON_BUFFER_BYTES 65536
+#define EXPORT_JSON_FLUSH_BYTES 61440 //Leaves room for the longest single put
+#define EXPORT_SLOT_MAX 65536
+
+//Chrome trace thread ids (one track per stage)
+#define EXPORT_TRACK_ACQUIRE 1
+#define EXPORT_TRACK_COMPUTE 2
+#define EXPORT_TRACK_ENCODE 3
+#define EXPORT_TRACK_WRITE 4
+#define EXPORT_TRACK_ISSUES 5
+
+static frameTraceHeader exportHeader;
+static frameTraceRecord* exportRecords = NULL;
+static uint64_t exportFirstTime = 0;
+
+//Buffered JSON Output
+static char exportJSONBuffer[EXPORT_JSON_BUFFER_BYTES];
+static bitstreamTextWriter exportJSON;
+
+//Chrome traces count microseconds so the nanoseconds go after the decimal point
+static int exportJSONPutTime(uint64_t time) {
+	uint64_t nanoseconds = ((time - exportFirstTime) * 1000) / exportHeader.ticksPerMicrosecond;
+	int error = bitstreamTextPutNumber(&exportJSON, nanoseconds / 1000);
+	RETURN_ON_ERROR(error);
+	uint64_t fraction = nanoseconds % 1000;
+	char* text = &(exportJSON.buffer[exportJSON.bytes]);
+	text[0] = '.';
+	text[1] = (char) ('0' + (fraction / 100));
+	text[2] = (char) ('0' + ((fraction / 10) % 10));
+	text[3] = (char) ('0' + (fraction % 10));
+	exportJSON.bytes += 4;
+	return 0;
+}
+
+//{"name": "Frame N", "ph": phase, "pid": 1, "tid": track, "ts": start (then the extra fields)
+static int exportJSONPutEvent(char* name, uint64_t frame, char* phase, uint64_t track, uint64_t time) {
+	int error = bitstreamTextPut(&exportJSON, ",\n{\"name\": \"");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, name);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPutNumber(&exportJSON, frame);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, "\", \"ph\": \"");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, phase);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, "\", \"pid\": 1, \"tid\": ");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPutNumber(&exportJSON, track);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, ", \"ts\": ");
+	RETURN_ON_ERROR(error);
+	return exportJSONPutTime(time);
+}
+
+static int exportJSONPutSlice(uint64_t frame, uint64_t track, uint64_t startTime, uint64_t endTime) {
+	int error = exportJSONPutEvent("Frame ", frame, "X", track, startTime);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, ", \"dur\": ");
+	RETURN_ON_ERROR(error);
+	error = exportJSONPutTime(exportFirstTime + (endTime - startTime));
+	RETURN_ON_ERROR(error);
+	return bitstreamTextPut(&exportJSON, "}");
+}
+
+static int exportJSONPutTrackName(uint64_t track, char* name) {
+	int error = bitstreamTextPut(&exportJSON, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": ");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPutNumber(&exportJSON, track);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, ", \"args\": {\"name\": \"");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, name);
+	RETURN_ON_ERROR(error);
+	return bitstreamTextPut(&exportJSON, "\"}}");
+}
+
+//Begin times waiting for their end record (a ring that wrapped can start with ends that get skipped)
+static uint64_t exportComputeStart = 0;
+static uint64_t exportEncodeStart = 0;
+static uint64_t exportWriteStarts[EXPORT_SLOT_MAX];
+static uint64_t exportPresentTime = 0;
+static uint64_t exportPresentFrame = 0;
+static uint64_t exportEventCounts[FRAME_TRACE_EVENTS];
+static uint64_t exportLongest[3]; //Compute, Encode, Write in ticks
+
+static void exportTrackLongest(uint64_t stage, uint64_t startTime, uint64_t endTime) {
+	if ((endTime - startTime) > exportLongest[stage]) {
+		exportLongest[stage] = endTime - startTime;
+	}
+}
+
+static int exportRecord(frameTraceRecord* record) {
+	static char* markerNames[3] = {"Acquire Missed ", "Repeat ", "Misc Issue "};
+	int error = 0;
+	switch (record->event) {
+		case FRAME_TRACE_PRESENT:
+			exportPresentTime = record->time;
+			exportPresentFrame = record->frame + 1; //0 means no present waiting
+			break;
+		case FRAME_TRACE_ACQUIRE:
+			if ((exportPresentFrame == (record->frame + 1)) && (exportPresentTime <= record->time)) {
+				error = exportJSONPutSlice(record->frame, EXPORT_TRACK_ACQUIRE, exportPresentTime, record->time);
+			}
+			exportPresentFrame = 0;
+			break;
+		case FRAME_TRACE_ACQUIRE_MISSED:
+		case FRAME_TRACE_REPEAT:
+		case FRAME_TRACE_MISC_ISSUE:
+			error = exportJSONPutEvent(markerNames[record->event - FRAME_TRACE_ACQUIRE_MISSED], record->frame, "i", EXPORT_TRACK_ISSUES, record->time);
+			if (error == 0) {
+				error = bitstreamTextPut(&exportJSON, ", \"s\": \"p\"}");
+			}
+			break;
+		case FRAME_TRACE_COMPUTE_SUBMIT:
+			exportComputeStart = record->time;
+			break;
+		case FRAME_TRACE_COMPUTE_DONE:
+			if (exportComputeStart > 0) {
+				exportTrackLongest(0, exportComputeStart, record->time);
+				error = exportJSONPutSlice(record->frame, EXPORT_TRACK_COMPUTE, exportComputeStart, record->time);
+			}
+			exportComputeStart = 0;
+			break;
+		case FRAME_TRACE_ENCODE_SUBMIT:
+			exportEncodeStart = record->time;
+			break;
+		case FRAME_TRACE_ENCODE_LOCK:
+			if (exportEncodeStart > 0) {
+				exportTrackLongest(1, exportEncodeStart, record->time);
+				error = exportJSONPutSlice(record->frame, EXPORT_TRACK_ENCODE, exportEncodeStart, record->time);
+			}
+			exportEncodeStart = 0;
+			break;
+		case FRAME_TRACE_WRITE_SUBMIT:
+			exportWriteStarts[record->slot] = record->time;
+			error = exportJSONPutEvent("Frame ", record->frame, "b", EXPORT_TRACK_WRITE, record->time);
+			if (error == 0) {
+				error = bitstreamTextPut(&exportJSON, ", \"cat\": \"write\", \"id\": ");
+			}
+			if (error == 0) {
+				error = bitstreamTextPutNumber(&exportJSON, record->frame);
+			}
+			if (error == 0) {
+				error = bitstreamTextPut(&exportJSON, "}");
+			}
+			break;
+		case FRAME_TRACE_WRITE_COMPLETE:
+			if (exportWriteStarts[record->slot] > 0) {
+				exportTrackLongest(2, exportWriteStarts[record->slot], record->time);
+				error = exportJSONPutEvent("Frame ", record->frame, "e", EXPORT_TRACK_WRITE, record->time);
+				if (error == 0) {
+					error = bitstreamTextPut(&exportJSON, ", \"cat\": \"write\", \"id\": ");
+				}
+				if (error == 0) {
+					error = bitstreamTextPutNumber(&exportJSON, record->frame);
+				}
+				if (error == 0) {
+					error = bitstreamTextPut(&exportJSON, "}");
+				}
+			}
+			exportWriteStarts[record->slot] = 0;
+			break;
+		default:
+			return ERROR_FRAME_TRACE_INVALID;
+	}
+	exportEventCounts[record->event]++;
+	return error;
+}
+
+static int exportLoad(char* traceFileName) {
+	void* file = NULL;
+	int error = ioOpenFile(&file, traceFileName, -1, IO_FILE_READ_NORMAL);
+	RETURN_ON_ERROR(error);
+	uint64_t fileBytes = 0;
+	error = ioGetFileSize(file, &fileBytes);
+	if (error == 0) {
+		uint32_t readBytes = sizeof(frameTraceHeader);
+		error = ioReadFile(file, &exportHeader, &readBytes);
+		if ((error == 0) && ((readBytes != sizeof(frameTraceHeader)) || (exportHeader.magic != FRAME_TRACE_MAGIC) ||
+			(exportHeader.ticksPerMicrosecond == 0) || (exportHeader.recordCount == 0) ||
+			(exportHeader.recordCount > ((fileBytes - sizeof(frameTraceHeader)) / sizeof(frameTraceRecord))))) {
+			error = ERROR_FRAME_TRACE_INVALID;
+		}
+	}
+	if (error == 0) {
+		void* memAlloc = NULL;
+		error = memoryAllocate(&memAlloc, exportHeader.recordCount * sizeof(frameTraceRecord), 0);
+		exportRecords = (frameTraceRecord*) memAlloc;
+	}
+	uint8_t* data = (uint8_t*) exportRecords;
+	uint64_t bytes = exportHeader.recordCount * sizeof(frameTraceRecord);
+	while ((error == 0) && (bytes > 0)) {
+		uint32_t readBytes = (uint32_t) ((bytes < EXPORT_READ_CHUNK_BYTES) ? bytes : EXPORT_READ_CHUNK_BYTES);
+		error = ioReadFile(file, data, &readBytes);
+		if ((error == 0) && (readBytes == 0)) {
+			error = ERROR_FRAME_TRACE_INVALID;
+		}
+		data += readBytes;
+		bytes -= readBytes;
+	}
+	int closeError = ioCloseFile(&file);
+	RETURN_ON_ERROR(error);
+	return closeError;
+}
+
+static int exportWrite(char* jsonFileName) {
+	exportFirstTime = exportRecords[0].time;
+	for (uint64_t r = 1; r < exportHeader.recordCount; r++) { //Presentation times come before their acquire record
+		if (exportRecords[r].time < exportFirstTime) {
+			exportFirstTime = exportRecords[r].time;
+		}
+	}
+	
+	int error = bitstreamTextOpen(&exportJSON, jsonFileName, exportJSONBuffer, EXPORT_JSON_FLUSH_BYTES);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(&exportJSON, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"LosslessScreenRecord\"}}");
+	if (error == 0) {
+		error = exportJSONPutTrackName(EXPORT_TRACK_ACQUIRE, "Acquire (presentation to acquire)");
+	}
+	if (error == 0) {
+		error = exportJSONPutTrackName(EXPORT_TRACK_COMPUTE, "Compute");
+	}
+	if (error == 0) {
+		error = exportJSONPutTrackName(EXPORT_TRACK_ENCODE, "Encode");
+	}
+	if (error == 0) {
+		error = exportJSONPutTrackName(EXPORT_TRACK_WRITE, "Write");
+	}
+	if (error == 0) {
+		error = exportJSONPutTrackName(EXPORT_TRACK_ISSUES, "Issues");
+	}
+	for (uint64_t r = 0; (r < exportHeader.recordCount) && (error == 0); r++) {
+		error = exportRecord(&(exportRecords[r]));
+	}
+	if (error == 0) {
+		error = bitstreamTextPut(&exportJSON, "\n]}\n");
+	}
+	return bitstreamTextClose(&exportJSON, error);
+}
+
+//Program Main Function
+int programMain() {
+	char* traceFileName = "bitstream.h265.trace";
+	char* jsonFileName = NULL;
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		traceFileName = argument;
+	}
+	if (ioGetCommandArgument(2, &argument, &argumentBytes) == 0) {
+		jsonFileName = argument;
+	}
+	
+	static char defaultJSONFileName[EXPORT_FILE_NAME_MAX]; //Trace file name with .json added
+	if (jsonFileName == NULL) {
+		uint64_t nameBytes = 0;
+		while (traceFileName[nameBytes] != 0) {
+			nameBytes++;
+		}
+		if ((nameBytes + 6) > EXPORT_FILE_NAME_MAX) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		memcpyBasic(defaultJSONFileName, traceFileName, nameBytes);
+		memcpyBasic(&(defaultJSONFileName[nameBytes]), ".json", 6);
+		jsonFileName = defaultJSONFileName;
+	}
+	
+	int error = exportLoad(traceFileName);
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(156, exportHeader.recordCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(157, exportHeader.overwritten, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	error = exportWrite(jsonFileName);
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(158, exportEventCounts[FRAME_TRACE_ACQUIRE_MISSED], NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(159, exportEventCounts[FRAME_TRACE_REPEAT], NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(160, exportEventCounts[FRAME_TRACE_MISC_ISSUE], NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrint(161, CON_NO_CTRL);
+	consolePrintWithNumber(148, exportLongest[0] / exportHeader.ticksPerMicrosecond, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, exportLongest[1] / exportHeader.ticksPerMicrosecond, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(164, exportLongest[2] / exportHeader.ticksPerMicrosecond, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER_NEW_LINE);
+	consolePrintLine(162);
+	
+	return memoryDeallocate((void**) &exportRecords);
+}
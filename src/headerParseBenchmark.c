@@ -0,0 +1,223 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//This is the main file for the Header Parse Benchmark helper program
+//It first checks that the AVX2 emulation prevention removal gives the same
+//bytes as the scalar version for every NAL unit of a recording and that the
+//slice headers it parses count their picture order the way the recorder does
+//Then it times the removal over whole NAL units and the per frame header work
+//(parameter sets when the frame has them plus the first slice header)
+//Usage: HeaderParseBenchmark [input bitstream] [passes]
+
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "bitstreamContainer.h" //Frame index and mapped frame views
+#include "hevcHeaders.h" //Includes the RBSP reader and header parsers
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+static bitstreamReader headerReader;
+static hevcParameterSets headerSets;
+static uint8_t* headerScalarRBSP = NULL;
+static uint8_t* headerVectorRBSP = NULL;
+static uint8_t headerSliceRBSP[HEVC_SLICE_HEADER_BYTES + HEVC_RBSP_EXTRA_BYTES];
+
+static int headerParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+//Every NAL unit of every frame through both versions (byte for byte)
+static int headerCheckUnescape(uint64_t* mismatches) {
+	*mismatches = 0;
+	for (uint64_t f = 0; f < headerReader.frameCount; f++) {
+		uint8_t* frameView = NULL;
+		uint64_t frameBytes = 0;
+		int error = bitstreamReaderViewFrame(&headerReader, f, &frameView, &frameBytes);
+		RETURN_ON_ERROR(error);
+		uint64_t position = 0;
+		bitstreamNalView nal;
+		while (bitstreamNextNal(frameView, frameBytes, &position, &nal) > 0) {
+			uint64_t scalarBytes = hevcUnescape(headerScalarRBSP, nal.data, nal.bytes, HEVC_ISA_SCALAR);
+			uint64_t vectorBytes = hevcUnescape(headerVectorRBSP, nal.data, nal.bytes, HEVC_ISA_AVX2);
+			if (scalarBytes != vectorBytes) {
+				(*mismatches)++;
+				continue;
+			}
+			for (uint64_t i = 0; i < scalarBytes; i++) {
+				if (headerScalarRBSP[i] != headerVectorRBSP[i]) {
+					(*mismatches)++;
+					break;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+//Parameter sets when the frame starts with them, then only the first slice header
+//pocMismatches counts slices whose picture order count does not follow the frame number
+static int headerParseFrames(uint64_t isa, uint64_t* pocMismatches) {
+	*pocMismatches = 0;
+	uint64_t lastIDR = 0;
+	for (uint64_t f = 0; f < headerReader.frameCount; f++) {
+		uint8_t* frameView = NULL;
+		uint64_t frameBytes = 0;
+		int error = bitstreamReaderViewFrame(&headerReader, f, &frameView, &frameBytes);
+		RETURN_ON_ERROR(error);
+		uint64_t position = 0;
+		bitstreamNalView nal;
+		rbspReader rbsp;
+		while (bitstreamPeekNal(frameView, frameBytes, &position, &nal) > 0) {
+			if (nal.type >= HEVC_NAL_VPS) { //Only parameter sets and other non slice NAL units get walked to their end
+				bitstreamNextNal(frameView, frameBytes, &position, &nal);
+			}
+			if (nal.type == HEVC_NAL_SPS) {
+				hevcReaderSetup(&rbsp, headerScalarRBSP, nal.data, nal.bytes, nal.bytes, isa);
+				error = hevcParseSPS(&headerSets, &rbsp);
+				RETURN_ON_ERROR(error);
+			}
+			else if (nal.type == HEVC_NAL_PPS) {
+				hevcReaderSetup(&rbsp, headerScalarRBSP, nal.data, nal.bytes, nal.bytes, isa);
+				error = hevcParsePPS(&headerSets, &rbsp);
+				RETURN_ON_ERROR(error);
+			}
+			else if (nal.type < HEVC_NAL_VPS) {
+				hevcSliceHeader slice;
+				hevcReaderSetup(&rbsp, headerSliceRBSP, nal.data, nal.bytes, HEVC_SLICE_HEADER_BYTES, isa);
+				error = hevcParseSliceHeader(&headerSets, &rbsp, nal.type, &slice);
+				RETURN_ON_ERROR(error);
+				if ((slice.nalType == HEVC_NAL_IDR_W_RADL) || (slice.nalType == HEVC_NAL_IDR_N_LP)) {
+					lastIDR = f;
+				}
+				uint64_t expected = (f - lastIDR) & ((((uint64_t) 1) << headerSets.log2MaxPicOrderCntLsb) - 1);
+				if (slice.picOrderCntLsb != expected) {
+					(*pocMismatches)++;
+				}
+				break; //Rest of the frame is slice data
+			}
+		}
+	}
+	return 0;
+}
+
+static int headerTimeUnescape(uint64_t isa, uint64_t passes, uint64_t* speed) {
+	uint64_t nalBytes = 0;
+	uint64_t startTime = getCurrentTime();
+	for (uint64_t p = 0; p < passes; p++) {
+		for (uint64_t f = 0; f < headerReader.frameCount; f++) {
+			uint8_t* frameView = NULL;
+			uint64_t frameBytes = 0;
+			int error = bitstreamReaderViewFrame(&headerReader, f, &frameView, &frameBytes);
+			RETURN_ON_ERROR(error);
+			uint64_t position = 0;
+			bitstreamNalView nal;
+			while (bitstreamNextNal(frameView, frameBytes, &position, &nal) > 0) {
+				hevcUnescape(headerScalarRBSP, nal.data, nal.bytes, isa);
+				nalBytes += nal.bytes;
+			}
+		}
+	}
+	uint64_t runTime = getDiffTimeMicroseconds(startTime, getCurrentTime());
+	if (runTime == 0) {
+		runTime = 1;
+	}
+	*speed = nalBytes / runTime; //Bytes per us is MB/s
+	return 0;
+}
+
+int programMain() {
+	char* inputFileName = "bitstream.h265";
+	uint64_t passes = 20;
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		inputFileName = argument;
+	}
+	if (ioGetCommandArgument(2, &argument, &argumentBytes) == 0) {
+		int error = headerParseNumber(argument, argumentBytes, &passes);
+		RETURN_ON_ERROR(error);
+		if (passes == 0) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+	}
+	
+	consolePrintLine(54);
+	int error = bitstreamReaderOpen(&headerReader, inputFileName);
+	RETURN_ON_ERROR(error);
+	uint64_t indexSource = 0;
+	error = bitstreamReaderIndex(&headerReader, 1, 60, &indexSource);
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(95, headerReader.frameCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, headerReader.maxFrameBytes + HEVC_RBSP_EXTRA_BYTES, 0);
+	RETURN_ON_ERROR(error);
+	headerScalarRBSP = (uint8_t*) memAlloc;
+	error = memoryAllocate(&memAlloc, headerReader.maxFrameBytes + HEVC_RBSP_EXTRA_BYTES, 0);
+	RETURN_ON_ERROR(error);
+	headerVectorRBSP = (uint8_t*) memAlloc;
+	
+	uint64_t isa = hevcGetMaxISA();
+	if (isa == HEVC_ISA_AVX2) {
+		uint64_t mismatches = 0;
+		error = headerCheckUnescape(&mismatches);
+		RETURN_ON_ERROR(error);
+		consolePrintLineWithNumber(114, mismatches, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	uint64_t pocMismatches = 0;
+	error = headerParseFrames(isa, &pocMismatches);
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(115, pocMismatches, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	for (uint64_t i = HEVC_ISA_SCALAR; i <= isa; i++) {
+		uint64_t speed = 0;
+		error = headerTimeUnescape(i, passes, &speed);
+		RETURN_ON_ERROR(error);
+		consolePrintLineWithNumber(116 + i, speed, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	
+	uint64_t startTime = getCurrentTime();
+	for (uint64_t p = 0; p < passes; p++) {
+		error = headerParseFrames(isa, &pocMismatches);
+		RETURN_ON_ERROR(error);
+	}
+	uint64_t runTime = getDiffTimeMicroseconds(startTime, getCurrentTime());
+	consolePrintLineWithNumber(118, (runTime * 1000) / (passes * headerReader.frameCount), NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	error = memoryDeallocate((void**) &headerVectorRBSP);
+	RETURN_ON_ERROR(error);
+	error = memoryDeallocate((void**) &headerScalarRBSP);
+	RETURN_ON_ERROR(error);
+	bitstreamReaderClose(&headerReader);
+	
+	consoleBufferFlush();
+	return 0;
+}
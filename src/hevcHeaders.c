@@ -0,0 +1,427 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced HEVC Header Parsing Functions
+//Emulation prevention removal (scalar and AVX2) and the short parameter set /
+//slice header parsers that run on every frame
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "hevcHeaders.h" //Include HEVC Header Parsing Function Definitions
+#include <cpuid.h> //CPU feature checks
+#include <immintrin.h> //AVX2 intrinsics
+
+uint64_t hevcGetMaxISA() {
+	uint32_t eax = 0;
+	uint32_t ebx = 0;
+	uint32_t ecx = 0;
+	uint32_t edx = 0;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+		return HEVC_ISA_SCALAR;
+	}
+	if (((ecx & bit_OSXSAVE) == 0) || ((ecx & bit_AVX) == 0)) {
+		return HEVC_ISA_SCALAR;
+	}
+	uint32_t xcr0 = 0;
+	uint32_t xcr0High = 0;
+	__asm__ volatile ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0)); //Registers the OS saves on context switches
+	if ((xcr0 & 0b110) != 0b110) {
+		return HEVC_ISA_SCALAR;
+	}
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+		return HEVC_ISA_SCALAR;
+	}
+	if ((ebx & bit_AVX2) == 0) {
+		return HEVC_ISA_SCALAR;
+	}
+	return HEVC_ISA_AVX2;
+}
+
+//A 0x03 is an emulation prevention byte when the two NAL bytes before it are zero
+//(zeros never get removed, so checking the original bytes matches the decoder's rule)
+static uint64_t hevcUnescapeScalar(uint8_t* rbsp, uint8_t* nal, uint64_t nalBytes, uint64_t first, uint64_t rbspBytes) {
+	for (uint64_t i = first; i < nalBytes; i++) {
+		if ((nal[i] == 3) && (i >= 2) && (nal[i - 1] == 0) && (nal[i - 2] == 0)) {
+			continue;
+		}
+		rbsp[rbspBytes] = nal[i];
+		rbspBytes++;
+	}
+	return rbspBytes;
+}
+
+//32 bytes at a time: the whole block gets stored and only the part before the first emulation byte counts
+__attribute__((target("avx2"))) static uint64_t hevcUnescapeAVX2(uint8_t* rbsp, uint8_t* nal, uint64_t nalBytes) {
+	uint64_t rbspBytes = 0;
+	uint64_t i = 0;
+	for (; (i < 2) && (i < nalBytes); i++) {
+		rbsp[rbspBytes] = nal[i];
+		rbspBytes++;
+	}
+	
+	__m256i zero = _mm256_setzero_si256();
+	__m256i three = _mm256_set1_epi8(3);
+	while ((i + 32) <= nalBytes) {
+		__m256i bytes = _mm256_loadu_si256((__m256i*) (&(nal[i])));
+		__m256i previous1 = _mm256_loadu_si256((__m256i*) (&(nal[i - 1])));
+		__m256i previous2 = _mm256_loadu_si256((__m256i*) (&(nal[i - 2])));
+		__m256i match = _mm256_and_si256(_mm256_cmpeq_epi8(bytes, three), _mm256_and_si256(_mm256_cmpeq_epi8(previous1, zero), _mm256_cmpeq_epi8(previous2, zero)));
+		uint32_t mask = (uint32_t) _mm256_movemask_epi8(match);
+		_mm256_storeu_si256((__m256i*) (&(rbsp[rbspBytes])), bytes);
+		if (mask == 0) {
+			rbspBytes += 32;
+			i += 32;
+		}
+		else {
+			uint64_t keep = (uint64_t) __builtin_ctz(mask);
+			rbspBytes += keep;
+			i += keep + 1;
+		}
+	}
+	return hevcUnescapeScalar(rbsp, nal, nalBytes, i, rbspBytes);
+}
+
+uint64_t hevcUnescape(uint8_t* rbsp, uint8_t* nal, uint64_t nalBytes, uint64_t isa) {
+	uint64_t rbspBytes = 0;
+	if (isa == HEVC_ISA_AVX2) {
+		rbspBytes = hevcUnescapeAVX2(rbsp, nal, nalBytes);
+	}
+	else {
+		rbspBytes = hevcUnescapeScalar(rbsp, nal, nalBytes, 0, 0);
+	}
+	for (uint64_t i = 0; i < 8; i++) { //Reads past the end see zeros
+		rbsp[rbspBytes + i] = 0;
+	}
+	return rbspBytes;
+}
+
+static uint64_t hevcCountStartCodesScalar(uint8_t* data, uint64_t dataBytes, uint32_t nalType, uint64_t* nalTypePosition, uint64_t i, uint64_t count) {
+	while ((i + 2) < dataBytes) {
+		if (data[i + 2] > 1) {
+			i += 3;
+		}
+		else if ((data[i + 2] == 1) && (data[i + 1] == 0) && (data[i] == 0)) {
+			if (((i + 3) < dataBytes) && (((data[i + 3] >> 1) & 0x3F) == nalType) && (*nalTypePosition == dataBytes)) {
+				*nalTypePosition = i;
+			}
+			count++;
+			i += 3;
+		}
+		else {
+			i++;
+		}
+	}
+	return count;
+}
+
+//Every byte position gets compared as the first, second and third byte of a start code
+__attribute__((target("avx2"))) static uint64_t hevcCountStartCodesAVX2(uint8_t* data, uint64_t dataBytes, uint32_t nalType, uint64_t* nalTypePosition) {
+	uint64_t count = 0;
+	uint64_t i = 0;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i one = _mm256_set1_epi8(1);
+	for (; (i + 34) <= dataBytes; i += 32) {
+		__m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*) (&(data[i]))), zero);
+		__m256i second = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*) (&(data[i + 1]))), zero);
+		__m256i third = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*) (&(data[i + 2]))), one);
+		uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(first, second), third));
+		while (mask != 0) {
+			uint64_t position = i + (uint64_t) __builtin_ctz(mask);
+			if (((position + 3) < dataBytes) && (((data[position + 3] >> 1) & 0x3F) == nalType) && (*nalTypePosition == dataBytes)) {
+				*nalTypePosition = position;
+			}
+			count++;
+			mask &= mask - 1;
+		}
+	}
+	return hevcCountStartCodesScalar(data, dataBytes, nalType, nalTypePosition, i, count);
+}
+
+uint64_t hevcCountStartCodes(uint8_t* data, uint64_t dataBytes, uint32_t nalType, uint64_t* nalTypePosition, uint64_t isa) {
+	*nalTypePosition = dataBytes;
+	if (isa == HEVC_ISA_AVX2) {
+		return hevcCountStartCodesAVX2(data, dataBytes, nalType, nalTypePosition);
+	}
+	return hevcCountStartCodesScalar(data, dataBytes, nalType, nalTypePosition, 0, 0);
+}
+
+void hevcReaderSetup(rbspReader* reader, uint8_t* rbsp, uint8_t* nal, uint64_t nalBytes, uint64_t maxBytes, uint64_t isa) {
+	if (nalBytes > maxBytes) {
+		nalBytes = maxBytes;
+	}
+	uint64_t rbspBytes = hevcUnescape(rbsp, nal, nalBytes, isa);
+	reader->data = rbsp;
+	reader->bits = rbspBytes << 3;
+	reader->position = 16; //NAL unit header
+}
+
+//profile_tier_level(1, maxSubLayersMinus1): 12 general bytes then the sub-layer flags and their parts
+static void hevcSkipProfileTierLevel(rbspReader* reader, uint32_t maxSubLayersMinus1) {
+	rbspSkipBits(reader, 96);
+	if (maxSubLayersMinus1 == 0) {
+		return;
+	}
+	uint32_t subLayerFlags = rbspReadBits(reader, 16); //Pairs for 8 sub-layers (the unused ones are reserved)
+	for (uint32_t i = 0; i < maxSubLayersMinus1; i++) {
+		if (((subLayerFlags >> (15 - (i << 1))) & 1) == 1) {
+			rbspSkipBits(reader, 88);
+		}
+		if (((subLayerFlags >> (14 - (i << 1))) & 1) == 1) {
+			rbspSkipBits(reader, 8);
+		}
+	}
+}
+
+//scaling_list_data(): only skipped, the DC and list coefficients are se(v) codes
+static void hevcSkipScalingListData(rbspReader* reader) {
+	for (uint32_t sizeId = 0; sizeId < 4; sizeId++) {
+		for (uint32_t matrixId = 0; matrixId < 6; matrixId += (sizeId == 3) ? 3 : 1) {
+			if (rbspReadBits(reader, 1) == 0) { //scaling_list_pred_mode_flag
+				rbspReadUnsigned(reader); //scaling_list_pred_matrix_id_delta
+				continue;
+			}
+			uint32_t coefNum = (sizeId == 0) ? 16 : 64;
+			if (sizeId > 1) {
+				rbspReadSigned(reader); //scaling_list_dc_coef_minus8
+			}
+			for (uint32_t i = 0; (i < coefNum) && (rbspBitsLeft(reader) > 0); i++) {
+				rbspReadSigned(reader); //scaling_list_delta_coef
+			}
+		}
+	}
+}
+
+//st_ref_pic_set(idx) as it appears in the SPS (deltaPocCounts holds NumDeltaPocs of the earlier sets)
+static int hevcSkipShortTermRefPicSet(rbspReader* reader, uint32_t idx, uint32_t* deltaPocCounts) {
+	if ((idx > 0) && (rbspReadBits(reader, 1) == 1)) { //inter_ref_pic_set_prediction_flag
+		rbspSkipBits(reader, 1); //delta_rps_sign
+		rbspReadUnsigned(reader); //abs_delta_rps_minus1
+		uint32_t refDeltaPocs = deltaPocCounts[idx - 1]; //delta_idx_minus1 is only sent in slice headers
+		uint32_t deltaPocs = 0;
+		for (uint32_t j = 0; j <= refDeltaPocs; j++) {
+			uint32_t usedByCurrPic = rbspReadBits(reader, 1);
+			uint32_t useDelta = 1;
+			if (usedByCurrPic == 0) {
+				useDelta = rbspReadBits(reader, 1);
+			}
+			deltaPocs += ((usedByCurrPic | useDelta) > 0) ? 1 : 0;
+		}
+		deltaPocCounts[idx] = deltaPocs;
+		return 0;
+	}
+	uint32_t negativePics = rbspReadUnsigned(reader);
+	uint32_t positivePics = rbspReadUnsigned(reader);
+	if ((negativePics > 16) || (positivePics > 16)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	for (uint32_t i = 0; i < (negativePics + positivePics); i++) {
+		rbspReadUnsigned(reader); //delta_poc_s0_minus1 / delta_poc_s1_minus1
+		rbspSkipBits(reader, 1); //used_by_curr_pic_s0_flag / used_by_curr_pic_s1_flag
+	}
+	deltaPocCounts[idx] = negativePics + positivePics;
+	return 0;
+}
+
+//Walks the rest of the SPS up to vui_num_units_in_tick and vui_time_scale
+//(stops without timing on anything it cannot follow, the fields before it are already parsed)
+static void hevcParseSPSTiming(hevcParameterSets* sets, rbspReader* reader) {
+	rbspReadUnsigned(reader); //log2_min_luma_transform_block_size_minus2
+	rbspReadUnsigned(reader); //log2_diff_max_min_luma_transform_block_size
+	rbspReadUnsigned(reader); //max_transform_hierarchy_depth_inter
+	rbspReadUnsigned(reader); //max_transform_hierarchy_depth_intra
+	if (rbspReadBits(reader, 1) == 1) { //scaling_list_enabled_flag
+		if (rbspReadBits(reader, 1) == 1) { //sps_scaling_list_data_present_flag
+			hevcSkipScalingListData(reader);
+		}
+	}
+	rbspSkipBits(reader, 2); //amp_enabled_flag, sample_adaptive_offset_enabled_flag
+	if (rbspReadBits(reader, 1) == 1) { //pcm_enabled_flag
+		rbspSkipBits(reader, 8); //pcm_sample_bit_depth_luma_minus1, pcm_sample_bit_depth_chroma_minus1
+		rbspReadUnsigned(reader); //log2_min_pcm_luma_coding_block_size_minus3
+		rbspReadUnsigned(reader); //log2_diff_max_min_pcm_luma_coding_block_size
+		rbspSkipBits(reader, 1); //pcm_loop_filter_disabled_flag
+	}
+	uint32_t shortTermRefPicSets = rbspReadUnsigned(reader);
+	if (shortTermRefPicSets > 64) {
+		return;
+	}
+	uint32_t deltaPocCounts[64];
+	for (uint32_t i = 0; i < shortTermRefPicSets; i++) {
+		if ((hevcSkipShortTermRefPicSet(reader, i, deltaPocCounts) != 0) || (rbspBitsLeft(reader) == 0)) {
+			return;
+		}
+	}
+	if (rbspReadBits(reader, 1) == 1) { //long_term_ref_pics_present_flag
+		uint32_t longTermRefPics = rbspReadUnsigned(reader);
+		if (longTermRefPics > 32) {
+			return;
+		}
+		rbspSkipBits(reader, longTermRefPics * (sets->log2MaxPicOrderCntLsb + 1)); //lt_ref_pic_poc_lsb_sps, used_by_curr_pic_lt_sps_flag
+	}
+	rbspSkipBits(reader, 2); //sps_temporal_mvp_enabled_flag, strong_intra_smoothing_enabled_flag
+	if ((rbspBitsLeft(reader) == 0) || (rbspReadBits(reader, 1) == 0)) { //vui_parameters_present_flag
+		return;
+	}
+	
+	if (rbspReadBits(reader, 1) == 1) { //aspect_ratio_info_present_flag
+		if (rbspReadBits(reader, 8) == 255) { //EXTENDED_SAR
+			rbspSkipBits(reader, 32); //sar_width, sar_height
+		}
+	}
+	if (rbspReadBits(reader, 1) == 1) { //overscan_info_present_flag
+		rbspSkipBits(reader, 1); //overscan_appropriate_flag
+	}
+	if (rbspReadBits(reader, 1) == 1) { //video_signal_type_present_flag
+		rbspSkipBits(reader, 4); //video_format, video_full_range_flag
+		if (rbspReadBits(reader, 1) == 1) { //colour_description_present_flag
+			rbspSkipBits(reader, 24); //colour_primaries, transfer_characteristics, matrix_coeffs
+		}
+	}
+	if (rbspReadBits(reader, 1) == 1) { //chroma_loc_info_present_flag
+		rbspReadUnsigned(reader); //chroma_sample_loc_type_top_field
+		rbspReadUnsigned(reader); //chroma_sample_loc_type_bottom_field
+	}
+	rbspSkipBits(reader, 3); //neutral_chroma_indication_flag, field_seq_flag, frame_field_info_present_flag
+	if (rbspReadBits(reader, 1) == 1) { //default_display_window_flag
+		for (uint64_t i = 0; i < 4; i++) {
+			rbspReadUnsigned(reader);
+		}
+	}
+	if ((rbspBitsLeft(reader) > 64) && (rbspReadBits(reader, 1) == 1)) { //vui_timing_info_present_flag
+		uint32_t unitsInTick = rbspReadBits(reader, 32);
+		uint32_t timeScale = rbspReadBits(reader, 32);
+		if ((unitsInTick > 0) && (timeScale > 0)) {
+			sets->unitsInTick = unitsInTick;
+			sets->timeScale = timeScale;
+		}
+	}
+}
+
+int hevcParseSPS(hevcParameterSets* sets, rbspReader* reader) {
+	rbspSkipBits(reader, 4); //sps_video_parameter_set_id
+	uint32_t maxSubLayersMinus1 = rbspReadBits(reader, 3);
+	rbspSkipBits(reader, 1); //sps_temporal_id_nesting_flag
+	hevcSkipProfileTierLevel(reader, maxSubLayersMinus1);
+	
+	sets->spsId = rbspReadUnsigned(reader);
+	sets->chromaFormat = rbspReadUnsigned(reader);
+	sets->separateColourPlane = 0;
+	if (sets->chromaFormat == 3) {
+		sets->separateColourPlane = rbspReadBits(reader, 1);
+	}
+	sets->width = rbspReadUnsigned(reader);
+	sets->height = rbspReadUnsigned(reader);
+	if (rbspReadBits(reader, 1) == 1) { //conformance_window_flag
+		for (uint64_t i = 0; i < 4; i++) {
+			rbspReadUnsigned(reader);
+		}
+	}
+	sets->bitDepthLuma = rbspReadUnsigned(reader) + 8;
+	sets->bitDepthChroma = rbspReadUnsigned(reader) + 8;
+	sets->log2MaxPicOrderCntLsb = rbspReadUnsigned(reader) + 4;
+	
+	uint32_t subLayerOrderingInfo = rbspReadBits(reader, 1);
+	for (uint32_t i = (subLayerOrderingInfo == 1) ? 0 : maxSubLayersMinus1; i <= maxSubLayersMinus1; i++) {
+		rbspReadUnsigned(reader); //sps_max_dec_pic_buffering_minus1
+		rbspReadUnsigned(reader); //sps_max_num_reorder_pics
+		rbspReadUnsigned(reader); //sps_max_latency_increase_plus1
+	}
+	uint32_t log2MinCbSize = rbspReadUnsigned(reader) + 3;
+	sets->log2CtbSize = log2MinCbSize + rbspReadUnsigned(reader);
+	if ((sets->log2MaxPicOrderCntLsb > 16) || (sets->log2CtbSize < 4) || (sets->log2CtbSize > 6) || (rbspBitsLeft(reader) == 0)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	
+	uint32_t ctbSize = ((uint32_t) 1) << sets->log2CtbSize;
+	uint64_t picSizeInCtbs = ((uint64_t) ((sets->width + ctbSize - 1) >> sets->log2CtbSize)) * ((sets->height + ctbSize - 1) >> sets->log2CtbSize);
+	if ((picSizeInCtbs == 0) || (picSizeInCtbs > 0xFFFFFFFF)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	sets->picSizeInCtbs = (uint32_t) picSizeInCtbs;
+	sets->sliceAddressBits = 0;
+	while ((((uint64_t) 1) << sets->sliceAddressBits) < picSizeInCtbs) {
+		sets->sliceAddressBits++;
+	}
+	
+	sets->unitsInTick = 0;
+	sets->timeScale = 0;
+	hevcParseSPSTiming(sets, reader);
+	return 0;
+}
+
+int hevcParsePPS(hevcParameterSets* sets, rbspReader* reader) {
+	sets->ppsId = rbspReadUnsigned(reader);
+	uint32_t spsId = rbspReadUnsigned(reader);
+	sets->dependentSliceSegmentsEnabled = rbspReadBits(reader, 1);
+	sets->outputFlagPresent = rbspReadBits(reader, 1);
+	sets->numExtraSliceHeaderBits = rbspReadBits(reader, 3);
+	if ((spsId != sets->spsId) || (rbspBitsLeft(reader) == 0)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	return 0;
+}
+
+int hevcParseSliceHeader(hevcParameterSets* sets, rbspReader* reader, uint32_t nalType, hevcSliceHeader* header) {
+	header->nalType = nalType;
+	header->firstSliceSegmentInPic = rbspReadBits(reader, 1);
+	header->noOutputOfPriorPics = 0;
+	if ((nalType >= HEVC_NAL_BLA_W_LP) && (nalType <= HEVC_NAL_RSV_IRAP_VCL23)) {
+		header->noOutputOfPriorPics = rbspReadBits(reader, 1);
+	}
+	header->ppsId = rbspReadUnsigned(reader);
+	if (header->ppsId != sets->ppsId) {
+		return ERROR_PARSE_ISSUE;
+	}
+	
+	header->dependentSliceSegment = 0;
+	header->sliceSegmentAddress = 0;
+	if (header->firstSliceSegmentInPic == 0) {
+		if (sets->dependentSliceSegmentsEnabled == 1) {
+			header->dependentSliceSegment = rbspReadBits(reader, 1);
+		}
+		header->sliceSegmentAddress = rbspReadBits(reader, sets->sliceAddressBits);
+	}
+	
+	//Dependent slice segments take everything else from the slice they continue
+	header->sliceType = HEVC_SLICE_I;
+	header->picOutput = 1;
+	header->picOrderCntLsb = 0;
+	if (header->dependentSliceSegment == 0) {
+		rbspSkipBits(reader, sets->numExtraSliceHeaderBits);
+		header->sliceType = rbspReadUnsigned(reader);
+		if (sets->outputFlagPresent == 1) {
+			header->picOutput = rbspReadBits(reader, 1);
+		}
+		if (sets->separateColourPlane == 1) {
+			rbspSkipBits(reader, 2); //colour_plane_id
+		}
+		if ((nalType != HEVC_NAL_IDR_W_RADL) && (nalType != HEVC_NAL_IDR_N_LP)) {
+			header->picOrderCntLsb = rbspReadBits(reader, sets->log2MaxPicOrderCntLsb);
+		}
+	}
+	if ((header->sliceType > HEVC_SLICE_I) || (rbspBitsLeft(reader) == 0)) {
+		return ERROR_PARSE_ISSUE;
+	}
+	return 0;
+}
@@ -0,0 +1,180 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced HEVC Header Parsing Definitions
+//Emulation prevention bytes (00 00 03) come out of a NAL unit once, into a
+//scratch buffer (with an AVX2 scan when the CPU has it), and the raw byte
+//sequence payload that is left gets read 64 bits at a time: fixed length
+//fields are a shift of one big endian load and Exp-Golomb codes find their
+//prefix length with a single count leading zeros
+//The parameter set and slice header parsers only go as far as the fields the
+//per frame work needs (slice type and picture order count)
+#ifndef MEDIA_ENHANCED_HEVC_HEADERS_H
+#define MEDIA_ENHANCED_HEVC_HEADERS_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+#define HEVC_NAL_BLA_W_LP 16
+#define HEVC_NAL_IDR_W_RADL 19
+#define HEVC_NAL_IDR_N_LP 20
+#define HEVC_NAL_RSV_IRAP_VCL23 23
+#define HEVC_NAL_VPS 32
+#define HEVC_NAL_SPS 33
+#define HEVC_NAL_PPS 34
+
+#define HEVC_SLICE_B 0
+#define HEVC_SLICE_P 1
+#define HEVC_SLICE_I 2
+
+//Scratch buffers need this much room past the NAL unit bytes (vector stores and the 64 bit loads past the end)
+#define HEVC_RBSP_EXTRA_BYTES 48
+#define HEVC_SLICE_HEADER_BYTES 256 //Only this much of a slice NAL gets unescaped for its header
+
+#define HEVC_ISA_SCALAR 0
+#define HEVC_ISA_AVX2 1
+
+typedef struct rbspReader {
+	uint8_t* data; //Unescaped payload followed by at least 8 readable bytes
+	uint64_t bits;
+	uint64_t position; //Next bit to read
+} rbspReader;
+
+//The next 57+ bits starting at the current position in the top bits
+static inline uint64_t rbspPeek(rbspReader* reader) {
+	uint64_t word = *((uint64_t*) (&(reader->data[reader->position >> 3])));
+	return __builtin_bswap64(word) << (reader->position & 7);
+}
+
+//Reads 0 to 32 bits as an unsigned value
+static inline uint32_t rbspReadBits(rbspReader* reader, uint64_t numBits) {
+	if (numBits == 0) {
+		return 0;
+	}
+	uint64_t value = rbspPeek(reader) >> (64 - numBits);
+	reader->position += numBits;
+	return (uint32_t) value;
+}
+
+static inline void rbspSkipBits(rbspReader* reader, uint64_t numBits) {
+	reader->position += numBits;
+}
+
+//ue(v): leadingZeros zero bits, a one, then leadingZeros bits of value
+//Codes longer than a peek (over 28 leading zeros) take a second load and codes
+//over 31 leading zeros (never valid) saturate
+static inline uint32_t rbspReadUnsigned(rbspReader* reader) {
+	uint64_t word = rbspPeek(reader);
+	uint64_t leadingZeros = (uint64_t) __builtin_clzll(word | 1);
+	if (leadingZeros <= 28) {
+		reader->position += (leadingZeros << 1) + 1;
+		return (uint32_t) ((word >> (63 - (leadingZeros << 1))) - 1);
+	}
+	if (leadingZeros > 31) {
+		reader->position += 32;
+		return 0xFFFFFFFF;
+	}
+	reader->position += leadingZeros;
+	return (uint32_t) ((((uint64_t) rbspReadBits(reader, leadingZeros + 1))) - 1);
+}
+
+//se(v): 1, -1, 2, -2, ... for the unsigned values 1, 2, 3, 4, ...
+static inline int32_t rbspReadSigned(rbspReader* reader) {
+	uint32_t value = rbspReadUnsigned(reader);
+	if ((value & 1) == 1) {
+		return (int32_t) ((value >> 1) + 1);
+	}
+	return -((int32_t) (value >> 1));
+}
+
+//Byte aligned fields of valueBytes (up to 8) then skipBytes more bytes
+static inline uint64_t rbspReadBytes(rbspReader* reader, uint64_t valueBytes, uint64_t skipBytes) {
+	uint64_t value = 0;
+	if (valueBytes > 4) {
+		value = ((uint64_t) rbspReadBits(reader, 32)) << ((valueBytes - 4) << 3);
+		valueBytes -= 4;
+	}
+	value |= rbspReadBits(reader, valueBytes << 3);
+	reader->position += skipBytes << 3;
+	return value;
+}
+
+static inline uint64_t rbspBitsLeft(rbspReader* reader) {
+	if (reader->position >= reader->bits) {
+		return 0;
+	}
+	return reader->bits - reader->position;
+}
+
+uint64_t hevcGetMaxISA();
+
+//Copies the NAL unit (header included) to rbsp without its emulation prevention bytes
+//rbsp needs nalBytes + HEVC_RBSP_EXTRA_BYTES and the bytes after the payload get zeroed
+uint64_t hevcUnescape(uint8_t* rbsp, uint8_t* nal, uint64_t nalBytes, uint64_t isa);
+
+//Counts the start codes (00 00 01) in the data and finds where the first start code of a
+//nalType NAL unit is (dataBytes when there is none), 32 bytes at a time with AVX2
+uint64_t hevcCountStartCodes(uint8_t* data, uint64_t dataBytes, uint32_t nalType, uint64_t* nalTypePosition, uint64_t isa);
+
+//Unescapes at most maxBytes of the NAL unit and points the reader past its 2 byte header
+void hevcReaderSetup(rbspReader* reader, uint8_t* rbsp, uint8_t* nal, uint64_t nalBytes, uint64_t maxBytes, uint64_t isa);
+
+//What the slice headers of the stream depend on (one SPS and one PPS like the recorder writes)
+typedef struct hevcParameterSets {
+	uint32_t spsId;
+	uint32_t ppsId;
+	uint32_t chromaFormat;
+	uint32_t separateColourPlane;
+	uint32_t width;
+	uint32_t height;
+	uint32_t bitDepthLuma;
+	uint32_t bitDepthChroma;
+	uint32_t log2MaxPicOrderCntLsb;
+	uint32_t log2CtbSize;
+	uint32_t picSizeInCtbs;
+	uint32_t sliceAddressBits; //Ceil(Log2(picSizeInCtbs))
+	uint32_t dependentSliceSegmentsEnabled;
+	uint32_t outputFlagPresent;
+	uint32_t numExtraSliceHeaderBits;
+	uint32_t unitsInTick; //SPS VUI frame timing (both 0 when the stream has none)
+	uint32_t timeScale;
+} hevcParameterSets;
+
+typedef struct hevcSliceHeader {
+	uint32_t nalType;
+	uint32_t firstSliceSegmentInPic;
+	uint32_t noOutputOfPriorPics;
+	uint32_t ppsId;
+	uint32_t dependentSliceSegment;
+	uint32_t sliceSegmentAddress;
+	uint32_t sliceType;
+	uint32_t picOutput;
+	uint32_t picOrderCntLsb;
+} hevcSliceHeader;
+
+//Readers start right after the 2 byte NAL unit header
+int hevcParseSPS(hevcParameterSets* sets, rbspReader* reader);
+int hevcParsePPS(hevcParameterSets* sets, rbspReader* reader);
+int hevcParseSliceHeader(hevcParameterSets* sets, rbspReader* reader, uint32_t nalType, hevcSliceHeader* header);
+
+#endif
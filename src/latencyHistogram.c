@@ -0,0 +1,176 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Latency Histogram Functions
+#define COMPATIBILITY_NETWORK_UNNEEDED //Do not need networking
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions
+#include "latencyHistogram.h" //Include Latency Histogram Function Definitions
+#include "bitstreamContainer.h" //Shared buffered text writer
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define LATENCY_JSON_BUFFER_BYTES 65536
+#define LATENCY_JSON_FLUSH_BYTES 61440 //Leaves room for the longest single put
+
+void latencyHistogramReset(latencyHistogram* histogram) {
+	memzeroBasic(histogram, sizeof(latencyHistogram));
+}
+
+//Values below 32 get their own bucket, every bigger power of two gets split into 32
+static uint64_t latencyBucket(uint64_t value) {
+	if (value < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+		return value;
+	}
+	uint64_t shift = (63 - __builtin_clzll(value)) - LATENCY_HISTOGRAM_SUB_BITS;
+	return ((shift + 1) << LATENCY_HISTOGRAM_SUB_BITS) + ((value >> shift) - LATENCY_HISTOGRAM_SUB_BUCKETS);
+}
+
+static uint64_t latencyBucketLowest(uint64_t bucket) {
+	if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+		return bucket;
+	}
+	uint64_t shift = (bucket >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+	return ((bucket & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1)) + LATENCY_HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+static uint64_t latencyBucketHighest(uint64_t bucket) {
+	if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+		return bucket;
+	}
+	uint64_t shift = (bucket >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+	return ((((bucket & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1)) + LATENCY_HISTOGRAM_SUB_BUCKETS + 1) << shift) - 1);
+}
+
+void latencyHistogramRecord(latencyHistogram* histogram, uint64_t nanoseconds) {
+	__atomic_fetch_add(&(histogram->buckets[latencyBucket(nanoseconds)]), 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(histogram->sum), nanoseconds, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(histogram->count), 1, __ATOMIC_RELAXED);
+	uint64_t max = __atomic_load_n(&(histogram->max), __ATOMIC_RELAXED);
+	while (nanoseconds > max) {
+		if (__atomic_compare_exchange_n(&(histogram->max), &max, nanoseconds, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+}
+
+uint64_t latencyHistogramPercentile(latencyHistogram* histogram, uint64_t basisPoints) {
+	uint64_t count = __atomic_load_n(&(histogram->count), __ATOMIC_RELAXED);
+	if (count == 0) {
+		return 0;
+	}
+	uint64_t target = ((count * basisPoints) + 9999) / 10000; //Rounded up so p100 is the last value
+	if (target == 0) {
+		target = 1;
+	}
+	uint64_t max = __atomic_load_n(&(histogram->max), __ATOMIC_RELAXED);
+	uint64_t seen = 0;
+	for (uint64_t b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+		seen += __atomic_load_n(&(histogram->buckets[b]), __ATOMIC_RELAXED);
+		if (seen >= target) {
+			uint64_t highest = latencyBucketHighest(b);
+			return (highest < max) ? highest : max;
+		}
+	}
+	return max;
+}
+
+//Buffered JSON Output
+static char latencyJSONBuffer[LATENCY_JSON_BUFFER_BYTES];
+
+static int latencyJSONWriteHistogram(bitstreamTextWriter* writer, latencyHistogram* histogram, char* name) {
+	static char* fieldNames[7] = {"count", "meanNs", "p50Ns", "p90Ns", "p99Ns", "p999Ns", "maxNs"};
+	uint64_t fields[7];
+	fields[0] = histogram->count;
+	fields[1] = (histogram->count > 0) ? (histogram->sum / histogram->count) : 0;
+	fields[2] = latencyHistogramPercentile(histogram, 5000);
+	fields[3] = latencyHistogramPercentile(histogram, 9000);
+	fields[4] = latencyHistogramPercentile(histogram, 9900);
+	fields[5] = latencyHistogramPercentile(histogram, 9990);
+	fields[6] = histogram->max;
+	
+	int error = bitstreamTextPut(writer, "\t\"");
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(writer, name);
+	RETURN_ON_ERROR(error);
+	error = bitstreamTextPut(writer, "\": {\n");
+	RETURN_ON_ERROR(error);
+	for (uint64_t f = 0; f < 7; f++) {
+		error = bitstreamTextPut(writer, "\t\t\"");
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPut(writer, fieldNames[f]);
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPut(writer, "\": ");
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPutNumber(writer, fields[f]);
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPut(writer, ",\n");
+		RETURN_ON_ERROR(error);
+	}
+	
+	//Pairs of [lowest value in ns, count] so histograms from many runs can be merged
+	error = bitstreamTextPut(writer, "\t\t\"buckets\": [");
+	RETURN_ON_ERROR(error);
+	uint64_t written = 0;
+	for (uint64_t b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+		if (histogram->buckets[b] == 0) {
+			continue;
+		}
+		error = bitstreamTextPut(writer, (written > 0) ? ", [" : "[");
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPutNumber(writer, latencyBucketLowest(b));
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPut(writer, ", ");
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPutNumber(writer, histogram->buckets[b]);
+		RETURN_ON_ERROR(error);
+		error = bitstreamTextPut(writer, "]");
+		RETURN_ON_ERROR(error);
+		written++;
+	}
+	return bitstreamTextPut(writer, "]\n\t}");
+}
+
+int latencyHistogramWriteJSON(char* fileName, latencyHistogram* histograms, char** names, uint64_t histogramCount) {
+	bitstreamTextWriter writer;
+	int error = bitstreamTextOpen(&writer, fileName, latencyJSONBuffer, LATENCY_JSON_FLUSH_BYTES);
+	RETURN_ON_ERROR(error);
+	
+	error = bitstreamTextPut(&writer, "{\n\t\"subBucketBits\": ");
+	if (error == 0) {
+		error = bitstreamTextPutNumber(&writer, LATENCY_HISTOGRAM_SUB_BITS);
+	}
+	if (error == 0) {
+		error = bitstreamTextPut(&writer, ",\n");
+	}
+	for (uint64_t h = 0; (h < histogramCount) && (error == 0); h++) {
+		error = latencyJSONWriteHistogram(&writer, &(histograms[h]), names[h]);
+		if (error == 0) {
+			error = bitstreamTextPut(&writer, ((h + 1) < histogramCount) ? ",\n" : "\n");
+		}
+	}
+	if (error == 0) {
+		error = bitstreamTextPut(&writer, "}\n");
+	}
+	return bitstreamTextClose(&writer, error);
+}
@@ -0,0 +1,58 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+//Media Enhanced Latency Histogram Definitions
+//Log-linear (HDR style) histograms of nanosecond latencies: every power of two
+//range gets 32 equal buckets, so any recorded value is kept within about 3%
+//from 1ns up to the full 64 bit range with a fixed 15 KiB per histogram
+//Recording is a few relaxed atomic adds (no locks) so any thread can record
+//into the same histogram while the recorder's main loop keeps running
+#ifndef MEDIA_ENHANCED_LATENCY_HISTOGRAM_H
+#define MEDIA_ENHANCED_LATENCY_HISTOGRAM_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#define LATENCY_HISTOGRAM_SUB_BUCKETS 32 //Buckets per power of two
+#define LATENCY_HISTOGRAM_BUCKETS ((64 - LATENCY_HISTOGRAM_SUB_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct latencyHistogram {
+	uint64_t count;
+	uint64_t sum; //Nanoseconds
+	uint64_t max;
+	uint64_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+} latencyHistogram;
+
+void latencyHistogramReset(latencyHistogram* histogram);
+void latencyHistogramRecord(latencyHistogram* histogram, uint64_t nanoseconds);
+
+//Highest value of the bucket that holds the percentile (basis points: 9990 is p99.9)
+//never more than the largest recorded value (0 when nothing got recorded)
+uint64_t latencyHistogramPercentile(latencyHistogram* histogram, uint64_t basisPoints);
+
+//Writes the count, mean, p50 / p90 / p99 / p99.9, max and the non-empty buckets
+//(lowest value and count) of every histogram as one JSON object keyed by the names
+int latencyHistogramWriteJSON(char* fileName, latencyHistogram* histograms, char** names, uint64_t histogramCount);
+
+#endif
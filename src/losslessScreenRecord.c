@@ -34,103 +34,25 @@
 #include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & Common Vulkan & <stdint.h>
 #include "math.h" //Includes the math function definitions
 #include "include/nvEncodeAPI.h" //Includes the NVIDIA Encoder API
+#include "frameSource.h" //Includes the Frame Source interface (Desktop Duplication plugs into it)
+#include "encoderBackend.h" //Includes the Encoder Backend interface (NVENC plugs into it)
+#include "colorConvert.h" //Includes the sRGB to xvYCbCr LUT generation (full & partial)
+#include "bitstreamContainer.h" //Includes the seek table trailer and checkpoint journal for the output file
+#include "latencyHistogram.h" //Includes the per stage latency histograms
+#include "frameTrace.h" //Includes the per frame trace ring
+#include "telemetry.h" //Includes the once a second metrics publisher
+#include "bitstreamRollover.h" //Includes the segment file rollover (one file when not splitting)
 
 //During the Make process the GLSL Vulkan Compute Shader gets compiled to SPIR-V
 //and then this binary data gets linked into the program via the following definitons
 extern uint64_t shader_size;
 extern uint8_t  shader_data[];
+extern uint64_t shaderPartial_size;
+extern uint8_t  shaderPartial_data[];
 
-//Definition constants used for sRGB loops:
-#define SRGB_MAX_VALUE 256
-#define NUM_SRGB_VALUES 16777216
-
-//sRGB to xvYCbCr LUT generation for both 601 (sYCC) and 709 (version > 0)
-//Using ITU-T H.273 as a reference
-//Color Primaries are always from 709:
-//    x       y    primary
-// 0.300   0.600   green
-// 0.150   0.060   blue
-// 0.640   0.330   red
-// 0.3127  0.3290  white D65
-//10-bit version when bits > 0, otherwise 8-bit version
-void populateSRGBtoXVYCbCrLUT(uint32_t* lutData, uint32_t version, uint32_t bits) {
-	double Kr = 0.299;
-	double Kb = 0.114;
-	if (version > 0) {
-		Kr = 0.2126;
-		Kb = 0.0722;
-	}
-	double Kg = (1.0 - Kr) - Kb;	
-	double CbMult = 0.5 / (1.0 - Kb);
-	double CrMult = 0.5 / (1.0 - Kr);
-	
-	double sRGBranged = 1.0 / 255.0;
-	
-	double bitFactor = 255.0;
-	if (bits > 0) {
-		bitFactor = 1023.0;
-	}
-	
-	uint32_t* xvYCbCr = lutData;
-	
-	for (uint32_t red = 0; red < SRGB_MAX_VALUE; red++) {
-		double R = ((double) red) * sRGBranged;
-		double Yr = Kr * R;
-		for (uint32_t green = 0; green < SRGB_MAX_VALUE; green++) {
-			double G = ((double) green) * sRGBranged;
-			double Yrg = (Kg * G) + Yr;
-			for (uint32_t blue = 0; blue < SRGB_MAX_VALUE; blue++) {
-				double B = ((double) blue) * sRGBranged;
-				double Y = (Kb * B) + Yrg;
-				
-				double Cb = B - Y;
-				double Cr = R - Y;
-				Cb *= CbMult;
-				Cr *= CrMult;
-				Cb += 0.5;
-				Cr += 0.5;
-				
-				Y *= bitFactor;
-				if (Y > bitFactor) {
-					Y = bitFactor;
-				}
-				else if (Y < 0.0) {
-					Y = 0.0;
-				}
-				
-				Cb *= bitFactor;
-				Cb += 0.5; //Needed only for FFMPEG almost perfect conversion
-				if (Cb > bitFactor) {
-					Cb = bitFactor;
-				}
-				else if (Cb < 0.0) {
-					Cb = 0.0;
-				}
-				
-				Cr *= bitFactor;
-				Cr += 0.5; //Needed only for FFMPEG almost perfect conversion
-				if (Cr > bitFactor) {
-					Cr = bitFactor;
-				}
-				else if (Cr < 0.0) {
-					Cr = 0.0;
-				}
-				
-				int32_t Yint = roundDouble(Y);
-				int32_t Cbint = roundDouble(Cb);
-				int32_t Crint = roundDouble(Cr);
-				
-				if (bits == 0) {
-					*xvYCbCr = (Yint << 16) | (Cbint << 8) | Crint;
-				}
-				else {
-					*xvYCbCr = (Yint << 20) | (Cbint << 10) | Crint;
-				}
-				xvYCbCr++;
-			}
-		}
-	}
-}
+//The partial LUT shader (shaderPartial.comp.glsl) gives the exact same output as the
+//full LUT shader from a 16 KiB table instead of the 64 MiB one (0 to use the full LUT)
+static uint32_t lutPartial = 1;
 
 static VkDevice device = VK_NULL_HANDLE;
 static VkQueue computeQueue = VK_NULL_HANDLE;
@@ -205,7 +127,11 @@ int setupVulkanCompute(uint32_t width, uint32_t height) {
 	
 	
 	//Create a Vulkan Staging Buffer:
-	VkDeviceSize lutSize = NUM_SRGB_VALUES * sizeof(uint32_t);
+	VkDeviceSize lutSize = NUM_SRGB_VALUES * sizeof(uint32_t); //Staging buffer size
+	VkDeviceSize lutBufferSize = lutSize;
+	if (lutPartial > 0) {
+		lutBufferSize = COLOR_PARTIAL_LUT_WORDS * sizeof(uint32_t);
+	}
 	VkBufferCreateInfo bufferInfo;
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.pNext = NULL;
@@ -222,6 +148,7 @@ int setupVulkanCompute(uint32_t width, uint32_t height) {
 	}
 	
 	//Create Vulkan LUT Bufferthat will be used to store the sRGB Color Conversion LUT
+	bufferInfo.size = lutBufferSize;
 	bufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT; //VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 	
 	result = vkCreateBuffer(device, &bufferInfo, VULKAN_ALLOCATOR, &lutBuffer);
@@ -360,7 +287,7 @@ int setupVulkanCompute(uint32_t width, uint32_t height) {
 	VkBufferCopy bufferCopyRegion;
 	bufferCopyRegion.srcOffset = 0;
 	bufferCopyRegion.dstOffset = 0;
-	bufferCopyRegion.size = lutSize;
+	bufferCopyRegion.size = lutBufferSize;
 	
 	vkCmdCopyBuffer(lutTransfer, stageBuffer, lutBuffer, 1, &bufferCopyRegion);
 	
@@ -521,6 +448,10 @@ int setupVulkanCompute(uint32_t width, uint32_t height) {
 	shaderModuleInfo.flags = 0;
 	shaderModuleInfo.codeSize = shader_size; //Extern Variable
 	shaderModuleInfo.pCode = (uint32_t*) shader_data; //Extern Variable
+	if (lutPartial > 0) {
+		shaderModuleInfo.codeSize = shaderPartial_size; //Extern Variable
+		shaderModuleInfo.pCode = (uint32_t*) shaderPartial_data; //Extern Variable
+	}
 	//consoleWriteLineSlow("Got Here!");
 	
 	result = vkCreateShaderModule(device, &shaderModuleInfo, VULKAN_ALLOCATOR, &computeShaderModule);
@@ -768,11 +699,15 @@ static void* nvidiaEncoderLibrary = NULL;
 typedef NVENCSTATUS (NVENCAPI *PFN_NvEncodeAPICreateInstance)(NV_ENCODE_API_FUNCTION_LIST *functionList);
 static NV_ENCODE_API_FUNCTION_LIST nvEncFunList;
 static void* nvEncoder = NULL;
-static NV_ENC_CREATE_BITSTREAM_BUFFER nvEncBitstreamBuff0;
-static NV_ENC_CREATE_BITSTREAM_BUFFER nvEncBitstreamBuff1;
+#define NVENC_BITSTREAM_BUFFER_MAX 32 //Output ring slots (encoded frames waiting on the disk)
+static NV_ENC_CREATE_BITSTREAM_BUFFER nvEncBitstreamBuffs[NVENC_BITSTREAM_BUFFER_MAX];
+static uint64_t nvEncBitstreamBuffCount = 0;
 static NV_ENC_PIC_PARAMS nvEncPicParams;
 
-int setupNvidiaEncoder(uint32_t width, uint32_t height, uint64_t fps, void* ioTempBuffer) {
+int setupNvidiaEncoder(uint32_t width, uint32_t height, uint64_t fps, uint64_t bitstreamBuffCount, void* ioTempBuffer) {
+	if ((bitstreamBuffCount < 2) || (bitstreamBuffCount > NVENC_BITSTREAM_BUFFER_MAX)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
 	int error = nvidiaCudaSetup(&cudaDevice, &nvCuFun);
 	RETURN_ON_ERROR(error);
 	
@@ -1215,35 +1150,24 @@ int setupNvidiaEncoder(uint32_t width, uint32_t height, uint64_t fps, void* ioTe
 	//consoleWaitForEnter();
 	
 	
-	//Create Bitstream Buffer Output ...Should auto allocate based on image dimensons and max B frames
-	//Might need to create multiple buffers depending on how it will be encoded
-	nvEncBitstreamBuff0.version = NV_ENC_CREATE_BITSTREAM_BUFFER_VER;
-	nvEncRes = nvEncFunList.nvEncCreateBitstreamBuffer(nvEncoder, &nvEncBitstreamBuff0);
-	if (nvEncRes != NV_ENC_SUCCESS) {
-		//nvidiaError = (int) nvEncRes;
-		return ERROR_NVENC_CANNOT_CREATE_BITSTREAM;
-	}
-	
-	//Extra safe
-	nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuff0.bitstreamBuffer);
-	if (nvEncRes != NV_ENC_SUCCESS) {
-		//nvidiaError = (int) nvEncRes;
-		return ERROR_NVENC_CANNOT_UNLOCK_BITSTREAM;
-	}
-	
-	nvEncBitstreamBuff1.version = NV_ENC_CREATE_BITSTREAM_BUFFER_VER;
-	nvEncRes = nvEncFunList.nvEncCreateBitstreamBuffer(nvEncoder, &nvEncBitstreamBuff1);
-	if (nvEncRes != NV_ENC_SUCCESS) {
-		//nvidiaError = (int) nvEncRes;
-		return ERROR_NVENC_CANNOT_CREATE_BITSTREAM;
-	}
-	
-	//Extra safe
-	nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuff1.bitstreamBuffer);
-	if (nvEncRes != NV_ENC_SUCCESS) {
-		//nvidiaError = (int) nvEncRes;
-		return ERROR_NVENC_CANNOT_UNLOCK_BITSTREAM;
+	//Create Bitstream Buffer Outputs ...Should auto allocate based on image dimensons and max B frames
+	//One per output ring slot so encoding can keep going while earlier frames wait on the disk
+	for (uint64_t b = 0; b < bitstreamBuffCount; b++) {
+		nvEncBitstreamBuffs[b].version = NV_ENC_CREATE_BITSTREAM_BUFFER_VER;
+		nvEncRes = nvEncFunList.nvEncCreateBitstreamBuffer(nvEncoder, &(nvEncBitstreamBuffs[b]));
+		if (nvEncRes != NV_ENC_SUCCESS) {
+			//nvidiaError = (int) nvEncRes;
+			return ERROR_NVENC_CANNOT_CREATE_BITSTREAM;
+		}
+		
+		//Extra safe
+		nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuffs[b].bitstreamBuffer);
+		if (nvEncRes != NV_ENC_SUCCESS) {
+			//nvidiaError = (int) nvEncRes;
+			return ERROR_NVENC_CANNOT_UNLOCK_BITSTREAM;
+		}
 	}
+	nvEncBitstreamBuffCount = bitstreamBuffCount;
 	
 	//consoleWriteLineSlow("Nvidia Bitstreams Create");
 	//consoleBufferFlush();
@@ -1261,7 +1185,7 @@ int setupNvidiaEncoder(uint32_t width, uint32_t height, uint64_t fps, void* ioTe
 	nvEncPicParams.inputDuration = 0; //Figure Out Later
 	
 	nvEncPicParams.inputBuffer = nvEncMappedInput.mappedResource;
-	nvEncPicParams.outputBitstream = nvEncBitstreamBuff0.bitstreamBuffer;
+	nvEncPicParams.outputBitstream = nvEncBitstreamBuffs[0].bitstreamBuffer;
 	nvEncPicParams.completionEvent = NULL;
 	
 	nvEncPicParams.bufferFmt = nvEncChosenFormat;//nvEncMappedInput.mappedBufferFmt; //Check Values are equal in future
@@ -1286,9 +1210,43 @@ int loadVulkanLUT() {
 		return ERROR_VULKAN_MEM_MAP_FAILED;
 	}
 	
-	populateSRGBtoXVYCbCrLUT(lutBufferPtr, 1, 1);
+	//Read from the cache file or generated straight into the mapped staging buffer
+	uint32_t lutKind = COLOR_LUT_KIND_FULL;
+	uint64_t lutBytes = NUM_SRGB_VALUES * sizeof(uint32_t);
+	if (lutPartial > 0) {
+		lutKind = COLOR_LUT_KIND_PARTIAL;
+		lutBytes = COLOR_PARTIAL_LUT_WORDS * sizeof(uint32_t);
+	}
+	uint64_t startTime = getCurrentTime();
+	uint64_t cacheHit = 1;
+	int error = colorLUTCacheLoad(lutBufferPtr, lutBytes, lutKind, 1, 1);
+	if (error != 0) {
+		cacheHit = 0;
+		uint64_t threadCount = syncGetProcessorCount(); //Split by red planes across every processor
+		if (threadCount > COLOR_CONVERT_THREAD_MAX) {
+			threadCount = COLOR_CONVERT_THREAD_MAX;
+		}
+		error = colorConvertSetupThreads(threadCount);
+		if (error == 0) {
+			if (lutPartial > 0) {
+				error = populateSRGBtoXVYCbCrPartialLUTParallel(lutBufferPtr);
+			}
+			else {
+				error = populateSRGBtoXVYCbCrLUTParallel(lutBufferPtr, 1, 1, colorConvertGetMaxISA());
+			}
+			colorConvertCleanupThreads();
+		}
+	}
+	uint64_t stopTime = getCurrentTime();
 	
+	if ((error == 0) && (cacheHit == 0)) { //The next launch can skip the generation
+		if (colorLUTCacheSave(lutBufferPtr, lutBytes, lutKind, 1, 1) != 0) {
+			consolePrintLine(92);
+		}
+	}
 	vkUnmapMemory(device, stageBufferMemory);
+	RETURN_ON_ERROR(error);
+	consolePrintLineWithNumber(90 + cacheHit, getDiffTimeMicroseconds(startTime, stopTime), NUM_FORMAT_UNSIGNED_INTEGER);
 	
 	//Copy from lut data from staging to LUT
 	VkSubmitInfo submitInfo;
@@ -1301,7 +1259,7 @@ int loadVulkanLUT() {
 	submitInfo.pCommandBuffers = &transferCommandBuffers[0];
 	submitInfo.signalSemaphoreCount = 0;
 	submitInfo.pSignalSemaphores = NULL;
-
+	
 	vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
 	vkQueueWaitIdle(transferQueue); //Fence in future
 	
@@ -1368,7 +1326,7 @@ int encodeOneFrame() {
 	nvEncBitstreamLock.version = NV_ENC_LOCK_BITSTREAM_VER;
 	nvEncBitstreamLock.doNotWait = 0;
 	nvEncBitstreamLock.getRCStats = 0;
-	nvEncBitstreamLock.outputBitstream = nvEncBitstreamBuff0.bitstreamBuffer;
+	nvEncBitstreamLock.outputBitstream = nvEncBitstreamBuffs[0].bitstreamBuffer;
 	nvEncBitstreamLock.sliceOffsets = NULL;
 	
 	nvEncRes = nvEncFunList.nvEncLockBitstream(nvEncoder, &nvEncBitstreamLock);
@@ -1384,7 +1342,7 @@ int encodeOneFrame() {
 	error = ioCloseFile(&h265File);
 	RETURN_ON_ERROR(error);
 	
-	nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuff0.bitstreamBuffer);
+	nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuffs[0].bitstreamBuffer);
 	if (nvEncRes != NV_ENC_SUCCESS) {
 		//nvidiaError = nvEncRes;
 		return ERROR_NVENC_EXTRA_INFO;
@@ -1393,8 +1351,99 @@ int encodeOneFrame() {
 	return 0;
 }
 
-static NV_ENC_LOCK_BITSTREAM ddEncodeBitstreamLock0 = {0};
-static NV_ENC_LOCK_BITSTREAM ddEncodeBitstreamLock1 = {0};
+static NV_ENC_LOCK_BITSTREAM ddEncodeBitstreamLocks[NVENC_BITSTREAM_BUFFER_MAX] = {0};
+
+//NVENC as an Encoder Backend (each output ring slot is one NVENC bitstream buffer)
+//NVENC hands back its own buffer with nothing writable in front, so the lock thread copies
+//each access unit into the slot's staging buffer after ENCODER_HEADER_ROOM_BYTES and unlocks
+//right away: the main loop then writes the reserved NAL and the frame with one WriteFile
+//(the staging buffers are sized for the worst case but only touched up to the real frame sizes)
+static encoderBackend ddEncoder;
+static uint8_t* ddLockedBitstreams[NVENC_BITSTREAM_BUFFER_MAX];
+static uint64_t ddLockedBytes[NVENC_BITSTREAM_BUFFER_MAX];
+static uint8_t* ddStagingBuffers[NVENC_BITSTREAM_BUFFER_MAX];
+static uint64_t ddStagingCapacity = 0; //Access unit bytes that fit after the header room
+
+static int nvencEncodeFrame(uint64_t slot, uint64_t forceIDR) {
+	if (forceIDR == ENCODER_FORCE_IDR) {
+		nvEncPicParams.encodePicFlags = NV_ENC_PIC_FLAG_FORCEIDR | NV_ENC_PIC_FLAG_OUTPUT_SPSPPS;
+	}
+	else if (forceIDR > 0) {
+		nvEncPicParams.encodePicFlags = NV_ENC_PIC_FLAG_FORCEINTRA; //nvEncPicParams.pictureType = NV_ENC_PIC_TYPE_IDR; //NV_ENC_PIC_TYPE_I;
+	}
+	else {
+		nvEncPicParams.encodePicFlags = 0; //nvEncPicParams.pictureType = NV_ENC_PIC_TYPE_P;
+	}
+	nvEncPicParams.outputBitstream = nvEncBitstreamBuffs[slot].bitstreamBuffer;
+	
+	NVENCSTATUS nvEncRes = nvEncFunList.nvEncEncodePicture(nvEncoder, &nvEncPicParams);
+	if (nvEncRes != NV_ENC_SUCCESS) {
+		//nvidiaError = nvEncRes;
+		return ERROR_NVENC_EXTRA_INFO;
+	}
+	return 0;
+}
+
+static int nvencLockBitstream(uint64_t slot, uint8_t** bitstreamPtr, uint64_t* bitstreamBytes) {
+	NVENCSTATUS nvEncRes = nvEncFunList.nvEncLockBitstream(nvEncoder, &(ddEncodeBitstreamLocks[slot]));
+	if (nvEncRes != NV_ENC_SUCCESS) {
+		return ERROR_NVENC_EXTRA_INFO;
+	}
+	uint64_t accessUnitBytes = ddEncodeBitstreamLocks[slot].bitstreamSizeInBytes;
+	int error = 0;
+	if (accessUnitBytes <= ddStagingCapacity) {
+		memcpyBasic(&(ddStagingBuffers[slot][ENCODER_HEADER_ROOM_BYTES]), ddEncodeBitstreamLocks[slot].bitstreamBufferPtr, accessUnitBytes);
+	}
+	else {
+		error = ERROR_ENCODER_BITSTREAM_TOO_BIG;
+	}
+	nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuffs[slot].bitstreamBuffer);
+	RETURN_ON_ERROR(error);
+	if (nvEncRes != NV_ENC_SUCCESS) {
+		//nvidiaError = nvEncRes;
+		return ERROR_NVENC_EXTRA_INFO;
+	}
+	*bitstreamPtr = &(ddStagingBuffers[slot][ENCODER_HEADER_ROOM_BYTES]);
+	*bitstreamBytes = accessUnitBytes;
+	return 0;
+}
+
+static int nvencUnlockBitstream(uint64_t slot) {
+	return 0; //Already unlocked once the access unit got copied (the staging buffer only gets reused by the next lock of the slot)
+}
+
+static void nvencCleanup() {
+	nvEncFunList.nvEncDestroyEncoder(nvEncoder);
+	for (uint64_t b = 0; b < nvEncBitstreamBuffCount; b++) {
+		if (ddStagingBuffers[b] != NULL) {
+			memoryDeallocate((void**) &(ddStagingBuffers[b]));
+		}
+	}
+	ddStagingCapacity = 0;
+}
+
+static int ddEncoderSetupNVENC(uint32_t width, uint32_t height) {
+	ddStagingCapacity = ((((uint64_t) width) * height * 30) / 8) * 9 / 8 + 1048576; //Three 10-bit samples per pixel with room for lossless overhead
+	for (uint64_t b = 0; b < nvEncBitstreamBuffCount; b++) {
+		void* memAlloc = NULL;
+		int error = memoryAllocate(&memAlloc, ENCODER_HEADER_ROOM_BYTES + ddStagingCapacity, 0);
+		RETURN_ON_ERROR(error);
+		ddStagingBuffers[b] = (uint8_t*) memAlloc;
+	}
+	for (uint64_t b = 0; b < nvEncBitstreamBuffCount; b++) {
+		ddEncodeBitstreamLocks[b].version = NV_ENC_LOCK_BITSTREAM_VER;
+		ddEncodeBitstreamLocks[b].doNotWait = 0; //Has to be 0 for synchronous mode... tested and documented
+		ddEncodeBitstreamLocks[b].getRCStats = 0;
+		ddEncodeBitstreamLocks[b].outputBitstream = nvEncBitstreamBuffs[b].bitstreamBuffer;
+		ddEncodeBitstreamLocks[b].sliceOffsets = NULL;
+	}
+	ddEncoder.encodeFrame = nvencEncodeFrame;
+	ddEncoder.lockBitstream = nvencLockBitstream;
+	ddEncoder.unlockBitstream = nvencUnlockBitstream;
+	ddEncoder.cleanup = nvencCleanup;
+	ddEncoder.slotCount = nvEncBitstreamBuffCount;
+	return 0;
+}
 
 static void* ddThreadEndEvent = NULL;
 static void* ddEncodeEvent = NULL;
@@ -1402,8 +1451,7 @@ static void* ddLockEvent = NULL;
 
 static int ddEncodeLockThread() {
 	//consolePrintLine(41);
-	uint64_t bitTest = 0;
-	NV_ENC_LOCK_BITSTREAM* bitstreamToLock = &ddEncodeBitstreamLock0;
+	uint64_t lockIndex = 0; //Encodes finish in the same order as the output ring slots get used
 	uint64_t signal = 0;
 	int error = syncEventCheck(ddThreadEndEvent, &signal);
 	RETURN_ON_ERROR(error);
@@ -1412,20 +1460,15 @@ static int ddEncodeLockThread() {
 		error = syncEventWait(ddEncodeEvent);
 		RETURN_ON_ERROR(error);
 		
-		NVENCSTATUS nvEncRes = nvEncFunList.nvEncLockBitstream(nvEncoder, bitstreamToLock);
-		if (nvEncRes != NV_ENC_SUCCESS) {
-			return nvEncRes;
-		}
+		error = ddEncoder.lockBitstream(lockIndex, &(ddLockedBitstreams[lockIndex]), &(ddLockedBytes[lockIndex]));
+		RETURN_ON_ERROR(error);
 		
 		error = syncSetEvent(ddLockEvent);
 		RETURN_ON_ERROR(error);
 		
-		bitTest ^= 1; //XOR with 1
-		if (bitTest == 0) {
-			bitstreamToLock = &ddEncodeBitstreamLock0;
-		}
-		else {
-			bitstreamToLock = &ddEncodeBitstreamLock1;
+		lockIndex++;
+		if (lockIndex >= ddEncoder.slotCount) {
+			lockIndex = 0;
 		}
 		
 		error = syncEventCheck(ddThreadEndEvent, &signal);
@@ -1435,13 +1478,46 @@ static int ddEncodeLockThread() {
 
 static void* ddEncodeLockThreadHandle = NULL;
 
-static uint8_t ddReservedNAL[10];
-static uint32_t* ddReservedNALsize = NULL;
-static uint64_t ddWriteOffset = 0;
+//The reserved NAL header goes in the encoder's header room right before the slot's access unit
+//so both are one write (and stay untouched until that slot's write completes)
+static const uint8_t ddReservedNALStart[6] = {0, 0, 0, 1, 84, 1};
+static ioWriteVec ddWriteVectors[NVENC_BITSTREAM_BUFFER_MAX];
+static uint64_t ddSlotSegmentStarts[NVENC_BITSTREAM_BUFFER_MAX]; //The slot's frame starts a new segment file
+static bitstreamRollover ddRollover; //Output file (or segment files) with their seek table trailers
+static bitstreamCheckpoint ddCheckpoint; //Flushes the file every few IDR segments and journals how far it got
+static uint64_t ddWrittenOffset = 0; //Bytes of completed frame writes (where they end in the file when not splitting)
+static frameTrace ddTrace; //Every stage step of every frame (saved next to the bitstream)
+static uint64_t ddComputeFrame = 0; //Frame period of the image in the compute stage
 
 static VkSubmitInfo ddComputeSubmitInfo;
 static VkFence ddComputeFence = VK_NULL_HANDLE;
 
+static void* ddComputeEvent = NULL;
+static void* ddComputeDoneEvent = NULL;
+static VkResult ddComputeResult = VK_SUCCESS;
+static void* ddComputeWaitThreadHandle = NULL;
+
+//Turns the compute fence into an event so the main loop can sleep on it (Vulkan fences cannot be waited on with other OS objects)
+static int ddComputeWaitThread() {
+	uint64_t signal = 0;
+	int error = syncEventCheck(ddThreadEndEvent, &signal);
+	RETURN_ON_ERROR(error);
+	while (signal == 0) {
+		error = syncEventWait(ddComputeEvent);
+		RETURN_ON_ERROR(error);
+		
+		ddComputeResult = vkWaitForFences(device, 1, &ddComputeFence, VK_TRUE, UINT64_MAX);
+		
+		error = syncSetEvent(ddComputeDoneEvent);
+		RETURN_ON_ERROR(error);
+		
+		error = syncEventCheck(ddThreadEndEvent, &signal);
+	}
+	return 0;
+}
+
+static void* ddWaitSet = NULL;
+
 static uint64_t ddAcquireLatencySum = 0;
 static uint64_t ddComputeLatencySum = 0;
 static uint64_t ddEncodeLatencySum = 0;
@@ -1455,52 +1531,115 @@ static uint64_t ddAcquireMissedTiming = 0;
 static uint64_t ddMiscIssues = 0;
 static uint64_t ddAccumulatedFramesSum = 0;
 
+//Output Ring: slots go from encoding -> locked & writing -> written (unlocked) in order
+//Head counts encodes started, ddEncodeCount counts writes started, and tail counts writes finished
+static uint64_t ddRingHead = 0;
+static uint64_t ddRingTail = 0;
+static uint64_t ddRingHighWaterMark = 0;
+
+//Every frame's latency through each stage in nanoseconds (the means above hide the spikes that repeat frames)
+//Presentation to disk runs from the presentation of the frame's image until its write completed
+//(repeated frames count from the image they repeat)
+#define DD_LATENCY_ACQUIRE 0
+#define DD_LATENCY_COMPUTE 1
+#define DD_LATENCY_ENCODE 2
+#define DD_LATENCY_WRITE 3
+#define DD_LATENCY_PRESENT_TO_DISK 4
+#define DD_LATENCY_STAGES 5
+static latencyHistogram ddLatency[DD_LATENCY_STAGES];
+static char* ddLatencyNames[DD_LATENCY_STAGES] = {"acquire", "compute", "encode", "write", "presentationToDisk"};
+static uint64_t ddAcquirePresentationTime = 0;
+static uint64_t ddComputePresentationTime = 0; //Image in the compute output
+static uint64_t ddSlotPresentationTimes[NVENC_BITSTREAM_BUFFER_MAX];
+static uint64_t ddSlotWriteTimes[NVENC_BITSTREAM_BUFFER_MAX];
+
+static void ddRecordLatency(uint64_t stage, uint64_t startTime, uint64_t endTime) {
+	if (endTime >= startTime) {
+		latencyHistogramRecord(&(ddLatency[stage]), getDiffTimeNanoseconds(startTime, endTime));
+	}
+}
+
+//Counters go out once a second so a long record can be watched from another machine
+static telemetryPublisher ddTelemetry;
+
+static int ddTelemetryUpdate(uint64_t numWrittenFrames) {
+	uint64_t currentTime = getCurrentTime();
+	if (telemetryDue(&ddTelemetry, currentTime) == 0) {
+		return 0;
+	}
+	telemetryDatagram* datagram = &(ddTelemetry.datagram);
+	datagram->framesWritten = numWrittenFrames;
+	datagram->bytesWritten = ddWrittenOffset;
+	datagram->ringOccupancy = ddRingHead - ddRingTail;
+	datagram->ringSlots = ddEncoder.slotCount;
+	datagram->repeatCount = ddRepeatCount;
+	datagram->missedCount = ddAcquireMissedTiming;
+	datagram->miscIssues = ddMiscIssues;
+	return telemetrySend(&ddTelemetry, currentTime, ddLatency);
+}
+
 static uint64_t ddState = 0;
 static uint64_t ddNextFrame = 0;
 static uint64_t ddCounterIDRreset = 0;
 static uint64_t ddCounterIDR = 0;
-static uint64_t ddFrameIntervalTime = 0;
+static uint64_t ddFps = 0;
+static uint64_t ddTimeFrequency = 0; //Time counter ticks per second
 static uint64_t ddFirstFrameStartTime = 0;
 static uint64_t ddAcquireOffset = 0;
 
-int ddEncodeStart(uint64_t fps) {
+//Computed from the first frame so a frame interval that is not a whole number of ticks (144 fps) does not drift
+static uint64_t ddFrameStartTime(uint64_t frame) {
+	return ddFirstFrameStartTime + ((frame * ddTimeFrequency) / ddFps);
+}
+
+//Where the frames come from (Desktop Duplication when recording)
+static frameSource ddFrameSource;
+_Static_assert(ERROR_FRAME_SOURCE_TIMEOUT == ERROR_DESKDUPL_ACQUIRE_TIMEOUT, "Frame source timeout must match Desktop Duplication");
+
+static void ddFrameSourceSetupDesktopDuplication(uint32_t width, uint32_t height) {
+	ddFrameSource.acquireNextFrame = graphicsDesktopDuplicationAcquireNextFrame;
+	ddFrameSource.releaseFrame = graphicsDesktopDuplicationReleaseFrame;
+	ddFrameSource.cleanup = graphicsDesktopDuplicationCleanup;
+	ddFrameSource.frameData = NULL; //Stays on the GPU (imported into Vulkan)
+	ddFrameSource.width = width;
+	ddFrameSource.height = height;
+}
+
+int ddEncodeStart(uint64_t fps, uint64_t idrInterval) {
 	//Release Frame
-	int error = graphicsDesktopDuplicationReleaseFrame();
+	int error = ddFrameSource.releaseFrame();
 	RETURN_ON_ERROR(error);
 	
-	ddEncodeBitstreamLock0.version = NV_ENC_LOCK_BITSTREAM_VER;
-	ddEncodeBitstreamLock0.doNotWait = 0; //Has to be 0 for synchronous mode... tested and documented
-	ddEncodeBitstreamLock0.getRCStats = 0;
-	ddEncodeBitstreamLock0.outputBitstream = nvEncBitstreamBuff0.bitstreamBuffer;
-	ddEncodeBitstreamLock0.sliceOffsets = NULL;
-	
-	ddEncodeBitstreamLock1.version = NV_ENC_LOCK_BITSTREAM_VER;
-	ddEncodeBitstreamLock1.doNotWait = 0;
-	ddEncodeBitstreamLock1.getRCStats = 0;
-	ddEncodeBitstreamLock1.outputBitstream = nvEncBitstreamBuff1.bitstreamBuffer;
-	ddEncodeBitstreamLock1.sliceOffsets = NULL;
-	
+	error = ddEncoderSetupNVENC(ddFrameSource.width, ddFrameSource.height);
+	RETURN_ON_ERROR(error);
 	
-	error = syncCreateEvent(&ddThreadEndEvent, 0, 0);
+	error = syncCreateEvent(&ddThreadEndEvent, 1, 0); //Manual reset so every helper thread sees it
 	RETURN_ON_ERROR(error);
 	error = syncCreateEvent(&ddEncodeEvent, 0, 0);
 	RETURN_ON_ERROR(error);
 	error = syncCreateEvent(&ddLockEvent, 0, 0);
 	RETURN_ON_ERROR(error);
+	error = syncCreateEvent(&ddComputeEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	error = syncCreateEvent(&ddComputeDoneEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	
+	//The main loop sleeps until one of the stages finishes, a write completes, or it is time to acquire
+	error = syncCreateWaitSet(&ddWaitSet);
+	RETURN_ON_ERROR(error);
+	error = syncWaitSetAddEvent(ddWaitSet, ddLockEvent);
+	RETURN_ON_ERROR(error);
+	error = syncWaitSetAddEvent(ddWaitSet, ddComputeDoneEvent);
+	RETURN_ON_ERROR(error);
 	
 	PFN_ThreadStart threadStart = ddEncodeLockThread;
 	error = syncStartThread(&ddEncodeLockThreadHandle, threadStart, 0);
 	RETURN_ON_ERROR(error);
+	threadStart = ddComputeWaitThread;
+	error = syncStartThread(&ddComputeWaitThreadHandle, threadStart, 0);
+	RETURN_ON_ERROR(error);
 	
-	ddReservedNAL[0] = 0;
-	ddReservedNAL[1] = 0;
-	ddReservedNAL[2] = 0;
-	ddReservedNAL[3] = 1;
-	ddReservedNAL[4] = 84;
-	ddReservedNAL[5] = 1;
-	ddReservedNALsize = (uint32_t*) (&(ddReservedNAL[6]));
-	
-	ddWriteOffset = 0;
+	ddWrittenOffset = 0;
 		
 	//Create the Vulkan Compute Finish Fence
 	VkFenceCreateInfo fenceInfo;
@@ -1529,7 +1668,7 @@ int ddEncodeStart(uint64_t fps) {
 	
 	uint64_t presentationInfo = 0;
 	uint64_t accumulatedFrames = 0;
-	error = graphicsDesktopDuplicationAcquireNextFrame(1000 / fps, &presentationInfo, &accumulatedFrames);
+	error = ddFrameSource.acquireNextFrame(1000 / fps, &presentationInfo, &accumulatedFrames);
 	RETURN_ON_ERROR(error);
 	//if (error == ERROR_DESKDUPL_ACQUIRE_TIMEOUT) {
 	//	
@@ -1539,6 +1678,8 @@ int ddEncodeStart(uint64_t fps) {
 	
 	//Start Compute Immediately:
 	vkQueueSubmit(computeQueue, 1, &ddComputeSubmitInfo, ddComputeFence);
+	error = syncSetEvent(ddComputeEvent);
+	RETURN_ON_ERROR(error);
 	ddAcquireLatencySum = 0;//currentTime - ddLastPresentationTime;
 	ddComputeLatencySum = 0;
 	ddEncodeLatencySum = 0;
@@ -1551,27 +1692,51 @@ int ddEncodeStart(uint64_t fps) {
 	ddAcquireMissedTiming = 0;
 	ddMiscIssues = 0;
 	ddAccumulatedFramesSum = 0;
+	ddRingHead = 0;
+	ddRingTail = 0;
+	ddRingHighWaterMark = 0;
+	for (uint64_t s = 0; s < DD_LATENCY_STAGES; s++) {
+		latencyHistogramReset(&(ddLatency[s]));
+	}
+	ddAcquirePresentationTime = presentationInfo;
+	ddComputePresentationTime = presentationInfo;
+	frameTraceReset(&ddTrace);
+	frameTraceAdd(&ddTrace, FRAME_TRACE_PRESENT, 0, 0, presentationInfo);
+	frameTraceAdd(&ddTrace, FRAME_TRACE_ACQUIRE, 0, 0, currentTime);
+	frameTraceAdd(&ddTrace, FRAME_TRACE_COMPUTE_SUBMIT, 0, 0, currentTime);
+	ddComputeFrame = 0;
 	
 	//Setup Run Variables:
-	ddState = 0b0001000; //Bits: Frame Released | Compute Start Wait | Encode Start Wait | Compute Stage Active | Encoding Active | Write 1 | Write 0
+	ddState = 0b0001000; //Bits: Frame Released | Compute Start Wait | Encode Start Wait | Compute Stage Active | Encoding Active | (Unused) | (Unused)
 	ddNextFrame = 1;
 	ddCounterIDR = 0;
-	ddCounterIDRreset = fps * 3;
+	ddCounterIDRreset = idrInterval - 1; //Frames between the IDR frames
 	
-	ddFrameIntervalTime = getFrameIntervalTime(fps);
-	ddFirstFrameStartTime = currentTime; // + (ddFrameIntervalTime >> 1);
+	ddFps = fps;
+	ddTimeFrequency = getFrameIntervalTime(1);
+	ddFirstFrameStartTime = currentTime;
 	ddAcquireOffset = 500 * getMicrosecondDivider();
 	
 	return 0;
 }
 
-int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
+//The slot's write finished so its latencies get recorded before its bitstream gets unlocked
+static int ddWriteComplete(uint64_t slot) {
+	uint64_t currentTime = getCurrentTime();
+	ddRecordLatency(DD_LATENCY_WRITE, ddSlotWriteTimes[slot], currentTime);
+	ddRecordLatency(DD_LATENCY_PRESENT_TO_DISK, ddSlotPresentationTimes[slot], currentTime);
+	frameTraceAdd(&ddTrace, FRAME_TRACE_WRITE_COMPLETE, ddRingTail, slot, currentTime);
+	ddWrittenOffset += BITSTREAM_RESERVED_NAL_BYTES + ddLockedBytes[slot];
+	return ddEncoder.unlockBitstream(slot);
+}
+
+int ddEncodeRun(uint64_t* frameWriteCount) {
 	int error = 0;
 	uint64_t signaled = 0;
 	
 	if ((ddState & 64) > 0) { //Frame Released
-		uint64_t frameStartTime = ddFirstFrameStartTime + (ddNextFrame * ddFrameIntervalTime);
-		uint64_t frameEndTime = frameStartTime + ddFrameIntervalTime;
+		uint64_t frameStartTime = ddFrameStartTime(ddNextFrame);
+		uint64_t frameEndTime = ddFrameStartTime(ddNextFrame + 1);
 		uint64_t acquireStartTime = frameStartTime + ddAcquireOffset;
 		uint64_t acquireEndTime = frameEndTime + ddAcquireOffset;
 		uint64_t currentTime = getCurrentTime();
@@ -1580,50 +1745,60 @@ int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
 				//consoleWriteLineFast("Acquiring Image", 15);
 				uint64_t presentationTime = 0;
 				uint64_t accumulatedFrames = 0;
-				error = graphicsDesktopDuplicationAcquireNextFrame(1, &presentationTime, &accumulatedFrames);
+				error = ddFrameSource.acquireNextFrame(1, &presentationTime, &accumulatedFrames);
 				if (error == 0) { //Acquired Something (Might just be mouse stuff)
 					if (presentationTime >= frameStartTime) { //Actually acquired image and it is in the expected time
 						currentTime = getCurrentTime();
 						ddAcquireLatencySum += currentTime - presentationTime;
 						ddAcquireCount++;
+						ddRecordLatency(DD_LATENCY_ACQUIRE, presentationTime, currentTime);
+						ddAcquirePresentationTime = presentationTime;
 						ddAccumulatedFramesSum += accumulatedFrames;
 						if (presentationTime < frameEndTime) { //Image is valid for current frame
 							ddNextFrame++;
 							if ((ddState & 32) > 0) {
 								ddMiscIssues++;
+								frameTraceAdd(&ddTrace, FRAME_TRACE_MISC_ISSUE, ddNextFrame - 1, 0, currentTime);
 							}
 							ddState |= 32;
 							ddState &= ~64;
 						}
 						else { //Got a frame but its for the next acquire period so first step is to encode the duplicate
+							frameTraceAdd(&ddTrace, FRAME_TRACE_REPEAT, ddNextFrame, 0, currentTime);
 							ddNextFrame += 2;
 							if ((ddState & 0b110000) > 0) {
 								ddMiscIssues++;
+								frameTraceAdd(&ddTrace, FRAME_TRACE_MISC_ISSUE, ddNextFrame - 1, 0, currentTime);
 							}
 							ddRepeatCount++;
 							ddState |= 16 | 32;
 							ddState &= ~64;
 						}
+						frameTraceAdd(&ddTrace, FRAME_TRACE_PRESENT, ddNextFrame - 1, 0, presentationTime);
+						frameTraceAdd(&ddTrace, FRAME_TRACE_ACQUIRE, ddNextFrame - 1, 0, currentTime);
 					}
 					else { //probably acquired mouse change info... need to release frame
-						error = graphicsDesktopDuplicationReleaseFrame();
+						error = ddFrameSource.releaseFrame();
 						RETURN_ON_ERROR(error);
 					}
 				}
-				else if (error != ERROR_DESKDUPL_ACQUIRE_TIMEOUT) { //Failed to acquire next frame but not to timeout
+				else if (error != ERROR_FRAME_SOURCE_TIMEOUT) { //Failed to acquire next frame but not to timeout
 					return error;
 				}
 			}
 			else {
 				ddAcquireMissedTiming++; // Missed Timing
+				frameTraceAdd(&ddTrace, FRAME_TRACE_ACQUIRE_MISSED, ddNextFrame, 0, currentTime);
 				//ddNextFrame++;
 			}
 			if ((ddState & 64) > 0) { //Encode duplicate frame if did not acquire new frame
 				currentTime = getCurrentTime();
 				if (currentTime >= frameEndTime) {
+					frameTraceAdd(&ddTrace, FRAME_TRACE_REPEAT, ddNextFrame, 0, currentTime);
 					ddNextFrame++;
 					if ((ddState & 16) > 0) {
 						ddMiscIssues++;
+						frameTraceAdd(&ddTrace, FRAME_TRACE_MISC_ISSUE, ddNextFrame - 1, 0, currentTime);
 					}
 					ddRepeatCount++;
 					ddState |= 16;
@@ -1632,44 +1807,26 @@ int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
 		}
 	}
 	
-	if ((ddState & 1) > 0) { //Write Output 0 Check
-		//Check on async file write here
-		//consoleWriteLineFast("Write 0 Check", 13);
-		error = ioAsyncSignalCheck(0, &signaled);
+	//Output Ring Write Checks (oldest first, a slot only gets reused after its write finishes)
+	while (ddRingTail < ddEncodeCount) {
+		uint64_t slot = ddRingTail % ddEncoder.slotCount;
+		//consoleWriteLineFast("Write Check", 11);
+		error = ioAsyncSignalCheck(slot, &signaled);
 		RETURN_ON_ERROR(error);
-		if (signaled == 1) { //Write Event Signaled
-			NVENCSTATUS nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuff0.bitstreamBuffer);
-			if (nvEncRes != NV_ENC_SUCCESS) {
-				//nvidiaError = nvEncRes;
-				return ERROR_NVENC_EXTRA_INFO;
-			}
-			(*frameWriteCount)++;
-			//consoleWriteLineFast("Wrote to File 0", 15);
-			
-			error = ioAsyncSignalWait(2);
-			RETURN_ON_ERROR(error);
-			ddState &= ~1;
+		if (signaled == 0) {
+			break;
 		}
-	}
-	if ((ddState & 2) > 0) { //Write Output 1 Check
-		//Check on async file write here
-		//consoleWriteLineFast("Write 1 Check", 13);
-		error = ioAsyncSignalCheck(1, &signaled);
+		error = ddWriteComplete(slot);
 		RETURN_ON_ERROR(error);
-		if (signaled == 1) { //Write Event Signaled
-			NVENCSTATUS nvEncRes = nvEncFunList.nvEncUnlockBitstream(nvEncoder, nvEncBitstreamBuff1.bitstreamBuffer);
-			if (nvEncRes != NV_ENC_SUCCESS) {
-				//nvidiaError = nvEncRes;
-				return ERROR_NVENC_EXTRA_INFO;
-			}
-			(*frameWriteCount)++;
-			//consoleWriteLineFast("Wrote to File 1", 15);
-			
-			error = ioAsyncSignalWait(3);
-			RETURN_ON_ERROR(error);
-			ddState &= ~2;
-		}
+		(*frameWriteCount)++;
+		//consoleWriteLineFast("Wrote to File", 13);
+		
+		ddRingTail++;
 	}
+	error = bitstreamCheckpointUpdate(&ddCheckpoint, ddRollover.file, ddWrittenOffset);
+	RETURN_ON_ERROR(error);
+	error = bitstreamRolloverUpdate(&ddRollover, ddRingTail);
+	RETURN_ON_ERROR(error);
 	
 	if ((ddState & 4) > 0) { //Encoding Wait Check
 		//Lock Bitstream to "finish" encoding step
@@ -1681,52 +1838,46 @@ int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
 			
 			uint64_t currentTime = getCurrentTime();
 			ddEncodeLatencySum += currentTime - ddEncodeStartTime;
-			ddEncodeCount++;			
+			ddRecordLatency(DD_LATENCY_ENCODE, ddEncodeStartTime, currentTime);
+			
+			uint64_t slot = ddEncodeCount % ddEncoder.slotCount;
+			frameTraceAdd(&ddTrace, FRAME_TRACE_ENCODE_LOCK, ddEncodeCount, slot, currentTime);
+			ddEncodeCount++;
+			
+			//consoleWriteLineFast("Write", 5);
+			uint8_t* reservedNAL = ddLockedBitstreams[slot] - BITSTREAM_RESERVED_NAL_BYTES;
+			memcpyBasic(reservedNAL, ddReservedNALStart, 6);
+			*((uint32_t*) (&(reservedNAL[6]))) = (uint32_t) ddLockedBytes[slot];
+			ddWriteVectors[slot].dataPtr = reservedNAL;
+			ddWriteVectors[slot].numBytes = BITSTREAM_RESERVED_NAL_BYTES + ddLockedBytes[slot];
+			
+			//Start Async Write Here (Reserved NAL Header and Frame Together)
+			ddSlotWriteTimes[slot] = currentTime;
+			frameTraceAdd(&ddTrace, FRAME_TRACE_WRITE_SUBMIT, ddEncodeCount - 1, slot, currentTime);
+			error = bitstreamRolloverWrite(&ddRollover, &(ddWriteVectors[slot]), 1, slot, ddLockedBitstreams[slot], ddLockedBytes[slot], ddEncodeCount - 1, ddSlotSegmentStarts[slot]);
+			RETURN_ON_ERROR(error);
+			bitstreamCheckpointAdd(&ddCheckpoint, reservedNAL, ddLockedBitstreams[slot], ddLockedBytes[slot]);
 			
-			if ((ddEncodeCount & 1) > 0) { //Odd Frame
-				//consoleWriteLineFast("Write 0", 7);
-				
-				*ddReservedNALsize = (uint32_t) ddEncodeBitstreamLock0.bitstreamSizeInBytes;
-				error = ioAsyncWriteFile(bitstreamFilePtr, ddReservedNAL, 10, 2, ddWriteOffset);
-				RETURN_ON_ERROR(error);
-				ddWriteOffset += 10;
-				
-				//Start Async Write Here
-				error = ioAsyncWriteFile(bitstreamFilePtr, ddEncodeBitstreamLock0.bitstreamBufferPtr, ddEncodeBitstreamLock0.bitstreamSizeInBytes, 0, ddWriteOffset);
-				RETURN_ON_ERROR(error);
-				ddWriteOffset += ddEncodeBitstreamLock0.bitstreamSizeInBytes;
-				
-				ddState |= 1;
-			}
-			else { //Even Frame
-				//consoleWriteLineFast("Write 1", 7);
-				
-				*ddReservedNALsize = (uint32_t) ddEncodeBitstreamLock1.bitstreamSizeInBytes;
-				error = ioAsyncWriteFile(bitstreamFilePtr, ddReservedNAL, 10, 3, ddWriteOffset);
-				RETURN_ON_ERROR(error);
-				ddWriteOffset += 10;
-				
-				//Start Async Write Here
-				error = ioAsyncWriteFile(bitstreamFilePtr, ddEncodeBitstreamLock1.bitstreamBufferPtr, ddEncodeBitstreamLock1.bitstreamSizeInBytes, 1, ddWriteOffset);
-				RETURN_ON_ERROR(error);
-				ddWriteOffset += ddEncodeBitstreamLock1.bitstreamSizeInBytes;
-				
-				ddState |= 2;
-			}
 			ddState &= ~4;
 		}
 	}
 	
 	if ((ddState & 8) > 0) { //Compute Wait Check
 		//consoleWriteLineFast("Compute Check", 13);
-		VkResult vkRes = vkGetFenceStatus(device, ddComputeFence);
-		if (vkRes == VK_SUCCESS) { //Can Now Encode and Release Desktop Duplication
+		error = syncEventCheck(ddComputeDoneEvent, &signaled);
+		RETURN_ON_ERROR(error);
+		if ((signaled == 1) && (ddComputeResult != VK_SUCCESS)) {
+			return ERROR_VULKAN_EXTRA_INFO;
+		}
+		else if (signaled == 1) { //Can Now Encode and Release Desktop Duplication
 			
 			uint64_t currentTime = getCurrentTime();
 			ddComputeLatencySum += currentTime - ddComputeStartTime;
 			ddComputeCount++;
+			ddRecordLatency(DD_LATENCY_COMPUTE, ddComputeStartTime, currentTime);
+			frameTraceAdd(&ddTrace, FRAME_TRACE_COMPUTE_DONE, ddComputeFrame, 0, currentTime);
 			
-			error = graphicsDesktopDuplicationReleaseFrame();
+			error = ddFrameSource.releaseFrame();
 			RETURN_ON_ERROR(error);
 			
 			vkResetFences(device, 1, &ddComputeFence);
@@ -1734,47 +1885,46 @@ int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
 			ddState |= 64 | 16; //Released Frame | Encode Start Wait
 			ddState &= ~8;
 		}
-		else if (vkRes == VK_NOT_READY) {
-			return 0; //The Compute is a bottleneck / showstopper
-		}
 		else {
-			return ERROR_VULKAN_EXTRA_INFO;
+			return 0; //The Compute is a bottleneck / showstopper
 		}
 	}
 	
 	if ((ddState & 16) > 0) { //Encoding Start Wait Check
 		//consoleWriteLineFast("Encode Start Check", 18);
-		uint64_t writeCheck = ddState & 1;
-		if ((ddEncodeCount & 1) > 0) {
-			writeCheck = ddState & 2;
+		uint64_t ringFull = 0;
+		if ((ddRingHead - ddRingTail) >= ddEncoder.slotCount) {
+			ringFull = 1;
 		}
-		if (((ddState & 0b1100) == 0) && (writeCheck == 0)) {
+		if (((ddState & 0b1100) == 0) && (ringFull == 0)) {
 			ddEncodeStartTime = getCurrentTime();
 			
-			if (ddCounterIDR > 0) {
-			nvEncPicParams.encodePicFlags = 0; //nvEncPicParams.pictureType = NV_ENC_PIC_TYPE_P;
-			ddCounterIDR--;
-			}
-			else {
-				nvEncPicParams.encodePicFlags = NV_ENC_PIC_FLAG_FORCEINTRA; //nvEncPicParams.pictureType = NV_ENC_PIC_TYPE_IDR; //NV_ENC_PIC_TYPE_I;
+			uint64_t forceIDR = 0;
+			ddSlotSegmentStarts[ddRingHead % ddEncoder.slotCount] = bitstreamRolloverDue(&ddRollover);
+			if (ddSlotSegmentStarts[ddRingHead % ddEncoder.slotCount] > 0) { //New segment files have to start with their own parameter sets
+				forceIDR = ENCODER_FORCE_IDR;
 				ddCounterIDR = ddCounterIDRreset;
 			}
-			if ((ddEncodeCount & 1) > 0) {
-				nvEncPicParams.outputBitstream = nvEncBitstreamBuff1.bitstreamBuffer;
+			else if (ddCounterIDR > 0) {
+				ddCounterIDR--;
 			}
 			else {
-				nvEncPicParams.outputBitstream = nvEncBitstreamBuff0.bitstreamBuffer;
-			}
-			
-			NVENCSTATUS nvEncRes = nvEncFunList.nvEncEncodePicture(nvEncoder, &nvEncPicParams);
-			if (nvEncRes != NV_ENC_SUCCESS) {
-				//nvidiaError = nvEncRes;
-				return ERROR_NVENC_EXTRA_INFO;
+				forceIDR = ENCODER_FORCE_INTRA;
+				ddCounterIDR = ddCounterIDRreset;
 			}
+			ddSlotPresentationTimes[ddRingHead % ddEncoder.slotCount] = ddComputePresentationTime;
+			frameTraceAdd(&ddTrace, FRAME_TRACE_ENCODE_SUBMIT, ddRingHead, ddRingHead % ddEncoder.slotCount, ddEncodeStartTime);
+			error = ddEncoder.encodeFrame(ddRingHead % ddEncoder.slotCount, forceIDR);
+			RETURN_ON_ERROR(error);
 			
 			error = syncSetEvent(ddEncodeEvent);
 			RETURN_ON_ERROR(error);
 			
+			ddRingHead++;
+			if ((ddRingHead - ddRingTail) > ddRingHighWaterMark) {
+				ddRingHighWaterMark = ddRingHead - ddRingTail;
+			}
+			
 			ddState |= 4;
 			ddState &= ~16;
 		}
@@ -1784,7 +1934,12 @@ int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
 		//consoleWriteLineFast("Compute Start Check", 19);
 		if ((ddState & 0b11100) == 0) {
 			ddComputeStartTime = getCurrentTime();
+			ddComputePresentationTime = ddAcquirePresentationTime;
+			ddComputeFrame = ddNextFrame - 1;
+			frameTraceAdd(&ddTrace, FRAME_TRACE_COMPUTE_SUBMIT, ddComputeFrame, 0, ddComputeStartTime);
 			vkQueueSubmit(computeQueue, 1, &ddComputeSubmitInfo, ddComputeFence);
+			error = syncSetEvent(ddComputeEvent);
+			RETURN_ON_ERROR(error);
 			
 			ddState |= 8;
 			ddState &= ~32;
@@ -1795,7 +1950,58 @@ int ddEncodeRun(void* bitstreamFilePtr, uint64_t* frameWriteCount) {
 	return 0;
 }
 
-int ddEncodePrintStats() {
+//Sleeps until ddEncodeRun has something to do: a stage finishing, the oldest write completing, or the next acquire time
+//ddEncodeRun moves every stage as far as it can go so anything still waiting needs one of these
+int ddEncodeWait() {
+	uint64_t endTime = SYNC_WAIT_NONE;
+	if ((ddState & 64) > 0) { //Frame Released
+		uint64_t acquireStartTime = ddFrameStartTime(ddNextFrame) + ddAcquireOffset;
+		if (getCurrentTime() >= acquireStartTime) {
+			return 0; //Acquiring already waits (1ms at a time) inside ddEncodeRun
+		}
+		endTime = acquireStartTime;
+	}
+	uint64_t asyncOperation = SYNC_WAIT_NONE;
+	if (ddRingTail < ddEncodeCount) {
+		asyncOperation = ddRingTail % ddEncoder.slotCount;
+	}
+	else if (ddCheckpoint.step > BITSTREAM_CHECKPOINT_WAIT_WRITES) { //Otherwise a checkpoint step only gets noticed at the next wake
+		asyncOperation = ddCheckpoint.asyncOperation;
+	}
+	else if (ddRollover.step == BITSTREAM_ROLLOVER_WAIT_TRAILER) { //Same for an old segment's trailer
+		asyncOperation = ddRollover.asyncOperation;
+	}
+	return syncWaitSetWait(ddWaitSet, asyncOperation, endTime);
+}
+
+//Waits for the writes still in flight, finishes the last checkpoint, and then appends the seek table trailers that are left
+int ddEncodeFinish() {
+	while (ddRingTail < ddEncodeCount) {
+		uint64_t slot = ddRingTail % ddEncoder.slotCount;
+		int error = ioAsyncSignalWait(slot);
+		RETURN_ON_ERROR(error);
+		error = ddWriteComplete(slot);
+		RETURN_ON_ERROR(error);
+		ddRingTail++;
+	}
+	int checkpointError = bitstreamCheckpointFinish(&ddCheckpoint, ddRollover.file, ddWrittenOffset); //The trailer still gets written
+	
+	int error = bitstreamRolloverFinish(&ddRollover);
+	RETURN_ON_ERROR(error);
+	return checkpointError;
+}
+
+//p50 / p90 / p99 / p99.9 / max on one line in microseconds
+static void ddPrintLatency(uint64_t line, latencyHistogram* histogram) {
+	consolePrint(line, CON_NO_CTRL);
+	consolePrintWithNumber(148, latencyHistogramPercentile(histogram, 5000) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, latencyHistogramPercentile(histogram, 9000) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, latencyHistogramPercentile(histogram, 9900) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(148, latencyHistogramPercentile(histogram, 9990) / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(164, histogram->max / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER_NEW_LINE);
+}
+
+int ddEncodePrintStats(char* outputFileName) {
 	uint64_t microsecondDivider = getMicrosecondDivider();
 	if (ddAcquireCount > 0) {
 		uint64_t latency = ddAcquireLatencySum / ddAcquireCount;
@@ -1817,11 +2023,165 @@ int ddEncodePrintStats() {
 	consolePrintLineWithNumber(48, ddAcquireMissedTiming, NUM_FORMAT_UNSIGNED_INTEGER);
 	consolePrintLineWithNumber(49, ddMiscIssues, NUM_FORMAT_UNSIGNED_INTEGER);
 	consolePrintLineWithNumber(50, ddAccumulatedFramesSum, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(61, ddEncoder.slotCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(62, ddRingHighWaterMark, NUM_FORMAT_UNSIGNED_INTEGER);
+	
+	for (uint64_t s = 0; s < DD_LATENCY_STAGES; s++) {
+		ddPrintLatency(143 + s, &(ddLatency[s]));
+	}
+	char latencyFileName[BITSTREAM_FILE_NAME_MAX];
+	int error = bitstreamSideFileName(latencyFileName, outputFileName, ".latency.json");
+	if (error == 0) {
+		error = latencyHistogramWriteJSON(latencyFileName, ddLatency, ddLatencyNames, DD_LATENCY_STAGES);
+		if (error == 0) {
+			consolePrintLine(149);
+		}
+	}
+	
+	if (ddCheckpoint.segmentInterval > 0) {
+		consolePrintLineWithNumber(150, ddCheckpoint.recordCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(151, ddCheckpoint.skipped, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(152, ddCheckpoint.durationMax, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	if (ddTrace.records != NULL) {
+		consolePrintLineWithNumber(163, (ddTrace.head <= ddTrace.mask) ? ddTrace.head : (ddTrace.mask + 1), NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	if (ddTelemetry.enabled > 0) {
+		consolePrintLineWithNumber(176, ddTelemetry.sent, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(177, ddTelemetry.skipped, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	if ((ddRollover.segmentFrames > 0) || (ddRollover.segmentBytes > 0)) {
+		consolePrintLineWithNumber(186, ddRollover.segmentCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(187, ddRollover.deferred, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(188, ddRollover.deleted, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
 	
 	return 0;
 }
 
 
+#define DD_FPS_MAX 1000 //Acquire timeouts are in whole milliseconds
+#define DD_OPEN_ENDED_INDEX_SECONDS 3600 //Seek table size when recording until <Enter> (later frames still get saved)
+#define DD_ENTER_CHECK_MILLISECONDS 100
+#define DD_PREALLOCATE_PERCENT 25 //Worst case output size as a percent of the raw 10-bit 4:4:4 frames (busy game footage)
+#define DD_PREALLOCATE_OPEN_ENDED_SECONDS 60 //Reserved when recording until <Enter> (later frames allocate as they go)
+
+static int ddParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	if ((argumentBytes == 0) || (argumentBytes > 9)) {
+		return ERROR_INVALID_ARGUMENT;
+	}
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+static uint64_t ddArgumentIs(char* argument, uint64_t argumentBytes, char* name) {
+	uint64_t i = 0;
+	for (; i < argumentBytes; i++) {
+		if (argument[i] != name[i]) {
+			return 0;
+		}
+	}
+	return (name[i] == 0) ? 1 : 0;
+}
+
+//Options come in name value pairs: -fps, -seconds (0 records until <Enter>), -output, -idr (frames), -ring (slots), -telemetry (address),
+//-segment-seconds, -segment-mb, -keep (segments), -preallocate (percent of the raw frame size) and -checkpoint (IDR segments, 0 is off)
+static int ddParseArguments(uint64_t* fps, uint64_t* recordSeconds, char** outputFileName, uint64_t* idrInterval, uint64_t* outputRingSlots, char** telemetryAddress, uint64_t* segmentSeconds, uint64_t* segmentMegabytes, uint64_t* keepSegments, uint64_t* preallocatePercent, uint64_t* checkpointSegments) {
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	int error = ioGetNextCommandArgument(&argument, &argumentBytes); //The program itself
+	RETURN_ON_ERROR(error);
+	while (ioGetNextCommandArgument(&argument, &argumentBytes) == 0) {
+		char* value = NULL;
+		uint64_t valueBytes = 0;
+		error = ioGetNextCommandArgument(&value, &valueBytes);
+		if (error != 0) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		if (ddArgumentIs(argument, argumentBytes, "-fps") > 0) {
+			error = ddParseNumber(value, valueBytes, fps);
+			if ((*fps == 0) || (*fps > DD_FPS_MAX)) {
+				error = ERROR_INVALID_ARGUMENT;
+			}
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-seconds") > 0) {
+			error = ddParseNumber(value, valueBytes, recordSeconds);
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-output") > 0) {
+			*outputFileName = value;
+			if (valueBytes >= (BITSTREAM_FILE_NAME_MAX - 16)) { //Room for the side file extensions
+				error = ERROR_INVALID_ARGUMENT;
+			}
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-idr") > 0) {
+			error = ddParseNumber(value, valueBytes, idrInterval);
+			if (*idrInterval == 0) {
+				error = ERROR_INVALID_ARGUMENT;
+			}
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-ring") > 0) {
+			error = ddParseNumber(value, valueBytes, outputRingSlots);
+			if ((*outputRingSlots < 2) || (*outputRingSlots > NVENC_BITSTREAM_BUFFER_MAX)) {
+				error = ERROR_INVALID_ARGUMENT;
+			}
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-telemetry") > 0) {
+			*telemetryAddress = value;
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-segment-seconds") > 0) {
+			error = ddParseNumber(value, valueBytes, segmentSeconds);
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-segment-mb") > 0) {
+			error = ddParseNumber(value, valueBytes, segmentMegabytes);
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-keep") > 0) {
+			error = ddParseNumber(value, valueBytes, keepSegments);
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-preallocate") > 0) {
+			error = ddParseNumber(value, valueBytes, preallocatePercent);
+			if (*preallocatePercent > 100) { //Lossless frames do not get bigger than the raw samples by much
+				error = ERROR_INVALID_ARGUMENT;
+			}
+		}
+		else if (ddArgumentIs(argument, argumentBytes, "-checkpoint") > 0) {
+			error = ddParseNumber(value, valueBytes, checkpointSegments);
+		}
+		else {
+			error = ERROR_INVALID_ARGUMENT;
+		}
+		RETURN_ON_ERROR(error);
+	}
+	if ((*keepSegments > 0) && (*segmentSeconds == 0) && (*segmentMegabytes == 0)) { //Instant replay needs segments to drop
+		return ERROR_INVALID_ARGUMENT;
+	}
+	return 0;
+}
+
+//Worst case size of the output file (or of each segment) so its extents can be reserved before the record starts
+//instead of the file system allocating them while frames are being written
+//(the reservation itself gets capped at the free disk space minus a quarter of it)
+static uint64_t ddPreallocateBytes(uint32_t width, uint32_t height, uint64_t fps, uint64_t recordSeconds, uint64_t segmentSeconds, uint64_t segmentBytes, uint64_t preallocatePercent, uint64_t outputRingSlots) {
+	uint64_t frameBytes = ((((uint64_t) width) * height * 30) / 8) * preallocatePercent / 100; //Three 10-bit samples per pixel
+	uint64_t seconds = (recordSeconds > 0) ? recordSeconds : DD_PREALLOCATE_OPEN_ENDED_SECONDS;
+	if ((segmentSeconds > 0) && (segmentSeconds < seconds)) {
+		seconds = segmentSeconds + 1; //Rollovers can get put off
+	}
+	uint64_t preallocateBytes = frameBytes * fps * seconds;
+	if (segmentBytes > 0) {
+		uint64_t segmentLimitBytes = segmentBytes + (frameBytes * outputRingSlots); //Frames already in flight when the limit gets reached
+		if (segmentLimitBytes < preallocateBytes) {
+			preallocateBytes = segmentLimitBytes;
+		}
+	}
+	return preallocateBytes;
+}
+
 //Program Main Function
 int programMain() {
 	int error = 0;
@@ -1829,7 +2189,42 @@ int programMain() {
 	//consolePrintLine(25);
 	
 	uint64_t fps = 60;
-	uint64_t recordSeconds = 60;
+	uint64_t recordSeconds = 60; //0 records until <Enter> gets pressed
+	char* outputFileName = "bitstream.h265";
+	uint64_t idrInterval = 0; //Frames from one IDR frame to the next (0 is 3 seconds worth)
+	uint64_t outputRingSlots = 0; //Frames that can wait on the disk before encoding stalls (2 to 32, 0 is the same time span as 16 frames at 60 fps)
+	uint64_t checkpointSegments = 1; //IDR segments between flushes of the output file (0 turns them off)
+	uint64_t traceRecords = FRAME_TRACE_DEFAULT_RECORDS; //Latest stage steps kept for the .trace file (0 turns tracing off)
+	char* telemetryAddress = NULL; //Where the once a second telemetry goes ("::1" for TelemetryReceive on this machine, NULL turns it off)
+	uint64_t segmentSeconds = 0; //New segment file every so often (0 with no size limit writes one file)
+	uint64_t segmentMegabytes = 0; //New segment file once this much got written (0 is no size limit)
+	uint64_t keepSegments = 0; //Instant replay: only the latest segments stay on disk (0 keeps them all)
+	uint64_t preallocatePercent = DD_PREALLOCATE_PERCENT; //Disk space reserved up front (0 turns it off, unused space gets released at the end)
+	
+	error = ddParseArguments(&fps, &recordSeconds, &outputFileName, &idrInterval, &outputRingSlots, &telemetryAddress, &segmentSeconds, &segmentMegabytes, &keepSegments, &preallocatePercent, &checkpointSegments);
+	if (error != 0) {
+		consolePrintLine(182);
+		return error;
+	}
+	if (idrInterval == 0) {
+		idrInterval = fps * 3;
+	}
+	if ((segmentSeconds > 0) || (segmentMegabytes > 0)) { //Every segment is flushed when it gets closed and the journal only knows one file
+		checkpointSegments = 0;
+	}
+	if (outputRingSlots == 0) { //Higher frame rates get more slots so the ring covers the same disk stall
+		outputRingSlots = (fps * 16) / 60;
+		if (outputRingSlots < 2) {
+			outputRingSlots = 2;
+		}
+		else if (outputRingSlots > NVENC_BITSTREAM_BUFFER_MAX) {
+			outputRingSlots = NVENC_BITSTREAM_BUFFER_MAX;
+		}
+	}
+	uint64_t outputFileNameBytes = 0;
+	while (outputFileName[outputFileNameBytes] != 0) {
+		outputFileNameBytes++;
+	}
 	
 	//Desktop Duplication Setup:
 	consolePrintLine(26);
@@ -1838,11 +2233,12 @@ int programMain() {
 	uint32_t venderID = 0;
 	error = graphicsDesktopDuplicationSetup(&width, &height, &venderID);
 	RETURN_ON_ERROR(error);
+	ddFrameSourceSetupDesktopDuplication(width, height);
 	consolePrintLine(27);
 	
 	if (venderID != NVIDIA_PCI_VENDER_ID) {
 		consolePrintLine(36);
-		graphicsDesktopDuplicationCleanup();
+		ddFrameSource.cleanup();
 		return 1;
 	}
 	
@@ -1858,7 +2254,7 @@ int programMain() {
 	uint64_t memPageBytes = 0;
 	error = memoryAllocateOnePage(&memPagePtr, &memPageBytes);
 	RETURN_ON_ERROR(error);
-	error = setupNvidiaEncoder(width, height, fps, memPagePtr);
+	error = setupNvidiaEncoder(width, height, fps, outputRingSlots, memPagePtr);
 	RETURN_ON_ERROR(error);
 	consolePrintLine(31);
 	
@@ -1870,46 +2266,112 @@ int programMain() {
 	
 	//*
 	consolePrintLine(37);
-	void* h265File = NULL;
-	error = ioOpenFile(&h265File, "bitstream.h265", -1, IO_FILE_WRITE_ASYNC);
+	error = ioAsyncSetup(outputRingSlots + 1); //One more for the checkpoints and the trailers
 	RETURN_ON_ERROR(error);
-	error = ioAsyncSetup(4);
+	uint64_t numOfFrames = fps * recordSeconds;
+	uint64_t indexFrames = numOfFrames;
+	if (recordSeconds == 0) {
+		numOfFrames = UINT64_MAX;
+		indexFrames = fps * DD_OPEN_ENDED_INDEX_SECONDS;
+	}
+	if ((segmentSeconds > 0) && ((fps * segmentSeconds) < indexFrames)) { //A second more for a rollover put off because the next file was not ready
+		indexFrames = fps * (segmentSeconds + 1);
+	}
+	uint64_t segmentBytes = segmentMegabytes * 1024 * 1024;
+	uint64_t preallocateBytes = ddPreallocateBytes(width, height, fps, recordSeconds, segmentSeconds, segmentBytes, preallocatePercent, outputRingSlots);
+	error = bitstreamRolloverSetup(&ddRollover, indexFrames + outputRingSlots, fps * segmentSeconds, segmentBytes, keepSegments, preallocateBytes, 1, (uint32_t) fps, outputRingSlots); //Writes already in flight can go past numOfFrames
+	RETURN_ON_ERROR(error);
+	error = bitstreamRolloverStart(&ddRollover, outputFileName);
+	RETURN_ON_ERROR(error);
+	error = bitstreamCheckpointSetup(&ddCheckpoint, outputFileName, checkpointSegments, outputRingSlots);
+	RETURN_ON_ERROR(error);
+	error = frameTraceSetup(&ddTrace, traceRecords);
 	RETURN_ON_ERROR(error);
-	consolePrintLine(38);
+	error = telemetrySetup(&ddTelemetry, telemetryAddress);
+	RETURN_ON_ERROR(error);
+	consolePrint(38, CON_NO_CTRL);
+	consoleWrite(outputFileName, outputFileNameBytes, CON_NEW_LINE);
+	consolePrintLineWithNumber(190, ddRollover.reservedBytes >> 20, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(178, fps, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(179, recordSeconds, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(180, idrInterval, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(181, outputRingSlots, NUM_FORMAT_UNSIGNED_INTEGER);
+	if ((segmentSeconds > 0) || (segmentMegabytes > 0)) {
+		consolePrintLineWithNumber(183, segmentSeconds, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(184, segmentMegabytes, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(185, keepSegments, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	else {
+		consolePrintLineWithNumber(197, checkpointSegments, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
 	
 	consolePrintLine(39);
 	consoleBufferFlush();
 	consoleWaitForEnter();
 	consolePrintLine(40);
 	
-	error = ddEncodeStart(fps);
+	error = ddEncodeStart(fps, idrInterval);
 	RETURN_ON_ERROR(error);
+	telemetryStart(&ddTelemetry, ddFirstFrameStartTime);
 	
 	consoleBufferFlush();
 		
 	//*
 	
-	uint64_t numOfFrames = fps * recordSeconds;
+	uint64_t enterCheckInterval = getFrameIntervalTime(1000 / DD_ENTER_CHECK_MILLISECONDS);
+	uint64_t enterCheckTime = ddFirstFrameStartTime + enterCheckInterval;
 	uint64_t numWrittenFrames = 0;
 	while (numWrittenFrames < numOfFrames) {
-		error = ddEncodeRun(h265File, &numWrittenFrames);
+		error = ddEncodeRun(&numWrittenFrames);
 		if (error != 0) {
 			break; //Need to handle the possible errors in the future
 		}
+		error = ddTelemetryUpdate(numWrittenFrames);
+		if (error != 0) {
+			break;
+		}
+		uint64_t currentTime = getCurrentTime();
+		if (currentTime >= enterCheckTime) { //<Enter> stops the record early (and is the only way to stop an open ended one)
+			enterCheckTime = currentTime + enterCheckInterval;
+			uint64_t enterPressed = 0;
+			error = consoleCheckForEnter(&enterPressed);
+			if ((error != 0) || (enterPressed > 0)) {
+				break;
+			}
+		}
+		if (numWrittenFrames < numOfFrames) {
+			error = ddEncodeWait(); //Sleep instead of spinning on the checks
+			if (error != 0) {
+				break;
+			}
+		}
 	}
 	
 	//*/
 	int errorBackup = error;
+	if (errorBackup == 0) {
+		error = ddEncodeFinish();
+		if (error == ERROR_BITSTREAM_ROLLOVER_OPEN) {
+			consolePrintLine(189);
+		}
+		else if (error != 0) { //Tools can still index the file by walking it
+			consolePrintLine(106);
+		}
+	}
 	
-	//Close (and Save) Output Bitstream File
-	error = ioCloseFile(&h265File);
+	//Close (and Save) Output Bitstream Files
+	error = bitstreamRolloverClose(&ddRollover);
+	RETURN_ON_ERROR(error);
+	error = frameTraceWrite(&ddTrace, outputFileName); //Also saved when the record failed (that is when it is needed)
 	RETURN_ON_ERROR(error);
 	
 	if (errorBackup == 0) {
-		consolePrintLine(42);
+		consolePrint(42, CON_NO_CTRL);
+		consoleWrite(outputFileName, outputFileNameBytes, CON_NEW_LINE);
 	}
 	else {
-		consolePrintLine(43);
+		consolePrint(43, CON_NO_CTRL);
+		consoleWrite(outputFileName, outputFileNameBytes, CON_NEW_LINE);
 		RETURN_ON_ERROR(errorBackup);
 	}
 	
@@ -1919,8 +2381,10 @@ int programMain() {
 	//consoleBufferFlush();
 	//consoleWaitForEnter();
 	
-	ddEncodePrintStats();
+	ddEncodePrintStats(outputFileName);
 	consoleBufferFlush();
+	error = telemetryCleanup(&ddTelemetry);
+	RETURN_ON_ERROR(error);
 	
 	//Cleanup here in the future
 	
@@ -0,0 +1,663 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+//This is the main file for the Scheduler Benchmark helper program
+//It runs the same staged pipeline as the Lossless Screen Record program
+//(acquire -> compute -> encode -> asynchronous write through an output ring)
+//with a CPU frame source standing in for Desktop Duplication and CPU threads
+//standing in for the GPU stages, using the same acquire timing and repeat
+//frame rules as ddEncodeRun
+//The encode stage is the CPU lossless HEVC encoder backend so the output file
+//is a real bitstream (same reserved NAL framing as the recorder) that
+//BitstreamFrameExtract and regular decoders can read
+//The pipeline runs once with the main loop busy polling the stage checks and
+//once sleeping on a Wait Set between them, then reports the CPU utilization
+//and acquire timing of both (the event driven run also saves a frame trace
+//next to the output file like the recorder does)
+//Usage: SchedulerBenchmark [seconds per run] [output file] [frame source]
+// [present fps] [present jitter in us] [width] [height] [encoder threads]
+// [telemetry address] [segment seconds] [segment MB] [segments kept]
+//The frame source is static, scroll, noise, or the name of a raw .rgb file
+//(same layout as image0.rgb: width x height BGRA frames back to back)
+//Given a telemetry address (::1 for TelemetryReceive on the same machine)
+//both runs publish the same once a second datagrams as the recorder, and
+//given segment limits both runs split their output into segment files the
+//same way the recorder does (the last K of them kept for instant replay)
+
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "frameSource.h" //Includes the Frame Source interface
+#include "encoderBackend.h" //Includes the Encoder Backend interface
+#include "colorConvert.h" //Includes the CPU versions of the compute shader
+#include "bitstreamContainer.h" //Includes the seek table trailer the recorder appends
+#include "frameTrace.h" //Includes the per frame trace ring
+#include "telemetry.h" //Includes the metrics publisher
+#include "bitstreamRollover.h" //Includes the segment file rollover the recorder writes through
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+#define BENCH_FPS 60
+#define BENCH_RING_SLOTS 8
+#define BENCH_MODE_POLL 0
+#define BENCH_MODE_WAIT 1
+
+static frameSource benchSource;
+static encoderBackend benchEncoder;
+static uint16_t* benchPlanes = NULL; //Compute output (encode input): Y, Cb, Cr planes
+static uint64_t benchConvertISA = COLOR_CONVERT_ISA_SCALAR;
+static uint8_t* benchLockedBitstreams[BENCH_RING_SLOTS];
+static uint64_t benchLockedBytes[BENCH_RING_SLOTS];
+static const uint8_t benchReservedNALStart[6] = {0, 0, 0, 1, 84, 1};
+static ioWriteVec benchWriteVectors[BENCH_RING_SLOTS]; //Reserved NAL in the encoder's header room and the frame as one write
+static uint64_t benchSlotSegmentStarts[BENCH_RING_SLOTS];
+static bitstreamRollover benchRollover; //Output file (or segment files) with their seek table trailers
+static frameTrace benchTrace; //Same records as the recorder's trace (saved for the event driven run)
+static uint64_t benchComputeFrame = 0;
+static telemetryPublisher benchTelemetry; //Stage latencies are left out (no histograms here)
+
+static void* benchComputeEvent = NULL;
+static void* benchComputeDoneEvent = NULL;
+static void* benchEncodeEvent = NULL;
+static void* benchLockEvent = NULL;
+static void* benchThreadHandle0 = NULL;
+static void* benchThreadHandle1 = NULL;
+static void* benchWaitSet = NULL;
+
+static uint64_t benchLockSlot = 0; //Ring slot the lock thread waits on next
+static uint64_t benchCounterIDR = 0;
+static uint64_t benchCounterIDRreset = 0;
+static uint64_t benchEncodeTimeSum = 0;
+static uint64_t benchEncodeStartTimes[BENCH_RING_SLOTS];
+
+//Stage state with the same bits as ddState in the recorder
+static uint64_t benchState = 0;
+static uint64_t benchNextFrame = 0;
+static uint64_t benchFirstFrameStartTime = 0;
+static uint64_t benchFrameIntervalTime = 0;
+static uint64_t benchAcquireOffset = 0;
+static uint64_t benchRingHead = 0;
+static uint64_t benchRingTail = 0;
+static uint64_t benchWriteCount = 0;
+static uint64_t benchWriteOffset = 0;
+static uint64_t benchMissedCount = 0;
+static uint64_t benchAcquireDelaySum = 0;
+static uint64_t benchAcquireLatencySum = 0;
+static uint64_t benchAcquireCount = 0;
+static uint64_t benchAccumulatedFramesSum = 0;
+static uint64_t benchRepeatCount = 0;
+static uint64_t benchMiscIssues = 0;
+static uint64_t benchStopping = 0;
+
+//Converts the acquired BGRA frame to the same 3 x R16 layout the recorder's compute shader outputs
+//(fixed point version of the shader's lookup table so the results match it exactly)
+static int benchComputeThread() {
+	while (1) {
+		int error = syncEventWait(benchComputeEvent);
+		RETURN_ON_ERROR(error);
+		
+		colorConvertRows(benchPlanes, (uint32_t*) benchSource.frameData, NULL, benchSource.width, benchSource.height, 0, benchSource.height, COLOR_CONVERT_FIXED, benchConvertISA);
+		
+		error = syncSetEvent(benchComputeDoneEvent);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+//Same job as ddEncodeLockThread: waits for each encode in ring order
+static int benchLockThread() {
+	while (1) {
+		int error = syncEventWait(benchEncodeEvent);
+		RETURN_ON_ERROR(error);
+		
+		error = benchEncoder.lockBitstream(benchLockSlot, &(benchLockedBitstreams[benchLockSlot]), &(benchLockedBytes[benchLockSlot]));
+		RETURN_ON_ERROR(error);
+		benchEncodeTimeSum += getCurrentTime() - benchEncodeStartTimes[benchLockSlot];
+		benchLockSlot++;
+		if (benchLockSlot >= BENCH_RING_SLOTS) {
+			benchLockSlot = 0;
+		}
+		
+		error = syncSetEvent(benchLockEvent);
+		RETURN_ON_ERROR(error);
+	}
+	return 0;
+}
+
+//Same acquire rules as ddEncodeRun (including encoding a repeat when no new frame shows up in time)
+static int benchAcquire() {
+	uint64_t frameStartTime = benchFirstFrameStartTime + (benchNextFrame * benchFrameIntervalTime);
+	uint64_t frameEndTime = frameStartTime + benchFrameIntervalTime;
+	uint64_t acquireStartTime = frameStartTime + benchAcquireOffset;
+	uint64_t acquireEndTime = frameEndTime + benchAcquireOffset;
+	uint64_t currentTime = getCurrentTime();
+	if (currentTime < acquireStartTime) {
+		return 0;
+	}
+	
+	if (currentTime < acquireEndTime) {
+		uint64_t presentationTime = 0;
+		uint64_t accumulatedFrames = 0;
+		int error = benchSource.acquireNextFrame(1, &presentationTime, &accumulatedFrames);
+		if (error == 0) {
+			if (presentationTime >= frameStartTime) {
+				currentTime = getCurrentTime();
+				benchAcquireDelaySum += currentTime - acquireStartTime;
+				benchAcquireLatencySum += currentTime - presentationTime;
+				benchAcquireCount++;
+				benchAccumulatedFramesSum += accumulatedFrames;
+				if (presentationTime < frameEndTime) { //Image is valid for current frame
+					benchNextFrame++;
+					if ((benchState & 32) > 0) {
+						benchMiscIssues++;
+						frameTraceAdd(&benchTrace, FRAME_TRACE_MISC_ISSUE, benchNextFrame - 1, 0, currentTime);
+					}
+					benchState |= 32;
+					benchState &= ~64;
+				}
+				else { //Frame for the next period so encode the duplicate first
+					frameTraceAdd(&benchTrace, FRAME_TRACE_REPEAT, benchNextFrame, 0, currentTime);
+					benchNextFrame += 2;
+					if ((benchState & 0b110000) > 0) {
+						benchMiscIssues++;
+						frameTraceAdd(&benchTrace, FRAME_TRACE_MISC_ISSUE, benchNextFrame - 1, 0, currentTime);
+					}
+					benchRepeatCount++;
+					benchState |= 16 | 32;
+					benchState &= ~64;
+				}
+				frameTraceAdd(&benchTrace, FRAME_TRACE_PRESENT, benchNextFrame - 1, 0, presentationTime);
+				frameTraceAdd(&benchTrace, FRAME_TRACE_ACQUIRE, benchNextFrame - 1, 0, currentTime);
+			}
+			else { //Presented before this frame period started
+				error = benchSource.releaseFrame();
+				RETURN_ON_ERROR(error);
+			}
+		}
+		else if (error != ERROR_FRAME_SOURCE_TIMEOUT) {
+			return error;
+		}
+	}
+	else {
+		benchMissedCount++;
+		frameTraceAdd(&benchTrace, FRAME_TRACE_ACQUIRE_MISSED, benchNextFrame, 0, currentTime);
+	}
+	
+	if ((benchState & 64) > 0) { //Encode duplicate frame if did not acquire new frame
+		currentTime = getCurrentTime();
+		if (currentTime >= frameEndTime) {
+			frameTraceAdd(&benchTrace, FRAME_TRACE_REPEAT, benchNextFrame, 0, currentTime);
+			benchNextFrame++;
+			if ((benchState & 16) > 0) {
+				benchMiscIssues++;
+				frameTraceAdd(&benchTrace, FRAME_TRACE_MISC_ISSUE, benchNextFrame - 1, 0, currentTime);
+			}
+			benchRepeatCount++;
+			benchState |= 16;
+		}
+	}
+	return 0;
+}
+
+static int benchRun(uint64_t* frameWriteCount) {
+	int error = 0;
+	uint64_t signaled = 0;
+	
+	if (((benchState & 64) > 0) && (benchStopping == 0)) { //Frame Released
+		error = benchAcquire();
+		RETURN_ON_ERROR(error);
+	}
+	
+	while (benchRingTail < benchWriteCount) { //Output Ring Write Checks
+		uint64_t slot = benchRingTail % BENCH_RING_SLOTS;
+		error = ioAsyncSignalCheck(slot, &signaled);
+		RETURN_ON_ERROR(error);
+		if (signaled == 0) {
+			break;
+		}
+		frameTraceAdd(&benchTrace, FRAME_TRACE_WRITE_COMPLETE, benchRingTail, slot, getCurrentTime());
+		error = benchEncoder.unlockBitstream(slot);
+		RETURN_ON_ERROR(error);
+		(*frameWriteCount)++;
+		benchRingTail++;
+	}
+	error = bitstreamRolloverUpdate(&benchRollover, benchRingTail);
+	RETURN_ON_ERROR(error);
+	
+	if ((benchState & 4) > 0) { //Encoding Wait Check
+		error = syncEventCheck(benchLockEvent, &signaled);
+		RETURN_ON_ERROR(error);
+		if (signaled == 1) {
+			uint64_t slot = benchWriteCount % BENCH_RING_SLOTS;
+			uint64_t currentTime = getCurrentTime();
+			frameTraceAdd(&benchTrace, FRAME_TRACE_ENCODE_LOCK, benchWriteCount, slot, currentTime);
+			frameTraceAdd(&benchTrace, FRAME_TRACE_WRITE_SUBMIT, benchWriteCount, slot, currentTime);
+			benchWriteCount++;
+			uint8_t* reservedNAL = benchLockedBitstreams[slot] - BITSTREAM_RESERVED_NAL_BYTES;
+			memcpyBasic(reservedNAL, benchReservedNALStart, 6);
+			*((uint32_t*) (&(reservedNAL[6]))) = (uint32_t) benchLockedBytes[slot];
+			benchWriteVectors[slot].dataPtr = reservedNAL;
+			benchWriteVectors[slot].numBytes = BITSTREAM_RESERVED_NAL_BYTES + benchLockedBytes[slot];
+			error = bitstreamRolloverWrite(&benchRollover, &(benchWriteVectors[slot]), 1, slot, benchLockedBitstreams[slot], benchLockedBytes[slot], benchWriteCount - 1, benchSlotSegmentStarts[slot]);
+			RETURN_ON_ERROR(error);
+			benchWriteOffset += 10 + benchLockedBytes[slot];
+			benchState &= ~4;
+		}
+	}
+	
+	if ((benchState & 8) > 0) { //Compute Wait Check
+		error = syncEventCheck(benchComputeDoneEvent, &signaled);
+		RETURN_ON_ERROR(error);
+		if (signaled == 0) {
+			return 0;
+		}
+		frameTraceAdd(&benchTrace, FRAME_TRACE_COMPUTE_DONE, benchComputeFrame, 0, getCurrentTime());
+		error = benchSource.releaseFrame();
+		RETURN_ON_ERROR(error);
+		benchState |= 64 | 16;
+		benchState &= ~8;
+	}
+	
+	if ((benchState & 16) > 0) { //Encoding Start Wait Check
+		if (benchStopping > 0) {
+			benchState &= ~16;
+		}
+		else if (((benchState & 0b1100) == 0) && ((benchRingHead - benchRingTail) < BENCH_RING_SLOTS)) {
+			uint64_t slot = benchRingHead % BENCH_RING_SLOTS;
+			uint64_t forceIDR = 0;
+			benchSlotSegmentStarts[slot] = bitstreamRolloverDue(&benchRollover);
+			if (benchSlotSegmentStarts[slot] > 0) {
+				forceIDR = ENCODER_FORCE_IDR;
+				benchCounterIDR = benchCounterIDRreset;
+			}
+			else if (benchCounterIDR == 0) {
+				forceIDR = ENCODER_FORCE_INTRA;
+				benchCounterIDR = benchCounterIDRreset;
+			}
+			else {
+				benchCounterIDR--;
+			}
+			benchEncodeStartTimes[slot] = getCurrentTime();
+			frameTraceAdd(&benchTrace, FRAME_TRACE_ENCODE_SUBMIT, benchRingHead, slot, benchEncodeStartTimes[slot]);
+			error = benchEncoder.encodeFrame(slot, forceIDR);
+			RETURN_ON_ERROR(error);
+			error = syncSetEvent(benchEncodeEvent);
+			RETURN_ON_ERROR(error);
+			benchRingHead++;
+			benchState |= 4;
+			benchState &= ~16;
+		}
+	}
+	
+	if ((benchState & 32) > 0) { //Compute Start Wait Check
+		if (benchStopping > 0) {
+			error = benchSource.releaseFrame();
+			RETURN_ON_ERROR(error);
+			benchState &= ~32;
+		}
+		else if ((benchState & 0b11100) == 0) {
+			benchComputeFrame = benchNextFrame - 1;
+			frameTraceAdd(&benchTrace, FRAME_TRACE_COMPUTE_SUBMIT, benchComputeFrame, 0, getCurrentTime());
+			error = syncSetEvent(benchComputeEvent);
+			RETURN_ON_ERROR(error);
+			benchState |= 8;
+			benchState &= ~32;
+		}
+	}
+	
+	return 0;
+}
+
+//Same rules as ddEncodeWait in the recorder
+static int benchWait() {
+	uint64_t endTime = SYNC_WAIT_NONE;
+	if (((benchState & 64) > 0) && (benchStopping == 0)) {
+		uint64_t acquireStartTime = benchFirstFrameStartTime + (benchNextFrame * benchFrameIntervalTime) + benchAcquireOffset;
+		if (getCurrentTime() >= acquireStartTime) {
+			return 0;
+		}
+		endTime = acquireStartTime;
+	}
+	uint64_t asyncOperation = SYNC_WAIT_NONE;
+	if (benchRingTail < benchWriteCount) {
+		asyncOperation = benchRingTail % BENCH_RING_SLOTS;
+	}
+	else if (benchRollover.step == BITSTREAM_ROLLOVER_WAIT_TRAILER) {
+		asyncOperation = benchRollover.asyncOperation;
+	}
+	return syncWaitSetWait(benchWaitSet, asyncOperation, endTime);
+}
+
+static int benchPipeline(char* outputFileName, uint64_t mode, uint64_t numOfFrames) {
+	int error = bitstreamRolloverStart(&benchRollover, outputFileName);
+	RETURN_ON_ERROR(error);
+	
+	benchRingHead = 0;
+	benchRingTail = 0;
+	benchLockSlot = 0;
+	benchCounterIDR = 0; //Each run's file starts with an IDR
+	benchEncodeTimeSum = 0;
+	benchWriteCount = 0;
+	benchWriteOffset = 0;
+	benchMissedCount = 0;
+	benchAcquireDelaySum = 0;
+	benchAcquireLatencySum = 0;
+	benchAcquireCount = 0;
+	benchAccumulatedFramesSum = 0;
+	benchRepeatCount = 0;
+	benchMiscIssues = 0;
+	benchStopping = 0;
+	benchFrameIntervalTime = getFrameIntervalTime(BENCH_FPS);
+	benchAcquireOffset = 500 * getMicrosecondDivider();
+	
+	//First frame goes straight to compute like in ddEncodeStart
+	//(a static source only presents once so later runs start from the frame it already has)
+	uint64_t presentationTime = 0;
+	uint64_t accumulatedFrames = 0;
+	error = benchSource.acquireNextFrame(1000 / BENCH_FPS, &presentationTime, &accumulatedFrames);
+	if ((error != 0) && (error != ERROR_FRAME_SOURCE_TIMEOUT)) {
+		return error;
+	}
+	
+	uint64_t processStartTime = getProcessTimeMicroseconds();
+	uint64_t startTime = getCurrentTime();
+	benchFirstFrameStartTime = startTime;
+	benchNextFrame = 1;
+	
+	frameTraceReset(&benchTrace);
+	if (presentationTime > 0) {
+		frameTraceAdd(&benchTrace, FRAME_TRACE_PRESENT, 0, 0, presentationTime);
+	}
+	frameTraceAdd(&benchTrace, FRAME_TRACE_ACQUIRE, 0, 0, startTime);
+	frameTraceAdd(&benchTrace, FRAME_TRACE_COMPUTE_SUBMIT, 0, 0, startTime);
+	benchComputeFrame = 0;
+	
+	benchState = 8;
+	error = syncSetEvent(benchComputeEvent);
+	RETURN_ON_ERROR(error);
+	
+	telemetryStart(&benchTelemetry, startTime);
+	
+	uint64_t numWrittenFrames = 0;
+	while (numWrittenFrames < numOfFrames) {
+		error = benchRun(&numWrittenFrames);
+		RETURN_ON_ERROR(error);
+		uint64_t currentTime = getCurrentTime();
+		if (telemetryDue(&benchTelemetry, currentTime) > 0) {
+			telemetryDatagram* datagram = &(benchTelemetry.datagram);
+			datagram->framesWritten = numWrittenFrames;
+			datagram->bytesWritten = benchWriteOffset; //Submitted bytes (the ring is at most a few frames ahead)
+			datagram->ringOccupancy = benchWriteCount - benchRingTail;
+			datagram->ringSlots = BENCH_RING_SLOTS;
+			datagram->repeatCount = benchRepeatCount;
+			datagram->missedCount = benchMissedCount;
+			datagram->miscIssues = benchMiscIssues;
+			error = telemetrySend(&benchTelemetry, currentTime, NULL);
+			RETURN_ON_ERROR(error);
+		}
+		if ((mode == BENCH_MODE_WAIT) && (numWrittenFrames < numOfFrames)) {
+			error = benchWait();
+			RETURN_ON_ERROR(error);
+		}
+	}
+	
+	uint64_t stopTime = getCurrentTime();
+	uint64_t processTime = getProcessTimeMicroseconds() - processStartTime;
+	
+	//Let whatever is still in flight finish before the next run
+	benchStopping = 1;
+	while (((benchState & 0b101100) > 0) || (benchRingTail < benchWriteCount)) {
+		error = benchRun(&numWrittenFrames);
+		RETURN_ON_ERROR(error);
+		if (((benchState & 0b101100) > 0) || (benchRingTail < benchWriteCount)) { //Nothing left to wake the wait otherwise
+			error = benchWait();
+			RETURN_ON_ERROR(error);
+		}
+	}
+	
+	//Same seek table trailers as ddEncodeFinish (the output ring is empty now)
+	error = bitstreamRolloverFinish(&benchRollover);
+	if (error == ERROR_BITSTREAM_ROLLOVER_OPEN) {
+		consolePrintLine(189);
+	}
+	else if (error != 0) {
+		consolePrintLine(106);
+	}
+	error = bitstreamRolloverClose(&benchRollover);
+	RETURN_ON_ERROR(error);
+	if (mode == BENCH_MODE_WAIT) { //Same scheduling as the recorder
+		error = frameTraceWrite(&benchTrace, outputFileName);
+		RETURN_ON_ERROR(error);
+	}
+	
+	uint64_t microsecondDivider = getMicrosecondDivider();
+	uint64_t runTime = getDiffTimeMicroseconds(startTime, stopTime);
+	consolePrintLine(63 + mode);
+	consolePrintLineWithNumber(65, numOfFrames, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(66, (processTime * 100) / runTime, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(67, benchMissedCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(46, (benchEncodeTimeSum / benchWriteCount) / microsecondDivider, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(59, benchWriteOffset / runTime, NUM_FORMAT_UNSIGNED_INTEGER); //Bytes per us is MB/s
+	if (benchAcquireCount > 0) {
+		consolePrintLineWithNumber(68, (benchAcquireDelaySum / benchAcquireCount) / microsecondDivider, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(44, (benchAcquireLatencySum / benchAcquireCount) / microsecondDivider, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	consolePrintLineWithNumber(47, benchRepeatCount, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(49, benchMiscIssues, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(50, benchAccumulatedFramesSum, NUM_FORMAT_UNSIGNED_INTEGER);
+	if ((benchRollover.segmentFrames > 0) || (benchRollover.segmentBytes > 0)) {
+		consolePrintLineWithNumber(186, benchRollover.segmentCount, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(187, benchRollover.deferred, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(188, benchRollover.deleted, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	consoleBufferFlush();
+	
+	return 0;
+}
+
+static int benchParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+static uint64_t benchArgumentIs(char* argument, uint64_t argumentBytes, char* name) {
+	uint64_t i = 0;
+	for (; i < argumentBytes; i++) {
+		if (argument[i] != name[i]) {
+			return 0;
+		}
+	}
+	return (name[i] == 0) ? 1 : 0;
+}
+
+int programMain() {
+	uint64_t recordSeconds = 5;
+	char* outputFileName = "scheduler.h265";
+	char* sourceArgument = "scroll";
+	uint64_t sourceArgumentBytes = 6;
+	uint64_t presentFps = BENCH_FPS;
+	uint64_t jitterMicroseconds = 0;
+	uint64_t width = 0;
+	uint64_t height = 0;
+	uint64_t encoderThreads = syncGetProcessorCount();
+	char* telemetryAddress = NULL;
+	uint64_t segmentSeconds = 0;
+	uint64_t segmentMegabytes = 0;
+	uint64_t keepSegments = 0;
+	
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	int error = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &recordSeconds);
+		RETURN_ON_ERROR(error);
+		if (recordSeconds == 0) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+	}
+	if (ioGetCommandArgument(2, &argument, &argumentBytes) == 0) {
+		outputFileName = argument;
+	}
+	if (ioGetCommandArgument(3, &argument, &argumentBytes) == 0) {
+		sourceArgument = argument;
+		sourceArgumentBytes = argumentBytes;
+	}
+	if (ioGetCommandArgument(4, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &presentFps);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(5, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &jitterMicroseconds);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(6, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &width);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(7, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &height);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(8, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &encoderThreads);
+		RETURN_ON_ERROR(error);
+		if (encoderThreads == 0) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+	}
+	if ((ioGetCommandArgument(9, &argument, &argumentBytes) == 0) && (argumentBytes > 0)) { //Empty leaves telemetry off (to get to the segment arguments)
+		telemetryAddress = argument;
+	}
+	if (ioGetCommandArgument(10, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &segmentSeconds);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(11, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &segmentMegabytes);
+		RETURN_ON_ERROR(error);
+	}
+	if (ioGetCommandArgument(12, &argument, &argumentBytes) == 0) {
+		error = benchParseNumber(argument, argumentBytes, &keepSegments);
+		RETURN_ON_ERROR(error);
+		if ((keepSegments > 0) && (segmentSeconds == 0) && (segmentMegabytes == 0)) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+	}
+	
+	uint64_t pattern = FRAME_SOURCE_PATTERN_REPLAY;
+	if (benchArgumentIs(sourceArgument, sourceArgumentBytes, "static") > 0) {
+		pattern = FRAME_SOURCE_PATTERN_STATIC;
+	}
+	else if (benchArgumentIs(sourceArgument, sourceArgumentBytes, "scroll") > 0) {
+		pattern = FRAME_SOURCE_PATTERN_SCROLL_TEXT;
+	}
+	else if (benchArgumentIs(sourceArgument, sourceArgumentBytes, "noise") > 0) {
+		pattern = FRAME_SOURCE_PATTERN_NOISE;
+	}
+	
+	if (pattern == FRAME_SOURCE_PATTERN_REPLAY) {
+		if (width == 0) { //Same size as the image0.rgb dump
+			width = 1920;
+			height = 1080;
+		}
+		error = frameSourceSetupReplay(&benchSource, sourceArgument, (uint32_t) width, (uint32_t) height, presentFps, jitterMicroseconds);
+		RETURN_ON_ERROR(error);
+	}
+	else {
+		if (width == 0) {
+			width = 1280;
+			height = 720;
+		}
+		error = frameSourceSetupSynthetic(&benchSource, (uint32_t) width, (uint32_t) height, pattern, presentFps, jitterMicroseconds);
+		RETURN_ON_ERROR(error);
+	}
+	
+	void* memAlloc = NULL;
+	error = memoryAllocate(&memAlloc, width * height * 3 * sizeof(uint16_t), 0);
+	RETURN_ON_ERROR(error);
+	benchPlanes = (uint16_t*) memAlloc;
+	benchConvertISA = colorConvertGetMaxISA();
+	error = encoderSetupCPU(&benchEncoder, benchPlanes, (uint32_t) width, (uint32_t) height, BENCH_FPS, BENCH_RING_SLOTS, encoderThreads);
+	RETURN_ON_ERROR(error);
+	benchCounterIDRreset = (BENCH_FPS * 3) - 1; //Frames between the IDR frames (the recorder's default interval)
+	
+	error = syncCreateEvent(&benchComputeEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	error = syncCreateEvent(&benchComputeDoneEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	error = syncCreateEvent(&benchEncodeEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	error = syncCreateEvent(&benchLockEvent, 0, 0);
+	RETURN_ON_ERROR(error);
+	error = syncCreateWaitSet(&benchWaitSet);
+	RETURN_ON_ERROR(error);
+	error = syncWaitSetAddEvent(benchWaitSet, benchLockEvent);
+	RETURN_ON_ERROR(error);
+	error = syncWaitSetAddEvent(benchWaitSet, benchComputeDoneEvent);
+	RETURN_ON_ERROR(error);
+	
+	PFN_ThreadStart threadStart = benchComputeThread;
+	error = syncStartThread(&benchThreadHandle0, threadStart, 0);
+	RETURN_ON_ERROR(error);
+	threadStart = benchLockThread;
+	error = syncStartThread(&benchThreadHandle1, threadStart, 0);
+	RETURN_ON_ERROR(error);
+	
+	error = ioAsyncSetup(BENCH_RING_SLOTS + 1); //One more for the trailers
+	RETURN_ON_ERROR(error);
+	
+	uint64_t numOfFrames = BENCH_FPS * recordSeconds;
+	uint64_t segmentBytes = segmentMegabytes * 1024 * 1024;
+	uint64_t preallocateBytes = ((width * height * 30) / 8) * BENCH_FPS * ((segmentSeconds > 0) ? (segmentSeconds + 1) : recordSeconds); //PCM frames are the raw size
+	if ((segmentBytes > 0) && (segmentBytes < preallocateBytes)) {
+		preallocateBytes = segmentBytes;
+	}
+	error = bitstreamRolloverSetup(&benchRollover, numOfFrames + BENCH_RING_SLOTS, BENCH_FPS * segmentSeconds, segmentBytes, keepSegments, preallocateBytes, 1, BENCH_FPS, BENCH_RING_SLOTS);
+	RETURN_ON_ERROR(error);
+	error = frameTraceSetup(&benchTrace, FRAME_TRACE_DEFAULT_RECORDS);
+	RETURN_ON_ERROR(error);
+	error = telemetrySetup(&benchTelemetry, telemetryAddress);
+	RETURN_ON_ERROR(error);
+	error = benchPipeline(outputFileName, BENCH_MODE_POLL, numOfFrames);
+	RETURN_ON_ERROR(error);
+	error = benchPipeline(outputFileName, BENCH_MODE_WAIT, numOfFrames);
+	RETURN_ON_ERROR(error);
+	
+	ioAsyncCleanup();
+	bitstreamRolloverCleanup(&benchRollover);
+	frameTraceCleanup(&benchTrace);
+	if (benchTelemetry.enabled > 0) {
+		consolePrintLineWithNumber(176, benchTelemetry.sent, NUM_FORMAT_UNSIGNED_INTEGER);
+		consolePrintLineWithNumber(177, benchTelemetry.skipped, NUM_FORMAT_UNSIGNED_INTEGER);
+	}
+	error = telemetryCleanup(&benchTelemetry);
+	RETURN_ON_ERROR(error);
+	syncCloseWaitSet(&benchWaitSet);
+	benchEncoder.cleanup();
+	benchSource.cleanup();
+	
+	return 0;
+}
@@ -0,0 +1,70 @@
+#version 460
+//https://www.khronos.org/opengl/wiki/Compute_Shader for reference
+//Partial LUT version of shader.comp.glsl with the exact same output:
+//the 64 MiB LUT read becomes three reads from 256 entry per channel tables
+//(fixed point numerators) and one division per channel, and the rare exact
+//ties look up the short sorted correction list
+//(colorConvertPartialPixel in colorConvertLUT.c is the CPU version)
+
+layout(local_size_x = 16, local_size_y = 4, local_size_z = 1) in; //64 multiple size
+
+layout(set = 0, binding = 0, r32ui) uniform readonly uimage2D inputImage;
+
+layout(set = 0, binding = 1, std430) buffer lutBufBlock{
+	uvec4 partial[768]; //Red, Green, Blue tables of (Y, Cb, Cr, unused) numerator parts
+	uint correctionCount;
+	uint corrections[]; //(rgb << 8) | round down bits
+} lutData;
+
+layout(set = 0, binding = 2, r16ui) uniform writeonly uimage2D outputImage;
+
+const uvec3 divisors = uvec3(850000, 1577260, 1338580);
+
+uint findCorrection(uint rgbValue) {
+	uint low = 0;
+	uint high = lutData.correctionCount;
+	while (low < high) {
+		uint middle = (low + high) >> 1;
+		if ((lutData.corrections[middle] >> 8) < rgbValue) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	if ((low < lutData.correctionCount) && ((lutData.corrections[low] >> 8) == rgbValue)) {
+		return lutData.corrections[low] & 7;
+	}
+	return 0;
+}
+
+void main() {
+	ivec2 imgLocation = ivec2(gl_GlobalInvocationID.x, gl_GlobalInvocationID.y);
+	ivec2 imgSize = imageSize(inputImage);
+	
+	uvec4 uintValue = imageLoad(inputImage, imgLocation);
+	int imgHeight2 = imgSize.y << 1;
+	ivec2 imgLocation2 = ivec2(gl_GlobalInvocationID.x, gl_GlobalInvocationID.y + imgSize.y);
+	ivec2 imgLocation3 = ivec2(gl_GlobalInvocationID.x, gl_GlobalInvocationID.y + imgHeight2);
+	
+	uint rgbValue = uintValue.x & 0xFFFFFF;
+	uvec3 numerators = lutData.partial[rgbValue >> 16].xyz; //Wraps back into [0, 2^31)
+	numerators += lutData.partial[256 + ((rgbValue >> 8) & 0xFF)].xyz;
+	numerators += lutData.partial[512 + (rgbValue & 0xFF)].xyz;
+	
+	uvec3 yuvValues = numerators / divisors;
+	bvec3 ties = equal(yuvValues * divisors, numerators);
+	if (any(ties)) {
+		uint correction = findCorrection(rgbValue);
+		yuvValues -= uvec3(ties) & uvec3(correction, correction >> 1, correction >> 2) & uvec3(1);
+	}
+	yuvValues = min(yuvValues, uvec3(1023));
+	
+	uvec4 storeValue = uvec4(yuvValues.x << 6, 0, 0, 0);
+	uvec4 storeValue2 = uvec4(yuvValues.y << 6, 0, 0, 0);
+	uvec4 storeValue3 = uvec4(yuvValues.z << 6, 0, 0, 0);
+	
+	imageStore(outputImage, imgLocation, storeValue);
+	imageStore(outputImage, imgLocation2, storeValue2);
+	imageStore(outputImage, imgLocation3, storeValue3);
+}
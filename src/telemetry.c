@@ -0,0 +1,124 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//Media Enhanced Telemetry Functions
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "compatibility.h" //Include Compatibility Function Definitions (with networking)
+#include "telemetry.h" //Include Telemetry Function Definitions
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+int telemetrySetup(telemetryPublisher* publisher, char* receiverAddress) {
+	memzeroBasic(publisher, sizeof(telemetryPublisher));
+	if (receiverAddress == NULL) {
+		return 0;
+	}
+	int error = networkStartup(0, receiverAddress);
+	RETURN_ON_ERROR(error);
+	publisher->enabled = 1;
+	publisher->intervalTime = 1000000 * getMicrosecondDivider();
+	publisher->datagram.magic = TELEMETRY_MAGIC;
+	return 0;
+}
+
+void telemetryStart(telemetryPublisher* publisher, uint64_t startTime) {
+	publisher->startTime = startTime;
+	publisher->lastTime = startTime;
+	publisher->nextTime = startTime + publisher->intervalTime;
+	publisher->lastBytes = 0; //Each record starts its counters over
+	for (uint64_t s = 0; s < TELEMETRY_STAGES; s++) {
+		publisher->lastCounts[s] = 0;
+		publisher->lastSums[s] = 0;
+	}
+}
+
+uint64_t telemetryDue(telemetryPublisher* publisher, uint64_t currentTime) {
+	return ((publisher->enabled > 0) && (currentTime >= publisher->nextTime)) ? 1 : 0;
+}
+
+int telemetrySend(telemetryPublisher* publisher, uint64_t currentTime, latencyHistogram* stages) {
+	telemetryDatagram* datagram = &(publisher->datagram);
+	publisher->nextTime += publisher->intervalTime;
+	if (publisher->nextTime <= currentTime) { //Fell behind (a long stall) so skip ahead
+		publisher->nextTime = currentTime + publisher->intervalTime;
+	}
+	
+	uint64_t intervalMicroseconds = getDiffTimeMicroseconds(publisher->lastTime, currentTime);
+	if (intervalMicroseconds == 0) {
+		intervalMicroseconds = 1;
+	}
+	datagram->elapsedMilliseconds = getDiffTimeMicroseconds(publisher->startTime, currentTime) / 1000;
+	datagram->bytesPerSecond = ((datagram->bytesWritten - publisher->lastBytes) * 1000000) / intervalMicroseconds;
+	publisher->lastTime = currentTime;
+	publisher->lastBytes = datagram->bytesWritten;
+	for (uint64_t s = 0; s < TELEMETRY_STAGES; s++) {
+		datagram->stageMean[s] = 0;
+		datagram->stageP99[s] = 0;
+		datagram->stageMax[s] = 0;
+		if (stages == NULL) {
+			continue;
+		}
+		uint64_t count = __atomic_load_n(&(stages[s].count), __ATOMIC_RELAXED);
+		uint64_t sum = __atomic_load_n(&(stages[s].sum), __ATOMIC_RELAXED);
+		if (count > publisher->lastCounts[s]) {
+			datagram->stageMean[s] = ((sum - publisher->lastSums[s]) / (count - publisher->lastCounts[s])) / 1000;
+		}
+		publisher->lastCounts[s] = count;
+		publisher->lastSums[s] = sum;
+		datagram->stageP99[s] = latencyHistogramPercentile(&(stages[s]), 9900) / 1000;
+		datagram->stageMax[s] = __atomic_load_n(&(stages[s].max), __ATOMIC_RELAXED) / 1000;
+	}
+	
+	uint8_t* sendBuffer = NULL;
+	uint64_t sendMaxBytes = 0;
+	int error = networkGetNextSendMessageBuffer(&sendBuffer, &sendMaxBytes, 0);
+	if ((error != 0) || (sendMaxBytes < sizeof(telemetryDatagram))) { //Still sending the last one (or the network went away)
+		publisher->skipped++;
+		return 0;
+	}
+	memcpyBasic(sendBuffer, datagram, sizeof(telemetryDatagram));
+	netAddrPortFlow receiver;
+	error = networkGetServerAddrPort(&receiver);
+	RETURN_ON_ERROR(error);
+	error = networkSendMessage(&receiver, sizeof(telemetryDatagram));
+	if (error != 0) { //Nobody listening right now is not a reason to stop recording
+		publisher->skipped++;
+		return 0;
+	}
+	datagram->sequence++;
+	publisher->sent++;
+	return 0;
+}
+
+int telemetryCleanup(telemetryPublisher* publisher) {
+	if (publisher->enabled == 0) {
+		return 0;
+	}
+	publisher->enabled = 0;
+	if (publisher->sent > 0) {
+		networkWaitOnSentMessages();
+	}
+	return networkCleanup();
+}
@@ -0,0 +1,83 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//Media Enhanced Telemetry Definitions
+//Fixed format UDP datagrams that a long running record sends once a second
+//through the compatibility network layer (IPv6, port 4567) so an operator can
+//watch the disk keep up from another machine: frames written, write
+//throughput, how much of the output ring is waiting on the disk, repeated and
+//missed frames, and the stage latencies. Sending never waits: when the last
+//datagram is still going out (or the send fails) that second gets skipped
+#ifndef MEDIA_ENHANCED_TELEMETRY_H
+#define MEDIA_ENHANCED_TELEMETRY_H
+
+#include <stdint.h> //Defines Data Types: https://en.wikipedia.org/wiki/C_data_types
+#include "latencyHistogram.h" //Stage latencies
+
+#define TELEMETRY_MAGIC 0x31454C455452534C //"LSRTELE1"
+#define TELEMETRY_STAGES 5 //Acquire, Compute, Encode, Write, Presentation to Disk
+
+//Little endian and the same layout on every platform (208 bytes)
+typedef struct telemetryDatagram {
+	uint64_t magic;
+	uint64_t sequence; //Gaps are lost datagrams
+	uint64_t elapsedMilliseconds; //Since the record started
+	uint64_t framesWritten;
+	uint64_t bytesWritten;
+	uint64_t bytesPerSecond; //Over the last interval
+	uint64_t ringOccupancy; //Frames encoded but not on the disk yet
+	uint64_t ringSlots;
+	uint64_t repeatCount;
+	uint64_t missedCount;
+	uint64_t miscIssues;
+	uint64_t stageMean[TELEMETRY_STAGES]; //Microseconds over the last interval
+	uint64_t stageP99[TELEMETRY_STAGES]; //Microseconds since the record started
+	uint64_t stageMax[TELEMETRY_STAGES];
+} telemetryDatagram;
+
+typedef struct telemetryPublisher {
+	uint64_t enabled;
+	uint64_t intervalTime;
+	uint64_t startTime;
+	uint64_t nextTime;
+	uint64_t lastTime;
+	uint64_t lastBytes;
+	uint64_t lastCounts[TELEMETRY_STAGES];
+	uint64_t lastSums[TELEMETRY_STAGES];
+	uint64_t sent;
+	uint64_t skipped;
+	telemetryDatagram datagram; //Counters get filled in by the caller before each send
+} telemetryPublisher;
+
+//A NULL receiver address turns the telemetry off
+int telemetrySetup(telemetryPublisher* publisher, char* receiverAddress);
+void telemetryStart(telemetryPublisher* publisher, uint64_t startTime);
+uint64_t telemetryDue(telemetryPublisher* publisher, uint64_t currentTime);
+//Fills in the timing, throughput and stage latencies (histograms can be NULL) and sends
+int telemetrySend(telemetryPublisher* publisher, uint64_t currentTime, latencyHistogram* stages);
+int telemetryCleanup(telemetryPublisher* publisher);
+
+#endif
@@ -0,0 +1,116 @@
+//MIT License
+//Copyright (c) 2023 Jared Loewenthal
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files (the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions:
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
+
+
+
+
+
+
+//This is the main file for the Telemetry Receive helper program
+//It listens on UDP port 4567 (IPv6) for the once a second telemetry datagrams
+//a record sends and prints one line per datagram: seconds since the record
+//started, frames written, write throughput, output ring occupancy, repeated
+//and missed frames, and the p99 latency of each stage. A ring that stays
+//full while the throughput drops means the disk can not keep up
+//Usage: TelemetryReceive [datagram count (0 keeps listening)]
+
+#define COMPATIBILITY_GRAPHICS_UNNEEDED //Do not need graphics
+#include "programEntry.h" //Includes "programStrings.h" & "compatibility.h" & <stdint.h>
+#include "telemetry.h" //Includes the datagram layout
+#include <stddef.h> //NULL definition normally included by Vulkan
+
+static int receiveParseNumber(char* argument, uint64_t argumentBytes, uint64_t* number) {
+	*number = 0;
+	for (uint64_t i = 0; i < argumentBytes; i++) {
+		if ((argument[i] < '0') || (argument[i] > '9')) {
+			return ERROR_INVALID_ARGUMENT;
+		}
+		*number = ((*number) * 10) + (argument[i] - '0');
+	}
+	return 0;
+}
+
+static void receivePrint(telemetryDatagram* datagram) {
+	consolePrintWithNumber(167, datagram->elapsedMilliseconds / 1000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(168, datagram->framesWritten, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(169, datagram->bytesPerSecond / 1000000, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(170, datagram->ringOccupancy, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(171, datagram->ringSlots, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(172, datagram->repeatCount, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	consolePrintWithNumber(173, datagram->missedCount, NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	for (uint64_t s = 0; s < (TELEMETRY_STAGES - 1); s++) {
+		consolePrintWithNumber(148, datagram->stageP99[s], NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER);
+	}
+	consolePrintWithNumber(164, datagram->stageP99[TELEMETRY_STAGES - 1], NUM_FORMAT_UNSIGNED_INTEGER, CON_FLIP_ORDER_NEW_LINE);
+}
+
+//Program Main Function
+int programMain() {
+	uint64_t datagramCount = 0;
+	char* argument = NULL;
+	uint64_t argumentBytes = 0;
+	if (ioGetCommandArgument(1, &argument, &argumentBytes) == 0) {
+		int error = receiveParseNumber(argument, argumentBytes, &datagramCount);
+		RETURN_ON_ERROR(error);
+	}
+	
+	int error = networkStartup(1, NULL);
+	RETURN_ON_ERROR(error);
+	consolePrintLine(165);
+	consoleBufferFlush();
+	
+	uint64_t received = 0;
+	uint64_t lost = 0;
+	uint64_t nextSequence = 0;
+	while ((datagramCount == 0) || (received < datagramCount)) {
+		uint8_t* message = NULL;
+		uint64_t messageBytes = 0;
+		error = networkGetNextRecvMessageBuffer(&message, &messageBytes, 1);
+		if (error == NETWORK_RECV_PENDING) { //Nothing this second
+			continue;
+		}
+		RETURN_ON_ERROR(error);
+		telemetryDatagram* datagram = (telemetryDatagram*) message;
+		if ((messageBytes != sizeof(telemetryDatagram)) || (datagram->magic != TELEMETRY_MAGIC)) {
+			continue;
+		}
+		
+		if ((received == 0) || (datagram->sequence < nextSequence)) { //First datagram (or the record restarted)
+			char addressString[64];
+			uint64_t addressBytes = 64;
+			if (networkGetAddrPortStr(addressString, &addressBytes, 1) == 0) {
+				consolePrint(166, CON_NO_CTRL);
+				consoleWrite(addressString, addressBytes, CON_NEW_LINE);
+			}
+		}
+		else {
+			lost += datagram->sequence - nextSequence;
+		}
+		nextSequence = datagram->sequence + 1;
+		received++;
+		receivePrint(datagram);
+		consoleBufferFlush();
+	}
+	
+	consolePrintLineWithNumber(174, received, NUM_FORMAT_UNSIGNED_INTEGER);
+	consolePrintLineWithNumber(175, lost, NUM_FORMAT_UNSIGNED_INTEGER);
+	return networkCleanup();
+}